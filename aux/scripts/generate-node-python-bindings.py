@@ -22,8 +22,8 @@ import subprocess
 import CppHeaderParser
 
 node_superclasses = [ "Node", "UnaryOpNode", "BinaryOpNode", "StochasticNode", "FFTNode", "FFTOpNode", "LFO" ]
-omitted_classes = [ "VampAnalysis", "SegmentPlayer", "GrainSegments", "FFTNoiseGate", "FFTZeroPhase", "FFTOpNode", "FFTNode", "StochasticNode" ]
-macos_only_classes = [ "MouseX", "MouseY", "MouseDown", "FFTConvolve" ]
+omitted_classes = [ "VampAnalysis", "SegmentPlayer", "GrainSegments", "FFTNoiseGate", "FFTZeroPhase", "FFTOpNode", "FFTNode", "StochasticNode", "DiskRecorder", "AudioIn_Abstract", "AudioIn_Dummy", "AudioIn_SoundIO" ]
+macos_only_classes = [ "MouseX", "MouseY", "MouseDown" ]
 
 top_level = subprocess.check_output([ "git", "rev-parse", "--show-toplevel" ]).decode().strip()
 header_root = os.path.join(top_level, "source", "include")
@@ -64,10 +64,10 @@ def generate_class_bindings(class_name, parameter_sets, superclass="Node"):
 
 def generate_all_bindings():
     output = ""
-    output += generate_class_bindings("AudioIn", [[]]) + "\n"
     output += generate_class_bindings("AudioOut_Abstract", []) + "\n"
     output += generate_class_bindings("AudioOut_Dummy", [[
-        { "name": "num_channels", "type": "int", "default": 2 }
+        { "name": "num_channels", "type": "int", "default": 2 },
+        { "name": "sample_rate", "type": "int", "default": 44100 }
     ]], "AudioOut_Abstract") + "\n"
 
     output += generate_class_bindings("AudioOut", [[
@@ -0,0 +1,385 @@
+/*------------------------------------------------------------------------
+ * signalflow-bench
+ *
+ * Benchmarks the processing cost of each registered Node class, and the
+ * throughput of a set of whole-graph scenarios, rendering through a
+ * dummy output with no audio device. Results are written as JSON, so
+ * that they can be compared between releases.
+ *
+ * Usage: signalflow-bench [options]
+ *-----------------------------------------------------------------------*/
+
+#include <signalflow/signalflow.h>
+
+#include "json11/json11.hpp"
+
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <string>
+
+using namespace signalflow;
+using namespace json11;
+
+/*------------------------------------------------------------------------
+ * Node classes that can't be benchmarked with default arguments: outputs
+ * and nodes that need hardware or a windowing system, and nodes that
+ * need a buffer, property or input of a specific kind to be given at
+ * construction.
+ *-----------------------------------------------------------------------*/
+static std::set<std::string> excluded_node_names = {
+    "audioin-dummy", "audioout-dummy", "audioout-soundio", "mousex", "mousey", "mousedown",
+    "cross-correlate", "fft-continuous-pv", "grain-segments", "impulse-sequence",
+    "index", "random-choice", "segment-player", "waveshaper", "wavetable2d"
+};
+
+/*------------------------------------------------------------------------
+ * Number of blocks rendered before timing begins, to populate caches
+ * and any lazily-allocated state.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_BENCH_WARMUP_BLOCKS 8
+
+typedef struct
+{
+    std::string name;
+    std::function<void(AudioGraphRef graph)> setup;
+} bench_scenario_t;
+
+void usage()
+{
+    std::cerr << "Usage: signalflow-bench [options]" << std::endl
+              << std::endl
+              << "Options:" << std::endl
+              << "  -b <sizes>      Comma-separated block sizes (default: 64,256,1024)" << std::endl
+              << "  -c <counts>     Comma-separated channel counts for node benchmarks (default: 1,2,8)" << std::endl
+              << "  -d <seconds>    Duration of audio rendered per benchmark (default: 1.0)" << std::endl
+              << "  -f <text>       Only run benchmarks whose name contains this text" << std::endl
+              << "  -o <file>       Write JSON results to a file, rather than stdout" << std::endl
+              << "  -q              Don't print progress" << std::endl;
+}
+
+std::vector<int> parse_list(const std::string &value)
+{
+    std::vector<int> values;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        values.push_back(std::stoi(item));
+    }
+    return values;
+}
+
+AudioGraphRef create_graph(int block_size, int num_channels)
+{
+    AudioGraphConfig config;
+    config.set_block_size(block_size);
+    return new AudioGraph(&config, new AudioOut_Dummy(num_channels));
+}
+
+BufferRef create_test_buffer(int num_channels)
+{
+    BufferRef buffer = new Buffer(num_channels, SIGNALFLOW_DEFAULT_SAMPLE_RATE * 2);
+    for (int channel = 0; channel < num_channels; channel++)
+    {
+        for (int frame = 0; frame < buffer->get_num_frames(); frame++)
+        {
+            buffer->data[channel][frame] = sin(2 * M_PI * frame * 220.0 / SIGNALFLOW_DEFAULT_SAMPLE_RATE);
+        }
+    }
+    return buffer;
+}
+
+/*------------------------------------------------------------------------
+ * Render a single node with its default inputs, widening each constant
+ * input to num_channels channels so that multichannel nodes are
+ * upmixed, and measure its processing time via the graph's profiler.
+ * Unconnected inputs are fed with a sine wave. Only the node's own
+ * processing is timed, not that of its inputs. Nodes that can't be
+ * created or rendered this way (such as FFT operations, which need an
+ * FFT input at construction) are reported with an error.
+ *-----------------------------------------------------------------------*/
+Json bench_node(const std::string &name, int block_size, int num_channels, double duration)
+{
+    AudioGraphRef graph = create_graph(block_size, num_channels);
+    graph->set_profiling_enabled(true);
+
+    NodeRef node = NodeRegistry::global()->create(name);
+    NodeRef source = new SineOscillator(std::vector<float>(num_channels, 220.0));
+    for (auto input : node->inputs)
+    {
+        Constant *constant = dynamic_cast<Constant *>(input.second->get());
+        if (!*input.second)
+        {
+            node->set_input(input.first, source);
+        }
+        else if (constant && num_channels > 1)
+        {
+            node->set_input(input.first, NodeRef(std::vector<float>(num_channels, constant->value)));
+        }
+    }
+    for (auto buffer : node->buffers)
+    {
+        if (!*buffer.second)
+        {
+            node->set_buffer(buffer.first, create_test_buffer(num_channels));
+        }
+    }
+    graph->play(node);
+
+    for (int block = 0; block < SIGNALFLOW_BENCH_WARMUP_BLOCKS; block++)
+    {
+        graph->render(block_size);
+    }
+    graph->reset_profile();
+
+    int num_blocks = std::max(1, (int) (duration * graph->get_sample_rate() / block_size));
+    for (int block = 0; block < num_blocks; block++)
+    {
+        graph->render(block_size);
+    }
+
+    /*------------------------------------------------------------------------
+     * A node whose output is known to be silent is never processed, and
+     * so records no blocks. A node that was never scheduled has no profile.
+     *-----------------------------------------------------------------------*/
+    NodeProfileStats stats;
+    NodeProfile *profile = node->get_profile();
+    if (profile)
+    {
+        stats = profile->get_stats(name);
+    }
+    int num_output_channels = std::max(1, node->get_num_output_channels());
+    double ns_per_sample = stats.num_blocks ? stats.mean * 1e9 / (block_size * num_output_channels) : 0.0;
+
+    return Json::object {
+        { "name", name },
+        { "block_size", block_size },
+        { "num_channels", num_output_channels },
+        { "num_blocks", (int) stats.num_blocks },
+        { "ns_per_sample", ns_per_sample },
+        { "mean", stats.mean },
+        { "p99", stats.p99 },
+        { "max", stats.max },
+    };
+}
+
+/*------------------------------------------------------------------------
+ * Render a whole graph and measure its wall-clock throughput.
+ *-----------------------------------------------------------------------*/
+Json bench_scenario(const bench_scenario_t &scenario, int block_size, double duration)
+{
+    int num_channels = 2;
+    AudioGraphRef graph = create_graph(block_size, num_channels);
+    scenario.setup(graph);
+
+    for (int block = 0; block < SIGNALFLOW_BENCH_WARMUP_BLOCKS; block++)
+    {
+        graph->render(block_size);
+    }
+
+    int num_blocks = std::max(1, (int) (duration * graph->get_sample_rate() / block_size));
+    double t0 = signalflow_timestamp();
+    for (int block = 0; block < num_blocks; block++)
+    {
+        graph->render(block_size);
+    }
+    double elapsed = signalflow_timestamp() - t0;
+    AudioGraphTelemetryStats telemetry = graph->get_telemetry();
+    int node_count = graph->get_node_count();
+    long num_frames = (long) num_blocks * block_size;
+
+    return Json::object {
+        { "name", scenario.name },
+        { "block_size", block_size },
+        { "num_channels", num_channels },
+        { "num_blocks", num_blocks },
+        { "node_count", node_count },
+        { "ns_per_frame", elapsed * 1e9 / num_frames },
+        { "realtime_factor", (double) num_frames / graph->get_sample_rate() / elapsed },
+        { "max_load", telemetry.max_load },
+    };
+}
+
+std::vector<bench_scenario_t> get_scenarios()
+{
+    std::vector<bench_scenario_t> scenarios;
+
+    scenarios.push_back({ "sine-voices-1000", [](AudioGraphRef graph) {
+                             for (int voice = 0; voice < 1000; voice++)
+                             {
+                                 graph->play(NodeRef(new SineOscillator(110 + voice)) * 0.001);
+                             }
+                         } });
+
+    scenarios.push_back({ "fft-chain", [](AudioGraphRef graph) {
+                             NodeRef noise = new WhiteNoise();
+                             NodeRef fft = new FFT(noise, 1024, 256);
+                             NodeRef lpf = new FFTLPF(fft, 1000);
+                             NodeRef ifft = new IFFT(lpf);
+                             graph->play(ifft);
+                         } });
+
+    /*------------------------------------------------------------------------
+     * Grains of 0.5s triggered at 1kHz, so 500 grains sound at once.
+     *-----------------------------------------------------------------------*/
+    scenarios.push_back({ "granulator-500-grains", [](AudioGraphRef graph) {
+                             NodeRef clock = new Impulse(1000);
+                             NodeRef pos = new SineLFO(0.5, 0.0, 1.0);
+                             NodeRef granulator = new Granulator(create_test_buffer(1), clock, pos, 0.5);
+                             graph->play(granulator * 0.002);
+                         } });
+
+    /*------------------------------------------------------------------------
+     * A balanced tree of Add nodes, summing sine leaves, within a single
+     * Patch: one sine and one Add per leaf, not counting constant inputs.
+     *-----------------------------------------------------------------------*/
+    scenarios.push_back({ "patch-tree-10000", [](AudioGraphRef graph) {
+                             PatchRef patch = new Patch();
+                             int num_leaves = 10000 / 2;
+                             std::vector<NodeRef> level;
+                             for (int leaf = 0; leaf < num_leaves; leaf++)
+                             {
+                                 level.push_back(patch->add_node(new SineOscillator(110 + leaf)));
+                             }
+                             while (level.size() > 1)
+                             {
+                                 std::vector<NodeRef> next;
+                                 for (size_t index = 0; index + 1 < level.size(); index += 2)
+                                 {
+                                     next.push_back(patch->add_node(level[index] + level[index + 1]));
+                                 }
+                                 if (level.size() % 2)
+                                 {
+                                     next.push_back(level.back());
+                                 }
+                                 level = next;
+                             }
+                             patch->set_output(patch->add_node(level[0] * (1.0 / num_leaves)));
+                             graph->play(patch);
+                         } });
+
+    return scenarios;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<int> block_sizes = { 64, 256, 1024 };
+    std::vector<int> channel_counts = { 1, 2, 8 };
+    double duration = 1.0;
+    std::string filter;
+    std::string output_filename;
+    bool quiet = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-q")
+        {
+            quiet = true;
+        }
+        else if ((arg == "-b" || arg == "-c" || arg == "-d" || arg == "-f" || arg == "-o") && i + 1 < argc)
+        {
+            std::string value = argv[++i];
+            if (arg == "-b")
+                block_sizes = parse_list(value);
+            else if (arg == "-c")
+                channel_counts = parse_list(value);
+            else if (arg == "-d")
+                duration = std::stod(value);
+            else if (arg == "-f")
+                filter = value;
+            else
+                output_filename = value;
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    Json::array nodes;
+    Json::array scenarios;
+
+    try
+    {
+        for (auto name : NodeRegistry::global()->get_node_names())
+        {
+            if (excluded_node_names.count(name) || name.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+            for (int block_size : block_sizes)
+            {
+                for (int num_channels : channel_counts)
+                {
+                    if (!quiet)
+                    {
+                        fprintf(stderr, "\r\033[K%s (%d frames, %d channels)", name.c_str(), block_size, num_channels);
+                    }
+                    try
+                    {
+                        nodes.push_back(bench_node(name, block_size, num_channels, duration));
+                    }
+                    catch (const std::exception &e)
+                    {
+                        nodes.push_back(Json::object {
+                            { "name", name },
+                            { "block_size", block_size },
+                            { "num_channels", num_channels },
+                            { "error", e.what() },
+                        });
+                    }
+                }
+            }
+        }
+
+        for (auto scenario : get_scenarios())
+        {
+            if (scenario.name.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+            for (int block_size : block_sizes)
+            {
+                if (!quiet)
+                {
+                    fprintf(stderr, "\r\033[K%s (%d frames)", scenario.name.c_str(), block_size);
+                }
+                scenarios.push_back(bench_scenario(scenario, block_size, duration));
+            }
+        }
+        if (!quiet)
+        {
+            fprintf(stderr, "\r\033[K");
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "signalflow-bench: " << e.what() << std::endl;
+        return 1;
+    }
+
+    Json results = Json::object {
+        { "version", SIGNALFLOW_VERSION },
+        { "sample_rate", SIGNALFLOW_DEFAULT_SAMPLE_RATE },
+        { "duration", duration },
+        { "nodes", nodes },
+        { "scenarios", scenarios },
+    };
+
+    if (output_filename.empty())
+    {
+        std::cout << results.dump() << std::endl;
+    }
+    else
+    {
+        std::ofstream output(output_filename);
+        output << results.dump() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*------------------------------------------------------------------------
+ * signalflow-render
+ *
+ * Renders a PatchSpec, described in JSON, to a sound file, as fast as
+ * the CPU allows and without an audio device.
+ *
+ * Usage: signalflow-render [options] <patch.json> <output-file>
+ *-----------------------------------------------------------------------*/
+
+#include <signalflow/signalflow.h>
+
+#include <iostream>
+#include <stdio.h>
+#include <string>
+
+/*------------------------------------------------------------------------
+ * The longest that a patch is rendered for when no duration is given,
+ * in case it never finishes.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_RENDER_DEFAULT_MAX_DURATION 600
+
+using namespace signalflow;
+
+void usage()
+{
+    std::cerr << "Usage: signalflow-render [options] <patch.json> <output-file>" << std::endl
+              << std::endl
+              << "Options:" << std::endl
+              << "  -d <seconds>    Duration to render. If omitted, renders until the patch finishes," << std::endl
+              << "                  for at most " << SIGNALFLOW_RENDER_DEFAULT_MAX_DURATION << " seconds." << std::endl
+              << "  -r <rate>       Sample rate, in Hz (default: " << SIGNALFLOW_DEFAULT_SAMPLE_RATE << ")" << std::endl
+              << "  -c <channels>   Number of output channels (default: 2)" << std::endl
+              << "  -f <format>     Sample format: float32, pcm16, pcm24 or flac (default: float32)" << std::endl
+              << "  -b <frames>     Block size, a power of two, or 0 for auto (default: 0)" << std::endl
+              << "  -q              Don't print progress" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    double duration = 0;
+    int sample_rate = SIGNALFLOW_DEFAULT_SAMPLE_RATE;
+    int num_channels = 2;
+    int block_size = 0;
+    bool quiet = false;
+    signalflow_recording_format_t format = SIGNALFLOW_RECORDING_FORMAT_FLOAT32;
+    std::vector<std::string> filenames;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "-q")
+        {
+            quiet = true;
+        }
+        else if ((arg == "-d" || arg == "-r" || arg == "-c" || arg == "-f" || arg == "-b") && i + 1 < argc)
+        {
+            std::string value = argv[++i];
+            if (arg == "-d")
+                duration = std::stod(value);
+            else if (arg == "-r")
+                sample_rate = std::stoi(value);
+            else if (arg == "-c")
+                num_channels = std::stoi(value);
+            else if (arg == "-b")
+                block_size = std::stoi(value);
+            else if (value == "float32")
+                format = SIGNALFLOW_RECORDING_FORMAT_FLOAT32;
+            else if (value == "pcm16")
+                format = SIGNALFLOW_RECORDING_FORMAT_PCM16;
+            else if (value == "pcm24")
+                format = SIGNALFLOW_RECORDING_FORMAT_PCM24;
+            else if (value == "flac")
+                format = SIGNALFLOW_RECORDING_FORMAT_FLAC;
+            else
+            {
+                std::cerr << "Unknown format: " << value << std::endl;
+                return 1;
+            }
+        }
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            usage();
+            return 1;
+        }
+        else
+        {
+            filenames.push_back(arg);
+        }
+    }
+
+    if (filenames.size() != 2)
+    {
+        usage();
+        return 1;
+    }
+
+    try
+    {
+        /*------------------------------------------------------------------------
+         * Render without an audio device, via a dummy output.
+         *-----------------------------------------------------------------------*/
+        AudioGraphConfig config;
+        config.set_block_size(block_size);
+        AudioGraphRef graph = new AudioGraph(&config, new AudioOut_Dummy(num_channels));
+        graph->set_sample_rate(sample_rate);
+
+        /*------------------------------------------------------------------------
+         * The patch frees itself once finished, which ends the render if no
+         * duration is given. Not every patch finishes, so the render is also
+         * limited to a maximum duration.
+         *-----------------------------------------------------------------------*/
+        PatchSpecRef spec = new PatchSpec(filenames[0]);
+        PatchRef patch = new Patch(spec);
+        patch->set_auto_free(true);
+        graph->play(patch);
+
+        signalflow_offline_progress_callback_t progress = nullptr;
+        if (!quiet)
+        {
+            progress = [](double seconds_rendered, double realtime_factor) {
+                fprintf(stderr, "\rRendered %.1fs (%.1fx realtime)", seconds_rendered, realtime_factor);
+            };
+        }
+
+        double seconds_rendered = graph->render_to_file(filenames[1], duration, num_channels, format, progress,
+                                                        SIGNALFLOW_RENDER_DEFAULT_MAX_DURATION);
+        if (!quiet)
+        {
+            fprintf(stderr, "\n");
+        }
+        if (duration == 0 && seconds_rendered >= SIGNALFLOW_RENDER_DEFAULT_MAX_DURATION)
+        {
+            std::cerr << "signalflow-render: Warning: Patch didn't finish within " << SIGNALFLOW_RENDER_DEFAULT_MAX_DURATION
+                      << " seconds, so was stopped. Use -d to set the duration." << std::endl;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "signalflow-render: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
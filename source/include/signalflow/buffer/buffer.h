@@ -10,6 +10,7 @@
 #include "signalflow/core/constants.h"
 #include "signalflow/core/util.h"
 
+#include <atomic>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -22,6 +23,16 @@
 #define SIGNALFLOW_BUFFER_LINEAR_DECAY "linear-decay"
 #define SIGNALFLOW_BUFFER_TRIANGLE "triangle"
 
+/*-------------------------------------------------------------------------
+ * States of a page of a paged buffer (see StreamingBuffer).
+ * READ_AHEAD marks a resident page whose first read requests the pages
+ * that follow it.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_BUFFER_PAGE_ABSENT 0
+#define SIGNALFLOW_BUFFER_PAGE_REQUESTED 1
+#define SIGNALFLOW_BUFFER_PAGE_RESIDENT 2
+#define SIGNALFLOW_BUFFER_PAGE_READ_AHEAD 3
+
 namespace signalflow
 {
 
@@ -96,6 +107,13 @@ public:
       *------------------------------------------------------------------------*/
     void resize(int num_channels, int num_frames);
 
+    /**------------------------------------------------------------------------
+      * Exchange the buffer's sample storage and dimensions with those of
+      * `other`, without allocating.
+      *
+      *------------------------------------------------------------------------*/
+    void swap_storage(Buffer &other);
+
     /**------------------------------------------------------------------------
      * Load the contents of `filename` into the buffer.
      * If the buffer is smaller than the file's contents, only the first
@@ -273,6 +291,32 @@ protected:
     float duration;
 
     signalflow_interpolation_mode_t interpolate;
+
+    /*-------------------------------------------------------------------------
+     * Buffers whose storage is paged in from disk set page_states to an
+     * array of one state per page of (1 << page_shift) frames. get_frame()
+     * returns silence for frames whose page is not resident, rather than
+     * blocking, and calls request_page() to have it paged in.
+     *
+     * If page_last_read is set, each read of a resident page stamps it with
+     * the current value of page_clock, so that the least recently read pages
+     * can be found and released.
+     *-----------------------------------------------------------------------*/
+    std::atomic<uint8_t> *page_states = nullptr;
+    std::atomic<uint32_t> *page_last_read = nullptr;
+    int page_shift = 0;
+    static std::atomic<uint32_t> page_clock;
+    virtual void request_page(int page);
+
+    /*-------------------------------------------------------------------------
+     * Returns the path of the audio file `filename`, looking in
+     * SIGNALFLOW_USER_DIR/audio if it isn't found relative to the working
+     * directory.
+     *-----------------------------------------------------------------------*/
+    static std::string resolve_path(std::string filename);
+
+private:
+    bool is_frame_resident(int frame);
 };
 
 /**-------------------------------------------------------------------------
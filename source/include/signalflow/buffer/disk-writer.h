@@ -0,0 +1,123 @@
+#pragma once
+
+/**--------------------------------------------------------------------------------
+ * @file disk-writer.h
+ * @brief DiskWriter streams audio to a sound file. Blocks are passed from the
+ *        audio thread to a background writer thread via a lock-free ring
+ *        buffer, so that the audio thread never performs file I/O.
+ *
+ *--------------------------------------------------------------------------------*/
+
+#include "signalflow/core/constants.h"
+#include "signalflow/core/spsc-ringbuffer.h"
+
+#include <sndfile.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace signalflow
+{
+
+class DiskWriter
+{
+public:
+    /**--------------------------------------------------------------------------------
+     * Open a sound file for writing, and start the writer thread.
+     * Throws if the file cannot be opened.
+     *
+     * @param filename The file to write to.
+     * @param num_channels The number of channels to write.
+     * @param sample_rate The sample rate of the file, in Hz.
+     * @param format The sample format. WAV is used for all formats except FLAC.
+     * @param buffer_duration The duration of audio that can be buffered while
+     *                        waiting for the disk, in seconds.
+     *
+     *--------------------------------------------------------------------------------*/
+    DiskWriter(const std::string &filename,
+               int num_channels,
+               int sample_rate,
+               signalflow_recording_format_t format = SIGNALFLOW_RECORDING_FORMAT_FLOAT32,
+               float buffer_duration = SIGNALFLOW_DISK_WRITER_BUFFER_DURATION);
+
+    /**--------------------------------------------------------------------------------
+     * Close the file, writing any audio still buffered.
+     *
+     *--------------------------------------------------------------------------------*/
+    ~DiskWriter();
+
+    /**--------------------------------------------------------------------------------
+     * Queue a block of audio to be written. Real-time safe: never blocks,
+     * allocates, or touches the disk. If the ring buffer does not have space
+     * for the whole block, the block is dropped and counted as an overflow.
+     * Must only be called from a single thread at a time.
+     *
+     * @param channels Pointers to one buffer per channel, of at least
+     *                 num_channels channels.
+     * @param num_frames The number of frames in each buffer.
+     * @param wait If true, wait for the writer thread to make space rather than
+     *             dropping audio. Not real-time safe; for use when rendering
+     *             offline, where the producer may outpace the disk.
+     *
+     *--------------------------------------------------------------------------------*/
+    void write(sample *const *channels, int num_frames, bool wait = false);
+
+    /**--------------------------------------------------------------------------------
+     * Stop the writer thread, write any audio still buffered, and close the
+     * file. Subsequent calls to write() are ignored. Must not be called
+     * concurrently with write().
+     *
+     *--------------------------------------------------------------------------------*/
+    void close();
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of channels being written.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_num_channels();
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of blocks dropped because the ring buffer was full.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_overflow_count();
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of frames dropped because the ring buffer was full.
+     *
+     *--------------------------------------------------------------------------------*/
+    long get_frames_dropped();
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of frames written to the file so far.
+     *
+     *--------------------------------------------------------------------------------*/
+    long get_frames_written();
+
+private:
+    void run_thread();
+    void drain();
+
+    SNDFILE *file;
+    int num_channels;
+    SPSCRingBuffer<sample> ring;
+
+    /*--------------------------------------------------------------------------------
+     * Interleaved scratch space for each side of the ring: the audio thread
+     * interleaves into input_buffer, and the writer thread reads into
+     * output_buffer.
+     *-------------------------------------------------------------------------------*/
+    std::vector<sample> input_buffer;
+    std::vector<sample> output_buffer;
+
+    std::atomic<bool> running;
+    std::atomic<bool> closed;
+    std::atomic<int> overflow_count;
+    std::atomic<long> frames_dropped;
+    std::atomic<long> frames_written;
+    std::thread thread;
+};
+
+}
@@ -2,7 +2,10 @@
 
 /**--------------------------------------------------------------------------------
  * @file ringbuffer.h
- * @brief RingBuffer is a single-producer, single-consumer ringbuffer.
+ * @brief RingBuffer is a circular buffer of the most recent values appended
+ *        to it, read with linear interpolation, for use as a delay line.
+ *        It is not thread-safe: to pass samples between threads, use
+ *        SPSCRingBuffer.
  *
  *--------------------------------------------------------------------------------*/
 
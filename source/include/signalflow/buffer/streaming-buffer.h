@@ -0,0 +1,152 @@
+#pragma once
+
+/**--------------------------------------------------------------------------------
+ * @file streaming-buffer.h
+ * @brief StreamingBuffer is a Buffer whose samples are memory-mapped from a
+ *        raw float cache of an audio file, and paged in from disk by a
+ *        background thread as they are played.
+ *
+ *--------------------------------------------------------------------------------*/
+
+#include "signalflow/buffer/buffer.h"
+
+#include <memory>
+#include <string>
+
+/*--------------------------------------------------------------------------------
+ * Each page holds (1 << SIGNALFLOW_STREAMING_BUFFER_PAGE_SHIFT) frames,
+ * in every channel.
+ *-------------------------------------------------------------------------------*/
+#define SIGNALFLOW_STREAMING_BUFFER_PAGE_SHIFT 16
+
+/*--------------------------------------------------------------------------------
+ * The number of pages requested ahead of the page being read.
+ *-------------------------------------------------------------------------------*/
+#define SIGNALFLOW_STREAMING_BUFFER_READ_AHEAD_PAGES 4
+
+/*--------------------------------------------------------------------------------
+ * The duration, in seconds, that is kept resident from the start of the
+ * file, so that playback can start instantly.
+ *-------------------------------------------------------------------------------*/
+#define SIGNALFLOW_STREAMING_BUFFER_DEFAULT_PRELOAD_DURATION 0.5
+
+/*--------------------------------------------------------------------------------
+ * The total size of pages that are paged in across all StreamingBuffers,
+ * excluding preloaded pages, above which the least recently read pages
+ * are released. Pages being read, and those within their read-ahead, are
+ * never released.
+ *-------------------------------------------------------------------------------*/
+#define SIGNALFLOW_STREAMING_BUFFER_MAX_RESIDENT_BYTES (1024L * 1024 * 1024)
+
+/*--------------------------------------------------------------------------------
+ * The time, in seconds, between a page being released and its memory being
+ * discarded. Must be longer than the duration of a block, so that the audio
+ * thread never reads a page whose memory is being discarded.
+ *-------------------------------------------------------------------------------*/
+#define SIGNALFLOW_STREAMING_BUFFER_RELEASE_DELAY 0.1
+
+namespace signalflow
+{
+
+class StreamingBuffer : public Buffer
+{
+public:
+    /**------------------------------------------------------------------------
+     * Open the audio file `filename` for streaming.
+     *
+     * On first use, the file is decoded into a raw float cache file in
+     * `cache_dir`, which is then memory-mapped. This can take some time for
+     * a large file, but later StreamingBuffers of the same (unmodified) file
+     * reuse the cache, and open immediately.
+     *
+     * The buffer's data can be read like that of any other Buffer. Reads
+     * through get() and get_frame() never block: frames that have not been
+     * paged in yet read as silence, and are paged in by a background thread,
+     * along with the pages that follow. Direct access to `data` is not
+     * paged, and so may block on disk.
+     *
+     * Writes to the buffer's data are not saved to the cache, and are lost
+     * when their page is released.
+     *
+     * @param filename The filename to read. Must be of a type supported by
+     *                 libsndfile.
+     * @param preload_duration The duration from the start of the file, in
+     *                         seconds, to page in before returning, and keep
+     *                         resident.
+     * @param cache_dir The directory to store cache files in. Defaults to
+     *                  SIGNALFLOW_USER_DIR/cache.
+     *
+     *------------------------------------------------------------------------*/
+    StreamingBuffer(std::string filename,
+                    float preload_duration = SIGNALFLOW_STREAMING_BUFFER_DEFAULT_PRELOAD_DURATION,
+                    std::string cache_dir = "");
+
+    /**------------------------------------------------------------------------
+     * Unmap the cache file. The cache file itself is kept for reuse.
+     *
+     *------------------------------------------------------------------------*/
+    virtual ~StreamingBuffer();
+
+    /**------------------------------------------------------------------------
+     * @returns The path of the raw float cache file.
+     *
+     *------------------------------------------------------------------------*/
+    std::string get_cache_path();
+
+    /**------------------------------------------------------------------------
+     * @returns The number of frames per page.
+     *
+     *------------------------------------------------------------------------*/
+    int get_page_size();
+
+    /**------------------------------------------------------------------------
+     * @returns The number of pages.
+     *
+     *------------------------------------------------------------------------*/
+    int get_num_pages();
+
+    /**------------------------------------------------------------------------
+     * @returns The number of pages that are currently resident, including
+     *          preloaded pages.
+     *
+     *------------------------------------------------------------------------*/
+    int get_num_resident_pages();
+
+    /**------------------------------------------------------------------------
+     * @param frame A frame index.
+     * @returns true if the page containing `frame` is resident, and so can
+     *          be read without blocking.
+     *
+     *------------------------------------------------------------------------*/
+    bool get_frame_is_resident(int frame);
+
+    /**------------------------------------------------------------------------
+     * @returns The number of pages that have been requested because a read
+     *          found them absent, which will have read as silence.
+     *
+     *------------------------------------------------------------------------*/
+    long get_page_miss_count();
+
+protected:
+    virtual void request_page(int page) override;
+
+private:
+    friend class StreamingBufferPager;
+
+    void create_cache(std::string path, std::string cache_path);
+    void load_page(int page);
+    void release_page(int page);
+    void discard_page(int page);
+
+    std::string cache_path;
+    size_t map_size;
+    int num_pages;
+    int num_preloaded_pages;
+    std::unique_ptr<std::atomic<uint8_t>[]> pages;
+    std::unique_ptr<std::atomic<uint32_t>[]> page_reads;
+    std::atomic<long> page_miss_count;
+};
+
+typedef BufferRefTemplate<StreamingBuffer> StreamingBufferRef;
+
+}
@@ -6,6 +6,8 @@
  *
  *--------------------------------------------------------------------------------*/
 
+#include "signalflow/core/constants.h"
+
 #include <string>
 
 namespace signalflow
@@ -73,6 +75,28 @@ public:
      *--------------------------------------------------------------------------------*/
     void set_output_buffer_size(unsigned int buffer_size);
 
+    /**--------------------------------------------------------------------------------
+     * Get the block size that the graph renders in, in frames.
+     * To query the actual block size, use AudioGraph::get_block_size().
+     *
+     * @returns The block size, or 0 if not set.
+     *
+     *--------------------------------------------------------------------------------*/
+    unsigned int get_block_size() const;
+
+    /**--------------------------------------------------------------------------------
+     * Set the block size that the graph renders in. Audio device callbacks of
+     * any size are served from a FIFO of fixed-size blocks, so that nodes are
+     * always processed with the same number of frames. Must be a power of two,
+     * no larger than SIGNALFLOW_NODE_BUFFER_SIZE. This must be set before the
+     * AudioGraph is created.
+     *
+     * @param block_size The block size, or 0 to use the largest power of two
+     *                   that fits within the output buffer size.
+     *
+     *--------------------------------------------------------------------------------*/
+    void set_block_size(unsigned int block_size);
+
     /**--------------------------------------------------------------------------------
      * Get the name of the audio hardware device to use for input.
      *
@@ -109,6 +133,67 @@ public:
      *--------------------------------------------------------------------------------*/
     void set_output_device_name(const std::string &name);
 
+    /**--------------------------------------------------------------------------------
+     * Get the number of threads used to render the graph.
+     *
+     * @returns The thread count. 0 or 1 indicates single-threaded rendering.
+     *
+     *--------------------------------------------------------------------------------*/
+    unsigned int get_render_thread_count() const;
+
+    /**--------------------------------------------------------------------------------
+     * Set the number of threads used to render the graph, including the audio
+     * I/O thread. When greater than 1, independent subgraphs (for example, each
+     * Patch that is playing) are rendered in parallel by a pool of real-time
+     * worker threads. This must be set before the AudioGraph is created.
+     *
+     * @param count The thread count, or 0 for single-threaded rendering.
+     *
+     *--------------------------------------------------------------------------------*/
+    void set_render_thread_count(unsigned int count);
+
+    /**--------------------------------------------------------------------------------
+     * Get the number of blocks that are rendered ahead of the audio device.
+     *
+     * @returns The number of blocks. 0 indicates that blocks are rendered within
+     *          the device's audio callback.
+     *
+     *--------------------------------------------------------------------------------*/
+    unsigned int get_render_ahead_blocks() const;
+
+    /**--------------------------------------------------------------------------------
+     * Set the number of blocks that are rendered ahead of the audio device.
+     * When non-zero, the graph is rendered on a dedicated real-time thread, which
+     * keeps this many blocks ready in a lock-free ring, and the device callback
+     * only copies frames from the ring. This adds up to count * block_size frames
+     * of latency, in exchange for tolerating render times that occasionally
+     * exceed a block. Takes effect the next time the AudioGraph is started.
+     *
+     * @param count The number of blocks, or 0 to render within the callback.
+     *
+     *--------------------------------------------------------------------------------*/
+    void set_render_ahead_blocks(unsigned int count);
+
+    /**--------------------------------------------------------------------------------
+     * Get the planner effort used to create FFT plans.
+     *
+     * @returns The planner effort.
+     *
+     *--------------------------------------------------------------------------------*/
+    signalflow_fft_planner_effort_t get_fft_planner_effort() const;
+
+    /**--------------------------------------------------------------------------------
+     * Set the planner effort used to create FFT plans (FFTW only).
+     * MEASURE and PATIENT produce faster transforms but can take seconds to plan
+     * the first time a transform size is used. The results are saved as FFTW
+     * wisdom in ~/.signalflow/fftw-wisdom so that later runs can reuse them.
+     * Affects FFT nodes created after the AudioGraph.
+     *
+     * @param effort The planner effort.
+     *
+     *--------------------------------------------------------------------------------*/
+    void set_fft_planner_effort(signalflow_fft_planner_effort_t effort);
+
     /**--------------------------------------------------------------------------------
      * Print the current config to stdout.
      *
@@ -119,8 +204,12 @@ private:
     unsigned int sample_rate = 0;
     unsigned int input_buffer_size = 0;
     unsigned int output_buffer_size = 0;
+    unsigned int block_size = 0;
     std::string input_device_name;
     std::string output_device_name;
+    unsigned int render_thread_count = 0;
+    unsigned int render_ahead_blocks = 0;
+    signalflow_fft_planner_effort_t fft_planner_effort = SIGNALFLOW_FFT_PLANNER_ESTIMATE;
 };
 
 } /* namespace signalflow */
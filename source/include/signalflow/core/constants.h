@@ -26,11 +26,6 @@ typedef RingBuffer<sample> SampleRingBuffer;
  *-----------------------------------------------------------------------*/
 #define SIGNALFLOW_MAX_CHANNELS 32
 
-/*------------------------------------------------------------------------
- * Initial number of output buffers to allocate per node
- *-----------------------------------------------------------------------*/
-#define SIGNALFLOW_NODE_INITIAL_OUTPUT_BUFFERS 32
-
 /*------------------------------------------------------------------------
  * Max supported number of FFT bins.
  *-----------------------------------------------------------------------*/
@@ -40,6 +35,15 @@ typedef RingBuffer<sample> SampleRingBuffer;
 #define SIGNALFLOW_DEFAULT_FFT_WINDOW_SIZE 0
 #define SIGNALFLOW_DEFAULT_FFT_DO_WINDOW true
 
+/*------------------------------------------------------------------------
+ * Partitioned convolution (FFTConvolve): the number of impulse response
+ * partitions convolved on the audio thread, and the number of partitions
+ * in each block of the tail, which is computed ahead on a background
+ * thread.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_FFT_CONVOLVE_HEAD_PARTITIONS 4
+#define SIGNALFLOW_FFT_CONVOLVE_TAIL_BLOCK_PARTITIONS 16
+
 /*------------------------------------------------------------------------
  * Default sample block size unless otherwise specified.
  *-----------------------------------------------------------------------*/
@@ -51,12 +55,62 @@ typedef RingBuffer<sample> SampleRingBuffer;
 #define SIGNALFLOW_DEFAULT_BLOCK_SIZE 256
 
 /*------------------------------------------------------------------------
- * The default size of a node's output buffer, in samples.
- * Needed because nodes such as AudioOut may be instantiated before the
- * audio hardware's sample rate is known.
+ * The maximum number of frames that the graph can render in one block.
+ * Node output buffers are initially allocated at the graph's block size
+ * (or this size, if smaller), and grown on demand if a larger block is
+ * rendered.
  *-----------------------------------------------------------------------*/
 #define SIGNALFLOW_NODE_BUFFER_SIZE 2048
 
+/*------------------------------------------------------------------------
+ * Capacity of the AudioGraph's command queue: the maximum number of
+ * structural changes (play, stop, set_input, etc) that can be pending
+ * between successive audio blocks. Must be a power of two.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_GRAPH_COMMAND_QUEUE_SIZE 4096
+
+/*------------------------------------------------------------------------
+ * Maximum number of events scheduled for a future frame (with
+ * AudioGraph::set_input_at, trigger_at, etc) that can be pending at
+ * once.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_GRAPH_EVENT_QUEUE_SIZE 1024
+
+/*------------------------------------------------------------------------
+ * Capacity of the AudioGraph's reclaim queue: the maximum number of
+ * objects released by the audio thread that can be awaiting destruction
+ * on the reclaim thread. Must be a power of two.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_GRAPH_RECLAIM_QUEUE_SIZE 16384
+
+/*------------------------------------------------------------------------
+ * Capacity of the AudioGraph's telemetry ring: the maximum number of
+ * block records that can be awaiting aggregation on the telemetry
+ * thread. Records submitted while the ring is full are dropped and
+ * counted.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_GRAPH_TELEMETRY_QUEUE_SIZE 1024
+
+/*------------------------------------------------------------------------
+ * Duration of audio, in seconds, that can be buffered between the audio
+ * thread and the disk writer thread when recording. If the disk stalls
+ * for longer than this, blocks are dropped and counted as overflows.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_DISK_WRITER_BUFFER_DURATION 2.0
+
+/*------------------------------------------------------------------------
+ * Audio input drift compensation. AudioIn resamples its input by a ratio
+ * that tracks the smoothed fill level of its ring, so that the input and
+ * output clocks may differ slightly without the ring over- or underrunning.
+ *  - DRIFT_SMOOTHING: the coefficient of the one-pole filter applied to
+ *    the fill level, per block
+ *  - DRIFT_GAIN: the change in ratio per unit of relative fill error
+ *  - MAX_DRIFT: the maximum deviation of the ratio from nominal
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_AUDIO_IN_DRIFT_SMOOTHING 0.05
+#define SIGNALFLOW_AUDIO_IN_DRIFT_GAIN 0.02
+#define SIGNALFLOW_AUDIO_IN_MAX_DRIFT 0.01
+
 /*------------------------------------------------------------------------
  * The default trigger name, used when node->trigger() is called
  * without any parameters.
@@ -129,6 +183,43 @@ enum signalflow_interpolation_mode_t : unsigned int
     SIGNALFLOW_INTERPOLATION_COSINE
 };
 
+/**------------------------------------------------------------------------
+ * Planner effort used when creating FFTW plans. Higher levels take
+ * longer to plan but produce faster transforms. Plans are cached, and
+ * saved to FFTW wisdom under ~/.signalflow, so the cost of planning is
+ * only paid once per transform size.
+ *------------------------------------------------------------------------*/
+enum signalflow_fft_planner_effort_t : unsigned int
+{
+    SIGNALFLOW_FFT_PLANNER_ESTIMATE,
+    SIGNALFLOW_FFT_PLANNER_MEASURE,
+    SIGNALFLOW_FFT_PLANNER_PATIENT
+};
+
+/**------------------------------------------------------------------------
+ * Sample format used when recording to disk. FLAC files are written
+ * with 24-bit samples.
+ *------------------------------------------------------------------------*/
+enum signalflow_recording_format_t : unsigned int
+{
+    SIGNALFLOW_RECORDING_FORMAT_FLOAT32,
+    SIGNALFLOW_RECORDING_FORMAT_PCM16,
+    SIGNALFLOW_RECORDING_FORMAT_PCM24,
+    SIGNALFLOW_RECORDING_FORMAT_FLAC
+};
+
+/**------------------------------------------------------------------------
+ * Policy used by a VoicePool when a voice is requested but all voices are
+ * sounding: refuse the request, or reuse the voice started least or most
+ * recently.
+ *------------------------------------------------------------------------*/
+enum signalflow_voice_steal_policy_t : unsigned int
+{
+    SIGNALFLOW_VOICE_STEAL_NONE,
+    SIGNALFLOW_VOICE_STEAL_OLDEST,
+    SIGNALFLOW_VOICE_STEAL_NEWEST
+};
+
 enum signalflow_event_distribution_t : unsigned int
 {
     SIGNALFLOW_EVENT_DISTRIBUTION_UNIFORM,
@@ -0,0 +1,66 @@
+#pragma once
+
+/**--------------------------------------------------------------------------------
+ * @file graph-reclaimer.h
+ * @brief AudioGraphReclaimer frees objects released by the audio thread, on a
+ *        low-priority background thread.
+ *
+ *--------------------------------------------------------------------------------*/
+
+#include "signalflow/core/lockfree-queue.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace signalflow
+{
+
+class AudioGraphReclaimer
+{
+public:
+    /**--------------------------------------------------------------------------------
+     * Create a reclaimer and start its background thread.
+     *
+     * @param capacity The maximum number of objects awaiting reclamation.
+     *                 Must be a power of two.
+     *
+     *--------------------------------------------------------------------------------*/
+    AudioGraphReclaimer(int capacity);
+
+    /**--------------------------------------------------------------------------------
+     * Stop the background thread, and free any objects still awaiting reclamation.
+     *
+     *--------------------------------------------------------------------------------*/
+    ~AudioGraphReclaimer();
+
+    /**--------------------------------------------------------------------------------
+     * Hand over a reference to an object (typically a Node, Patch or Buffer).
+     * If this is the last reference, the object is destroyed on the background
+     * thread rather than the caller's. Safe to call from any thread, and does
+     * not block or allocate.
+     *
+     * If the queue is full, the reference is instead released immediately.
+     *
+     * @param object The reference to release. Any shared_ptr can be passed.
+     *
+     *--------------------------------------------------------------------------------*/
+    void release(std::shared_ptr<void> object);
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of references that were released immediately, on the
+     *         caller's thread, because the queue was full.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_overflow_count();
+
+private:
+    void run_thread();
+    void reclaim();
+
+    LockFreeQueue<std::shared_ptr<void>> garbage;
+    std::atomic<bool> running;
+    std::thread thread;
+};
+
+}
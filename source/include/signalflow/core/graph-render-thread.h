@@ -0,0 +1,110 @@
+#pragma once
+
+/**--------------------------------------------------------------------------------
+ * @file graph-render-thread.h
+ * @brief AudioGraphRenderThread renders an AudioGraph ahead of the audio device,
+ *        on a dedicated real-time thread, into a lock-free ring of interleaved
+ *        frames that the device callback copies from.
+ *
+ *--------------------------------------------------------------------------------*/
+
+#include "signalflow/core/constants.h"
+#include "signalflow/core/spsc-ringbuffer.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#else
+#include <semaphore.h>
+#endif
+
+namespace signalflow
+{
+
+class AudioGraph;
+
+class AudioGraphRenderThread
+{
+public:
+    /**--------------------------------------------------------------------------------
+     * Create a render thread. The thread is not started until start() is called.
+     *
+     * @param graph The graph to render.
+     * @param num_blocks The number of blocks to keep rendered ahead of the device.
+     * @param num_channels The number of channels to render.
+     *
+     *--------------------------------------------------------------------------------*/
+    AudioGraphRenderThread(AudioGraph *graph, int num_blocks, int num_channels);
+
+    /**--------------------------------------------------------------------------------
+     * Stop the thread, if it is running.
+     *
+     *--------------------------------------------------------------------------------*/
+    ~AudioGraphRenderThread();
+
+    /**--------------------------------------------------------------------------------
+     * Fill the ring, and then start the thread, so that the device's first
+     * callback has audio ready.
+     *
+     *--------------------------------------------------------------------------------*/
+    void start();
+
+    /**--------------------------------------------------------------------------------
+     * Stop the thread, and wait for the block that it is rendering to finish.
+     * Frames remaining in the ring are discarded.
+     *
+     *--------------------------------------------------------------------------------*/
+    void stop();
+
+    /**--------------------------------------------------------------------------------
+     * Copy the next frames from the ring, and wake the thread to render more.
+     * Real-time safe: never blocks or allocates. If not enough frames have been
+     * rendered, the remainder is filled with silence and an underrun is counted.
+     * Must only be called from one thread at a time (typically the device's
+     * audio callback).
+     *
+     * @param output An interleaved buffer of num_frames * num_channels samples.
+     * @param num_frames The number of frames to read.
+     *
+     *--------------------------------------------------------------------------------*/
+    void read(sample *output, int num_frames);
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of frames rendered and not yet read.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_buffered_frames();
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of reads that found too few frames in the ring.
+     *
+     *--------------------------------------------------------------------------------*/
+    long get_underrun_count();
+
+    int get_num_channels();
+
+private:
+    void run_thread();
+    void render_blocks();
+    void wake();
+    void wait();
+
+    AudioGraph *graph;
+    int num_channels;
+    int block_size;
+    SPSCRingBuffer<sample> ring;
+    std::vector<sample> block;
+    std::atomic<bool> running;
+    std::thread thread;
+
+#ifdef __APPLE__
+    dispatch_semaphore_t semaphore;
+#else
+    sem_t semaphore;
+#endif
+};
+
+}
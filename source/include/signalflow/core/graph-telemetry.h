@@ -0,0 +1,135 @@
+#pragma once
+
+/**--------------------------------------------------------------------------------
+ * @file graph-telemetry.h
+ * @brief AudioGraphTelemetry collects timing records from each block rendered
+ *        by the audio thread, via a lock-free ring, and aggregates them into
+ *        health counters on a background thread.
+ *
+ *--------------------------------------------------------------------------------*/
+
+#include "signalflow/core/spsc-ringbuffer.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*------------------------------------------------------------------------
+ * Number of buckets in the load histogram. Each bucket spans 10% of the
+ * block's deadline; the final bucket counts every block that overran.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_TELEMETRY_HISTOGRAM_SIZE 11
+
+/*------------------------------------------------------------------------
+ * Blocks that use more than this proportion of their deadline are counted
+ * as late, even if they don't overrun.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_TELEMETRY_LATE_THRESHOLD 0.75
+
+namespace signalflow
+{
+
+/*------------------------------------------------------------------------
+ * A record of a single rendered block. Times are in seconds.
+ *  - timestamp: when rendering started
+ *  - render_duration: how long rendering took
+ *  - deadline: the duration of audio rendered, which rendering must not
+ *    exceed if the device is to be kept fed
+ *-----------------------------------------------------------------------*/
+typedef struct
+{
+    double timestamp;
+    double render_duration;
+    double deadline;
+    int num_frames;
+    int node_count;
+    int patch_count;
+} signalflow_block_telemetry_t;
+
+/**--------------------------------------------------------------------------------
+ * Counters aggregated from block records, since the graph was created or
+ * telemetry was last reset.
+ *  - xrun_count: blocks whose render duration exceeded their deadline
+ *  - late_count: blocks that used more than SIGNALFLOW_TELEMETRY_LATE_THRESHOLD
+ *    of their deadline (including xruns)
+ *  - max_render_duration: the longest render duration, in seconds
+ *  - max_load: the highest ratio of render duration to deadline
+ *  - histogram: the number of blocks in each 10% band of load
+ *  - dropped_count: records lost because the ring was full
+ *
+ *--------------------------------------------------------------------------------*/
+class AudioGraphTelemetryStats
+{
+public:
+    long block_count = 0;
+    long xrun_count = 0;
+    long late_count = 0;
+    double max_render_duration = 0.0;
+    double max_load = 0.0;
+    double last_timestamp = 0.0;
+    std::vector<long> histogram = std::vector<long>(SIGNALFLOW_TELEMETRY_HISTOGRAM_SIZE);
+    long dropped_count = 0;
+};
+
+class AudioGraphTelemetry
+{
+public:
+    /**--------------------------------------------------------------------------------
+     * Create a telemetry collector and start its background thread.
+     *
+     * @param capacity The maximum number of block records awaiting aggregation.
+     *
+     *--------------------------------------------------------------------------------*/
+    AudioGraphTelemetry(int capacity);
+
+    /**--------------------------------------------------------------------------------
+     * Stop the background thread.
+     *
+     *--------------------------------------------------------------------------------*/
+    ~AudioGraphTelemetry();
+
+    /**--------------------------------------------------------------------------------
+     * Submit the record of a rendered block. Real-time safe: never blocks or
+     * allocates. If the ring is full, the record is dropped and counted.
+     * Must only be called from one thread at a time.
+     *
+     * @param block The block record.
+     *
+     *--------------------------------------------------------------------------------*/
+    void record(const signalflow_block_telemetry_t &block);
+
+    /**--------------------------------------------------------------------------------
+     * Get the aggregated counters, including any records not yet aggregated by
+     * the background thread.
+     *
+     * @return The counters.
+     *
+     *--------------------------------------------------------------------------------*/
+    AudioGraphTelemetryStats get_stats();
+
+    /**--------------------------------------------------------------------------------
+     * Reset the aggregated counters to zero.
+     *
+     *--------------------------------------------------------------------------------*/
+    void reset();
+
+private:
+    void run_thread();
+    void aggregate();
+
+    SPSCRingBuffer<signalflow_block_telemetry_t> ring;
+    std::atomic<long> dropped_count;
+
+    /*--------------------------------------------------------------------------------
+     * The ring's consumer side is shared by the background thread and
+     * get_stats(), so is serialised by this mutex, which also guards stats.
+     *-------------------------------------------------------------------------------*/
+    std::mutex mutex;
+    AudioGraphTelemetryStats stats;
+
+    std::atomic<bool> running;
+    std::thread thread;
+};
+
+}
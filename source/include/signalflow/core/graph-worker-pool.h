@@ -0,0 +1,109 @@
+#pragma once
+
+/**--------------------------------------------------------------------------------
+ * @file graph-worker-pool.h
+ * @brief AudioGraphWorkerPool is a pool of real-time worker threads used to
+ *        render independent subgraphs of an AudioGraph in parallel.
+ *
+ *--------------------------------------------------------------------------------*/
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#else
+#include <semaphore.h>
+#endif
+
+namespace signalflow
+{
+
+class AudioGraph;
+
+class AudioGraphWorkerPool
+{
+public:
+    /**--------------------------------------------------------------------------------
+     * Create a worker pool.
+     *
+     * @param graph The graph whose render tasks are to be executed.
+     * @param num_threads The total number of threads that render each block,
+     *                    including the thread that calls run(). num_threads - 1
+     *                    worker threads are created.
+     *
+     *--------------------------------------------------------------------------------*/
+    AudioGraphWorkerPool(AudioGraph *graph, int num_threads);
+    ~AudioGraphWorkerPool();
+
+    /**--------------------------------------------------------------------------------
+     * Distribute a set of tasks between the pool's threads.
+     * Tasks should be ordered by decreasing cost, so that the largest tasks are
+     * dealt out first. Must not be called concurrently with run().
+     *
+     * @param num_tasks The number of tasks.
+     *
+     *--------------------------------------------------------------------------------*/
+    void set_task_count(int num_tasks);
+
+    /**--------------------------------------------------------------------------------
+     * Render every task, calling AudioGraph::render_task for each.
+     * The calling thread participates in rendering, and this method returns once
+     * all tasks have completed. If any task throws, the exception is rethrown here.
+     *
+     * @param num_frames The number of frames to render.
+     *
+     *--------------------------------------------------------------------------------*/
+    void run(int num_frames);
+
+    /**--------------------------------------------------------------------------------
+     * Get the total number of rendering threads, including the caller of run().
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_num_threads();
+
+private:
+    /*--------------------------------------------------------------------------------
+     * Each thread owns a queue of task indices. The owner and any thieves both
+     * claim tasks by incrementing `next`, so a queue is simply drained from the
+     * front by whichever thread gets there first, without locks.
+     *
+     * Tasks are dealt out round-robin, so the queue of thread `t` holds tasks
+     * t, t + num_threads, t + 2 * num_threads, ..., and is computed from
+     * num_tasks rather than stored.
+     *-------------------------------------------------------------------------------*/
+    class TaskQueue
+    {
+    public:
+        std::atomic<int> next;
+    };
+
+    void run_thread(int thread_index);
+    void render_tasks(int thread_index);
+    void wake_workers();
+    void wait_for_work();
+
+    AudioGraph *graph;
+    int num_threads;
+    int num_tasks;
+    int num_frames;
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::atomic<bool> running;
+    std::atomic<int> num_threads_finished;
+
+    std::mutex exception_mutex;
+    std::exception_ptr exception;
+
+#ifdef __APPLE__
+    dispatch_semaphore_t semaphore;
+#else
+    sem_t semaphore;
+#endif
+};
+
+}
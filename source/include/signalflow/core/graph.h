@@ -7,17 +7,148 @@
  *
  *--------------------------------------------------------------------------------*/
 
+#include "signalflow/buffer/disk-writer.h"
 #include "signalflow/core/config.h"
+#include "signalflow/core/graph-telemetry.h"
+#include "signalflow/core/lockfree-queue.h"
 #include "signalflow/node/io/output/abstract.h"
 #include "signalflow/node/node.h"
 #include "signalflow/patch/patch.h"
 
-#include <sndfile.h>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace signalflow
 {
 
 class AudioGraphMonitor;
+class AudioGraphReclaimer;
+class AudioGraphRenderThread;
+class AudioGraphWorkerPool;
+
+/*------------------------------------------------------------------------
+ * A single step of the AudioGraph's flattened render schedule.
+ *  - If upmix_input is null, render `node`.
+ *  - Otherwise, upmix the output of `upmix_input` to the number of input
+ *    channels that `node` expects, before `node` is rendered.
+ *-----------------------------------------------------------------------*/
+typedef struct
+{
+    Node *node;
+    Node *upmix_input;
+} signalflow_render_step_t;
+
+/*------------------------------------------------------------------------
+ * A pool of scratch buffers, allocated on the control thread and handed
+ * to the audio thread, with capacity reserved for the lists that the
+ * audio thread builds from it. `buffers` and `node_capacity` don't change
+ * once the pool is published; each pool holds every buffer of the last.
+ *
+ * The pool also carries empty containers with room for `step_capacity`
+ * schedule steps, whose capacity the audio thread takes over when it
+ * adopts the pool, so that rebuilding the schedule doesn't allocate.
+ * Those used to partition the schedule are only reserved when rendering
+ * in parallel.
+ *-----------------------------------------------------------------------*/
+typedef struct
+{
+    std::vector<sample *> buffers;
+    std::vector<sample *> free_buffers;
+    std::vector<NodeRef> nodes;
+    std::vector<NodeRef> nodes_previous;
+    int node_capacity;
+
+    std::vector<signalflow_render_step_t> schedule;
+    std::vector<std::pair<Node *, bool>> schedule_stack;
+    std::vector<NodeRef> schedule_nodes;
+    std::vector<signalflow_render_step_t> parallel_head;
+    std::vector<signalflow_render_step_t> parallel_steps;
+    std::vector<std::pair<int, int>> parallel_tasks;
+    std::vector<signalflow_render_step_t> parallel_tail;
+    std::vector<Node *> partition_roots;
+    std::vector<Node *> partition_stack;
+    std::vector<int> partition_offsets;
+    int step_capacity;
+} signalflow_scratch_pool_t;
+
+/*------------------------------------------------------------------------
+ * Callbacks used by AudioGraph::render_offline():
+ *  - the block callback receives each block of the output node's buffers
+ *  - the progress callback receives the number of seconds rendered so far,
+ *    and the ratio of audio rendered to wall-clock time elapsed
+ *-----------------------------------------------------------------------*/
+typedef std::function<void(sample **output, int num_frames)> signalflow_offline_block_callback_t;
+typedef std::function<void(double seconds_rendered, double realtime_factor)> signalflow_offline_progress_callback_t;
+
+/*------------------------------------------------------------------------
+ * Changes to the graph's structure that are posted to the audio thread.
+ *-----------------------------------------------------------------------*/
+typedef enum
+{
+    SIGNALFLOW_GRAPH_COMMAND_NONE,
+    SIGNALFLOW_GRAPH_COMMAND_PLAY_NODE,
+    SIGNALFLOW_GRAPH_COMMAND_PLAY_PATCH,
+    SIGNALFLOW_GRAPH_COMMAND_STOP_NODE,
+    SIGNALFLOW_GRAPH_COMMAND_STOP_PATCH,
+    SIGNALFLOW_GRAPH_COMMAND_REPLACE_NODE,
+    SIGNALFLOW_GRAPH_COMMAND_ADD_NODE,
+    SIGNALFLOW_GRAPH_COMMAND_REMOVE_NODE,
+    SIGNALFLOW_GRAPH_COMMAND_SET_INPUT,
+    SIGNALFLOW_GRAPH_COMMAND_ADD_INPUT,
+    SIGNALFLOW_GRAPH_COMMAND_REMOVE_INPUT,
+    SIGNALFLOW_GRAPH_COMMAND_CLEAR,
+    SIGNALFLOW_GRAPH_COMMAND_START_RECORDING,
+    SIGNALFLOW_GRAPH_COMMAND_STOP_RECORDING,
+    SIGNALFLOW_GRAPH_COMMAND_SET_VALUE,
+    SIGNALFLOW_GRAPH_COMMAND_RAMP_VALUE,
+    SIGNALFLOW_GRAPH_COMMAND_TRIGGER,
+    SIGNALFLOW_GRAPH_COMMAND_RESET_PATCH
+} signalflow_graph_command_type_t;
+
+/*------------------------------------------------------------------------
+ * A single command. Which fields are used depends on the command type:
+ * for example, REPLACE_NODE replaces `node` with `other`, and SET_INPUT
+ * sets `node`'s input named `input_name` to `other`, creating the input
+ * if `node` has variable inputs. ADD_INPUT and REMOVE_INPUT add `other`
+ * to or remove it from a node with variable inputs. START_RECORDING
+ * starts passing the graph's output to `recorder`. SET_VALUE and
+ * RAMP_VALUE set the Constant `other` to `value`, the latter over
+ * `duration` seconds, and TRIGGER calls `node`'s trigger `input_name`
+ * with `value`. RESET_PATCH resets the state of `patch`'s nodes.
+ *
+ * If `frame` is set, the command is held by the audio thread until the
+ * graph reaches that frame, and applied at that exact frame within its
+ * block. Otherwise, it is applied at the start of the next block.
+ *
+ * `promise` is fulfilled once the command has been applied, or holds the
+ * exception raised when applying it.
+ *
+ * When SET_INPUT is posted to a running graph, `input_change` holds the
+ * storage that applying it needs, allocated by the posting thread.
+ *-----------------------------------------------------------------------*/
+class AudioGraphCommand
+{
+public:
+    signalflow_graph_command_type_t type = SIGNALFLOW_GRAPH_COMMAND_NONE;
+    NodeRef node = nullptr;
+    NodeRef other = nullptr;
+    PatchRef patch = nullptr;
+    Patch *patch_ptr = nullptr;
+    std::string input_name;
+    float value = 0.0;
+    double duration = 0.0;
+    long frame = -1;
+    std::shared_ptr<DiskWriter> recorder;
+    std::shared_ptr<std::promise<void>> promise;
+    std::shared_ptr<NodeInputChange> input_change;
+};
 
 class AudioGraph
 {
@@ -28,23 +159,82 @@ public:
 
     virtual ~AudioGraph();
 
+    /**--------------------------------------------------------------------------------
+     * Get the graph that new Nodes, Buffers and Patches are attached to: the graph
+     * that is current on the calling thread or, if the thread has none and only
+     * one graph exists, that graph.
+     *
+     * A graph is made current on the thread that creates it. Several graphs can
+     * exist at once, each current on its own thread, so that (for example) a batch
+     * of patches can be rendered offline in parallel. Only one graph can be current
+     * on each thread. While more than one graph exists, other threads must call
+     * make_current() before creating Nodes, Buffers or Patches.
+     *
+     * @return The graph, or null if no graph exists.
+     * @throws std::runtime_error if several graphs exist and none is current on
+     *         the calling thread.
+     *
+     *--------------------------------------------------------------------------------*/
+    static AudioGraph *get_shared_graph();
+
+    /**--------------------------------------------------------------------------------
+     * Make this the current graph on the calling thread, replacing any graph
+     * that was previously current on the thread.
+     *
+     *--------------------------------------------------------------------------------*/
+    void make_current();
+
+    /**--------------------------------------------------------------------------------
+     * Seed the graph's random number generators, which are used by every thread
+     * that renders the graph (including worker and render-ahead threads). Takes
+     * effect at the start of the next block. Called by random_seed() on the
+     * current graph.
+     *
+     * @param seed The seed.
+     *
+     *--------------------------------------------------------------------------------*/
+    void set_random_seed(long seed);
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of graphs that currently exist.
+     *
+     *--------------------------------------------------------------------------------*/
+    static int get_graph_count();
+
     /**--------------------------------------------------------------------------------
      * Begin audio I/O.
      *
+     * Once started, changes to the graph's structure (playing and stopping nodes,
+     * and setting the inputs of nodes that are part of the graph) are no longer
+     * made directly. Instead, they are posted to a lock-free command queue and
+     * applied by the audio thread at the start of the next block, so that the
+     * graph is never modified while it is being rendered.
+     *
      **--------------------------------------------------------------------------------*/
     void start();
 
     /**--------------------------------------------------------------------------------
-     * Stop audio I/O.
+     * Stop audio I/O. Any pending commands are applied before returning.
      *
      *--------------------------------------------------------------------------------*/
     void stop();
 
+    /**--------------------------------------------------------------------------------
+     * Query whether audio I/O is running, rather than the graph being rendered
+     * manually (for example, offline).
+     *
+     * @return true between start() and stop().
+     *
+     *--------------------------------------------------------------------------------*/
+    bool get_is_running();
+
     /**--------------------------------------------------------------------------------
      * Remove all nodes from the graph.
      *
+     * @return A future that is ready once the nodes have been removed.
+     *
      **--------------------------------------------------------------------------------*/
-    void clear();
+    std::future<void> clear();
 
     /**--------------------------------------------------------------------------------
      * Run (and block the main thread) for a given number of seconds, or forever if
@@ -89,8 +279,9 @@ public:
 
     /**--------------------------------------------------------------------------------
      * Render the entire graph.
-     *  - Reset "rendered" flags
-     *  - Perform a recursive render from the output node
+     *  - Apply any pending removals/replacements
+     *  - Rebuild the render schedule, if the graph's topology has changed
+     *  - Render each node in the schedule, in dependency order
      *  - Calculate timing and CPU usage
      *
      * Typically this is called from the audio I/O thread and does not need to be
@@ -101,6 +292,53 @@ public:
      *--------------------------------------------------------------------------------*/
     void render(int num_frames);
 
+    /**--------------------------------------------------------------------------------
+     * Obtain the next frames of output for an audio device callback.
+     *
+     * The graph is always rendered in blocks of get_block_size() frames,
+     * regardless of how many frames the device requests. When the current
+     * block has been consumed, the next block is rendered; otherwise, the
+     * remaining frames of the current block are returned. Callbacks should
+     * call this repeatedly until they have obtained the frames they need.
+     *
+     * The one exception is a block that contains the frame of an event
+     * scheduled with set_input_at() and friends: its nodes are rendered in
+     * shorter sub-blocks, split at the event, so nodes must not assume that
+     * they are always passed get_block_size() frames.
+     *
+     * Typically this is called from the audio I/O thread and does not need to be
+     * called manually.
+     *
+     * @param max_frames The maximum number of frames to return.
+     * @param output Populated with a pointer to the next frame of each channel of
+     *               the output node's buffer. Must have space for
+     *               SIGNALFLOW_MAX_CHANNELS pointers.
+     * @return The number of frames available via `output`, between 1 and
+     *         max_frames.
+     *
+     *--------------------------------------------------------------------------------*/
+    int render_output(int max_frames, sample **output);
+
+    /**--------------------------------------------------------------------------------
+     * Fill an audio device's interleaved output buffer with the next frames of
+     * output, hard-limited to [-1, 1].
+     *
+     * If the config's render_ahead_blocks is non-zero and the graph is running,
+     * frames are copied from blocks already rendered by the render-ahead thread,
+     * so this never renders on the caller's thread. If not enough frames are
+     * ready, the remainder is filled with silence and an underrun is counted.
+     * Otherwise, blocks are rendered as needed, as per render_output().
+     *
+     * Typically this is called from the audio I/O thread and does not need to be
+     * called manually.
+     *
+     * @param output An interleaved buffer with space for num_frames frames of
+     *               the output node's input channels.
+     * @param num_frames The number of frames to fill.
+     *
+     *--------------------------------------------------------------------------------*/
+    void read_output(sample *output, int num_frames);
+
     /**--------------------------------------------------------------------------------
      * Perform a recursive render from the specified node.
      *
@@ -126,10 +364,60 @@ public:
      *--------------------------------------------------------------------------------*/
     void render_to_buffer(BufferRef buffer, int block_size = SIGNALFLOW_DEFAULT_BLOCK_SIZE);
 
+    /**--------------------------------------------------------------------------------
+     * Render the graph offline, as fast as the CPU allows, in blocks of
+     * get_block_size() frames. Rendering happens on the calling thread, so the
+     * graph must not be started. To render without an audio device, create
+     * the graph with an AudioOut_Dummy output.
+     *
+     * Unlike render_to_buffer, output is handed to the callback block by block,
+     * so memory usage does not grow with the duration.
+     *
+     * @param duration The duration to render, in seconds. If zero, render until
+     *                 nothing is left playing (for example, once every Patch
+     *                 has auto-freed).
+     * @param callback Called with the output node's buffers after each block.
+     * @param progress If set, called approximately once per second of wall-clock
+     *                 time, and once when rendering is complete.
+     * @param max_duration If duration is zero, the longest to render for, in
+     *                     seconds, in case something never stops playing.
+     *                     If zero, there is no limit.
+     * @return The duration rendered, in seconds.
+     *
+     *--------------------------------------------------------------------------------*/
+    double render_offline(double duration,
+                          const signalflow_offline_block_callback_t &callback,
+                          const signalflow_offline_progress_callback_t &progress = nullptr,
+                          double max_duration = 0);
+
+    /**--------------------------------------------------------------------------------
+     * Render the graph offline to a sound file, as with render_offline().
+     * Audio is streamed to disk by a background writer thread, which the
+     * renderer waits for if the disk falls behind, so no audio is dropped.
+     *
+     * @param filename The file to write to.
+     * @param duration The duration to render, in seconds, or zero to render until
+     *                 nothing is left playing.
+     * @param num_channels The number of channels to write, or 0 to write all of
+     *                     the output's channels.
+     * @param format The sample format.
+     * @param progress If set, called as with render_offline().
+     * @param max_duration If duration is zero, the longest to render for, as
+     *                     with render_offline().
+     * @return The duration rendered, in seconds.
+     *
+     *--------------------------------------------------------------------------------*/
+    double render_to_file(const std::string &filename,
+                          double duration = 0,
+                          int num_channels = 0,
+                          signalflow_recording_format_t format = SIGNALFLOW_RECORDING_FORMAT_FLOAT32,
+                          const signalflow_offline_progress_callback_t &progress = nullptr,
+                          double max_duration = 0);
+
     /**--------------------------------------------------------------------------------
      * Reset the audio graph:
-     *  - do garbage collection on any nodes/patches that are scheduled to be removed
-     *  - clear rendered flags across the whole graph
+     *  - apply any pending commands (play, stop, replace, set_input, etc)
+     *  - rebuild the render schedule if the graph's topology has changed
      *
      * This is done automatically in each call to render() so does not typically
      * need to be called manually.
@@ -137,6 +425,17 @@ public:
      *--------------------------------------------------------------------------------*/
     void reset_graph();
 
+    /**--------------------------------------------------------------------------------
+     * Mark the render schedule as stale, so that it is rebuilt from the current
+     * graph topology at the start of the next render() call.
+     *
+     * This is called automatically whenever a node's inputs are connected or
+     * disconnected, and when nodes are played, stopped, replaced, added or
+     * removed, so does not typically need to be called manually.
+     *
+     *--------------------------------------------------------------------------------*/
+    void invalidate_schedule();
+
     /**--------------------------------------------------------------------------------
      * Clear the rendered flag across nodes beneath the specified root.
      * Does not typically need to be called manually.
@@ -180,78 +479,268 @@ public:
      * Remove a node from the graph's playback schedule.
      *
      * @param node The node.
+     * @return A future that is ready once the node has been removed.
      *
      *--------------------------------------------------------------------------------*/
-    void remove_node(NodeRef node);
+    std::future<void> remove_node(NodeRef node);
 
     /**--------------------------------------------------------------------------------
      * Begin playing the specified node, by connecting it to the graph's output.
      * This can also be written as node->connect(graph->get_output()).
      *
      * @param node The node to begin playing.
+     * @return A future that is ready once the node is connected.
      *
      *--------------------------------------------------------------------------------*/
-    void play(NodeRef node);
+    std::future<void> play(NodeRef node);
 
     /**--------------------------------------------------------------------------------
      * Begin playing the specified patch, by connecting it to the graph's output.
      * This can also be written as patch->connect(graph->get_output()).
      *
      * @param patch The patch to begin playing.
+     * @return A future that is ready once the patch is connected.
      *
      *--------------------------------------------------------------------------------*/
-    void play(PatchRef patch);
+    std::future<void> play(PatchRef patch);
 
     /**--------------------------------------------------------------------------------
      * Disconnect a node from the graph's output.
+     * The node is always disconnected at the start of the next block, including
+     * when called from the audio thread.
      *
      * @param node The node to stop.
+     * @return A future that is ready once the node is disconnected.
      *
      *--------------------------------------------------------------------------------*/
-    void stop(NodeRef node);
+    std::future<void> stop(NodeRef node);
 
     /**--------------------------------------------------------------------------------
-     * Replace the specified node with another.
+     * Replace the specified node with another, at the start of the next block.
      *
      * @param node The node to stop.
      * @param other The replacement node.
+     * @return A future that is ready once the node has been replaced.
      *
      *--------------------------------------------------------------------------------*/
-    void replace(NodeRef node, NodeRef other);
+    std::future<void> replace(NodeRef node, NodeRef other);
 
     /**--------------------------------------------------------------------------------
-     * Disconnect a patch from the graph's output.
+     * Disconnect a patch from the graph's output, at the start of the next block.
      *
      * @param patch The patch to stop.
+     * @return A future that is ready once the patch is disconnected.
      *
      *--------------------------------------------------------------------------------*/
-    void stop(Patch *patch);
+    std::future<void> stop(Patch *patch);
 
     /**--------------------------------------------------------------------------------
-     * Disconnect a patch from the graph's output.
+     * Disconnect a patch from the graph's output, at the start of the next block.
      *
      * @param patch The patch to stop.
+     * @return A future that is ready once the patch is disconnected.
+     *
+     *--------------------------------------------------------------------------------*/
+    std::future<void> stop(PatchRef patch);
+
+    /**--------------------------------------------------------------------------------
+     * Set the input of a node. If the node is part of a running graph, the
+     * change is applied at the start of the next block. This is called
+     * automatically by Node::set_input, so does not typically need to be
+     * called manually.
+     *
+     * @param node The node whose input to set.
+     * @param name The name of the input.
+     * @param input The new input node.
+     * @return A future that is ready once the input has been set.
+     *
+     *--------------------------------------------------------------------------------*/
+    std::future<void> set_input(NodeRef node, std::string name, NodeRef input);
+
+    /**--------------------------------------------------------------------------------
+     * Add an input to, or remove an input from, a node with variable inputs
+     * (such as Sum). If the node is part of a running graph, the change is
+     * applied at the start of the next block. These are called automatically
+     * by the node's add_input and remove_input, so do not typically need to be
+     * called manually.
+     *
+     * @param node The node whose inputs to change.
+     * @param input The input node to add or remove.
+     * @return A future that is ready once the input has been added or removed.
+     *
+     *--------------------------------------------------------------------------------*/
+    std::future<void> add_input(NodeRef node, NodeRef input);
+    std::future<void> remove_input(NodeRef node, NodeRef input);
+
+    /**--------------------------------------------------------------------------------
+     * Schedule events to happen at an exact frame, as counted by
+     * get_frame_position(). The block that contains the frame is split at that
+     * point, so the event takes effect on that frame regardless of the block
+     * or device buffer size. This means that the graph's nodes render that
+     * block as two or more sub-blocks of fewer than get_block_size() frames,
+     * though the output is still returned a whole block at a time. Events
+     * whose frame has already passed happen at
+     * the start of the next block. To schedule an event at a wall-clock time,
+     * convert it with get_frame_at_time().
+     *
+     * set_input_at and ramp_input_at set an input whose value is a constant,
+     * jumping to the new value or ramping linearly to it over `duration`
+     * seconds. They throw if the input is not a constant.
+     *
+     * @return A future that is ready once the event has happened.
      *
      *--------------------------------------------------------------------------------*/
-    void stop(PatchRef patch);
+    std::future<void> set_input_at(NodeRef node, std::string name, float value, long frame);
+    std::future<void> ramp_input_at(NodeRef node, std::string name, float value, double duration, long frame);
+    std::future<void> trigger_at(NodeRef node, std::string name, float value, long frame);
+    std::future<void> play_at(PatchRef patch, long frame);
+    std::future<void> stop_at(PatchRef patch, long frame);
 
     /**--------------------------------------------------------------------------------
-     * Start recording the graph's output to a named file.
+     * Set the value of a Constant node, or reset the state of a patch's nodes.
+     * While the graph is running, the change is posted to the audio thread and
+     * applied at the start of the next block, in order with other commands.
+     * Otherwise, it is applied immediately. Can be called from the audio thread.
+     *
+     * @return A future that is ready once the change has been applied.
+     *
+     *--------------------------------------------------------------------------------*/
+    std::future<void> set_constant_value(NodeRef constant, float value);
+    std::future<void> reset_patch(PatchRef patch);
+
+    /**--------------------------------------------------------------------------------
+     * As set_constant_value() and reset_patch(), but without a future, so that
+     * neither posting nor applying the change allocates. If the command queue
+     * is full, the change is dropped, and counted by
+     * get_command_queue_overflow_count().
+     *
+     *--------------------------------------------------------------------------------*/
+    void post_constant_value(NodeRef constant, float value);
+    void post_reset_patch(PatchRef patch);
+
+    /**--------------------------------------------------------------------------------
+     * Get the number of frames rendered since the graph was created, which is
+     * the frame at which the next block will begin.
+     *
+     * @return The frame position.
+     *
+     *--------------------------------------------------------------------------------*/
+    long get_frame_position();
+
+    /**--------------------------------------------------------------------------------
+     * Estimate the frame that will be rendered at a given wall-clock time,
+     * based upon the time at which the most recent block was rendered.
+     *
+     * @param timestamp A time, as returned by signalflow_timestamp().
+     * @return The estimated frame.
+     *
+     *--------------------------------------------------------------------------------*/
+    long get_frame_at_time(double timestamp);
+
+    /**--------------------------------------------------------------------------------
+     * Query whether changes to the graph's nodes are currently posted to the
+     * command queue, rather than being made immediately.
+     *
+     * @return true if the graph is running and the caller is not applying
+     *         queued commands.
+     *
+     *--------------------------------------------------------------------------------*/
+    bool get_is_queueing_commands();
+
+    /**--------------------------------------------------------------------------------
+     * Query the number of commands that have been rejected because the command
+     * queue was full. A rejected command's future holds an exception.
+     *
+     * @return The number of rejected commands.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_command_queue_overflow_count();
+
+    /**--------------------------------------------------------------------------------
+     * Query the number of objects whose destruction could not be deferred to the
+     * reclaim thread, because its queue was full, and so were destroyed on the
+     * audio thread.
+     *
+     * @return The number of objects destroyed on the audio thread.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_reclaim_overflow_count();
+
+    /**--------------------------------------------------------------------------------
+     * Query the number of stop() and replace() commands whose node wasn't
+     * playing, and so had no effect.
+     *
+     * @return The number of nodes not found.
+     *
+     *--------------------------------------------------------------------------------*/
+    long get_missing_node_count();
+
+    /**--------------------------------------------------------------------------------
+     * Query the timing health of the audio thread: how many blocks have been
+     * rendered, how many overran their deadline (xruns) or came close to it,
+     * and the worst-case render time, since the graph was created or
+     * telemetry was last reset.
+     *
+     * @return The telemetry counters.
+     *
+     *--------------------------------------------------------------------------------*/
+    AudioGraphTelemetryStats get_telemetry();
+
+    /**--------------------------------------------------------------------------------
+     * Reset the telemetry counters to zero.
+     *
+     *--------------------------------------------------------------------------------*/
+    void reset_telemetry();
+
+    /**--------------------------------------------------------------------------------
+     * Start recording the graph's output to a named file. The audio thread
+     * passes each block to a background writer thread, which performs all
+     * file I/O. If already recording, the current recording is stopped first.
      *
      * @param filename The file to write to.
      * @param num_channels The number of channels to record. If not specified,
      *                     uses the same number of channels as the graph's
      *                     output device.
+     * @param format The sample format to record in.
      *
      *--------------------------------------------------------------------------------*/
-    void start_recording(const std::string &filename, int num_channels = 0);
+    void start_recording(const std::string &filename,
+                         int num_channels = 0,
+                         signalflow_recording_format_t format = SIGNALFLOW_RECORDING_FORMAT_FLOAT32);
 
     /**--------------------------------------------------------------------------------
-     * Stop recording the graph's output.
+     * Stop recording the graph's output. Returns once all buffered audio has
+     * been written and the file has been closed.
      *
      *--------------------------------------------------------------------------------*/
     void stop_recording();
 
+    /**--------------------------------------------------------------------------------
+     * Returns the number of blocks dropped from the current recording, because
+     * the writer thread could not keep up with the audio thread.
+     *
+     * @return The number of blocks dropped, or 0 if not recording.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_recording_overflow_count();
+
+    /**--------------------------------------------------------------------------------
+     * Returns the number of device callbacks that found too few frames rendered
+     * ahead, and so output silence, since the graph was last started.
+     *
+     * @return The number of underruns, or 0 if render-ahead has not been used.
+     *
+     *--------------------------------------------------------------------------------*/
+    long get_render_ahead_underrun_count();
+
+    /**--------------------------------------------------------------------------------
+     * Returns the number of frames rendered ahead and waiting to be output.
+     *
+     * @return The number of frames, or 0 if render-ahead is not in use.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_render_ahead_buffered_frames();
+
     /**--------------------------------------------------------------------------------
      * Get audio sample rate.
      *
@@ -281,6 +770,16 @@ public:
      *--------------------------------------------------------------------------------*/
     int get_output_buffer_size();
 
+    /**--------------------------------------------------------------------------------
+     * Get the block size that the graph renders in when driven by the audio
+     * hardware. To query the requested block size, call
+     * graph.config.get_block_size()
+     *
+     * @return The block size, in frames.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_block_size();
+
     /**--------------------------------------------------------------------------------
      * Query the number of nodes in the audio graph.
      * This includes all of the nodes in every patch.
@@ -290,6 +789,17 @@ public:
      *--------------------------------------------------------------------------------*/
     int get_node_count();
 
+    /**--------------------------------------------------------------------------------
+     * Query the number of scratch buffers allocated by the graph. The outputs of
+     * intermediate nodes are written to a pool of scratch buffers, which are
+     * reused once each output has been read. Each scratch buffer holds one
+     * channel of audio.
+     *
+     * @return The number of scratch buffers.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_scratch_buffer_count();
+
     /**--------------------------------------------------------------------------------
       * Query the number of patches in the audio graph.
       *
@@ -307,6 +817,47 @@ public:
       *--------------------------------------------------------------------------------*/
     float get_cpu_usage();
 
+    /**--------------------------------------------------------------------------------
+     * Enable or disable per-node profiling. While enabled, the time taken to
+     * process each node is recorded in every block. While disabled, the only
+     * cost is a single branch per node.
+     *
+     * @param enabled Whether to profile.
+     *
+     *--------------------------------------------------------------------------------*/
+    void set_profiling_enabled(bool enabled);
+
+    /**--------------------------------------------------------------------------------
+     * @return true if per-node profiling is enabled.
+     *
+     *--------------------------------------------------------------------------------*/
+    bool get_profiling_enabled();
+
+    /**--------------------------------------------------------------------------------
+     * Summarise the processing time of each node connected to the graph, and of
+     * each class of node, since profiling was enabled or last reset.
+     *
+     * @return The profile.
+     *
+     *--------------------------------------------------------------------------------*/
+    AudioGraphProfile get_profile();
+
+    /**--------------------------------------------------------------------------------
+     * Clear the recorded timings of each node connected to the graph.
+     *
+     *--------------------------------------------------------------------------------*/
+    void reset_profile();
+
+    /**--------------------------------------------------------------------------------
+     * Get the profiled nodes connected to the graph. While the graph is running,
+     * these are read from a snapshot taken by the audio thread when the render
+     * order was last rebuilt, so that this is safe to call at any time.
+     *
+     * @return The nodes.
+     *
+     *--------------------------------------------------------------------------------*/
+    std::vector<NodeRef> get_profiled_nodes();
+
     /**--------------------------------------------------------------------------------
       * Get the current graph config.
       *
@@ -317,25 +868,258 @@ public:
 
 private:
     std::set<NodeRef> scheduled_nodes;
-    std::set<NodeRef> nodes_to_remove;
-    std::set<std::pair<NodeRef, NodeRef>> nodes_to_replace;
-    std::set<PatchRef> patches;
-    std::set<Patch *> patches_to_remove;
+    std::vector<PatchRef> patches;
+
+    /*--------------------------------------------------------------------------------
+     * Structural changes are posted to `commands` by any thread, and applied
+     * in order by the audio thread in reset_graph(). The queue's storage is
+     * preallocated, so neither posting nor applying blocks or allocates.
+     *
+     * Commands are only queued while the graph is running: otherwise, nothing
+     * else can be accessing the graph, so changes are applied immediately.
+     * The exceptions are stop() and replace(), which are always deferred to
+     * the next block (as they are typically triggered mid-render, when a
+     * Patch auto-frees).
+     *
+     * When a node is played (or connected to a node that is playing), it and
+     * its inputs are marked as owned by the audio thread; subsequent changes
+     * to their inputs are then posted to the queue by Node::set_input.
+     *
+     * post_command_without_result and apply_command_without_result attach no
+     * promise to the command, so don't allocate.
+     *-------------------------------------------------------------------------------*/
+    std::future<void> post_command(AudioGraphCommand &command);
+    std::future<void> apply_command(AudioGraphCommand &command);
+    void post_command_without_result(AudioGraphCommand &command);
+    void apply_command_without_result(AudioGraphCommand &command);
+    void apply_command_unchecked(AudioGraphCommand &command);
+    void apply_pending_commands();
+    void complete_command(AudioGraphCommand &command);
+    void claim_subgraph(Node *root);
+    LockFreeQueue<AudioGraphCommand> commands;
+
+    /*--------------------------------------------------------------------------------
+     * Commands scheduled for a future frame, held by the audio thread in
+     * order of frame. Its capacity is reserved up front, so inserting doesn't
+     * allocate. A block that contains one or more of these frames is rendered
+     * in sub-blocks split at each, which are assembled in event_buffer.
+     *-------------------------------------------------------------------------------*/
+    void render_schedule(int num_frames);
+    std::vector<AudioGraphCommand> timed_commands;
+    std::vector<sample> event_buffer;
+    std::atomic<long> frame_position;
+    std::atomic<double> frame_position_time;
+    std::atomic<bool> is_running;
+
+    /*--------------------------------------------------------------------------------
+     * Applying a command can drop the last reference to a node or patch (for
+     * example, when a Patch auto-frees). Rather than running its destructor
+     * on the audio thread, each reference held by a command is handed to the
+     * reclaimer once the command is applied, which frees it on a background
+     * thread.
+     *-------------------------------------------------------------------------------*/
+    void release(std::shared_ptr<void> object);
+    AudioGraphReclaimer *reclaimer;
+
+    /*--------------------------------------------------------------------------------
+     * Each rendered block submits a timing record to the telemetry ring,
+     * which is aggregated into counters on a background thread, so that
+     * overruns can be monitored without blocking the audio thread.
+     *-------------------------------------------------------------------------------*/
+    AudioGraphTelemetry *telemetry;
+
+    /*--------------------------------------------------------------------------------
+     * When render-ahead is enabled, the thread that renders blocks ahead of the
+     * audio device while the graph is running.
+     *-------------------------------------------------------------------------------*/
+    AudioGraphRenderThread *render_thread;
 
     void show_structure(NodeRef &root, int depth);
+
+    /*--------------------------------------------------------------------------------
+     * Duplicate the output channels of input_node to match the number of input
+     * channels expected by node, if needed.
+     *-------------------------------------------------------------------------------*/
+    void upmix(Node *input_node, Node *node, int num_frames);
+
+    /*--------------------------------------------------------------------------------
+     * The render schedule is a flat list of nodes (and upmix operations) in
+     * topological order, so that each node is rendered after all of its inputs.
+     * It holds raw pointers: every node in the schedule is kept alive by the
+     * graph's own references, and any change to those references invalidates
+     * the schedule before the next render.
+     *
+     * The schedule is rebuilt on the audio thread. To avoid allocating there,
+     * the working state of a rebuild is kept in the graph's member containers,
+     * which are cleared rather than reconstructed, and in fields of each node
+     * stamped with schedule_generation. Their capacity is reserved on the
+     * control thread with the scratch pool (see below), from the number of
+     * steps in the last schedule plus those of the nodes claimed since.
+     *-------------------------------------------------------------------------------*/
+    void rebuild_schedule();
+    void schedule_subgraph(Node *root);
+    bool get_is_scheduled(Node *node);
+    void render_steps(const signalflow_render_step_t *steps, int num_steps, int num_frames);
+    std::vector<signalflow_render_step_t> schedule;
+    std::vector<std::pair<Node *, bool>> schedule_stack;
+    unsigned long schedule_generation = 0;
+    std::atomic<int> schedule_steps_needed { 0 };
+    std::atomic<unsigned long> schedule_generation_built { 0 };
+    int schedule_steps_claimed = 0;
+    unsigned long schedule_steps_claimed_generation = 0;
+    std::atomic<bool> schedule_invalid;
+
+    /*--------------------------------------------------------------------------------
+     * One random number generator per rendering thread: index 0 for the thread
+     * that calls render(), and one for each other worker thread. A new seed is
+     * applied by the audio thread at the start of the next block.
+     *-------------------------------------------------------------------------------*/
+    std::vector<std::mt19937> random_generators;
+    std::atomic<long> random_seed_value;
+    std::atomic<bool> random_seed_changed;
+
+    /*--------------------------------------------------------------------------------
+     * Before each block, find the nodes whose output will be silent, which
+     * are not processed, and the nodes whose output is then not needed by
+     * any node that is processed, which are skipped altogether.
+     *
+     * Skipping unneeded nodes relies on every consumer preceding its inputs
+     * when the schedule is walked backwards, so is disabled if the graph
+     * contains a cycle.
+     *-------------------------------------------------------------------------------*/
+    void mark_silent_nodes();
+    bool schedule_has_cycle = false;
+
+    /*--------------------------------------------------------------------------------
+     * Parallel rendering (when config.render_thread_count > 1).
+     *
+     * The schedule is split into three phases:
+     *  - head: nodes that feed into more than one root (i.e., more than one
+     *    input of the output node, or more than one scheduled node), which
+     *    are rendered first on the audio thread
+     *  - tasks: the nodes that belong exclusively to each root, which are
+     *    rendered concurrently by the worker pool
+     *  - tail: the output node, which mixes the results once all tasks
+     *    have joined
+     *
+     * The steps of every task are stored contiguously in parallel_steps, and
+     * parallel_tasks holds the [begin, end) range of each, largest first.
+     *-------------------------------------------------------------------------------*/
+    friend class AudioGraphWorkerPool;
+    void partition_schedule();
+    void render_task(int task_index, int num_frames);
+    AudioGraphWorkerPool *worker_pool;
+    std::vector<signalflow_render_step_t> parallel_head;
+    std::vector<signalflow_render_step_t> parallel_steps;
+    std::vector<std::pair<int, int>> parallel_tasks;
+    int parallel_task_count = 0;
+    std::vector<signalflow_render_step_t> parallel_tail;
+    std::vector<Node *> partition_roots;
+    std::vector<Node *> partition_stack;
+    std::vector<int> partition_offsets;
+    unsigned long partition_generation = 0;
+
+    /*--------------------------------------------------------------------------------
+     * Scratch buffers.
+     *
+     * Once the schedule is built, the lifetime of each node's output is known:
+     * it is written when the node is rendered, and last read by its final
+     * consumer. Nodes whose lifetimes don't overlap share the same scratch
+     * buffers, so the memory touched during a render is proportional to the
+     * width of the graph rather than its size.
+     *
+     * Nodes are pinned to their own output buffers if they are observed from
+     * outside of the render (the output node, scheduled nodes, and any node
+     * with get_output_buffer_pinned()), if they never write their output
+     * (writes_output is false), or if they are read in a later block via a
+     * cyclic connection. Scratch buffers are not used when rendering in
+     * parallel.
+     *
+     * Buffers are allocated on the control thread, when nodes are claimed by
+     * claim_subgraph(), which estimates how many more the new nodes need. Each
+     * reservation publishes a new pool to scratch_pool_published, which the
+     * audio thread adopts when it next assigns buffers, so that it only ever
+     * assigns pointers. If the pool turns out to be too small, the remaining
+     * nodes keep their own output buffers, and the shortfall is included in
+     * scratch_buffers_needed, so that the next reservation covers it.
+     *
+     * scratch_pools holds every pool that the audio thread may still be
+     * using, newest last. Those older than scratch_pool_adopted are deleted
+     * by the control thread, under scratch_pool_mutex.
+     *
+     * Each reservation also covers the schedule: schedule_steps_claimed
+     * counts the steps of nodes claimed since the audio thread last built
+     * the schedule, whose size it records in schedule_steps_needed. If the
+     * schedule still outgrows the reservation, it is grown on the audio
+     * thread, and the next reservation covers it.
+     *-------------------------------------------------------------------------------*/
+    void adopt_scratch_pool();
+    void assign_scratch_buffers();
+    bool assign_scratch_buffers_from_pool();
+    bool get_can_use_scratch_buffer(Node *node);
+    void reserve_scratch_buffers(int num_buffers, int num_nodes, int num_steps);
+    void estimate_scratch_buffers(Node *root,
+                                  const std::vector<Node *> &claimed,
+                                  int &num_buffers,
+                                  int &num_nodes);
+    signalflow_scratch_pool_t *scratch_pool = nullptr;
+    std::vector<std::unique_ptr<signalflow_scratch_pool_t>> scratch_pools;
+    std::atomic<signalflow_scratch_pool_t *> scratch_pool_published { nullptr };
+    std::atomic<signalflow_scratch_pool_t *> scratch_pool_adopted { nullptr };
+    std::atomic<int> scratch_buffers_needed { 0 };
+    std::atomic<int> scratch_nodes_needed { 0 };
+    std::mutex scratch_pool_mutex;
+
     AudioGraphMonitor *monitor;
     int sample_rate;
+
+    /*--------------------------------------------------------------------------------
+     * The fixed block size used by render_output(), and the number of frames
+     * of the current block that have already been returned. A block is only
+     * rendered in sub-blocks of fewer frames when split by a timed command.
+     *-------------------------------------------------------------------------------*/
+    int block_size = 0;
+    int block_position = 0;
+
     int node_count;
-    int _node_count_tmp;
     float cpu_usage;
+    std::atomic<bool> profiling_enabled;
+
+    /*--------------------------------------------------------------------------------
+     * Allocate profiles, on the control thread, for a node or for every node
+     * connected to it that doesn't yet have one.
+     *-------------------------------------------------------------------------------*/
+    void allocate_profile(Node *node);
+    void allocate_profiles(Node *node, std::unordered_set<Node *> &visited);
+
+    /*--------------------------------------------------------------------------------
+     * A snapshot of the nodes in the schedule, taken by the audio thread when
+     * the schedule is rebuilt while the graph is running, so that the control
+     * thread can find profiled nodes without walking connections that the
+     * audio thread may be changing. Cleared when the graph stops.
+     *
+     * The snapshot is built in schedule_nodes_pending, and swapped into
+     * schedule_nodes under schedule_nodes_mutex. The audio thread only
+     * try-locks the mutex: if it is held, the swap is retried on the next
+     * block.
+     *-------------------------------------------------------------------------------*/
+    void publish_schedule_nodes();
+    void release_unscheduled_nodes(std::vector<NodeRef> &nodes);
+    std::vector<NodeRef> schedule_nodes;
+    std::vector<NodeRef> schedule_nodes_pending;
+    bool schedule_nodes_stale = false;
+    std::mutex schedule_nodes_mutex;
 
     NodeRef input = nullptr;
     NodeRef output = nullptr;
     AudioGraphConfig config;
 
-    SNDFILE *recording_fd;
-    float *recording_buffer;
-    int recording_num_channels;
+    /*--------------------------------------------------------------------------------
+     * The recorder is owned by the main thread. The audio thread only sees
+     * rendering_recorder, which is set and cleared by commands.
+     *-------------------------------------------------------------------------------*/
+    std::shared_ptr<DiskWriter> recorder;
+    DiskWriter *rendering_recorder;
 };
 
 class AudioGraphRef : public std::shared_ptr<AudioGraph>
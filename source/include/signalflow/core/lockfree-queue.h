@@ -0,0 +1,149 @@
+#pragma once
+
+/**--------------------------------------------------------------------------------
+ * @file lockfree-queue.h
+ * @brief LockFreeQueue is a bounded, multi-producer queue that can be read from
+ *        a real-time thread without locks or memory allocation.
+ *
+ *--------------------------------------------------------------------------------*/
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace signalflow
+{
+
+template <class T>
+class LockFreeQueue
+{
+public:
+    /**--------------------------------------------------------------------------------
+     * Create a queue. All storage is allocated up-front.
+     *
+     * @param capacity The maximum number of queued items. Must be a power of two.
+     *
+     *--------------------------------------------------------------------------------*/
+    LockFreeQueue(int capacity)
+        : cells(capacity), mask(capacity - 1)
+    {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+        {
+            throw std::runtime_error("LockFreeQueue: Capacity must be a power of two");
+        }
+        for (int i = 0; i < capacity; i++)
+        {
+            this->cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        this->write_pos.store(0, std::memory_order_relaxed);
+        this->read_pos.store(0, std::memory_order_relaxed);
+        this->overflow_count.store(0, std::memory_order_relaxed);
+    }
+
+    /**--------------------------------------------------------------------------------
+     * Append an item to the queue. Safe to call from any number of threads.
+     * Never blocks: if the queue is full, the overflow count is incremented and
+     * the item is not queued.
+     *
+     * @param item The item to append. It is moved from only if the push succeeds.
+     * @return true if the item was queued, false if the queue was full.
+     *
+     *--------------------------------------------------------------------------------*/
+    bool push(T &item)
+    {
+        Cell *cell;
+        size_t pos = this->write_pos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &this->cells[pos & this->mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+            if (diff == 0)
+            {
+                if (this->write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                this->overflow_count.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                pos = this->write_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = std::move(item);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**--------------------------------------------------------------------------------
+     * Remove the item at the head of the queue. Must only be called from a single
+     * consumer thread at a time.
+     *
+     * @param item Populated with the dequeued item.
+     * @return true if an item was dequeued, false if the queue was empty.
+     *
+     *--------------------------------------------------------------------------------*/
+    bool pop(T &item)
+    {
+        size_t pos = this->read_pos.load(std::memory_order_relaxed);
+        Cell *cell = &this->cells[pos & this->mask];
+        size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        if ((intptr_t) sequence - (intptr_t) (pos + 1) < 0)
+        {
+            return false;
+        }
+
+        item = std::move(cell->value);
+        cell->value = T();
+        this->read_pos.store(pos + 1, std::memory_order_relaxed);
+        cell->sequence.store(pos + this->mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of items that could not be queued because the queue was full.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_overflow_count()
+    {
+        return this->overflow_count.load(std::memory_order_relaxed);
+    }
+
+    /**--------------------------------------------------------------------------------
+     * @return The maximum number of queued items.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_capacity()
+    {
+        return (int) this->cells.size();
+    }
+
+private:
+    /*--------------------------------------------------------------------------------
+     * Each cell's sequence number records whose turn it is to use the cell:
+     * when sequence == pos, a producer may write it for position `pos`; when
+     * sequence == pos + 1, the consumer may read it.
+     *-------------------------------------------------------------------------------*/
+    class Cell
+    {
+    public:
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::vector<Cell> cells;
+    size_t mask;
+    std::atomic<size_t> write_pos;
+    std::atomic<size_t> read_pos;
+    std::atomic<int> overflow_count;
+};
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+/**--------------------------------------------------------------------------------
+ * @file profiler.h
+ * @brief NodeProfile records the time that a node takes to process each block,
+ *        when profiling is enabled on the AudioGraph.
+ *
+ *--------------------------------------------------------------------------------*/
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+/*------------------------------------------------------------------------
+ * Number of recent blocks from which each node's percentile timing is
+ * calculated.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_PROFILER_HISTORY_SIZE 512
+
+namespace signalflow
+{
+
+/**--------------------------------------------------------------------------------
+ * Timing statistics for a node, or for all nodes of the same class.
+ * All times are in seconds per block.
+ *
+ *--------------------------------------------------------------------------------*/
+class NodeProfileStats
+{
+public:
+    std::string name;
+    long num_blocks = 0;
+    double min = 0.0;
+    double mean = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    double total = 0.0;
+};
+
+/**--------------------------------------------------------------------------------
+ * A summary of the timings of every profiled node in an AudioGraph.
+ *  - nodes: stats for each node, in the order they are found from the output
+ *  - classes: stats for all nodes of each class, by decreasing total time
+ *
+ *--------------------------------------------------------------------------------*/
+class AudioGraphProfile
+{
+public:
+    std::vector<NodeProfileStats> nodes;
+    std::vector<NodeProfileStats> classes;
+};
+
+class NodeProfile
+{
+public:
+    NodeProfile();
+
+    /**--------------------------------------------------------------------------------
+     * Record the time taken to process a block. Called by the audio thread;
+     * does not block or allocate.
+     *
+     * @param duration The processing time, in seconds.
+     *
+     *--------------------------------------------------------------------------------*/
+    void record(double duration);
+
+    /**--------------------------------------------------------------------------------
+     * Clear all recorded timings.
+     *
+     *--------------------------------------------------------------------------------*/
+    void reset();
+
+    /**--------------------------------------------------------------------------------
+     * Summarise the recorded timings. Safe to call while the audio thread is
+     * recording, though the result may then be momentarily inconsistent.
+     * min, mean, max and total cover every block since the last reset;
+     * p99 covers the last SIGNALFLOW_PROFILER_HISTORY_SIZE blocks.
+     *
+     * @param name The name to give the stats.
+     * @return The stats.
+     *
+     *--------------------------------------------------------------------------------*/
+    NodeProfileStats get_stats(const std::string &name);
+
+    /**--------------------------------------------------------------------------------
+     * Add this profile's timings to the stats of a group of nodes (for example,
+     * every node of the same class). Call finalise() once every profile in the
+     * group has been added.
+     *
+     * @param stats The group's stats.
+     * @param history The group's recent block timings, appended to.
+     *
+     *--------------------------------------------------------------------------------*/
+    void accumulate(NodeProfileStats &stats, std::vector<float> &history);
+
+    /**--------------------------------------------------------------------------------
+     * Calculate the mean and p99 of accumulated stats.
+     *
+     *--------------------------------------------------------------------------------*/
+    static void finalise(NodeProfileStats &stats, std::vector<float> &history);
+
+private:
+    /*--------------------------------------------------------------------------------
+     * Fields are written by the audio thread and read by any other thread, so
+     * are atomics accessed with relaxed ordering, which compile to plain loads
+     * and stores.
+     *-------------------------------------------------------------------------------*/
+    std::atomic<float> history[SIGNALFLOW_PROFILER_HISTORY_SIZE];
+    std::atomic<long> num_blocks;
+    std::atomic<double> total;
+    std::atomic<double> min;
+    std::atomic<double> max;
+};
+
+}
@@ -4,12 +4,22 @@
 
 #pragma once
 
+#include <random>
+
 namespace signalflow
 {
 
 void random_init();
 void random_seed(long seed);
 
+/*--------------------------------------------------------------------*
+ * random_set_thread_generator(): Draw random numbers on the calling
+ * thread from `generator`, or from the thread's own generator if
+ * null. Used by AudioGraph while rendering, so that each graph has
+ * its own random state. Returns the previous generator.
+ *--------------------------------------------------------------------*/
+std::mt19937 *random_set_thread_generator(std::mt19937 *generator);
+
 double random_gaussian(double mean, double sd);
 double random_gaussian();
 double random_uniform();
@@ -4,6 +4,7 @@
 #include "signalflow/node/node.h"
 
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <string>
 
@@ -14,12 +15,35 @@ class GraphRenderer
 {
 public:
     GraphRenderer();
+
+    /**--------------------------------------------------------------------------------
+     * Print the graph's structure to stdout, in Graphviz DOT format.
+     *
+     *--------------------------------------------------------------------------------*/
     void render(AudioGraphRef graph);
+
+    /**--------------------------------------------------------------------------------
+     * Get the graph's structure in Graphviz DOT format. If the graph has been
+     * profiled, each node is labelled with its mean processing time, and
+     * coloured from green to red according to its share of the time taken by
+     * the most expensive node.
+     *
+     * @param graph The graph.
+     * @return The DOT source.
+     *
+     *--------------------------------------------------------------------------------*/
+    std::string get_dot(AudioGraph *graph);
+
     void render_node(NodeRef node);
 
     std::stringstream nodestream;
     std::stringstream edgestream;
     std::set<Node *> rendered_nodes;
+
+private:
+    void find_profiles(AudioGraph *graph);
+    std::map<Node *, NodeProfileStats> profile_stats;
+    double max_mean = 0.0;
 };
 
 }
@@ -0,0 +1,167 @@
+#pragma once
+
+/**--------------------------------------------------------------------------------
+ * @file spsc-ringbuffer.h
+ * @brief SPSCRingBuffer is a bounded, single-producer, single-consumer ring of
+ *        samples (or other trivially-copyable values) that can be written and
+ *        read in bulk without locks or memory allocation.
+ *
+ *--------------------------------------------------------------------------------*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace signalflow
+{
+
+template <class T>
+class SPSCRingBuffer
+{
+public:
+    /**--------------------------------------------------------------------------------
+     * Create a ring buffer. All storage is allocated up-front.
+     *
+     * @param capacity The maximum number of items that can be buffered.
+     *
+     *--------------------------------------------------------------------------------*/
+    SPSCRingBuffer(int capacity)
+        : data(capacity)
+    {
+        if (capacity < 1)
+        {
+            throw std::runtime_error("SPSCRingBuffer: Capacity must be positive");
+        }
+        this->write_pos.store(0, std::memory_order_relaxed);
+        this->read_pos.store(0, std::memory_order_relaxed);
+        this->overrun_count.store(0, std::memory_order_relaxed);
+        this->underrun_count.store(0, std::memory_order_relaxed);
+    }
+
+    /**--------------------------------------------------------------------------------
+     * Append up to `count` items. Must only be called from the producer thread.
+     *
+     * @param items The items to append.
+     * @param count The number of items to append.
+     * @return The number of items appended, which is less than `count` if the
+     *         ring does not have space for all of them, in which case an
+     *         overrun is counted.
+     *
+     *--------------------------------------------------------------------------------*/
+    int write(const T *items, int count)
+    {
+        size_t write_pos = this->write_pos.load(std::memory_order_relaxed);
+        size_t read_pos = this->read_pos.load(std::memory_order_acquire);
+        size_t capacity = this->data.size();
+        size_t available = capacity - (write_pos - read_pos);
+        if ((size_t) count > available)
+        {
+            this->overrun_count.fetch_add(1, std::memory_order_relaxed);
+            count = (int) available;
+        }
+
+        size_t offset = write_pos % capacity;
+        size_t first = std::min((size_t) count, capacity - offset);
+        std::copy(items, items + first, this->data.begin() + offset);
+        std::copy(items + first, items + count, this->data.begin());
+
+        this->write_pos.store(write_pos + count, std::memory_order_release);
+        return count;
+    }
+
+    /**--------------------------------------------------------------------------------
+     * Remove up to `count` items from the head of the ring. Must only be called
+     * from the consumer thread.
+     *
+     * @param items Populated with the items read.
+     * @param count The maximum number of items to read.
+     * @return The number of items read, which is less than `count` if fewer
+     *         items are available, in which case an underrun is counted.
+     *
+     *--------------------------------------------------------------------------------*/
+    int read(T *items, int count)
+    {
+        size_t read_pos = this->read_pos.load(std::memory_order_relaxed);
+        size_t write_pos = this->write_pos.load(std::memory_order_acquire);
+        size_t capacity = this->data.size();
+        size_t available = write_pos - read_pos;
+        if ((size_t) count > available)
+        {
+            this->underrun_count.fetch_add(1, std::memory_order_relaxed);
+            count = (int) available;
+        }
+
+        size_t offset = read_pos % capacity;
+        size_t first = std::min((size_t) count, capacity - offset);
+        std::copy(this->data.begin() + offset, this->data.begin() + offset + first, items);
+        std::copy(this->data.begin(), this->data.begin() + (count - first), items + first);
+
+        this->read_pos.store(read_pos + count, std::memory_order_release);
+        return count;
+    }
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of items that can currently be read. When called from
+     *         the consumer thread, at least this many items can be read.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_read_available()
+    {
+        return (int) (this->write_pos.load(std::memory_order_acquire) - this->read_pos.load(std::memory_order_acquire));
+    }
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of items that can currently be written. When called
+     *         from the producer thread, at least this many items can be written.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_write_available()
+    {
+        return this->get_capacity() - this->get_read_available();
+    }
+
+    /**--------------------------------------------------------------------------------
+     * @return The maximum number of items that can be buffered.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_capacity()
+    {
+        return (int) this->data.size();
+    }
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of writes that were truncated because the ring was full.
+     *
+     *--------------------------------------------------------------------------------*/
+    long get_overrun_count()
+    {
+        return this->overrun_count.load(std::memory_order_relaxed);
+    }
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of reads that requested more items than were available.
+     *         Consumers that poll the ring until it is empty will count an
+     *         underrun each time they drain it.
+     *
+     *--------------------------------------------------------------------------------*/
+    long get_underrun_count()
+    {
+        return this->underrun_count.load(std::memory_order_relaxed);
+    }
+
+private:
+    /*--------------------------------------------------------------------------------
+     * Positions increase monotonically, and are only reduced modulo the
+     * capacity when indexing, so that a full ring can be distinguished from
+     * an empty one.
+     *-------------------------------------------------------------------------------*/
+    std::vector<T> data;
+    std::atomic<size_t> write_pos;
+    std::atomic<size_t> read_pos;
+    std::atomic<long> overrun_count;
+    std::atomic<long> underrun_count;
+};
+
+}
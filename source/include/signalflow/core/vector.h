@@ -0,0 +1,85 @@
+/*--------------------------------------------------------------------*
+ * vector.h: Vectorised kernels for common block operations.
+ *
+ * Each kernel has scalar, SSE2, AVX2, AVX-512 and NEON
+ * implementations. The fastest that the CPU supports is selected at
+ * runtime, and can be overridden with signalflow_vector_set_isa().
+ *
+ * Except for signalflow_vector_sum(), every implementation gives
+ * bit-identical results to the scalar implementation. Output arrays
+ * may be the same as input arrays, but must not otherwise overlap.
+ *--------------------------------------------------------------------*/
+
+#pragma once
+
+#include "signalflow/core/constants.h"
+
+namespace signalflow
+{
+
+typedef enum
+{
+    SIGNALFLOW_VECTOR_ISA_SCALAR,
+    SIGNALFLOW_VECTOR_ISA_SSE2,
+    SIGNALFLOW_VECTOR_ISA_AVX2,
+    SIGNALFLOW_VECTOR_ISA_AVX512,
+    SIGNALFLOW_VECTOR_ISA_NEON
+} signalflow_vector_isa_t;
+
+/*--------------------------------------------------------------------*
+ * Query and select the instruction set used by the kernels.
+ * signalflow_vector_set_isa() throws if the CPU doesn't support it,
+ * and can be called while the graph is running.
+ *--------------------------------------------------------------------*/
+signalflow_vector_isa_t signalflow_vector_get_isa();
+void signalflow_vector_set_isa(signalflow_vector_isa_t isa);
+bool signalflow_vector_isa_is_supported(signalflow_vector_isa_t isa);
+
+/*--------------------------------------------------------------------*
+ * Element-wise arithmetic: out = a <op> b
+ *--------------------------------------------------------------------*/
+void signalflow_vector_add(const sample *a, const sample *b, sample *out, int num_samples);
+void signalflow_vector_subtract(const sample *a, const sample *b, sample *out, int num_samples);
+void signalflow_vector_multiply(const sample *a, const sample *b, sample *out, int num_samples);
+void signalflow_vector_divide(const sample *a, const sample *b, sample *out, int num_samples);
+void signalflow_vector_min(const sample *a, const sample *b, sample *out, int num_samples);
+void signalflow_vector_max(const sample *a, const sample *b, sample *out, int num_samples);
+
+/*--------------------------------------------------------------------*
+ * Multiply-accumulate: out = out + in * scale
+ * The multiply and add are rounded separately (never fused).
+ *--------------------------------------------------------------------*/
+void signalflow_vector_mac(const sample *in, sample scale, sample *out, int num_samples);
+
+/*--------------------------------------------------------------------*
+ * out = in * scale
+ *--------------------------------------------------------------------*/
+void signalflow_vector_scale(const sample *in, sample scale, sample *out, int num_samples);
+
+/*--------------------------------------------------------------------*
+ * Limit each sample to [min, max].
+ *--------------------------------------------------------------------*/
+void signalflow_vector_clamp(const sample *in, sample min, sample max, sample *out, int num_samples);
+
+/*--------------------------------------------------------------------*
+ * out = |in|
+ *--------------------------------------------------------------------*/
+void signalflow_vector_abs(const sample *in, sample *out, int num_samples);
+
+void signalflow_vector_fill(sample value, sample *out, int num_samples);
+void signalflow_vector_copy(const sample *in, sample *out, int num_samples);
+
+/*--------------------------------------------------------------------*
+ * Sum of all samples. Implementations accumulate in a different
+ * order, so results may differ in the least significant bits.
+ *--------------------------------------------------------------------*/
+sample signalflow_vector_sum(const sample *in, int num_samples);
+
+/*--------------------------------------------------------------------*
+ * Convert between an array of num_channels channel pointers and a
+ * single array of interleaved frames.
+ *--------------------------------------------------------------------*/
+void signalflow_vector_interleave(sample *const *in, int num_channels, sample *out, int num_frames);
+void signalflow_vector_deinterleave(const sample *in, int num_channels, sample *const *out, int num_frames);
+
+}
@@ -11,6 +11,7 @@ public:
     int hop_size = 0;
 
     virtual void process(Buffer &out, int num_frames);
+    virtual void copy_to(Node *node);
 
 private:
     SampleRingBuffer *ring_buffer;
@@ -21,7 +21,9 @@ public:
 
     virtual void set_buffer(std::string, BufferRef buffer);
     virtual void trigger(std::string = SIGNALFLOW_DEFAULT_TRIGGER, float value = 0.0);
+    virtual void reset();
     virtual void process(Buffer &out, int num_frames);
+    virtual bool get_output_will_be_silent();
 
 private:
     double phase;
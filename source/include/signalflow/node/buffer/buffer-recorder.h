@@ -18,6 +18,7 @@ public:
     bool loop;
 
     virtual void process(Buffer &out, int num_frames);
+    virtual void copy_to(Node *node);
 };
 
 REGISTER(BufferRecorder, "buffer-recorder")
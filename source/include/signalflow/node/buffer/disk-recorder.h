@@ -0,0 +1,49 @@
+#pragma once
+
+#include "signalflow/buffer/disk-writer.h"
+#include "signalflow/core/constants.h"
+#include "signalflow/node/node.h"
+
+#include <memory>
+
+namespace signalflow
+{
+
+/**--------------------------------------------------------------------------------
+ * Records its input to a sound file on disk. File I/O is performed on a
+ * background thread, so DiskRecorder can be used to tap any node in a
+ * graph that is running in real time. Add it to the graph with
+ * graph.add_node(). The file is finalised when the node is destroyed.
+ *
+ *--------------------------------------------------------------------------------*/
+class DiskRecorder : public Node
+{
+public:
+    DiskRecorder(std::string filename = "",
+                 NodeRef input = 0.0,
+                 int num_channels = 0,
+                 signalflow_recording_format_t format = SIGNALFLOW_RECORDING_FORMAT_FLOAT32);
+
+    NodeRef input;
+
+    virtual void process(Buffer &out, int num_frames);
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of blocks dropped because the writer thread could not
+     *         keep up.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_overflow_count();
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of frames written to disk so far.
+     *
+     *--------------------------------------------------------------------------------*/
+    long get_frames_written();
+
+private:
+    std::unique_ptr<DiskWriter> writer;
+};
+
+REGISTER(DiskRecorder, "disk-recorder")
+}
@@ -17,7 +17,9 @@ public:
     NodeRef release;
     NodeRef gate;
 
+    virtual void reset() override;
     virtual void process(Buffer &out, int num_frames);
+    virtual bool get_output_will_be_silent();
 
 private:
     float phase;
@@ -19,8 +19,11 @@ public:
 
     std::vector<float> phase;
 
+    virtual void alloc() override;
+    virtual void reset() override;
     virtual void trigger(std::string name = SIGNALFLOW_DEFAULT_TRIGGER, float value = 1.0) override;
     virtual void process(Buffer &out, int num_frames) override;
+    virtual bool get_output_will_be_silent() override;
 };
 
 REGISTER(EnvelopeASR, "envelope-asr")
@@ -16,6 +16,7 @@ public:
              bool loop = false);
 
     virtual void trigger(std::string name = SIGNALFLOW_DEFAULT_TRIGGER, float value = 1.0) override;
+    virtual void reset() override;
     virtual void process(Buffer &out, int num_frames) override;
 
 private:
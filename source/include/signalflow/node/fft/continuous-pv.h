@@ -11,6 +11,7 @@ public:
 
     virtual void process(Buffer &out, int num_frames);
     virtual void trigger(std::string name, float value);
+    virtual void copy_to(Node *node);
 
     sample *magnitude_buffer;
     sample *phase_buffer;
@@ -1,10 +1,38 @@
 #pragma once
 
 #include "signalflow/node/fft/fftnode.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
 #include <vector>
 
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#else
+#include <semaphore.h>
+#endif
+
 namespace signalflow
 {
+
+/**--------------------------------------------------------------------------------
+ * Uniformly-partitioned convolution of an FFT input with an impulse response.
+ *
+ * The impulse response is split into partitions of hop_size frames, each of
+ * which is multiplied by the spectrum of the corresponding past input frame.
+ * Spectra are multiplied and accumulated in Cartesian form, and only converted
+ * back to polar form once per hop.
+ *
+ * The first SIGNALFLOW_FFT_CONVOLVE_HEAD_PARTITIONS partitions are convolved on
+ * the audio thread. The contribution of the remaining partitions only depends on
+ * input frames that have already been received, so it is computed on a background
+ * thread during the preceding hop. If the background thread falls behind, the
+ * audio thread completes any work that it hasn't started. While the graph is
+ * running, the audio thread doesn't wait for work in progress, and instead omits
+ * those partitions from the hop; when rendering manually, it waits, so that the
+ * output does not depend on timing.
+ *--------------------------------------------------------------------------------*/
 class FFTConvolve : public FFTOpNode
 {
 public:
@@ -14,15 +42,64 @@ public:
     virtual void process(Buffer &out, int num_frames);
 
 private:
+    void multiply_accumulate(int first_partition,
+                             int last_partition,
+                             int position,
+                             sample *sum_real,
+                             sample *sum_imag);
+    void render_tail_blocks();
+    bool tail_round_finished();
+    void start_tail_round(int round, int position);
+    void wait_for_tail_round();
+    void run_tail_thread();
+
     BufferRef buffer;
     int num_partitions;
-    std::vector<sample *> ir_partitions;
-    std::vector<sample *> input_history;
-    sample *output_partition_polar_split;
-    sample *output_partition_polar;
-    sample *output_partition_cartesian;
-    sample *output_sum_cartesian;
-    sample *output_sum_polar;
+    int num_head_partitions;
+
+    /*--------------------------------------------------------------------------------
+     * Spectra are stored with separate real and imaginary arrays of num_bins.
+     * input_real/input_imag are a ring of the most recent num_history input
+     * frames, with the newest at history_position.
+     *-------------------------------------------------------------------------------*/
+    std::vector<sample> spectra;
+    std::vector<sample *> ir_real;
+    std::vector<sample *> ir_imag;
+    std::vector<sample *> input_real;
+    std::vector<sample *> input_imag;
+    sample *sum_real;
+    sample *sum_imag;
+    int num_history;
+    int history_position;
+    int hop_count;
+
+    /*--------------------------------------------------------------------------------
+     * The tail is divided into blocks, each of which is summed into its own
+     * buffer, so that blocks can be claimed by either thread and still be
+     * summed in a fixed order.
+     *
+     * Each round computes the tail for a single hop, and is numbered by that
+     * hop. Each block has two buffers, used in alternate rounds, so that a late
+     * block of the previous round can finish while the current round is being
+     * computed. tail_block_rounds holds the round that each block last
+     * completed, and a block is only summed at the hop of that round.
+     *-------------------------------------------------------------------------------*/
+    int num_tail_blocks;
+    std::vector<sample *> tail_real;
+    std::vector<sample *> tail_imag;
+    int tail_position;
+    int tail_round;
+    std::unique_ptr<std::atomic<int>[]> tail_block_rounds;
+    std::atomic<int> tail_next_block;
+    std::atomic<int> tail_blocks_finished;
+    std::atomic<bool> tail_thread_running;
+    std::thread tail_thread;
+
+#ifdef __APPLE__
+    dispatch_semaphore_t tail_semaphore;
+#else
+    sem_t tail_semaphore;
+#endif
 };
 
 REGISTER(FFTConvolve, "fft-convolve")
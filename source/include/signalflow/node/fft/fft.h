@@ -5,7 +5,7 @@
 #if defined(FFT_ACCELERATE)
 #include <Accelerate/Accelerate.h>
 #elif defined(FFT_FFTW)
-#include <fftw3.h>
+#include "signalflow/node/fft/fftw-plan-cache.h"
 #endif
 
 namespace signalflow
@@ -21,6 +21,7 @@ public:
     ~FFT();
 
     virtual void process(Buffer &out, int num_frames);
+    virtual void copy_to(Node *node);
 
     NodeRef input;
 
@@ -38,6 +39,7 @@ private:
 #elif defined(FFT_FFTW)
     sample *buffer;
     fftwf_complex *fftw_buffer;
+    fftwf_plan fftw_plan;
 #endif
 
     sample *window;
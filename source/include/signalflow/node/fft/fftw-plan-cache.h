@@ -0,0 +1,52 @@
+#pragma once
+
+/**--------------------------------------------------------------------------------
+ * @file fftw-plan-cache.h
+ * @brief Process-wide cache of FFTW plans.
+ *
+ * Creating an FFTW plan is expensive, particularly with the MEASURE and PATIENT
+ * planner efforts, so plans are created once per transform size and shared
+ * between nodes. Nodes execute the shared plans on their own buffers with the
+ * new-array execute functions (fftwf_execute_dft_r2c, fftwf_execute_dft_c2r),
+ * which are safe to call concurrently. Buffers must therefore be allocated with
+ * fftwf_malloc (or fftwf_alloc_real/fftwf_alloc_complex) so that their alignment
+ * matches the arrays that the plan was created with.
+ *
+ * FFTW wisdom is loaded from SIGNALFLOW_USER_DIR/fftw-wisdom on first use, and
+ * saved back whenever a plan is created with MEASURE or PATIENT effort.
+ *
+ *--------------------------------------------------------------------------------*/
+
+#include "signalflow/core/constants.h"
+
+#if defined(FFT_FFTW)
+
+#include <fftw3.h>
+#include <string>
+
+namespace signalflow
+{
+
+/**--------------------------------------------------------------------------------
+ * Returns a cached real-to-complex plan of the given size, creating it if needed.
+ * Must not be called from the audio thread, as planning may take a long time.
+ *
+ *--------------------------------------------------------------------------------*/
+fftwf_plan signalflow_fftw_plan_r2c(int fft_size, signalflow_fft_planner_effort_t effort);
+
+/**--------------------------------------------------------------------------------
+ * Returns a cached complex-to-real plan of the given size, creating it if needed.
+ * Note that complex-to-real transforms overwrite their input.
+ *
+ *--------------------------------------------------------------------------------*/
+fftwf_plan signalflow_fftw_plan_c2r(int fft_size, signalflow_fft_planner_effort_t effort);
+
+/**--------------------------------------------------------------------------------
+ * Returns the path that FFTW wisdom is loaded from and saved to.
+ *
+ *--------------------------------------------------------------------------------*/
+std::string signalflow_fftw_wisdom_path();
+
+}
+
+#endif
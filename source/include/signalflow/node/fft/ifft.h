@@ -5,7 +5,7 @@
 #if defined(FFT_ACCELERATE)
 #include <Accelerate/Accelerate.h>
 #elif defined(FFT_FFTW)
-#include <fftw3.h>
+#include "signalflow/node/fft/fftw-plan-cache.h"
 #endif
 
 namespace signalflow
@@ -24,6 +24,7 @@ public:
     sample *buffer2;
 #elif defined(FFT_FFTW)
     fftwf_complex *fftw_buffer;
+    fftwf_plan fftw_plan;
 #endif
 
     sample *window;
@@ -35,6 +36,10 @@ public:
                       bool do_window = false,
                       float scale_factor = 1.0);
     virtual void process(Buffer &out, int num_frames);
+    virtual void copy_to(Node *node);
+
+private:
+    void generate_window();
 };
 
 REGISTER(IFFT, "ifft")
@@ -1,12 +1,28 @@
 #pragma once
 
 #include "signalflow/core/graph.h"
+#include "signalflow/core/spsc-ringbuffer.h"
 #include "signalflow/node/node.h"
 
+#include <atomic>
+#include <memory>
 #include <vector>
 
 namespace signalflow
 {
+
+/**--------------------------------------------------------------------------------
+ * AudioIn_Abstract is the base class of audio input nodes. The backend's audio
+ * callback passes each block of interleaved input frames to write(), which
+ * appends them to a lock-free ring; the graph reads them back in process().
+ *
+ * The input and output devices are driven by separate clocks, so in general
+ * input frames arrive at a slightly different rate to that at which the graph
+ * consumes them. To compensate, the input is resampled by a ratio that is
+ * continuously adjusted to keep the ring's fill level at its target.
+ *
+ * Any number of input nodes can exist at once, each with its own ring.
+ *-------------------------------------------------------------------------------*/
 class AudioIn_Abstract : public Node
 {
 public:
@@ -17,6 +33,81 @@ public:
     virtual int stop() = 0;
     virtual int destroy() = 0;
 
-    virtual void process(Buffer &out, int num_samples) = 0;
+    virtual void process(Buffer &out, int num_frames) override;
+
+    /**--------------------------------------------------------------------------------
+     * Append frames received from the input device. Real-time safe: never blocks
+     * or allocates. Must only be called from one thread at a time (typically the
+     * input device's audio callback). If the ring is full, the frames that don't
+     * fit are dropped and an overrun is counted.
+     *
+     * @param frames Interleaved frames, with one sample per output channel.
+     * @param num_frames The number of frames.
+     *
+     *--------------------------------------------------------------------------------*/
+    void write(const sample *frames, int num_frames);
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of input frames received and not yet read from the ring.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_buffered_frames();
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of frames that the ring is kept filled to.
+     *
+     *--------------------------------------------------------------------------------*/
+    int get_target_frames();
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of writes that found the ring full.
+     *
+     *--------------------------------------------------------------------------------*/
+    long get_overrun_count();
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of blocks that found too few frames in the ring, and
+     *         so were padded with silence.
+     *
+     *--------------------------------------------------------------------------------*/
+    long get_underrun_count();
+
+    /**--------------------------------------------------------------------------------
+     * @return The number of input frames currently consumed per output frame.
+     *
+     *--------------------------------------------------------------------------------*/
+    double get_resample_ratio();
+
+protected:
+    /*--------------------------------------------------------------------------------
+     * Called by subclasses once the input stream's format is known, to set
+     * the node's channel count and allocate its ring. Must be called before
+     * the first call to write().
+     *
+     * buffer_size is the number of frames that the device delivers per
+     * callback; sample_rate is the device's nominal sample rate, which is
+     * resampled to the graph's sample rate.
+     *-------------------------------------------------------------------------------*/
+    void init_ring(int num_channels, int buffer_size, int sample_rate);
+
+private:
+    std::unique_ptr<SPSCRingBuffer<sample>> ring;
+    int target_frames;
+    double nominal_ratio;
+    std::atomic<double> ratio;
+    double fill_average;
+    std::atomic<long> overrun_count;
+    std::atomic<long> underrun_count;
+    bool is_streaming;
+
+    /*--------------------------------------------------------------------------------
+     * Frames read from the ring that have not yet been fully consumed by the
+     * resampler, and the fractional position of the next output frame within
+     * them.
+     *-------------------------------------------------------------------------------*/
+    std::vector<sample> staging;
+    int staged_frames;
+    double phase;
 };
+
 }
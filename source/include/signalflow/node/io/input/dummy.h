@@ -0,0 +1,26 @@
+#pragma once
+
+#include "signalflow/node/io/input/abstract.h"
+
+namespace signalflow
+{
+
+/**--------------------------------------------------------------------------------
+ * An audio input with no device. Frames passed to write() are output by the
+ * node as they would be from a device, so that input handling can be used
+ * and tested without audio hardware.
+ *-------------------------------------------------------------------------------*/
+class AudioIn_Dummy : public AudioIn_Abstract
+{
+public:
+    AudioIn_Dummy(int num_channels = 1, int buffer_size = SIGNALFLOW_DEFAULT_BLOCK_SIZE, int sample_rate = 0);
+
+    virtual int init() override { return 0; }
+    virtual int start() override { return 0; }
+    virtual int stop() override { return 0; }
+    virtual int destroy() override { return 0; }
+};
+
+REGISTER(AudioIn_Dummy, "audioin-dummy")
+
+} // namespace signalflow
@@ -4,8 +4,9 @@
 
 #define AudioIn AudioIn_SoundIO
 
+#include <atomic>
 #include <soundio/soundio.h>
-#include <vector>
+#include <string>
 
 #include "abstract.h"
 
@@ -17,21 +18,40 @@ namespace signalflow
 class AudioIn_SoundIO : public AudioIn_Abstract
 {
 public:
-    AudioIn_SoundIO();
+    /**--------------------------------------------------------------------------------
+     * Open an input stream on an audio device. The graph's output must already
+     * have been created, as input streams share its libsoundio context.
+     *
+     * @param device_name The name of the input device, or an empty string to use
+     *                    the config's input device name or, failing that, the
+     *                    default input device.
+     * @param num_channels The number of channels to record, or 0 to use the
+     *                     device's default channel layout.
+     * @param buffer_size The preferred number of frames per callback, or 0 to use
+     *                    the config's input buffer size or, failing that, the
+     *                    graph's block size.
+     *
+     *--------------------------------------------------------------------------------*/
+    AudioIn_SoundIO(const std::string &device_name = "", int num_channels = 0, int buffer_size = 0);
     virtual ~AudioIn_SoundIO();
     virtual int init() override;
     virtual int start() override;
     virtual int stop() override;
     virtual int destroy() override;
-    virtual void process(Buffer &out, int num_samples) override;
 
     struct SoundIo *soundio;
     struct SoundIoDevice *device;
     struct SoundIoInStream *instream;
 
-    Buffer *buffer;
-    int read_pos;
-    int write_pos;
+    /*--------------------------------------------------------------------------------
+     * Set while the audio thread is reading from this input's stream.
+     *-------------------------------------------------------------------------------*/
+    std::atomic<bool> is_processing;
+
+private:
+    std::string device_name;
+    int requested_num_channels;
+    int requested_buffer_size;
 };
 
 }
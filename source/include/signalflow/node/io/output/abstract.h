@@ -12,6 +12,7 @@ class AudioOut_Abstract : public Node
 public:
     AudioOut_Abstract();
     virtual void process(Buffer &out, int num_samples);
+    virtual void set_channels(int num_input_channels, int num_output_channels);
 
     virtual int init() = 0;
     virtual int start() = 0;
@@ -23,6 +24,24 @@ public:
     virtual void replace_input(NodeRef node, NodeRef other);
     std::list<NodeRef> get_inputs();
 
+    /**--------------------------------------------------------------------------------
+     * Returns whether any node is connected as an input. Unlike get_inputs(),
+     * this doesn't allocate.
+     *
+     * @return true if there is at least one input.
+     *-------------------------------------------------------------------------------*/
+    bool has_inputs();
+
+    /**--------------------------------------------------------------------------------
+     * Returns the number of times that remove_input() or replace_input() was
+     * called with a node that isn't an input, such as when stopping a node
+     * that isn't playing. These are applied on the audio thread, so are
+     * counted rather than reported.
+     *
+     * @return The number of nodes not found.
+     *-------------------------------------------------------------------------------*/
+    long get_missing_input_count();
+
     unsigned int get_sample_rate();
 
     /**--------------------------------------------------------------------------------
@@ -37,6 +56,7 @@ protected:
     unsigned int buffer_size = 0;
     std::list<NodeRef> audio_inputs;
     int input_index;
+    std::atomic<long> missing_input_count;
 };
 
 } // namespace signalflow
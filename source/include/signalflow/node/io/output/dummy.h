@@ -8,7 +8,7 @@ namespace signalflow
 class AudioOut_Dummy : public AudioOut_Abstract
 {
 public:
-    AudioOut_Dummy(int num_channels = 2);
+    AudioOut_Dummy(int num_channels = 2, int sample_rate = 44100);
 
     virtual int init() { return 0; }
     virtual int start() { return 0; }
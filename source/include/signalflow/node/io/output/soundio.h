@@ -4,6 +4,7 @@
 
 #define AudioOut AudioOut_SoundIO
 
+#include <atomic>
 #include <soundio/soundio.h>
 #include <vector>
 
@@ -31,12 +32,24 @@ public:
     struct SoundIoDevice *device;
     struct SoundIoOutStream *outstream;
 
+    /*--------------------------------------------------------------------------------
+     * Set while the audio thread is writing to this output's stream.
+     *-------------------------------------------------------------------------------*/
+    std::atomic<bool> is_processing;
+
 private:
     std::string device_name;
 };
 
 REGISTER(AudioOut_SoundIO, "audioout-soundio")
 
+/*--------------------------------------------------------------------------------
+ * Returns true if libsoundio's channel areas describe a single buffer of
+ * interleaved float frames, which can be converted with
+ * signalflow_vector_interleave/deinterleave.
+ *-------------------------------------------------------------------------------*/
+bool signalflow_soundio_areas_are_interleaved(const struct SoundIoChannelArea *areas, int channel_count);
+
 } // namespace signalflow
 
 #endif
@@ -4,9 +4,11 @@
 #include "signalflow/buffer/ringbuffer.h"
 #include "signalflow/core/constants.h"
 #include "signalflow/core/platform.h"
+#include "signalflow/core/profiler.h"
 #include "signalflow/core/property.h"
 #include "signalflow/node/registry.h"
 
+#include <list>
 #include <math.h>
 #include <memory>
 #include <set>
@@ -31,6 +33,18 @@ typedef enum
     SIGNALFLOW_NODE_STATE_STOPPED
 } signalflow_node_state_t;
 
+/*------------------------------------------------------------------------
+ * Tags for the node classes that need special treatment when rendering,
+ * so that they can be identified without comparing names.
+ *-----------------------------------------------------------------------*/
+typedef enum
+{
+    SIGNALFLOW_NODE_TYPE_GENERIC,
+    SIGNALFLOW_NODE_TYPE_CONSTANT,
+    SIGNALFLOW_NODE_TYPE_AUDIO_OUT,
+    SIGNALFLOW_NODE_TYPE_AUDIO_IN
+} signalflow_node_type_t;
+
 /*------------------------------------------------------------------------
  * Allows us to use a float (or direct node ptr) in place of a NodeRef
  * by specifying conversion constructors.
@@ -43,6 +57,8 @@ public:
         : std::shared_ptr<T>(nullptr) {};
     NodeRefTemplate(T *ptr)
         : std::shared_ptr<T>(ptr) {};
+    NodeRefTemplate(const std::shared_ptr<T> &ptr)
+        : std::shared_ptr<T>(ptr) {};
     NodeRefTemplate(double x);
     NodeRefTemplate(int x);
     NodeRefTemplate(std::initializer_list<NodeRefTemplate> x);
@@ -64,7 +80,44 @@ public:
 
 typedef NodeRefTemplate<Node> NodeRef;
 
-class Node
+/*------------------------------------------------------------------------
+ * Output storage for a node, allocated on the control thread so that
+ * the audio thread can install it with Node::swap_output_buffers().
+ *-----------------------------------------------------------------------*/
+class NodeOutputBuffers
+{
+public:
+    NodeRef node;
+    Buffer out;
+    std::vector<float> last_sample;
+    std::vector<float> final_sample;
+    std::vector<sample *> scratch_channels;
+};
+
+/*------------------------------------------------------------------------
+ * A change to one of a node's inputs, prepared on the control thread by
+ * Node::prepare_set_input() and applied on the audio thread by
+ * Node::apply_set_input(), which only swaps in what has been prepared:
+ *  - `slot`, and copies of the node's input tables that include it, if
+ *    the input is one that a node with variable inputs doesn't yet have
+ *  - the entry for the new input's outputs, and room to add it
+ *  - storage for each node whose channel count grows
+ * Once applied, it holds the storage that it replaced, and is released
+ * to the graph's reclaimer.
+ *-----------------------------------------------------------------------*/
+class NodeInputChange
+{
+public:
+    std::list<NodeRef> slot;
+    std::vector<NodeRef *> input_slots;
+    std::vector<std::string> input_names;
+    std::unordered_map<std::string, NodeRef *> inputs;
+    std::pair<Node *, std::string> output;
+    std::vector<std::pair<Node *, std::string>> outputs;
+    std::list<NodeOutputBuffers> buffers;
+};
+
+class Node : public std::enable_shared_from_this<Node>
 {
 
     /**------------------------------------------------------------------------
@@ -158,9 +211,9 @@ public:
 
     /**------------------------------------------------------------------------
      * Get the number of output channels allocated in memory.
-     * Initially, a node allocates SIGNALFLOW_NODE_INITIAL_OUTPUT_BUFFERS
-     * channels. During the course of graph construction, if more channels
-     * than this are required, it re-allocates the memory.
+     * Initially, a node allocates as many channels as it outputs. During the
+     * course of graph construction, if more channels than this are required
+     * (for example, to upmix the node's output), it re-allocates the memory.
      *
      * @returns The number of output channels allocated in memory, which
      *          is at least as large as num_output_channels.
@@ -194,6 +247,23 @@ public:
     virtual void trigger(std::string name = SIGNALFLOW_DEFAULT_TRIGGER,
                          float value = 1);
 
+    /*------------------------------------------------------------------------
+     * Return the node to the state it was in when constructed (for example,
+     * an oscillator's phase or an envelope's position), so that it can be
+     * reused rather than reallocated. Subclasses with internal state
+     * override this, and must call Node::reset().
+     *-----------------------------------------------------------------------*/
+    virtual void reset();
+
+    /*------------------------------------------------------------------------
+     * Create a new node of the same class and configuration, with the same
+     * properties, buffers and channel counts. Its inputs are connected to
+     * the same nodes as this node's, except for constant inputs, which are
+     * copied so that the two nodes can be modulated independently.
+     * To copy a network of nodes, use Patch::clone().
+     *-----------------------------------------------------------------------*/
+    NodeRef clone();
+
     /*------------------------------------------------------------------------
      * Print the node's output value to stdout at a specified frequency.
      *-----------------------------------------------------------------------*/
@@ -214,6 +284,78 @@ public:
      *-----------------------------------------------------------------------*/
     int get_output_buffer_length();
 
+    /*------------------------------------------------------------------------
+     * Grow the output buffers to hold at least num_frames frames.
+     * Called before each block is rendered.
+     *-----------------------------------------------------------------------*/
+    void resize_output_buffer_length(int num_frames);
+
+    /*------------------------------------------------------------------------
+     * Pin the node's output buffer, so that the AudioGraph never shares it
+     * with the output of other nodes. While rendering, a node whose output
+     * is only read by other nodes in the same block may instead write into
+     * one of the graph's shared scratch buffers.
+     *
+     * Must be called for any node whose output is read outside of the
+     * graph's render (this is done automatically when its output_buffer is
+     * accessed from Python, or when it is polled), or whose process()
+     * relies on the contents of its output buffer from a previous block.
+     *-----------------------------------------------------------------------*/
+    void pin_output_buffer();
+
+    /*------------------------------------------------------------------------
+     * @returns true if the output buffer is pinned.
+     *-----------------------------------------------------------------------*/
+    bool get_output_buffer_pinned();
+
+    /*------------------------------------------------------------------------
+     * @returns true if, in the block most recently rendered, each channel
+     * of the node's output held a single value for the whole block (for
+     * example, a Constant, or arithmetic between Constants). Nodes can
+     * then read out[channel][0] once per block, rather than every sample.
+     *-----------------------------------------------------------------------*/
+    bool get_output_is_constant();
+
+    /*------------------------------------------------------------------------
+     * Returns true if the node's output will be silent throughout the next
+     * block, so that it does not need to be processed. Called by the
+     * AudioGraph before each block, after its inputs have been queried
+     * (whose answers are available via get_output_is_silent()).
+     *
+     * By default, returns true while the node is inactive. Subclasses
+     * override this to account for their inputs: for example, Multiply is
+     * silent if either input is silent, and a finished envelope remains
+     * silent only while its clock input is silent.
+     *-----------------------------------------------------------------------*/
+    virtual bool get_output_will_be_silent();
+
+    /*------------------------------------------------------------------------
+     * @returns true if the AudioGraph found the node's output to be silent
+     * for the current block, in which case the node is not processed and
+     * its output is filled with zeros. Any inputs not needed by other nodes
+     * are then not processed either.
+     *-----------------------------------------------------------------------*/
+    bool get_output_is_silent();
+
+    /*------------------------------------------------------------------------
+     * @returns true if the node has declared that it will output silence
+     * until it is next triggered.
+     *-----------------------------------------------------------------------*/
+    bool get_is_inactive();
+
+    /*------------------------------------------------------------------------
+     * @returns The node's processing times, recorded while profiling is
+     * enabled on the AudioGraph, or null if it has not been profiled.
+     *-----------------------------------------------------------------------*/
+    NodeProfile *get_profile();
+
+    /*------------------------------------------------------------------------
+     * Get a pointer to the node's own output buffer storage, which holds
+     * each channel contiguously, get_output_buffer_length() samples apart.
+     * This differs from out[0] while the node is assigned a scratch buffer.
+     *-----------------------------------------------------------------------*/
+    sample *get_output_buffer_data();
+
     /*------------------------------------------------------------------------
      * Get the Patch that this node is part of.
      *-----------------------------------------------------------------------*/
@@ -229,6 +371,12 @@ public:
      *----------------------------------------------------------------------*/
     std::string name;
 
+    /*------------------------------------------------------------------------
+     * Class tag, set by the constructors of classes that need special
+     * treatment when rendering.
+     *----------------------------------------------------------------------*/
+    signalflow_node_type_t type;
+
     /*------------------------------------------------------------------------
      * Hash table of parameters: (name, pointer to NodeRef)
      * Must be a pointer, rather than the NodeRef itself, as the actual
@@ -241,7 +389,19 @@ public:
     std::unordered_map<std::string, NodeRef *> inputs;
 
     /*------------------------------------------------------------------------
-     * Set of outputs.
+     * The same inputs as a flat array, in the order they were created, with
+     * their names at the same indices in input_names. An input keeps its
+     * index for the lifetime of the node, unless an earlier input is
+     * destroyed (which only nodes with variable inputs do).
+     *
+     * Used to iterate over inputs when rendering, as the hash table is
+     * slow to iterate and copies each input's name.
+     *-----------------------------------------------------------------------*/
+    std::vector<NodeRef *> input_slots;
+    std::vector<std::string> input_names;
+
+    /*------------------------------------------------------------------------
+     * List of outputs.
      * Each output is a std::pair containing 
      *  - a reference to the Node connected outwards to
      *  - a string containing the name of the parameter that this node
@@ -249,7 +409,7 @@ public:
      * Note that a node may modulate two different parameters of the same
      * node.
      *-----------------------------------------------------------------------*/
-    std::set<std::pair<Node *, std::string>> outputs;
+    std::vector<std::pair<Node *, std::string>> outputs;
 
     /*------------------------------------------------------------------------
      * Hash table of properties: (name, PropertyRef *)
@@ -288,13 +448,19 @@ public:
 
     /*------------------------------------------------------------------------
      * Stores the number of frames in the previous processing block. Used
-     * to populate frame history in out[-1].
-     *
-     * TODO: Add a block buffer so that we always have a fixed block size.
+     * to populate frame history in out[-1]. When driven by the audio
+     * hardware, this is always the graph's block size.
      *-----------------------------------------------------------------------*/
     int last_num_frames;
 
 protected:
+    /*------------------------------------------------------------------------
+     * Construct a node attached to the given graph, rather than the
+     * current graph. Used by output devices, which may be created before
+     * the graph that they are passed to, and are then adopted by it.
+     *-----------------------------------------------------------------------*/
+    Node(AudioGraph *graph);
+
     /*------------------------------------------------------------------------
       * Called by Node subclasses to specify a fixed number of in/out
       * channels. Also unsets matches_input_channels.
@@ -318,6 +484,20 @@ protected:
       *-----------------------------------------------------------------------*/
     virtual void update_channels();
 
+    /*------------------------------------------------------------------------
+     * Get the number of input/output channels that update_channels() would
+     * give this node if its inputs had `input_channels` output channels
+     * (listed in the order of input_slots, with 0 for an empty slot),
+     * without modifying it. Throws invalid_channel_count_exception as
+     * update_channels() does.
+     *
+     * Used to prepare a change to a running graph's inputs on the control
+     * thread, so must be overridden alongside update_channels().
+     *-----------------------------------------------------------------------*/
+    virtual void infer_channels(const std::vector<int> &input_channels,
+                                int &num_input_channels,
+                                int &num_output_channels);
+
     /*------------------------------------------------------------------------
      * Allocate memory for output buffers.
      *  - resize_output_buffers() allocates at least as many as
@@ -332,6 +512,26 @@ protected:
     virtual void alloc();
     virtual void free();
 
+    /*------------------------------------------------------------------------
+     * Resize a vector of per-channel state in alloc(). Room is reserved for
+     * SIGNALFLOW_MAX_CHANNELS, so that when channels are added to a running
+     * graph, the audio thread can grow the state without allocating.
+     *-----------------------------------------------------------------------*/
+    template <typename T, typename V = T>
+    void resize_channel_state(std::vector<T> &state, const V &value = V())
+    {
+        state.reserve(SIGNALFLOW_MAX_CHANNELS);
+        state.resize(this->num_output_channels_allocated, value);
+    }
+
+    /*------------------------------------------------------------------------
+     * Install output storage prepared by prepare_set_input(), in place of
+     * resize_output_buffers(), so that a node can be grown on the audio
+     * thread without allocating. The node's previous storage is swapped into
+     * `buffers`. Does nothing if the node already has enough storage.
+     *-----------------------------------------------------------------------*/
+    void swap_output_buffers(NodeOutputBuffers &buffers);
+
     /*------------------------------------------------------------------------
      * Set node run state.
      *-----------------------------------------------------------------------*/
@@ -349,6 +549,60 @@ protected:
      *-----------------------------------------------------------------------*/
     virtual void destroy_input(std::string name);
 
+    /*------------------------------------------------------------------------
+     * Notify the graph that this node's connections have changed, so that
+     * its render schedule is rebuilt before the next block.
+     *-----------------------------------------------------------------------*/
+    void invalidate_graph_schedule();
+
+    /*------------------------------------------------------------------------
+     * Notify this node's Patch, if any, that its connections have changed,
+     * so that the Patch's clone plan is rebuilt.
+     *-----------------------------------------------------------------------*/
+    void invalidate_patch_clone_plan();
+
+    /*------------------------------------------------------------------------
+     * If this node is part of a running graph, post a change to one of its
+     * inputs to the graph's command queue, to be applied at the start of the
+     * next block. Must be called at the start of any set_input override.
+     *
+     * Returns true if the change was posted, in which case set_input must
+     * return without modifying the node.
+     *-----------------------------------------------------------------------*/
+    bool post_set_input(std::string name, const NodeRef &input);
+
+    /*------------------------------------------------------------------------
+     * As post_set_input, for nodes with variable inputs. Must be called at
+     * the start of any add_input or remove_input override.
+     *-----------------------------------------------------------------------*/
+    bool post_add_input(const NodeRef &input);
+    bool post_remove_input(const NodeRef &input);
+
+    /*------------------------------------------------------------------------
+     * Called on the control thread before a set_input is posted, to
+     * validate it and allocate everything that applying it needs into
+     * `change`. Channel counts are inferred from those of the connected
+     * nodes, so output storage is prepared for each node that will grow.
+     *
+     * Nodes with variable inputs override this to prepare a slot for an
+     * input that they don't yet have.
+     *-----------------------------------------------------------------------*/
+    virtual void prepare_set_input(const std::string &name, const NodeRef &input, NodeInputChange &change);
+
+    /*------------------------------------------------------------------------
+     * Called on the audio thread to apply a set_input prepared by
+     * prepare_set_input(), which it does without allocating.
+     *-----------------------------------------------------------------------*/
+    virtual void apply_set_input(const std::string &name, const NodeRef &input, NodeInputChange &change);
+
+    /*------------------------------------------------------------------------
+     * Used by nodes with variable inputs to prepare and apply a slot for an
+     * input named `name`, if they don't yet have one, which is stored in
+     * their `input_list`.
+     *-----------------------------------------------------------------------*/
+    void prepare_input_slot(const std::string &name, NodeInputChange &change);
+    void apply_input_slot(const std::string &name, std::list<NodeRef> &input_list, NodeInputChange &change);
+
     /*------------------------------------------------------------------------
       * Register properties.
       *-----------------------------------------------------------------------*/
@@ -364,6 +618,22 @@ protected:
      *-----------------------------------------------------------------------*/
     virtual void set_patch(Patch *patch);
 
+    /*------------------------------------------------------------------------
+     * Copy this node's configuration to a newly-constructed node of the
+     * same class: its properties, buffers and channel counts, but not its
+     * inputs. Nodes with configuration that is passed to their constructor
+     * but isn't an input, property or buffer override this to copy it too,
+     * and must call Node::copy_to(). Those that can't be copied throw.
+     *-----------------------------------------------------------------------*/
+    virtual void copy_to(Node *node);
+
+    /*------------------------------------------------------------------------
+     * Connect an input of a node created by copy_to(). Its channel counts
+     * and output buffers have already been copied from the prototype, so
+     * unlike set_input, channels are not inferred again from the input.
+     *-----------------------------------------------------------------------*/
+    void set_cloned_input(const std::string &name, const NodeRef &input);
+
     /*------------------------------------------------------------------------
      * Output buffer length, in samples.
      *-----------------------------------------------------------------------*/
@@ -383,6 +653,13 @@ protected:
      *-----------------------------------------------------------------------*/
     bool no_input_upmix;
 
+    /*------------------------------------------------------------------------
+     * Set to false by nodes whose process() never writes to `out` (for
+     * example, nodes that only write to a Buffer). Such nodes are never
+     * given a shared scratch buffer, so their output stays silent.
+     *-----------------------------------------------------------------------*/
+    bool writes_output = true;
+
     /*------------------------------------------------------------------------
      * If matches_input_channels is set, a node automatically increases its
      * input/output channel count to match those of its inputs.
@@ -391,7 +668,8 @@ protected:
 
     /*------------------------------------------------------------------------
      * Flag indicating whether the node has been processed within this
-     * graph traversal.
+     * graph traversal. Only used by render_subgraph(); AudioGraph::render()
+     * follows its precomputed schedule instead.
      *-----------------------------------------------------------------------*/
     bool has_rendered;
 
@@ -408,6 +686,21 @@ protected:
     int num_input_channels;
     int num_output_channels;
 
+    /*------------------------------------------------------------------------
+     * Set by process() if each channel of the block just rendered holds a
+     * single value. Cleared before every call to process(), so nodes that
+     * never set it are treated as audio-rate.
+     *-----------------------------------------------------------------------*/
+    bool output_is_constant;
+
+    /*------------------------------------------------------------------------
+     * Declare that the node outputs silence until it is next triggered
+     * (for example, once an envelope has finished). Subclasses must clear
+     * this when triggered, whether by trigger() or by a clock input.
+     *-----------------------------------------------------------------------*/
+    void set_inactive(bool inactive);
+    bool inactive;
+
     /*------------------------------------------------------------------------
      * Node state
      *-----------------------------------------------------------------------*/
@@ -425,11 +718,75 @@ private:
      *-----------------------------------------------------------------------*/
     virtual void _process(Buffer &out, int num_frames);
 
+    /*------------------------------------------------------------------------
+     * Called by AudioGraph in place of _process when the node's output is
+     * silent for the current block.
+     *-----------------------------------------------------------------------*/
+    void _process_silence(int num_frames);
+
+    /*------------------------------------------------------------------------
+     * Set by AudioGraph::mark_silent_nodes() before each block.
+     * render_silent: the node's output is silent, so it is not processed.
+     * render_needed: some node that is processed reads this node's output.
+     *-----------------------------------------------------------------------*/
+    bool render_silent = false;
+    bool render_needed = true;
+
+    /*------------------------------------------------------------------------
+     * Allocated by AudioGraph on the control thread, when the node is
+     * connected to the graph while profiling is enabled. It is set at most
+     * once, so the audio thread can read it without further synchronisation,
+     * and is owned (and deleted) by the node.
+     *-----------------------------------------------------------------------*/
+    std::atomic<NodeProfile *> profile { nullptr };
+
+    /*------------------------------------------------------------------------
+     * The constructor of this node's class, looked up in the NodeRegistry on
+     * the first call to clone(), so that later calls don't repeat the lookup.
+     *-----------------------------------------------------------------------*/
+    std::function<Node *()> clone_factory;
+
     /*------------------------------------------------------------------------
      * Pointer to the Patch that this node is a part of, if any.
      *-----------------------------------------------------------------------*/
     Patch *patch = nullptr;
 
+    /*------------------------------------------------------------------------
+     * Set by the AudioGraph once this node may be in use by the audio
+     * thread, after which changes to its inputs must go via post_set_input.
+     *-----------------------------------------------------------------------*/
+    bool graph_owned = false;
+
+    /*------------------------------------------------------------------------
+     * Used by the AudioGraph while rebuilding its schedule, in place of
+     * lookup tables, so that rebuilding doesn't allocate. The other fields
+     * are only valid while schedule_generation matches the graph's.
+     * schedule_expiring heads the list of nodes whose output is last read
+     * at this node's step, linked through schedule_next_expiring.
+     *-----------------------------------------------------------------------*/
+    unsigned long schedule_generation = 0;
+    unsigned long partition_generation = 0;
+    int schedule_step = 0;
+    int schedule_last_read = 0;
+    int schedule_owner = 0;
+    bool schedule_pinned = false;
+    Node *schedule_expiring = nullptr;
+    Node *schedule_next_expiring = nullptr;
+
+    /*------------------------------------------------------------------------
+     * Scratch buffers, assigned by AudioGraph::assign_scratch_buffers().
+     * While assigned, the channels of `out` point to scratch_channels, and
+     * the node's own channel pointers are kept in owned_output_data.
+     * last_sample is populated from final_sample, which is captured at
+     * the end of each block (before the scratch buffer is reused).
+     *-----------------------------------------------------------------------*/
+    void use_scratch_buffer();
+    void release_scratch_buffer();
+    bool output_buffer_pinned = false;
+    std::vector<sample *> scratch_channels;
+    sample **owned_output_data = nullptr;
+    std::vector<float> final_sample;
+
     /*------------------------------------------------------------------------
      * Allow friends to access private methods
      *-----------------------------------------------------------------------*/
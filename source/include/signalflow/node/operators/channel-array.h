@@ -20,9 +20,15 @@ public:
 
     virtual void process(Buffer &out, int num_frames);
     virtual void update_channels();
+    virtual void infer_channels(const std::vector<int> &input_channels,
+                                int &num_input_channels,
+                                int &num_output_channels);
 
     virtual void add_input(NodeRef input);
     virtual void set_input(std::string name, const NodeRef &node);
+    virtual void prepare_set_input(const std::string &name, const NodeRef &input, NodeInputChange &change);
+    virtual void apply_set_input(const std::string &name, const NodeRef &input, NodeInputChange &change);
+    virtual void copy_to(Node *node);
 
     std::list<NodeRef> input_list;
 };
@@ -18,6 +18,10 @@ public:
 
     virtual void process(Buffer &out, int num_frames);
     virtual void update_channels();
+    virtual void infer_channels(const std::vector<int> &input_channels,
+                                int &num_input_channels,
+                                int &num_output_channels);
+    virtual void copy_to(Node *node);
 
     std::list<NodeRef> inputs;
     int channels;
@@ -13,6 +13,7 @@ public:
     Multiply(NodeRef a = 1.0, NodeRef b = 1.0);
 
     virtual void process(Buffer &out, int num_frames);
+    virtual bool get_output_will_be_silent();
 };
 
 REGISTER(Multiply, "multiply")
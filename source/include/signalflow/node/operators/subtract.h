@@ -13,6 +13,7 @@ public:
     Subtract(NodeRef a = 0, NodeRef b = 0);
 
     virtual void process(Buffer &out, int num_frames);
+    virtual bool get_output_will_be_silent();
 };
 
 REGISTER(Subtract, "subtract")
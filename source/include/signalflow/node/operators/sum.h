@@ -23,6 +23,9 @@ public:
     virtual void add_input(NodeRef input);
     virtual void remove_input(NodeRef input);
     virtual void set_input(std::string name, const NodeRef &node);
+    virtual void prepare_set_input(const std::string &name, const NodeRef &input, NodeInputChange &change);
+    virtual void apply_set_input(const std::string &name, const NodeRef &input, NodeInputChange &change);
+    virtual void copy_to(Node *node);
 
 protected:
     std::list<NodeRef> input_list;
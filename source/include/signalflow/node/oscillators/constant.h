@@ -11,7 +11,31 @@ public:
 
     float value;
 
+    virtual void alloc();
     virtual void process(Buffer &out, int num_frames);
+    virtual bool get_output_will_be_silent();
+
+    /*--------------------------------------------------------------------------------
+     * Move linearly to a new value over the given number of frames, beginning
+     * with the next frame rendered, or jump to it immediately if num_frames is
+     * zero. Only called by the AudioGraph when applying scheduled events.
+     *--------------------------------------------------------------------------------*/
+    void ramp_to(float target, int num_frames);
+
+protected:
+    virtual void copy_to(Node *node);
+
+private:
+    /*--------------------------------------------------------------------------------
+     * The value and number of frames last written to the output buffer.
+     * The buffer is pinned, so only needs rewriting when either changes.
+     *--------------------------------------------------------------------------------*/
+    float filled_value;
+    int filled_num_frames;
+
+    float ramp_target;
+    float ramp_step;
+    int ramp_frames_remaining;
 };
 
 REGISTER(Constant, "constant")
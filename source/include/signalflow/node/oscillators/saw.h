@@ -10,6 +10,7 @@ public:
     SawOscillator(NodeRef frequency = 440);
 
     virtual void alloc() override;
+    virtual void reset() override;
     virtual void process(Buffer &out, int num_frames) override;
 
     NodeRef frequency;
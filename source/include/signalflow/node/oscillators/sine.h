@@ -11,6 +11,7 @@ public:
 
     virtual void process(Buffer &out, int num_frames) override;
     virtual void alloc() override;
+    virtual void reset() override;
 
     NodeRef frequency;
 
@@ -13,6 +13,7 @@ public:
     NodeRef width;
 
     virtual void alloc() override;
+    virtual void reset() override;
     virtual void process(Buffer &out, int num_frames) override;
 
 private:
@@ -12,6 +12,7 @@ public:
     NodeRef frequency;
 
     virtual void alloc() override;
+    virtual void reset() override;
     virtual void process(Buffer &out, int num_frames) override;
 
 private:
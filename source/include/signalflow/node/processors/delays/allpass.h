@@ -16,11 +16,13 @@ public:
     ~AllpassDelay();
 
     virtual void process(Buffer &out, int num_frames) override;
+    virtual void copy_to(Node *node) override;
 
 private:
     NodeRef delaytime;
     NodeRef feedback;
 
+    float maxdelaytime;
     std::vector<SampleRingBuffer *> buffers;
 };
 
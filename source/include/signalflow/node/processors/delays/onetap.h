@@ -15,10 +15,12 @@ public:
     ~OneTapDelay();
 
     virtual void process(Buffer &out, int num_frames) override;
+    virtual void copy_to(Node *node) override;
 
 private:
     NodeRef delaytime;
 
+    float maxdelaytime;
     std::vector<SampleRingBuffer *> buffers;
 };
 
@@ -16,6 +16,7 @@ public:
 
     virtual void alloc() override;
     virtual void process(Buffer &out, int num_frames) override;
+    virtual void copy_to(Node *node) override;
 
 private:
     signalflow_filter_type_t filter_type;
@@ -26,6 +27,12 @@ private:
     virtual void _recalculate();
 
     std::vector<float> a0, a1, a2, b1, b2, z1, z2;
+
+    /*--------------------------------------------------------------------------------
+     * Parameters that the current coefficients were calculated from, so that
+     * recalculation can be skipped while they are unchanged.
+     *--------------------------------------------------------------------------------*/
+    std::vector<float> last_cutoff, last_resonance, last_peak_gain;
 };
 
 REGISTER(BiquadFilter, "biquad-filter")
@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <unordered_map>
+#include <vector>
 
 #include "signalflow/patch/patch-node-spec.h"
 
@@ -51,6 +52,19 @@ public:
      *-----------------------------------------------------------------------*/
     Node *create(std::string name);
 
+    /**------------------------------------------------------------------------
+     * Return the constructor for Node objects of the given name, so that
+     * many objects can be constructed without repeating the lookup.
+     *
+     *-----------------------------------------------------------------------*/
+    std::function<Node *()> get_factory(std::string name);
+
+    /**------------------------------------------------------------------------
+     * List the names of all registered Node classes, in alphabetical order.
+     *
+     *-----------------------------------------------------------------------*/
+    std::vector<std::string> get_node_names();
+
     /*------------------------------------------------------------------------
      * (Function template implementations must be in .h file.)
      * http://stackoverflow.com/questions/495021/why-can-templates-only-be-implemented-in-the-header-file
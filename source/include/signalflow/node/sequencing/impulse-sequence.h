@@ -13,6 +13,7 @@ public:
 
     virtual void alloc() override;
     virtual void process(Buffer &out, int num_frames) override;
+    virtual void copy_to(Node *node) override;
     virtual void trigger(std::string name = SIGNALFLOW_DEFAULT_TRIGGER, float value = 1.0) override;
 
 private:
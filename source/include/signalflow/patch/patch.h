@@ -9,7 +9,9 @@
 
 #include "signalflow/patch/patch-node-spec.h"
 #include "signalflow/patch/patch-spec.h"
+#include <atomic>
 #include <map>
+#include <mutex>
 
 namespace signalflow
 {
@@ -21,6 +23,7 @@ typedef enum
 } signalflow_patch_state_t;
 
 class Patch;
+class VoicePool;
 
 template <class T>
 class PatchRefTemplate : public std::shared_ptr<T>
@@ -57,14 +60,45 @@ public:
     virtual ~Patch();
 
     signalflow_patch_state_t get_state();
-    void set_input(std::string name, float value);
-    void set_input(std::string name, NodeRef value);
-    void set_input(std::string name, BufferRef value);
+    void set_input(const std::string &name, float value);
+    void set_input(const std::string &name, NodeRef value);
+    void set_input(const std::string &name, BufferRef value);
     void disconnect();
     bool get_auto_free();
     void set_auto_free(bool value);
     void node_state_changed(Node *node);
 
+    /**------------------------------------------------------------------------
+     * Reset every node in the Patch to its initial state, so that the Patch
+     * can be played again from the start without being reinstantiated.
+     *
+     *-----------------------------------------------------------------------*/
+    void reset();
+
+    /**------------------------------------------------------------------------
+     * Create a copy of this Patch, with a copy of each of its nodes, wired
+     * in the same way. Unlike instantiating a Patch from a PatchSpec, nodes
+     * that feed multiple inputs are copied once and shared by the copy in
+     * the same way, and nodes connected to the Patch's inputs from outside
+     * it are shared with the copy rather than copied.
+     *
+     * The first call to clone() flattens the Patch into a list of nodes to
+     * copy, so that subsequent calls don't need to traverse it or look up
+     * node classes by name. Channel counts and output buffers are copied
+     * from each node rather than inferred again. The list is rebuilt if the
+     * Patch's nodes change, or any of them is rewired.
+     *
+     *-----------------------------------------------------------------------*/
+    PatchRef clone();
+
+    /**------------------------------------------------------------------------
+     * Mark the list of nodes used by clone() as stale, so that it is rebuilt
+     * by the next call. Called by the Patch's nodes when their inputs change,
+     * which may be on the audio thread, so doesn't free the list itself.
+     *
+     *-----------------------------------------------------------------------*/
+    void invalidate_clone_plan();
+
     NodeRef output = nullptr;
     std::unordered_map<std::string, NodeRef> inputs;
     std::unordered_map<std::string, BufferRef> buffer_inputs;
@@ -118,6 +152,46 @@ private:
     std::map<int, PatchNodeSpec *> nodespecs;
     std::set<NodeRef> parsed_nodes;
     bool parsed = false;
+
+    /*----------------------------------------------------------------------------------
+     * The steps taken by clone(): one per node, starting with the output,
+     * with inputs referenced by their index in the list. All of the nodes
+     * are created before any are connected, so that feedback cycles can be
+     * copied. Nodes connected to the Patch's inputs from outside it are
+     * referenced rather than copied.
+     *
+     * clone_plan_generation is incremented by invalidate_clone_plan(), which
+     * may be called on the audio thread, so doesn't take the mutex. The plan
+     * is current if it was built at the current generation. clone() holds
+     * clone_plan_mutex while building and reading the plan.
+     *---------------------------------------------------------------------------------*/
+    typedef struct
+    {
+        Node *prototype;
+        std::function<Node *()> factory;
+        std::vector<std::pair<std::string, int>> inputs;
+        NodeRef external;
+    } signalflow_clone_step_t;
+
+    void build_clone_plan();
+    int _add_clone_step(const NodeRef &node, std::unordered_map<Node *, int> &indices);
+    std::vector<signalflow_clone_step_t> clone_plan;
+    std::vector<std::pair<std::string, int>> clone_plan_inputs;
+    std::mutex clone_plan_mutex;
+    std::atomic<unsigned long> clone_plan_generation { 1 };
+    unsigned long clone_plan_built_generation = 0;
+
+    /*----------------------------------------------------------------------------------
+     * Set if this Patch is one of the voices of a VoicePool, which is notified
+     * when the voice stops in place of auto-freeing it.
+     *
+     * voice_generation counts the resets of the voice, and so is incremented
+     * on the audio thread when the reset for each new note is applied.
+     *---------------------------------------------------------------------------------*/
+    friend class VoicePool;
+    VoicePool *voice_pool = nullptr;
+    int voice_index = -1;
+    int voice_generation = 0;
 };
 
 }
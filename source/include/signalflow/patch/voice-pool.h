@@ -0,0 +1,157 @@
+#pragma once
+
+/**-------------------------------------------------------------------------
+ * @file voice-pool.h
+ * @brief VoicePool preinstantiates a fixed number of voices of a PatchSpec,
+ *        so that starting a note neither creates nodes nor modifies the
+ *        graph's structure.
+ *
+ *-----------------------------------------------------------------------*/
+
+#include "signalflow/core/constants.h"
+#include "signalflow/core/spsc-ringbuffer.h"
+#include "signalflow/patch/patch.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace signalflow
+{
+
+class VoicePool
+{
+public:
+    /**------------------------------------------------------------------------
+     * Instantiate `num_voices` voices of a PatchSpec. Every voice is connected
+     * to the pool's output from the outset, behind a gate that is closed
+     * while the voice is idle, so that idle voices are not rendered.
+     *
+     * @param spec The PatchSpec to instantiate.
+     * @param num_voices The number of voices.
+     * @param steal_policy What to do when a voice is requested and all
+     *                     voices are sounding.
+     *
+     *-----------------------------------------------------------------------*/
+    VoicePool(PatchSpecRef spec,
+              int num_voices,
+              signalflow_voice_steal_policy_t steal_policy = SIGNALFLOW_VOICE_STEAL_OLDEST);
+
+    virtual ~VoicePool();
+
+    /**------------------------------------------------------------------------
+     * Take an idle voice from the pool, or steal a sounding voice if none are
+     * idle. The voice is reset to its initial state, but remains silent until
+     * start() is called, so that its inputs can first be set.
+     *
+     * Takes constant time (plus a scan of the voices when stealing), and
+     * doesn't allocate. While the graph is running, the voice's gate and
+     * reset are posted to the audio thread, so take effect at the start of
+     * the next block. Must only be called from one thread at a time.
+     *
+     * @return The voice, or null if no voice is available and the steal
+     *         policy is SIGNALFLOW_VOICE_STEAL_NONE.
+     *
+     *-----------------------------------------------------------------------*/
+    PatchRef allocate();
+
+    /**------------------------------------------------------------------------
+     * Open the gate of a voice returned by allocate(), so that it sounds.
+     *
+     *-----------------------------------------------------------------------*/
+    void start(PatchRef voice);
+
+    /**------------------------------------------------------------------------
+     * Allocate a voice, set its inputs to the given values, and start it.
+     * Like allocate(), this doesn't allocate memory.
+     *
+     * @param inputs Values of the voice's named inputs.
+     * @return The voice, or null if no voice is available.
+     *
+     *-----------------------------------------------------------------------*/
+    PatchRef note_on(const std::unordered_map<std::string, float> &inputs = {});
+
+    /**------------------------------------------------------------------------
+     * Silence a voice immediately and return it to the pool. Voices are also
+     * returned to the pool automatically when one of their nodes stops (for
+     * example, when an envelope finishes).
+     *
+     *-----------------------------------------------------------------------*/
+    void stop(PatchRef voice);
+
+    /**------------------------------------------------------------------------
+     * @return The sum of all voices, which should be played by the graph.
+     *
+     *-----------------------------------------------------------------------*/
+    NodeRef get_output();
+
+    int get_num_voices();
+
+    /**------------------------------------------------------------------------
+     * @return The number of voices allocated and not yet stopped.
+     *
+     *-----------------------------------------------------------------------*/
+    int get_num_active_voices();
+
+    /**------------------------------------------------------------------------
+     * @return The number of times that a sounding voice has been stolen.
+     *
+     *-----------------------------------------------------------------------*/
+    int get_steal_count();
+
+    signalflow_voice_steal_policy_t get_steal_policy();
+    void set_steal_policy(signalflow_voice_steal_policy_t policy);
+
+private:
+    friend class Patch;
+
+    /*------------------------------------------------------------------------
+     * Called by a voice on the audio thread when one of its nodes stops.
+     * Closes the voice's gate, and passes it back to the control thread to
+     * be returned to the pool at the next call to allocate().
+     *-----------------------------------------------------------------------*/
+    void voice_stopped(Patch *voice);
+
+    /*------------------------------------------------------------------------
+     * Return voices that have stopped on the audio thread to the pool.
+     *-----------------------------------------------------------------------*/
+    void collect_stopped_voices();
+    void release_voice(int index);
+
+    /*------------------------------------------------------------------------
+     * Open or close a voice's gate, via the audio thread if the graph is
+     * running.
+     *-----------------------------------------------------------------------*/
+    void set_gate(int index, float value);
+
+    std::vector<PatchRef> voices;
+    std::vector<NodeRef> gates;
+    NodeRef output;
+
+    /*------------------------------------------------------------------------
+     * Control-thread state: the indices of idle voices, and for each voice,
+     * whether it is allocated and the order in which it was allocated.
+     *
+     * Each allocation of a voice increments its generation. Stop
+     * notifications carry the generation of the voice's reset that the audio
+     * thread last applied, so that a notification for an earlier note can't
+     * release a voice that has since been stolen, even if the new note's
+     * reset hasn't yet been applied.
+     *-----------------------------------------------------------------------*/
+    std::vector<int> idle_voices;
+    std::vector<bool> voice_active;
+    std::vector<long> voice_order;
+    std::vector<int> voice_generation;
+    long next_order = 0;
+    int num_active_voices = 0;
+    int steal_count = 0;
+    signalflow_voice_steal_policy_t steal_policy;
+
+    typedef struct
+    {
+        int index;
+        int generation;
+    } signalflow_stopped_voice_t;
+    SPSCRingBuffer<signalflow_stopped_voice_t> stopped_voices;
+};
+
+}
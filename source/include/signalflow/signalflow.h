@@ -6,18 +6,24 @@
 #include <signalflow/core/core.h>
 #include <signalflow/core/exceptions.h>
 #include <signalflow/core/graph.h>
+#include <signalflow/core/profiler.h>
 #include <signalflow/core/property.h>
 #include <signalflow/core/random.h>
+#include <signalflow/core/renderer.h>
 #include <signalflow/core/util.h>
+#include <signalflow/core/vector.h>
 #include <signalflow/core/version.h>
 
 #include <signalflow/buffer/buffer.h>
+#include <signalflow/buffer/disk-writer.h>
 #include <signalflow/buffer/ringbuffer.h>
+#include <signalflow/buffer/streaming-buffer.h>
 
 #include <signalflow/patch/patch-node-spec.h>
 #include <signalflow/patch/patch-registry.h>
 #include <signalflow/patch/patch-spec.h>
 #include <signalflow/patch/patch.h>
+#include <signalflow/patch/voice-pool.h>
 
 #include <signalflow/node/node.h>
 #include <signalflow/node/registry.h>
@@ -52,6 +58,7 @@
 #include <signalflow/node/io/output/soundio.h>
 
 #include <signalflow/node/io/input/abstract.h>
+#include <signalflow/node/io/input/dummy.h>
 #include <signalflow/node/io/input/soundio.h>
 
 /*------------------------------------------------------------------------
@@ -76,6 +83,7 @@
 #include <signalflow/node/buffer/beat-cutter.h>
 #include <signalflow/node/buffer/buffer-player.h>
 #include <signalflow/node/buffer/buffer-recorder.h>
+#include <signalflow/node/buffer/disk-recorder.h>
 #include <signalflow/node/buffer/feedback-buffer-reader.h>
 #include <signalflow/node/buffer/feedback-buffer-writer.h>
 #include <signalflow/node/buffer/granulator.h>
@@ -165,6 +173,7 @@
  * FFT
  *-----------------------------------------------------------------------*/
 #include <signalflow/node/fft/continuous-pv.h>
+#include <signalflow/node/fft/convolve.h>
 #include <signalflow/node/fft/fft.h>
 #include <signalflow/node/fft/find-peaks.h>
 #include <signalflow/node/fft/ifft.h>
@@ -172,7 +181,3 @@
 #include <signalflow/node/fft/noise-gate.h>
 #include <signalflow/node/fft/phase-vocoder.h>
 #include <signalflow/node/fft/tonality.h>
-
-#ifdef __APPLE__
-#include <signalflow/node/fft/convolve.h>
-#endif
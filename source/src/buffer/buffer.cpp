@@ -2,8 +2,10 @@
 #include "signalflow/core/constants.h"
 #include "signalflow/core/exceptions.h"
 #include "signalflow/core/graph.h"
+#include "signalflow/core/vector.h"
 #include <sndfile.h>
 
+#include <algorithm>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -14,11 +16,20 @@
 namespace signalflow
 {
 
-extern AudioGraph *shared_graph;
+std::atomic<uint32_t> Buffer::page_clock(0);
 
+/*--------------------------------------------------------------------------------
+ * An empty buffer (including each node's output buffer, before it is allocated)
+ * has no duration, so isn't given a graph's sample rate. This allows nodes such
+ * as output devices to be created on a thread with no current graph.
+ *-------------------------------------------------------------------------------*/
 Buffer::Buffer()
-    : Buffer(0, 0)
 {
+    this->num_channels = 0;
+    this->num_frames = 0;
+    this->interpolate = SIGNALFLOW_INTERPOLATION_LINEAR;
+    this->sample_rate = 0;
+    this->duration = 0;
 }
 
 Buffer::Buffer(int num_channels, int num_frames)
@@ -31,9 +42,10 @@ Buffer::Buffer(int num_channels, int num_frames)
      * If the AudioGraph has been instantiated, populate the buffer's sample
      * rate and duration. Otherwise, zero them.
      *-------------------------------------------------------------------------------*/
-    if (shared_graph)
+    AudioGraph *graph = AudioGraph::get_shared_graph();
+    if (graph)
     {
-        this->sample_rate = shared_graph->get_sample_rate();
+        this->sample_rate = graph->get_sample_rate();
         this->duration = this->num_frames / this->sample_rate;
     }
     else
@@ -120,7 +132,15 @@ void Buffer::resize(int num_channels, int num_frames)
     }
 }
 
-void Buffer::load(std::string filename)
+void Buffer::swap_storage(Buffer &other)
+{
+    std::swap(this->data, other.data);
+    std::swap(this->num_channels, other.num_channels);
+    std::swap(this->num_frames, other.num_frames);
+    std::swap(this->duration, other.duration);
+}
+
+std::string Buffer::resolve_path(std::string filename)
 {
     std::string path = filename;
     if (access(path.c_str(), F_OK) != 0)
@@ -131,6 +151,12 @@ void Buffer::load(std::string filename)
             throw std::runtime_error(std::string("Couldn't find file at path: ") + filename);
         }
     }
+    return path;
+}
+
+void Buffer::load(std::string filename)
+{
+    std::string path = Buffer::resolve_path(filename);
 
     SF_INFO info;
     SNDFILE *sndfile = sf_open(path.c_str(), SFM_READ, &info);
@@ -172,30 +198,25 @@ void Buffer::load(std::string filename)
     int frames_per_read = SIGNALFLOW_DEFAULT_BUFFER_BLOCK_SIZE;
     int samples_per_read = frames_per_read * info.channels;
     sample *buffer = new sample[samples_per_read];
+    std::vector<sample *> channels(info.channels);
     int total_frames_read = 0;
 
-    while (true)
+    while (total_frames_read < this->num_frames)
     {
         int count = sf_readf_float(sndfile, buffer, frames_per_read);
-        for (int frame = 0; frame < count; frame++)
+
+        /*------------------------------------------------------------------------
+         * Stop at the limit of this Buffer, which can happen in the case of
+         * pre-allocated buffers loading a determinate # samples from memory.
+         *-----------------------------------------------------------------------*/
+        count = std::min(count, this->num_frames - total_frames_read);
+        for (int channel = 0; channel < info.channels; channel++)
         {
-            // TODO: Vector-accelerated de-interleave
-            for (int channel = 0; channel < info.channels; channel++)
-            {
-                this->data[channel][total_frames_read] = buffer[frame * info.channels + channel];
-            }
-            total_frames_read++;
-
-            /*------------------------------------------------------------------------
-             * Check whether we've hit the limit of this Buffer, which can happen
-             * in the case of pre-allocated buffers loading a determinate # samples
-             * from memory.
-             *-----------------------------------------------------------------------*/
-            if (total_frames_read >= this->num_frames)
-            {
-                break;
-            }
+            channels[channel] = this->data[channel] + total_frames_read;
         }
+        signalflow_vector_deinterleave(buffer, info.channels, channels.data(), count);
+        total_frames_read += count;
+
         if (count < frames_per_read)
         {
             break;
@@ -318,6 +339,14 @@ sample Buffer::get_frame(int channel, double frame)
         frame = 0;
     }
 
+    if (this->page_states)
+    {
+        if (!this->is_frame_resident((int) frame) || !this->is_frame_resident((int) ceil(frame)))
+        {
+            return 0.0;
+        }
+    }
+
     if (this->interpolate == SIGNALFLOW_INTERPOLATION_LINEAR)
     {
         double frame_frac = (frame - (int) frame);
@@ -334,6 +363,31 @@ sample Buffer::get_frame(int channel, double frame)
     }
 }
 
+bool Buffer::is_frame_resident(int frame)
+{
+    int page = frame >> this->page_shift;
+    uint8_t state = this->page_states[page].load(std::memory_order_acquire);
+    if (state >= SIGNALFLOW_BUFFER_PAGE_RESIDENT && this->page_last_read)
+    {
+        uint32_t now = Buffer::page_clock.load(std::memory_order_relaxed);
+        if (this->page_last_read[page].load(std::memory_order_relaxed) != now)
+        {
+            this->page_last_read[page].store(now, std::memory_order_relaxed);
+        }
+    }
+    if (state == SIGNALFLOW_BUFFER_PAGE_RESIDENT)
+    {
+        return true;
+    }
+
+    this->request_page(page);
+    return state == SIGNALFLOW_BUFFER_PAGE_READ_AHEAD;
+}
+
+void Buffer::request_page(int page)
+{
+}
+
 sample Buffer::get(int channel, double offset)
 {
     double frame = this->offset_to_frame(offset);
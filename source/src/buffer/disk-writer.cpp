@@ -0,0 +1,187 @@
+#include "signalflow/buffer/disk-writer.h"
+#include "signalflow/core/core.h"
+#include "signalflow/core/vector.h"
+
+#include <algorithm>
+#include <string.h>
+#include <unistd.h>
+
+/*------------------------------------------------------------------------
+ * Interval between successive passes of the writer thread, in
+ * microseconds. Must be comfortably shorter than the buffer duration.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_DISK_WRITER_INTERVAL_US 10000
+
+namespace signalflow
+{
+
+DiskWriter::DiskWriter(const std::string &filename,
+                       int num_channels,
+                       int sample_rate,
+                       signalflow_recording_format_t format,
+                       float buffer_duration)
+    : num_channels(num_channels),
+      ring(std::max((int) (sample_rate * buffer_duration), SIGNALFLOW_NODE_BUFFER_SIZE) * std::max(num_channels, 1)),
+      input_buffer(SIGNALFLOW_NODE_BUFFER_SIZE * std::max(num_channels, 1)),
+      output_buffer(SIGNALFLOW_NODE_BUFFER_SIZE * std::max(num_channels, 1))
+{
+    if (num_channels < 1 || num_channels > SIGNALFLOW_MAX_CHANNELS)
+    {
+        throw std::runtime_error("DiskWriter: Invalid number of channels");
+    }
+
+    SF_INFO info;
+    memset(&info, 0, sizeof(SF_INFO));
+    info.channels = num_channels;
+    info.samplerate = sample_rate;
+    switch (format)
+    {
+        case SIGNALFLOW_RECORDING_FORMAT_FLOAT32:
+            info.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+            break;
+        case SIGNALFLOW_RECORDING_FORMAT_PCM16:
+            info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+            break;
+        case SIGNALFLOW_RECORDING_FORMAT_PCM24:
+            info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_24;
+            break;
+        case SIGNALFLOW_RECORDING_FORMAT_FLAC:
+            info.format = SF_FORMAT_FLAC | SF_FORMAT_PCM_24;
+            break;
+        default:
+            throw std::runtime_error("DiskWriter: Unknown recording format");
+    }
+
+    this->file = sf_open(filename.c_str(), SFM_WRITE, &info);
+    if (!this->file)
+    {
+        throw std::runtime_error(std::string("Failed to write soundfile (") + std::string(sf_strerror(NULL)) + ")");
+    }
+
+    /*------------------------------------------------------------------------
+     * Clip out-of-range samples for integer formats, rather than wrapping.
+     *-----------------------------------------------------------------------*/
+    if (format != SIGNALFLOW_RECORDING_FORMAT_FLOAT32)
+    {
+        sf_command(this->file, SFC_SET_CLIPPING, NULL, SF_TRUE);
+    }
+
+    this->overflow_count = 0;
+    this->frames_dropped = 0;
+    this->frames_written = 0;
+    this->closed = false;
+    this->running = true;
+    this->thread = std::thread(&DiskWriter::run_thread, this);
+}
+
+DiskWriter::~DiskWriter()
+{
+    this->close();
+}
+
+void DiskWriter::write(sample *const *channels, int num_frames, bool wait)
+{
+    if (this->closed.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    /*------------------------------------------------------------------------
+     * Write in chunks of at most SIGNALFLOW_NODE_BUFFER_SIZE frames, which
+     * is the size of the interleave buffer. Each chunk is either written
+     * in full or dropped, so that the file never contains partial frames.
+     *-----------------------------------------------------------------------*/
+    sample *chunk_channels[SIGNALFLOW_MAX_CHANNELS];
+    for (int offset = 0; offset < num_frames; offset += SIGNALFLOW_NODE_BUFFER_SIZE)
+    {
+        int chunk_frames = std::min(num_frames - offset, SIGNALFLOW_NODE_BUFFER_SIZE);
+        int chunk_samples = chunk_frames * this->num_channels;
+        while (wait && this->ring.get_write_available() < chunk_samples)
+        {
+            usleep(SIGNALFLOW_DISK_WRITER_INTERVAL_US / 10);
+        }
+        if (this->ring.get_write_available() < chunk_samples)
+        {
+            this->overflow_count.fetch_add(1, std::memory_order_relaxed);
+            this->frames_dropped.fetch_add(chunk_frames, std::memory_order_relaxed);
+            continue;
+        }
+
+        for (int channel = 0; channel < this->num_channels; channel++)
+        {
+            chunk_channels[channel] = channels[channel] + offset;
+        }
+        signalflow_vector_interleave(chunk_channels, this->num_channels, this->input_buffer.data(), chunk_frames);
+        this->ring.write(this->input_buffer.data(), chunk_samples);
+    }
+}
+
+void DiskWriter::drain()
+{
+    while (true)
+    {
+        int num_samples = this->ring.read(this->output_buffer.data(), (int) this->output_buffer.size());
+        if (num_samples == 0)
+        {
+            break;
+        }
+
+        /*------------------------------------------------------------------------
+         * The producer only ever writes whole frames, and output_buffer holds
+         * a whole number of frames, so num_samples is always a multiple of
+         * num_channels.
+         *-----------------------------------------------------------------------*/
+        int num_frames = num_samples / this->num_channels;
+        sf_count_t count = sf_writef_float(this->file, this->output_buffer.data(), num_frames);
+        if (count != num_frames)
+        {
+            signalflow_debug("DiskWriter: Failed to write to soundfile (%s)", sf_strerror(this->file));
+        }
+        this->frames_written.fetch_add((long) count, std::memory_order_relaxed);
+    }
+}
+
+void DiskWriter::run_thread()
+{
+    while (this->running)
+    {
+        this->drain();
+        usleep(SIGNALFLOW_DISK_WRITER_INTERVAL_US);
+    }
+}
+
+void DiskWriter::close()
+{
+    if (this->closed.exchange(true))
+    {
+        return;
+    }
+
+    this->running = false;
+    this->thread.join();
+    this->drain();
+    sf_close(this->file);
+    this->file = nullptr;
+}
+
+int DiskWriter::get_num_channels()
+{
+    return this->num_channels;
+}
+
+int DiskWriter::get_overflow_count()
+{
+    return this->overflow_count.load(std::memory_order_relaxed);
+}
+
+long DiskWriter::get_frames_dropped()
+{
+    return this->frames_dropped.load(std::memory_order_relaxed);
+}
+
+long DiskWriter::get_frames_written()
+{
+    return this->frames_written.load(std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,630 @@
+#include "signalflow/buffer/streaming-buffer.h"
+#include "signalflow/core/constants.h"
+#include "signalflow/core/core.h"
+#include "signalflow/core/vector.h"
+
+#include <sndfile.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <functional>
+#include <limits>
+#include <math.h>
+#include <mutex>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#else
+#include <semaphore.h>
+#endif
+
+#define SIGNALFLOW_STREAMING_BUFFER_CACHE_BLOCK_SIZE 65536
+
+namespace signalflow
+{
+
+/*--------------------------------------------------------------------------------
+ * StreamingBufferPager pages in the pages requested by all StreamingBuffers,
+ * on a single background thread, and releases the least recently read pages
+ * once their total size exceeds SIGNALFLOW_STREAMING_BUFFER_MAX_RESIDENT_BYTES.
+ *
+ * Requests are made from the audio thread by setting a page's state to
+ * REQUESTED and calling wake(), which never blocks. The pager is created
+ * with the first StreamingBuffer and never destroyed, so that wake() is
+ * always safe to call.
+ *
+ * Each pass of the pager advances Buffer::page_clock, which reads of a
+ * resident page stamp it with.
+ *-------------------------------------------------------------------------------*/
+class StreamingBufferPager
+{
+public:
+    static StreamingBufferPager *get_pager()
+    {
+        static StreamingBufferPager *pager = new StreamingBufferPager();
+        return pager;
+    }
+
+    void add(StreamingBuffer *buffer)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->buffers.push_back(buffer);
+    }
+
+    void remove(StreamingBuffer *buffer)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->buffers.erase(std::remove(this->buffers.begin(), this->buffers.end(), buffer), this->buffers.end());
+        for (int page = buffer->num_preloaded_pages; page < buffer->num_pages; page++)
+        {
+            if (buffer->pages[page].load() >= SIGNALFLOW_BUFFER_PAGE_RESIDENT)
+            {
+                this->resident_bytes -= StreamingBufferPager::get_page_bytes(buffer, page);
+            }
+        }
+        this->released_pages.erase(std::remove_if(this->released_pages.begin(), this->released_pages.end(),
+                                                  [buffer](const ReleasedPage &released_page) {
+                                                      return released_page.buffer == buffer;
+                                                  }),
+                                   this->released_pages.end());
+    }
+
+    void wake()
+    {
+#ifdef __APPLE__
+        dispatch_semaphore_signal(this->semaphore);
+#else
+        sem_post(&this->semaphore);
+#endif
+    }
+
+private:
+    struct ReleasedPage
+    {
+        StreamingBuffer *buffer;
+        int page;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    StreamingBufferPager()
+    {
+#ifdef __APPLE__
+        this->semaphore = dispatch_semaphore_create(0);
+#else
+        sem_init(&this->semaphore, 0, 0);
+#endif
+        this->resident_bytes = 0;
+        this->thread = std::thread(&StreamingBufferPager::run_thread, this);
+    }
+
+    static size_t get_page_bytes(StreamingBuffer *buffer, int page)
+    {
+        int start_frame = page << buffer->page_shift;
+        int page_frames = std::min(1 << buffer->page_shift, buffer->num_frames - start_frame);
+        return (size_t) page_frames * buffer->num_channels * sizeof(sample);
+    }
+
+    /*--------------------------------------------------------------------------------
+     * Wait to be woken, or, if timeout is non-zero, for at most timeout seconds.
+     *-------------------------------------------------------------------------------*/
+    void wait(double timeout)
+    {
+#ifdef __APPLE__
+        dispatch_semaphore_wait(this->semaphore,
+                                timeout > 0 ? dispatch_time(DISPATCH_TIME_NOW, (int64_t) (timeout * 1e9))
+                                            : DISPATCH_TIME_FOREVER);
+#else
+        if (timeout > 0)
+        {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            long nanoseconds = deadline.tv_nsec + (long) (timeout * 1e9);
+            deadline.tv_sec += nanoseconds / 1000000000L;
+            deadline.tv_nsec = nanoseconds % 1000000000L;
+            while (sem_timedwait(&this->semaphore, &deadline) != 0 && errno == EINTR)
+            {
+            }
+        }
+        else
+        {
+            while (sem_wait(&this->semaphore) != 0)
+            {
+            }
+        }
+#endif
+    }
+
+    void run_thread()
+    {
+        while (true)
+        {
+            this->wait(this->released_pages.empty() ? 0 : SIGNALFLOW_STREAMING_BUFFER_RELEASE_DELAY);
+
+            std::lock_guard<std::mutex> lock(this->mutex);
+            uint32_t now = StreamingBuffer::page_clock.fetch_add(1) + 1;
+            for (StreamingBuffer *buffer : this->buffers)
+            {
+                for (int page = 0; page < buffer->num_pages; page++)
+                {
+                    if (buffer->pages[page].load(std::memory_order_acquire) != SIGNALFLOW_BUFFER_PAGE_REQUESTED)
+                    {
+                        continue;
+                    }
+
+                    buffer->load_page(page);
+                    buffer->page_reads[page].store(now, std::memory_order_relaxed);
+                    this->resident_bytes += StreamingBufferPager::get_page_bytes(buffer, page);
+
+                    /*--------------------------------------------------------------------------------
+                     * If the next page is absent, mark this one so that reading it
+                     * extends the read-ahead.
+                     *-------------------------------------------------------------------------------*/
+                    bool is_last = (page + 1 < buffer->num_pages) && (buffer->pages[page + 1].load() == SIGNALFLOW_BUFFER_PAGE_ABSENT);
+                    buffer->pages[page].store(is_last ? SIGNALFLOW_BUFFER_PAGE_READ_AHEAD : SIGNALFLOW_BUFFER_PAGE_RESIDENT,
+                                              std::memory_order_release);
+                }
+            }
+
+            while (this->resident_bytes > SIGNALFLOW_STREAMING_BUFFER_MAX_RESIDENT_BYTES && this->evict_page(now))
+            {
+            }
+
+            this->discard_released_pages();
+        }
+    }
+
+    /*--------------------------------------------------------------------------------
+     * Release the least recently read page that is not preloaded, and is not
+     * being read or within the read-ahead of a page being read. A page counts
+     * as being read if it was read during this pass or the last.
+     *
+     * Returns false if there is no page that can be released.
+     *-------------------------------------------------------------------------------*/
+    bool evict_page(uint32_t now)
+    {
+        StreamingBuffer *oldest_buffer = nullptr;
+        int oldest_page = 0;
+        uint32_t oldest_age = 0;
+
+        for (StreamingBuffer *buffer : this->buffers)
+        {
+            int read_ahead_end = -1;
+            for (int page = 0; page < buffer->num_pages; page++)
+            {
+                if (buffer->pages[page].load(std::memory_order_acquire) < SIGNALFLOW_BUFFER_PAGE_RESIDENT)
+                {
+                    continue;
+                }
+
+                uint32_t age = now - buffer->page_reads[page].load(std::memory_order_relaxed);
+                if (age <= 1)
+                {
+                    read_ahead_end = page + SIGNALFLOW_STREAMING_BUFFER_READ_AHEAD_PAGES;
+                    continue;
+                }
+                if (page < buffer->num_preloaded_pages || page <= read_ahead_end)
+                {
+                    continue;
+                }
+                if (!oldest_buffer || age > oldest_age)
+                {
+                    oldest_buffer = buffer;
+                    oldest_page = page;
+                    oldest_age = age;
+                }
+            }
+        }
+
+        if (!oldest_buffer)
+        {
+            return false;
+        }
+
+        oldest_buffer->release_page(oldest_page);
+        this->resident_bytes -= StreamingBufferPager::get_page_bytes(oldest_buffer, oldest_page);
+        this->released_pages.push_back({ oldest_buffer, oldest_page, std::chrono::steady_clock::now() });
+        return true;
+    }
+
+    /*--------------------------------------------------------------------------------
+     * The audio thread may still be reading a page that it found resident
+     * just before it was released, so its memory is only discarded once
+     * SIGNALFLOW_STREAMING_BUFFER_RELEASE_DELAY has passed, and only if it
+     * has not been requested again since.
+     *-------------------------------------------------------------------------------*/
+    void discard_released_pages()
+    {
+        auto now = std::chrono::steady_clock::now();
+        auto delay = std::chrono::duration<double>(SIGNALFLOW_STREAMING_BUFFER_RELEASE_DELAY);
+        auto it = this->released_pages.begin();
+        while (it != this->released_pages.end() && now - it->time >= delay)
+        {
+            if (it->buffer->pages[it->page].load(std::memory_order_acquire) == SIGNALFLOW_BUFFER_PAGE_ABSENT)
+            {
+                it->buffer->discard_page(it->page);
+            }
+            it++;
+        }
+        this->released_pages.erase(this->released_pages.begin(), it);
+    }
+
+    std::mutex mutex;
+    std::vector<StreamingBuffer *> buffers;
+    std::deque<ReleasedPage> released_pages;
+    size_t resident_bytes;
+    std::thread thread;
+
+#ifdef __APPLE__
+    dispatch_semaphore_t semaphore;
+#else
+    sem_t semaphore;
+#endif
+};
+
+StreamingBuffer::StreamingBuffer(std::string filename, float preload_duration, std::string cache_dir)
+    : Buffer()
+{
+    std::string path = Buffer::resolve_path(filename);
+
+    SF_INFO info;
+    memset(&info, 0, sizeof(SF_INFO));
+    SNDFILE *sndfile = sf_open(path.c_str(), SFM_READ, &info);
+    if (!sndfile)
+    {
+        throw std::runtime_error(std::string("Couldn't read audio from path: ") + filename);
+    }
+    sf_close(sndfile);
+
+    if (info.frames > std::numeric_limits<int>::max())
+    {
+        throw std::runtime_error(std::string("Audio file is too long to stream: ") + filename);
+    }
+
+    this->num_channels = info.channels;
+    this->num_frames = (int) info.frames;
+    this->sample_rate = info.samplerate;
+    this->duration = this->num_frames / this->sample_rate;
+    this->map_size = (size_t) this->num_channels * this->num_frames * sizeof(sample);
+    this->page_miss_count = 0;
+
+    /*--------------------------------------------------------------------------------
+     * The cache file is named after the file's path, size and modification
+     * time, so that a modified file is decoded again.
+     *-------------------------------------------------------------------------------*/
+    if (cache_dir.empty())
+    {
+        mkdir((SIGNALFLOW_USER_DIR).c_str(), 0755);
+        cache_dir = SIGNALFLOW_USER_DIR + "/cache";
+    }
+    mkdir(cache_dir.c_str(), 0755);
+
+    struct stat file_stat;
+    stat(path.c_str(), &file_stat);
+    char *real_path = realpath(path.c_str(), NULL);
+    std::string key = std::string(real_path ? real_path : path.c_str())
+                      + ":" + std::to_string(file_stat.st_size)
+                      + ":" + std::to_string(file_stat.st_mtime);
+    free(real_path);
+
+    std::string basename = path.substr(path.find_last_of('/') + 1);
+    std::stringstream cache_name;
+    cache_name << basename << "-" << std::hex << std::hash<std::string>()(key) << ".f32";
+    this->cache_path = cache_dir + "/" + cache_name.str();
+
+    struct stat cache_stat;
+    if (stat(this->cache_path.c_str(), &cache_stat) != 0 || (size_t) cache_stat.st_size != this->map_size)
+    {
+        this->create_cache(path, this->cache_path);
+    }
+
+    /*--------------------------------------------------------------------------------
+     * Map the cache privately, so that the buffer's data can be written to
+     * like any other Buffer's without modifying the cache.
+     *-------------------------------------------------------------------------------*/
+    this->num_pages = 0;
+    this->num_preloaded_pages = 0;
+    if (this->map_size == 0)
+    {
+        return;
+    }
+
+    int fd = open(this->cache_path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Couldn't open cache file: " + this->cache_path);
+    }
+    void *map = mmap(NULL, this->map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        throw std::runtime_error("Couldn't map cache file: " + this->cache_path);
+    }
+
+    this->data = new sample *[this->num_channels]();
+    for (int channel = 0; channel < this->num_channels; channel++)
+    {
+        this->data[channel] = (sample *) map + (size_t) this->num_frames * channel;
+    }
+
+    this->page_shift = SIGNALFLOW_STREAMING_BUFFER_PAGE_SHIFT;
+    this->num_pages = ((this->num_frames - 1) >> this->page_shift) + 1;
+    this->pages.reset(new std::atomic<uint8_t>[this->num_pages]);
+    this->page_reads.reset(new std::atomic<uint32_t>[this->num_pages]);
+    for (int page = 0; page < this->num_pages; page++)
+    {
+        this->pages[page] = SIGNALFLOW_BUFFER_PAGE_ABSENT;
+        this->page_reads[page] = 0;
+    }
+
+    /*--------------------------------------------------------------------------------
+     * Page in and lock the start of the file, so that playback can start
+     * without waiting for the pager. Locking is best-effort, as it may
+     * exceed the process's limit on locked memory.
+     *-------------------------------------------------------------------------------*/
+    if (preload_duration > 0)
+    {
+        int preload_frames = (int) ceil(preload_duration * this->sample_rate);
+        this->num_preloaded_pages = std::min(this->num_pages, ((preload_frames - 1) >> this->page_shift) + 1);
+    }
+    for (int page = 0; page < this->num_preloaded_pages; page++)
+    {
+        this->load_page(page);
+        int start_frame = page << this->page_shift;
+        int page_frames = std::min(this->get_page_size(), this->num_frames - start_frame);
+        for (int channel = 0; channel < this->num_channels; channel++)
+        {
+            if (mlock(this->data[channel] + start_frame, page_frames * sizeof(sample)) != 0)
+            {
+                signalflow_debug("StreamingBuffer: Couldn't lock preloaded page %d", page);
+            }
+        }
+        bool is_last = (page == this->num_preloaded_pages - 1) && (page + 1 < this->num_pages);
+        this->pages[page] = is_last ? SIGNALFLOW_BUFFER_PAGE_READ_AHEAD : SIGNALFLOW_BUFFER_PAGE_RESIDENT;
+    }
+
+    this->page_states = this->pages.get();
+    this->page_last_read = this->page_reads.get();
+    StreamingBufferPager::get_pager()->add(this);
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+    if (this->page_states)
+    {
+        StreamingBufferPager::get_pager()->remove(this);
+    }
+
+    if (this->data)
+    {
+        munmap(this->data[0], this->map_size);
+        delete[] this->data;
+        this->data = NULL;
+    }
+}
+
+void StreamingBuffer::create_cache(std::string path, std::string cache_path)
+{
+    /*--------------------------------------------------------------------------------
+     * Decode into a temporary file and then rename it, so that an interrupted
+     * decode never leaves behind a cache file that looks complete.
+     *-------------------------------------------------------------------------------*/
+    std::string temp_path = cache_path + "." + std::to_string(getpid()) + ".tmp";
+    int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Couldn't create cache file: " + temp_path);
+    }
+
+    SF_INFO info;
+    memset(&info, 0, sizeof(SF_INFO));
+    SNDFILE *sndfile = sf_open(path.c_str(), SFM_READ, &info);
+    if (!sndfile)
+    {
+        close(fd);
+        unlink(temp_path.c_str());
+        throw std::runtime_error(std::string("Couldn't read audio from path: ") + path);
+    }
+
+    /*--------------------------------------------------------------------------------
+     * The cache holds each channel contiguously, in the same layout as a
+     * Buffer's data, so that it can be mapped directly.
+     *-------------------------------------------------------------------------------*/
+    int frames_per_read = SIGNALFLOW_STREAMING_BUFFER_CACHE_BLOCK_SIZE;
+    std::vector<sample> interleaved(frames_per_read * this->num_channels);
+    std::vector<sample> planar(frames_per_read * this->num_channels);
+    std::vector<sample *> channels(this->num_channels);
+    for (int channel = 0; channel < this->num_channels; channel++)
+    {
+        channels[channel] = planar.data() + frames_per_read * channel;
+    }
+
+    bool failed = (ftruncate(fd, this->map_size) != 0);
+    int total_frames_read = 0;
+    while (!failed && total_frames_read < this->num_frames)
+    {
+        int count = (int) sf_readf_float(sndfile, interleaved.data(), frames_per_read);
+        count = std::min(count, this->num_frames - total_frames_read);
+        if (count <= 0)
+        {
+            break;
+        }
+        signalflow_vector_deinterleave(interleaved.data(), this->num_channels, channels.data(), count);
+
+        for (int channel = 0; channel < this->num_channels; channel++)
+        {
+            off_t offset = ((off_t) this->num_frames * channel + total_frames_read) * sizeof(sample);
+            size_t num_bytes = count * sizeof(sample);
+            if (pwrite(fd, channels[channel], num_bytes, offset) != (ssize_t) num_bytes)
+            {
+                failed = true;
+                break;
+            }
+        }
+        total_frames_read += count;
+    }
+
+    sf_close(sndfile);
+    if (close(fd) != 0 || failed || rename(temp_path.c_str(), cache_path.c_str()) != 0)
+    {
+        unlink(temp_path.c_str());
+        throw std::runtime_error("Couldn't write cache file: " + cache_path);
+    }
+}
+
+void StreamingBuffer::load_page(int page)
+{
+    int start_frame = page << this->page_shift;
+    int page_frames = std::min(this->get_page_size(), this->num_frames - start_frame);
+    size_t os_page_size = (size_t) sysconf(_SC_PAGESIZE);
+
+    /*--------------------------------------------------------------------------------
+     * Advise the kernel of the whole range first, so that it can read
+     * each channel's range in parallel, then touch every memory page to
+     * wait until they are all resident.
+     *-------------------------------------------------------------------------------*/
+    for (int channel = 0; channel < this->num_channels; channel++)
+    {
+        uintptr_t start = (uintptr_t) (this->data[channel] + start_frame);
+        uintptr_t aligned_start = start - (start % os_page_size);
+        madvise((void *) aligned_start, start + page_frames * sizeof(sample) - aligned_start, MADV_WILLNEED);
+    }
+
+    for (int channel = 0; channel < this->num_channels; channel++)
+    {
+        const volatile char *start = (const volatile char *) (this->data[channel] + start_frame);
+        size_t num_bytes = page_frames * sizeof(sample);
+        for (size_t offset = 0; offset < num_bytes; offset += os_page_size)
+        {
+            (void) start[offset];
+        }
+        (void) start[num_bytes - 1];
+    }
+}
+
+void StreamingBuffer::release_page(int page)
+{
+    this->pages[page].store(SIGNALFLOW_BUFFER_PAGE_ABSENT, std::memory_order_release);
+}
+
+void StreamingBuffer::discard_page(int page)
+{
+    /*--------------------------------------------------------------------------------
+     * Only release memory pages that lie entirely within this page, so that
+     * neighbouring pages remain resident.
+     *-------------------------------------------------------------------------------*/
+    int start_frame = page << this->page_shift;
+    int page_frames = std::min(this->get_page_size(), this->num_frames - start_frame);
+    size_t os_page_size = (size_t) sysconf(_SC_PAGESIZE);
+    for (int channel = 0; channel < this->num_channels; channel++)
+    {
+        uintptr_t start = (uintptr_t) (this->data[channel] + start_frame);
+        uintptr_t end = start + page_frames * sizeof(sample);
+        uintptr_t aligned_start = ((start + os_page_size - 1) / os_page_size) * os_page_size;
+        uintptr_t aligned_end = (end / os_page_size) * os_page_size;
+        if (aligned_end > aligned_start)
+        {
+            madvise((void *) aligned_start, aligned_end - aligned_start, MADV_DONTNEED);
+        }
+    }
+}
+
+void StreamingBuffer::request_page(int page)
+{
+    /*--------------------------------------------------------------------------------
+     * Called from the audio thread, so must not block: mark the page and
+     * those that follow it as requested, and wake the pager.
+     *-------------------------------------------------------------------------------*/
+    bool requested = false;
+    uint8_t state = this->pages[page].load(std::memory_order_acquire);
+    if (state == SIGNALFLOW_BUFFER_PAGE_READ_AHEAD)
+    {
+        if (!this->pages[page].compare_exchange_strong(state, SIGNALFLOW_BUFFER_PAGE_RESIDENT))
+        {
+            return;
+        }
+    }
+    else if (state == SIGNALFLOW_BUFFER_PAGE_ABSENT)
+    {
+        if (!this->pages[page].compare_exchange_strong(state, SIGNALFLOW_BUFFER_PAGE_REQUESTED))
+        {
+            return;
+        }
+        this->page_miss_count.fetch_add(1, std::memory_order_relaxed);
+        requested = true;
+    }
+    else
+    {
+        return;
+    }
+
+    int last_page = std::min(page + SIGNALFLOW_STREAMING_BUFFER_READ_AHEAD_PAGES, this->num_pages - 1);
+    for (int next_page = page + 1; next_page <= last_page; next_page++)
+    {
+        uint8_t expected = SIGNALFLOW_BUFFER_PAGE_ABSENT;
+        if (this->pages[next_page].compare_exchange_strong(expected, SIGNALFLOW_BUFFER_PAGE_REQUESTED))
+        {
+            requested = true;
+        }
+    }
+
+    if (requested)
+    {
+        StreamingBufferPager::get_pager()->wake();
+    }
+}
+
+std::string StreamingBuffer::get_cache_path()
+{
+    return this->cache_path;
+}
+
+int StreamingBuffer::get_page_size()
+{
+    return 1 << this->page_shift;
+}
+
+int StreamingBuffer::get_num_pages()
+{
+    return this->num_pages;
+}
+
+int StreamingBuffer::get_num_resident_pages()
+{
+    int count = 0;
+    for (int page = 0; page < this->num_pages; page++)
+    {
+        if (this->pages[page].load() >= SIGNALFLOW_BUFFER_PAGE_RESIDENT)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool StreamingBuffer::get_frame_is_resident(int frame)
+{
+    if (frame < 0 || frame >= this->num_frames)
+    {
+        return false;
+    }
+    return this->pages[frame >> this->page_shift].load() >= SIGNALFLOW_BUFFER_PAGE_RESIDENT;
+}
+
+long StreamingBuffer::get_page_miss_count()
+{
+    return this->page_miss_count.load();
+}
+
+}
@@ -101,6 +101,10 @@ AudioGraphConfig::AudioGraphConfig()
                 {
                     this->output_buffer_size = std::stoi(parameter_value);
                 }
+                else if (parameter_name == "block_size")
+                {
+                    this->block_size = std::stoi(parameter_value);
+                }
                 else if (parameter_name == "input_device_name")
                 {
                     this->input_device_name = parameter_value;
@@ -109,6 +113,25 @@ AudioGraphConfig::AudioGraphConfig()
                 {
                     this->output_device_name = parameter_value;
                 }
+                else if (parameter_name == "render_thread_count")
+                {
+                    this->render_thread_count = std::stoi(parameter_value);
+                }
+                else if (parameter_name == "render_ahead_blocks")
+                {
+                    this->render_ahead_blocks = std::stoi(parameter_value);
+                }
+                else if (parameter_name == "fft_planner_effort")
+                {
+                    if (parameter_value == "estimate")
+                        this->fft_planner_effort = SIGNALFLOW_FFT_PLANNER_ESTIMATE;
+                    else if (parameter_value == "measure")
+                        this->fft_planner_effort = SIGNALFLOW_FFT_PLANNER_MEASURE;
+                    else if (parameter_value == "patient")
+                        this->fft_planner_effort = SIGNALFLOW_FFT_PLANNER_PATIENT;
+                    else
+                        throw std::runtime_error("Invalid FFT planner effort: " + parameter_value);
+                }
                 else
                 {
                     throw std::runtime_error("Invalid section parameter name: " + section_name + " > " + parameter_name);
@@ -152,6 +175,16 @@ void AudioGraphConfig::set_output_buffer_size(unsigned int buffer_size)
     this->output_buffer_size = buffer_size;
 }
 
+unsigned int AudioGraphConfig::get_block_size() const
+{
+    return this->block_size;
+}
+
+void AudioGraphConfig::set_block_size(unsigned int block_size)
+{
+    this->block_size = block_size;
+}
+
 const std::string &AudioGraphConfig::get_input_device_name() const
 {
     return this->input_device_name;
@@ -172,6 +205,36 @@ void AudioGraphConfig::set_output_device_name(const std::string &name)
     this->output_device_name = name;
 }
 
+unsigned int AudioGraphConfig::get_render_thread_count() const
+{
+    return this->render_thread_count;
+}
+
+void AudioGraphConfig::set_render_thread_count(unsigned int count)
+{
+    this->render_thread_count = count;
+}
+
+unsigned int AudioGraphConfig::get_render_ahead_blocks() const
+{
+    return this->render_ahead_blocks;
+}
+
+void AudioGraphConfig::set_render_ahead_blocks(unsigned int count)
+{
+    this->render_ahead_blocks = count;
+}
+
+signalflow_fft_planner_effort_t AudioGraphConfig::get_fft_planner_effort() const
+{
+    return this->fft_planner_effort;
+}
+
+void AudioGraphConfig::set_fft_planner_effort(signalflow_fft_planner_effort_t effort)
+{
+    this->fft_planner_effort = effort;
+}
+
 void AudioGraphConfig::print() const
 {
     std::cout << "SignalFlow config" << std::endl;
@@ -179,8 +242,12 @@ void AudioGraphConfig::print() const
     std::cout << " - sample_rate = " << this->sample_rate << std::endl;
     std::cout << " - input_buffer_size = " << this->input_buffer_size << std::endl;
     std::cout << " - output_buffer_size = " << this->output_buffer_size << std::endl;
+    std::cout << " - block_size = " << this->block_size << std::endl;
     std::cout << " - input_device_name = " << this->input_device_name << std::endl;
     std::cout << " - output_device_name = " << this->output_device_name << std::endl;
+    std::cout << " - render_thread_count = " << this->render_thread_count << std::endl;
+    std::cout << " - render_ahead_blocks = " << this->render_ahead_blocks << std::endl;
+    std::cout << " - fft_planner_effort = " << this->fft_planner_effort << std::endl;
 }
 
 }
@@ -0,0 +1,80 @@
+#include "signalflow/core/graph-reclaimer.h"
+#include "signalflow/core/core.h"
+
+#include <unistd.h>
+
+#if defined(__APPLE__)
+#include <pthread.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+/*------------------------------------------------------------------------
+ * Interval between reclamation passes, in microseconds.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_RECLAIM_INTERVAL_US 10000
+
+namespace signalflow
+{
+
+AudioGraphReclaimer::AudioGraphReclaimer(int capacity)
+    : garbage(capacity)
+{
+    this->running = true;
+    this->thread = std::thread(&AudioGraphReclaimer::run_thread, this);
+}
+
+AudioGraphReclaimer::~AudioGraphReclaimer()
+{
+    this->running = false;
+    this->thread.join();
+    this->reclaim();
+}
+
+void AudioGraphReclaimer::release(std::shared_ptr<void> object)
+{
+    /*--------------------------------------------------------------------------------
+     * push() only moves from `object` on success. Otherwise, the reference
+     * is dropped when `object` goes out of scope.
+     *-------------------------------------------------------------------------------*/
+    this->garbage.push(object);
+}
+
+int AudioGraphReclaimer::get_overflow_count()
+{
+    return this->garbage.get_overflow_count();
+}
+
+void AudioGraphReclaimer::reclaim()
+{
+    std::shared_ptr<void> object;
+    while (this->garbage.pop(object))
+    {
+        object.reset();
+    }
+}
+
+void AudioGraphReclaimer::run_thread()
+{
+    /*--------------------------------------------------------------------------------
+     * Run below normal priority: freeing memory is never urgent, and should
+     * not compete with the audio thread or the application's own threads.
+     *-------------------------------------------------------------------------------*/
+#if defined(__APPLE__)
+    pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0);
+#elif defined(__linux__)
+    if (setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), 10) != 0)
+    {
+        signalflow_debug("AudioGraphReclaimer: Couldn't lower thread priority");
+    }
+#endif
+
+    while (this->running)
+    {
+        this->reclaim();
+        usleep(SIGNALFLOW_RECLAIM_INTERVAL_US);
+    }
+}
+
+}
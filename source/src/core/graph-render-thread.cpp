@@ -0,0 +1,177 @@
+#include "signalflow/core/graph-render-thread.h"
+#include "signalflow/core/core.h"
+#include "signalflow/core/graph.h"
+#include "signalflow/core/vector.h"
+
+#include <iostream>
+#include <pthread.h>
+#include <string.h>
+
+namespace signalflow
+{
+
+AudioGraphRenderThread::AudioGraphRenderThread(AudioGraph *graph, int num_blocks, int num_channels)
+    : graph(graph),
+      num_channels(num_channels),
+      block_size(graph->get_block_size()),
+      ring(std::max(num_blocks, 1) * graph->get_block_size() * num_channels),
+      block(graph->get_block_size() * num_channels)
+{
+    if (num_blocks < 1)
+    {
+        throw std::runtime_error("AudioGraphRenderThread: Number of blocks must be positive");
+    }
+    if (num_channels < 1 || num_channels > SIGNALFLOW_MAX_CHANNELS)
+    {
+        throw std::runtime_error("AudioGraphRenderThread: Invalid channel count (" + std::to_string(num_channels) + ")");
+    }
+
+#ifdef __APPLE__
+    this->semaphore = dispatch_semaphore_create(0);
+#else
+    sem_init(&this->semaphore, 0, 0);
+#endif
+
+    this->running = false;
+}
+
+AudioGraphRenderThread::~AudioGraphRenderThread()
+{
+    this->stop();
+
+#ifdef __APPLE__
+    dispatch_release(this->semaphore);
+#else
+    sem_destroy(&this->semaphore);
+#endif
+}
+
+void AudioGraphRenderThread::start()
+{
+    if (this->running)
+    {
+        return;
+    }
+
+    this->render_blocks();
+    this->running = true;
+    this->thread = std::thread(&AudioGraphRenderThread::run_thread, this);
+}
+
+void AudioGraphRenderThread::stop()
+{
+    if (!this->running)
+    {
+        return;
+    }
+
+    this->running = false;
+    this->wake();
+    this->thread.join();
+}
+
+void AudioGraphRenderThread::read(sample *output, int num_frames)
+{
+    int num_samples = num_frames * this->num_channels;
+    int num_read = this->ring.read(output, num_samples);
+    if (num_read < num_samples)
+    {
+        memset(output + num_read, 0, (num_samples - num_read) * sizeof(sample));
+    }
+    signalflow_vector_clamp(output, -1.0, 1.0, output, num_samples);
+
+    this->wake();
+}
+
+int AudioGraphRenderThread::get_buffered_frames()
+{
+    return this->ring.get_read_available() / this->num_channels;
+}
+
+long AudioGraphRenderThread::get_underrun_count()
+{
+    return this->ring.get_underrun_count();
+}
+
+int AudioGraphRenderThread::get_num_channels()
+{
+    return this->num_channels;
+}
+
+void AudioGraphRenderThread::run_thread()
+{
+    /*--------------------------------------------------------------------------------
+     * Render at real-time priority, so that the ring is refilled promptly
+     * after each device callback. This requires privileges that may not be
+     * available, in which case continue at normal priority: the blocks held
+     * in the ring still absorb brief stalls.
+     *-------------------------------------------------------------------------------*/
+    struct sched_param param;
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+    {
+        signalflow_debug("AudioGraphRenderThread: Couldn't set real-time priority");
+    }
+
+    while (true)
+    {
+        this->wait();
+        if (!this->running)
+        {
+            break;
+        }
+
+        try
+        {
+            this->render_blocks();
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Exception in AudioGraph: " << e.what() << std::endl;
+            exit(1);
+        }
+    }
+}
+
+void AudioGraphRenderThread::render_blocks()
+{
+    /*--------------------------------------------------------------------------------
+     * Top up the ring with as many whole blocks as it has space for.
+     *-------------------------------------------------------------------------------*/
+    int block_samples = this->block_size * this->num_channels;
+    while (this->ring.get_write_available() >= block_samples)
+    {
+        this->graph->render(this->block_size);
+
+        sample *channels[SIGNALFLOW_MAX_CHANNELS];
+        Node *output = this->graph->get_output().get();
+        for (int channel = 0; channel < this->num_channels; channel++)
+        {
+            channels[channel] = output->out[channel];
+        }
+        signalflow_vector_interleave(channels, this->num_channels, this->block.data(), this->block_size);
+        this->ring.write(this->block.data(), block_samples);
+    }
+}
+
+void AudioGraphRenderThread::wake()
+{
+#ifdef __APPLE__
+    dispatch_semaphore_signal(this->semaphore);
+#else
+    sem_post(&this->semaphore);
+#endif
+}
+
+void AudioGraphRenderThread::wait()
+{
+#ifdef __APPLE__
+    dispatch_semaphore_wait(this->semaphore, DISPATCH_TIME_FOREVER);
+#else
+    while (sem_wait(&this->semaphore) != 0)
+    {
+    }
+#endif
+}
+
+}
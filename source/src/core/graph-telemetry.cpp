@@ -0,0 +1,89 @@
+#include "signalflow/core/graph-telemetry.h"
+
+#include <algorithm>
+#include <unistd.h>
+
+/*------------------------------------------------------------------------
+ * Interval between aggregation passes, in microseconds.
+ *-----------------------------------------------------------------------*/
+#define SIGNALFLOW_TELEMETRY_INTERVAL_US 50000
+
+namespace signalflow
+{
+
+AudioGraphTelemetry::AudioGraphTelemetry(int capacity)
+    : ring(capacity)
+{
+    this->dropped_count = 0;
+    this->running = true;
+    this->thread = std::thread(&AudioGraphTelemetry::run_thread, this);
+}
+
+AudioGraphTelemetry::~AudioGraphTelemetry()
+{
+    this->running = false;
+    this->thread.join();
+}
+
+void AudioGraphTelemetry::record(const signalflow_block_telemetry_t &block)
+{
+    if (this->ring.write(&block, 1) == 0)
+    {
+        this->dropped_count.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AudioGraphTelemetry::aggregate()
+{
+    signalflow_block_telemetry_t block;
+    while (this->ring.read(&block, 1))
+    {
+        double load = block.deadline > 0 ? block.render_duration / block.deadline : 0.0;
+        this->stats.block_count++;
+        if (load > 1.0)
+        {
+            this->stats.xrun_count++;
+        }
+        if (load > SIGNALFLOW_TELEMETRY_LATE_THRESHOLD)
+        {
+            this->stats.late_count++;
+        }
+        this->stats.max_render_duration = std::max(this->stats.max_render_duration, block.render_duration);
+        this->stats.max_load = std::max(this->stats.max_load, load);
+        this->stats.last_timestamp = block.timestamp;
+
+        int bucket = std::min((int) (load * 10), SIGNALFLOW_TELEMETRY_HISTOGRAM_SIZE - 1);
+        this->stats.histogram[bucket]++;
+    }
+}
+
+AudioGraphTelemetryStats AudioGraphTelemetry::get_stats()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->aggregate();
+    AudioGraphTelemetryStats stats = this->stats;
+    stats.dropped_count = this->dropped_count.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void AudioGraphTelemetry::reset()
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->aggregate();
+    this->stats = AudioGraphTelemetryStats();
+    this->dropped_count = 0;
+}
+
+void AudioGraphTelemetry::run_thread()
+{
+    while (this->running)
+    {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->aggregate();
+        }
+        usleep(SIGNALFLOW_TELEMETRY_INTERVAL_US);
+    }
+}
+
+}
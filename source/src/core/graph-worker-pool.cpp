@@ -0,0 +1,197 @@
+#include "signalflow/core/graph-worker-pool.h"
+#include "signalflow/core/core.h"
+#include "signalflow/core/graph.h"
+#include "signalflow/core/random.h"
+
+#include <pthread.h>
+
+namespace signalflow
+{
+
+AudioGraphWorkerPool::AudioGraphWorkerPool(AudioGraph *graph, int num_threads)
+    : graph(graph), num_threads(num_threads), num_tasks(0), num_frames(0)
+{
+    if (num_threads < 1)
+    {
+        throw std::runtime_error("AudioGraphWorkerPool: Thread count must be at least 1");
+    }
+
+#ifdef __APPLE__
+    this->semaphore = dispatch_semaphore_create(0);
+#else
+    sem_init(&this->semaphore, 0, 0);
+#endif
+
+    for (int i = 0; i < num_threads; i++)
+    {
+        TaskQueue *queue = new TaskQueue();
+        queue->next = 0;
+        this->queues.push_back(std::unique_ptr<TaskQueue>(queue));
+    }
+
+    this->running = true;
+    this->num_threads_finished = 0;
+
+    /*--------------------------------------------------------------------------------
+     * Thread 0 is the caller of run() (typically the audio I/O thread), so only
+     * num_threads - 1 workers are needed.
+     *-------------------------------------------------------------------------------*/
+    for (int i = 1; i < num_threads; i++)
+    {
+        this->threads.push_back(std::thread(&AudioGraphWorkerPool::run_thread, this, i));
+    }
+}
+
+AudioGraphWorkerPool::~AudioGraphWorkerPool()
+{
+    this->running = false;
+    this->wake_workers();
+    for (auto &thread : this->threads)
+    {
+        thread.join();
+    }
+
+#ifdef __APPLE__
+    dispatch_release(this->semaphore);
+#else
+    sem_destroy(&this->semaphore);
+#endif
+}
+
+void AudioGraphWorkerPool::set_task_count(int num_tasks)
+{
+    /*--------------------------------------------------------------------------------
+     * Tasks are dealt out round-robin. As tasks arrive in order of decreasing
+     * cost, this gives each thread a similar share of work to start with; any
+     * imbalance is then evened out by stealing.
+     *-------------------------------------------------------------------------------*/
+    this->num_tasks = num_tasks;
+}
+
+void AudioGraphWorkerPool::run(int num_frames)
+{
+    this->num_frames = num_frames;
+    for (auto &queue : this->queues)
+    {
+        queue->next.store(0, std::memory_order_relaxed);
+    }
+
+    this->wake_workers();
+    this->render_tasks(0);
+
+    /*--------------------------------------------------------------------------------
+     * Join: wait for every worker to finish its final task. By now the queues
+     * are empty, so this is a short wait for in-flight tasks only.
+     *-------------------------------------------------------------------------------*/
+    while (this->num_threads_finished.load(std::memory_order_acquire) < this->num_threads - 1)
+    {
+        std::this_thread::yield();
+    }
+    this->num_threads_finished.store(0, std::memory_order_relaxed);
+
+    if (this->exception)
+    {
+        std::exception_ptr exception = this->exception;
+        this->exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+int AudioGraphWorkerPool::get_num_threads()
+{
+    return this->num_threads;
+}
+
+void AudioGraphWorkerPool::wake_workers()
+{
+    for (int i = 1; i < this->num_threads; i++)
+    {
+#ifdef __APPLE__
+        dispatch_semaphore_signal(this->semaphore);
+#else
+        sem_post(&this->semaphore);
+#endif
+    }
+}
+
+void AudioGraphWorkerPool::wait_for_work()
+{
+#ifdef __APPLE__
+    dispatch_semaphore_wait(this->semaphore, DISPATCH_TIME_FOREVER);
+#else
+    while (sem_wait(&this->semaphore) != 0)
+    {
+    }
+#endif
+}
+
+void AudioGraphWorkerPool::run_thread(int thread_index)
+{
+    /*--------------------------------------------------------------------------------
+     * Request real-time scheduling, so that workers are not pre-empted by
+     * ordinary threads while the audio thread is waiting on them. This
+     * requires privileges that may not be available, in which case continue
+     * at normal priority.
+     *-------------------------------------------------------------------------------*/
+    struct sched_param param;
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+    {
+        signalflow_debug("AudioGraphWorkerPool: Couldn't set real-time priority for worker %d", thread_index);
+    }
+
+    /*--------------------------------------------------------------------------------
+     * Workers only ever render this graph, so always draw from its generator.
+     *-------------------------------------------------------------------------------*/
+    random_set_thread_generator(&this->graph->random_generators[thread_index]);
+
+    while (true)
+    {
+        this->wait_for_work();
+        if (!this->running)
+        {
+            break;
+        }
+
+        this->render_tasks(thread_index);
+        this->num_threads_finished.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void AudioGraphWorkerPool::render_tasks(int thread_index)
+{
+    /*--------------------------------------------------------------------------------
+     * Drain our own queue first, then visit each other thread's queue in turn
+     * and steal any tasks that haven't yet been claimed.
+     *-------------------------------------------------------------------------------*/
+    for (int offset = 0; offset < this->num_threads; offset++)
+    {
+        int queue_index = (thread_index + offset) % this->num_threads;
+        TaskQueue *queue = this->queues[queue_index].get();
+
+        while (true)
+        {
+            int index = queue->next.fetch_add(1, std::memory_order_relaxed);
+            int task_index = queue_index + index * this->num_threads;
+            if (task_index >= this->num_tasks)
+            {
+                break;
+            }
+
+            try
+            {
+                this->graph->render_task(task_index, this->num_frames);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(this->exception_mutex);
+                if (!this->exception)
+                {
+                    this->exception = std::current_exception();
+                }
+            }
+        }
+    }
+}
+
+}
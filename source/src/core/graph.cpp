@@ -1,6 +1,12 @@
 #include "signalflow/core/core.h"
 #include "signalflow/core/graph-monitor.h"
+#include "signalflow/core/graph-reclaimer.h"
+#include "signalflow/core/graph-render-thread.h"
+#include "signalflow/core/graph-telemetry.h"
+#include "signalflow/core/graph-worker-pool.h"
 #include "signalflow/core/graph.h"
+#include "signalflow/core/random.h"
+#include "signalflow/core/vector.h"
 #include "signalflow/node/node.h"
 #include "signalflow/node/oscillators/constant.h"
 
@@ -10,31 +16,157 @@
 #include "signalflow/node/io/output/ios.h"
 #include "signalflow/node/io/output/soundio.h"
 
+#include <algorithm>
+#include <chrono>
+#include <limits.h>
+#include <mutex>
 #include <string.h>
 #include <sys/time.h>
+#include <thread>
 #include <unistd.h>
 
 namespace signalflow
 {
 
-AudioGraph *shared_graph = NULL;
+/*------------------------------------------------------------------------
+ * All graphs that exist, in order of creation, and the graph that is
+ * current on each thread. Threads with no current graph use the first
+ * graph created. Only accessed when a graph, Node, Buffer or Patch is
+ * created or destroyed, never while rendering.
+ *-----------------------------------------------------------------------*/
+static std::mutex graphs_mutex;
+static std::vector<AudioGraph *> graphs;
+static std::unordered_map<std::thread::id, AudioGraph *> current_graphs;
+
+/*------------------------------------------------------------------------
+ * Set while the current thread is applying queued commands, so that
+ * any changes made as a side-effect are applied immediately rather than
+ * being re-queued.
+ *-----------------------------------------------------------------------*/
+static thread_local bool is_applying_commands = false;
+
+/*------------------------------------------------------------------------
+ * Set while the current thread is rendering the graph. Commands posted
+ * during rendering (for example, by a Patch that auto-frees) don't return
+ * a future, to avoid allocating on the audio thread.
+ *-----------------------------------------------------------------------*/
+static thread_local bool is_rendering = false;
+
+/*------------------------------------------------------------------------
+ * Sets a thread-local flag for the lifetime of the guard, clearing it
+ * even if rendering throws.
+ *-----------------------------------------------------------------------*/
+class ThreadFlagGuard
+{
+public:
+    ThreadFlagGuard(bool &flag)
+        : flag(flag) { flag = true; }
+    ~ThreadFlagGuard() { flag = false; }
+
+private:
+    bool &flag;
+};
+
+/*------------------------------------------------------------------------
+ * Draw random numbers from a graph's generator while rendering it.
+ *-----------------------------------------------------------------------*/
+class ThreadRandomGuard
+{
+public:
+    ThreadRandomGuard(std::mt19937 *generator)
+        : previous(random_set_thread_generator(generator)) {}
+    ~ThreadRandomGuard() { random_set_thread_generator(this->previous); }
+
+private:
+    std::mt19937 *previous;
+};
+
+/*------------------------------------------------------------------------
+ * Remove a graph from the list of graphs, and as the current graph of
+ * any thread.
+ *-----------------------------------------------------------------------*/
+static void unregister_graph(AudioGraph *graph)
+{
+    std::lock_guard<std::mutex> lock(graphs_mutex);
+    graphs.erase(std::remove(graphs.begin(), graphs.end(), graph), graphs.end());
+    for (auto it = current_graphs.begin(); it != current_graphs.end();)
+    {
+        if (it->second == graph)
+            it = current_graphs.erase(it);
+        else
+            ++it;
+    }
+}
+
+/*------------------------------------------------------------------------
+ * Take over the capacity of a container reserved on the control thread,
+ * if it is larger, moving the current contents into it.
+ *-----------------------------------------------------------------------*/
+template <typename T>
+static void adopt_capacity(std::vector<T> &current, std::vector<T> &reserved)
+{
+    if (reserved.capacity() > current.capacity())
+    {
+        reserved.clear();
+        reserved.insert(reserved.end(),
+                        std::make_move_iterator(current.begin()),
+                        std::make_move_iterator(current.end()));
+        current.clear();
+        current.swap(reserved);
+    }
+}
+
+/*------------------------------------------------------------------------
+ * Unregister a graph whose constructor throws once it has been
+ * registered, as its destructor is then never run.
+ *-----------------------------------------------------------------------*/
+class GraphRegistrationGuard
+{
+public:
+    GraphRegistrationGuard(AudioGraph *graph)
+        : graph(graph) {}
+    ~GraphRegistrationGuard()
+    {
+        if (this->graph)
+            unregister_graph(this->graph);
+    }
+    void dismiss() { this->graph = nullptr; }
+
+private:
+    AudioGraph *graph;
+};
 
 AudioGraph::AudioGraph(AudioGraphConfig *config,
                        NodeRef output_device,
                        bool start)
+    : commands(SIGNALFLOW_GRAPH_COMMAND_QUEUE_SIZE)
 {
     signalflow_init();
 
-    if (shared_graph)
+    /*------------------------------------------------------------------------
+     * Validate the config before registering the graph, so that an invalid
+     * config doesn't leave a dangling graph behind.
+     *-----------------------------------------------------------------------*/
+    if (config)
     {
-        throw graph_already_created_exception();
+        int block_size = config->get_block_size();
+        if (block_size > SIGNALFLOW_NODE_BUFFER_SIZE || (block_size & (block_size - 1)) != 0)
+        {
+            throw std::runtime_error("AudioGraph: Block size must be a power of two, no larger than " + std::to_string(SIGNALFLOW_NODE_BUFFER_SIZE));
+        }
+        this->config = *config;
     }
-    shared_graph = this;
 
-    if (config)
     {
-        this->config = *config;
+        std::lock_guard<std::mutex> lock(graphs_mutex);
+        if (current_graphs.count(std::this_thread::get_id()))
+        {
+            throw graph_already_created_exception("AudioGraph has already been created on this thread");
+        }
+        graphs.push_back(this);
+        current_graphs[std::this_thread::get_id()] = this;
     }
+    GraphRegistrationGuard registration(this);
 
     if (output_device)
     {
@@ -51,6 +183,13 @@ AudioGraph::AudioGraph(AudioGraphConfig *config,
         }
     }
 
+    /*------------------------------------------------------------------------
+     * Output devices are created without a graph, as they may be created
+     * before the graph that they are passed to. Adopt the device so that
+     * changes to its inputs update this graph's render schedule.
+     *-----------------------------------------------------------------------*/
+    this->output->graph = this;
+
     AudioOut_Abstract *audio_out = (AudioOut_Abstract *) this->output.get();
 
     if (audio_out->get_sample_rate() == 0)
@@ -59,23 +198,109 @@ AudioGraph::AudioGraph(AudioGraphConfig *config,
     }
 
     this->sample_rate = audio_out->get_sample_rate();
+
+    /*------------------------------------------------------------------------
+     * By default, use the largest power of two that fits within the
+     * hardware buffer, so that callbacks of the nominal size are served by
+     * whole blocks without any buffering.
+     *-----------------------------------------------------------------------*/
+    this->block_size = this->config.get_block_size();
+    if (this->block_size == 0)
+    {
+        this->block_size = SIGNALFLOW_DEFAULT_BLOCK_SIZE;
+        if (audio_out->get_buffer_size() > 0)
+        {
+            int max_block_size = std::min((int) audio_out->get_buffer_size(), SIGNALFLOW_NODE_BUFFER_SIZE);
+            this->block_size = 1;
+            while (this->block_size * 2 <= max_block_size)
+            {
+                this->block_size *= 2;
+            }
+        }
+    }
+    this->block_position = this->block_size;
+
     this->node_count = 0;
-    this->_node_count_tmp = 0;
     this->cpu_usage = 0.0;
+    this->profiling_enabled = false;
+    this->schedule_invalid = true;
+    this->is_running = false;
     this->monitor = NULL;
 
-    this->recording_fd = NULL;
-    this->recording_num_channels = 0;
-    this->recording_buffer = (float *) calloc(SIGNALFLOW_DEFAULT_BLOCK_SIZE * SIGNALFLOW_MAX_CHANNELS, sizeof(float));
+    this->reclaimer = new AudioGraphReclaimer(SIGNALFLOW_GRAPH_RECLAIM_QUEUE_SIZE);
+    this->telemetry = new AudioGraphTelemetry(SIGNALFLOW_GRAPH_TELEMETRY_QUEUE_SIZE);
+
+    /*------------------------------------------------------------------------
+     * Start with an empty scratch pool, so that the audio thread always has
+     * one to adopt.
+     *-----------------------------------------------------------------------*/
+    this->reserve_scratch_buffers(0, 0, 0);
+
+    /*------------------------------------------------------------------------
+     * Seed each graph's generators independently. They must exist before
+     * the worker threads start.
+     *-----------------------------------------------------------------------*/
+    this->random_generators.resize(std::max((int) this->config.get_render_thread_count(), 1));
+    for (auto &generator : this->random_generators)
+    {
+        generator.seed(random_integer(0, LONG_MAX));
+    }
+    this->random_seed_value = 0;
+    this->random_seed_changed = false;
+
+    this->worker_pool = NULL;
+    this->render_thread = NULL;
+    if (this->config.get_render_thread_count() > 1)
+    {
+        this->worker_pool = new AudioGraphWorkerPool(this, this->config.get_render_thread_count());
+    }
+
+    this->rendering_recorder = nullptr;
+
+    this->timed_commands.reserve(SIGNALFLOW_GRAPH_EVENT_QUEUE_SIZE);
+    this->event_buffer.resize(this->output->out.get_num_channels() * SIGNALFLOW_NODE_BUFFER_SIZE);
+    this->frame_position = 0;
+    this->frame_position_time = 0.0;
 
     if (start)
     {
         this->start();
     }
+    registration.dismiss();
 }
 
 void AudioGraph::start()
 {
+    /*------------------------------------------------------------------------
+     * From here on, every node connected to the graph may be in use by
+     * the audio thread.
+     *-----------------------------------------------------------------------*/
+    this->claim_subgraph(this->output.get());
+    for (auto node : this->scheduled_nodes)
+    {
+        this->claim_subgraph(node.get());
+    }
+    this->is_running = true;
+
+    /*------------------------------------------------------------------------
+     * Rebuild the schedule on the first block, to take a snapshot of its
+     * nodes for the control thread.
+     *-----------------------------------------------------------------------*/
+    this->invalidate_schedule();
+
+    /*------------------------------------------------------------------------
+     * The render-ahead thread fills its ring before the device starts, so
+     * that the first callback has audio ready.
+     *-----------------------------------------------------------------------*/
+    if (this->config.get_render_ahead_blocks() > 0)
+    {
+        delete this->render_thread;
+        this->render_thread = new AudioGraphRenderThread(this,
+                                                         this->config.get_render_ahead_blocks(),
+                                                         this->output->get_num_input_channels());
+        this->render_thread->start();
+    }
+
     AudioOut_Abstract *audio_out = (AudioOut_Abstract *) this->output.get();
     audio_out->start();
 }
@@ -84,24 +309,97 @@ void AudioGraph::stop()
 {
     AudioOut_Abstract *audioout = (AudioOut_Abstract *) this->output.get();
     audioout->stop();
-}
+    if (this->render_thread)
+    {
+        this->render_thread->stop();
+    }
+
+    /*------------------------------------------------------------------------
+     * The audio thread is no longer rendering, so apply anything that it
+     * didn't get to, preserving the order in which changes were made.
+     *-----------------------------------------------------------------------*/
+    this->is_running = false;
+    this->apply_pending_commands();
 
-void AudioGraph::clear()
-{
-    AudioOut_Abstract *audioout = (AudioOut_Abstract *) this->output.get();
-    auto inputs = audioout->get_inputs();
-    for (auto input : inputs)
     {
-        audioout->remove_input(input);
+        std::lock_guard<std::mutex> lock(this->schedule_nodes_mutex);
+        this->schedule_nodes.clear();
     }
-    this->node_count = 0;
+    this->schedule_nodes_pending.clear();
+    this->schedule_nodes_stale = false;
+}
+
+std::future<void> AudioGraph::clear()
+{
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_CLEAR;
+    return this->apply_command(command);
 }
 
 AudioGraph::~AudioGraph()
 {
+    delete this->render_thread;
+    delete this->worker_pool;
+
     AudioOut_Abstract *audioout = (AudioOut_Abstract *) this->output.get();
     audioout->destroy();
-    shared_graph = NULL;
+    delete this->reclaimer;
+    delete this->telemetry;
+
+    if (this->recorder)
+    {
+        this->recorder->close();
+    }
+
+    if (this->scratch_pool)
+    {
+        for (auto &node : this->scratch_pool->nodes)
+        {
+            node->release_scratch_buffer();
+        }
+    }
+    if (!this->scratch_pools.empty())
+    {
+        for (auto buffer : this->scratch_pools.back()->buffers)
+        {
+            delete[] buffer;
+        }
+    }
+
+    unregister_graph(this);
+}
+
+AudioGraph *AudioGraph::get_shared_graph()
+{
+    std::lock_guard<std::mutex> lock(graphs_mutex);
+    auto it = current_graphs.find(std::this_thread::get_id());
+    if (it != current_graphs.end())
+    {
+        return it->second;
+    }
+    if (graphs.size() > 1)
+    {
+        throw std::runtime_error("AudioGraph: Several graphs exist, and none is current on this thread. Call make_current() on the graph to use.");
+    }
+    return graphs.empty() ? nullptr : graphs.front();
+}
+
+void AudioGraph::make_current()
+{
+    std::lock_guard<std::mutex> lock(graphs_mutex);
+    current_graphs[std::this_thread::get_id()] = this;
+}
+
+void AudioGraph::set_random_seed(long seed)
+{
+    this->random_seed_value = seed;
+    this->random_seed_changed = true;
+}
+
+int AudioGraph::get_graph_count()
+{
+    std::lock_guard<std::mutex> lock(graphs_mutex);
+    return (int) graphs.size();
 }
 
 void AudioGraph::wait(float time)
@@ -136,7 +434,7 @@ void AudioGraph::render_subgraph(const NodeRef &node, int num_frames)
         return;
     }
 
-    if (!(node->inputs.size() > 0 || node->name == "constant" || node->name == "audioout" || node->name == "audioin"))
+    if (!(node->input_slots.size() > 0 || node->type == SIGNALFLOW_NODE_TYPE_CONSTANT || node->type == SIGNALFLOW_NODE_TYPE_AUDIO_OUT || node->type == SIGNALFLOW_NODE_TYPE_AUDIO_IN))
     {
         signalflow_debug("Node %s has no registered inputs", node->name.c_str());
     }
@@ -144,174 +442,1395 @@ void AudioGraph::render_subgraph(const NodeRef &node, int num_frames)
     /*------------------------------------------------------------------------
      * Pull our inputs before we generate our own outputs.
      *-----------------------------------------------------------------------*/
-    for (auto input : node->inputs)
+    for (NodeRef *input_node : node->input_slots)
     {
-        NodeRef input_node = *(input.second);
-        if (input_node)
+        if (*input_node)
         {
-            this->render_subgraph(input_node, num_frames);
-
-            /*------------------------------------------------------------------------
-             * Automatic input upmix.
-             *
-             * If the input node produces less channels than demanded, automatically
-             * up-mix its output by replicating the existing channels. This allows
-             * operations between multi-channel and mono-channel inputs to work
-             * seamlessly without any additional implementation within the node
-             * itself (for example, Multiply(new SineOscillator(440), new LinearPanner(2, ...)))
-             *
-             * A few nodes must prevent automatic input up-mixing from happening.
-             * These include ChannelArray and AudioOut.
-             *
-             * Some partially-initialised nodes (e.g. BufferPlayer with a not-yet-
-             * populated Buffer) will have num_output_channels == 0. Don't try to
-             * upmix a void output.
-             *-----------------------------------------------------------------------*/
-            if (input_node->get_num_output_channels() < node->get_num_input_channels() && !node->no_input_upmix && input_node->get_num_output_channels() > 0)
-            {
-                signalflow_debug("Upmixing %s (%s wants %d channels, %s only produces %d)", input_node->name.c_str(),
-                                 node->name.c_str(), node->get_num_input_channels(), input_node->name.c_str(), input_node->get_num_output_channels());
-
-                /*------------------------------------------------------------------------
-                 * Ensure the input node's output buffer re-allocation has been done.
-                 * Reallocation for inputs is automatically done in Node::update_channels.
-                 *-----------------------------------------------------------------------*/
-                if (input_node->get_num_output_channels_allocated() < node->get_num_input_channels())
-                {
-                    throw std::runtime_error("Input node does not have enough buffers allocated (need " + std::to_string(node->get_num_input_channels()) + ", got " + std::to_string(input_node->get_num_output_channels_allocated()));
-                }
-
-                /*------------------------------------------------------------------------
-                 * If we generate 2 channels but have 6 channels demanded, repeat
-                 * them: [ 0, 1, 0, 1, 0, 1 ]
-                 *-----------------------------------------------------------------------*/
-                for (int out_channel_index = input_node->get_num_output_channels();
-                     out_channel_index < node->get_num_input_channels();
-                     out_channel_index++)
-                {
-                    int in_channel_index = out_channel_index % input_node->get_num_output_channels();
-                    memcpy(input_node->out[out_channel_index],
-                           input_node->out[in_channel_index],
-                           num_frames * sizeof(sample));
-                }
-            }
+            this->render_subgraph(*input_node, num_frames);
+            this->upmix(input_node->get(), node.get(), num_frames);
         }
     }
 
+    /*------------------------------------------------------------------------
+     * Rendering outside of the schedule would overwrite scratch buffers that
+     * are in use by other nodes, so revert to the node's own buffer. This
+     * lasts until scratch buffers are next assigned, so the node isn't
+     * pinned, which would invalidate the schedule.
+     *-----------------------------------------------------------------------*/
+    node->release_scratch_buffer();
     node->_process(node->out, num_frames);
 
-    if (node->name != "constant")
+    if (node->type != SIGNALFLOW_NODE_TYPE_CONSTANT)
     {
         node->has_rendered = true;
-        this->_node_count_tmp++;
     }
 }
 
-void AudioGraph::reset_graph()
+void AudioGraph::upmix(Node *input_node, Node *node, int num_frames)
 {
-    for (auto pair : nodes_to_replace)
+    /*------------------------------------------------------------------------
+     * Automatic input upmix.
+     *
+     * If the input node produces less channels than demanded, automatically
+     * up-mix its output by replicating the existing channels. This allows
+     * operations between multi-channel and mono-channel inputs to work
+     * seamlessly without any additional implementation within the node
+     * itself (for example, Multiply(new SineOscillator(440), new LinearPanner(2, ...)))
+     *
+     * A few nodes must prevent automatic input up-mixing from happening.
+     * These include ChannelArray and AudioOut.
+     *
+     * Some partially-initialised nodes (e.g. BufferPlayer with a not-yet-
+     * populated Buffer) will have num_output_channels == 0. Don't try to
+     * upmix a void output.
+     *-----------------------------------------------------------------------*/
+    if (input_node->get_num_output_channels() < node->get_num_input_channels() && !node->no_input_upmix && input_node->get_num_output_channels() > 0)
     {
-        AudioOut_Abstract *output = (AudioOut_Abstract *) this->output.get();
-        output->replace_input(pair.first, pair.second);
+        signalflow_debug("Upmixing %s (%s wants %d channels, %s only produces %d)", input_node->name.c_str(),
+                         node->name.c_str(), node->get_num_input_channels(), input_node->name.c_str(), input_node->get_num_output_channels());
+
+        /*------------------------------------------------------------------------
+         * Ensure the input node's output buffer re-allocation has been done.
+         * Reallocation for inputs is automatically done in Node::update_channels.
+         *-----------------------------------------------------------------------*/
+        if (input_node->get_num_output_channels_allocated() < node->get_num_input_channels())
+        {
+            throw std::runtime_error("Input node does not have enough buffers allocated (need " + std::to_string(node->get_num_input_channels()) + ", got " + std::to_string(input_node->get_num_output_channels_allocated()));
+        }
 
-        // needed to ensure stale samples don't get delivered next time around
-        // as render_subgraph won't recurse to reset these nodes
-        this->reset_subgraph(pair.first);
+        /*------------------------------------------------------------------------
+         * If we generate 2 channels but have 6 channels demanded, repeat
+         * them: [ 0, 1, 0, 1, 0, 1 ]
+         *-----------------------------------------------------------------------*/
+        for (int out_channel_index = input_node->get_num_output_channels();
+             out_channel_index < node->get_num_input_channels();
+             out_channel_index++)
+        {
+            int in_channel_index = out_channel_index % input_node->get_num_output_channels();
+            memcpy(input_node->out[out_channel_index],
+                   input_node->out[in_channel_index],
+                   num_frames * sizeof(sample));
+            input_node->final_sample[out_channel_index] = input_node->final_sample[in_channel_index];
+        }
     }
-    nodes_to_replace.clear();
+}
+
+void AudioGraph::reset_graph()
+{
+    /*------------------------------------------------------------------------
+     * Apply any changes posted since the last block.
+     *-----------------------------------------------------------------------*/
+    this->apply_pending_commands();
 
     /*------------------------------------------------------------------------
-     * Disconnect any nodes and patches that are scheduled to be removed.
+     * Derive a distinct seed for each rendering thread's generator.
      *-----------------------------------------------------------------------*/
-    for (auto node : nodes_to_remove)
+    if (this->random_seed_changed.exchange(false))
     {
-        AudioOut_Abstract *output = (AudioOut_Abstract *) this->output.get();
-        output->remove_input(node);
+        long seed = this->random_seed_value;
+        for (int index = 0; index < (int) this->random_generators.size(); index++)
+        {
+            this->random_generators[index].seed(seed + index);
+        }
     }
-    nodes_to_remove.clear();
 
-    for (auto patch : patches_to_remove)
+    /*------------------------------------------------------------------------
+     * If any connections have changed since the last block, re-derive the
+     * render order. The flag is cleared before rebuilding so that a change
+     * made during the rebuild is picked up on the following block.
+     *-----------------------------------------------------------------------*/
+    if (this->schedule_invalid.exchange(false))
     {
-        for (auto patchref : patches)
+        /*------------------------------------------------------------------------
+         * While the graph is running, nodes are given profiles when they are
+         * connected (in claim_subgraph). Otherwise, render() is called by the
+         * thread that makes any changes, so can safely allocate them here.
+         *-----------------------------------------------------------------------*/
+        if (this->profiling_enabled && !this->is_running)
         {
-            if (patchref.get() == patch)
+            std::unordered_set<Node *> visited;
+            this->allocate_profiles(this->output.get(), visited);
+            for (auto &node : this->scheduled_nodes)
             {
-                patches.erase(patchref);
-                break;
+                this->allocate_profiles(node.get(), visited);
             }
         }
+        this->rebuild_schedule();
     }
-    this->patches_to_remove.clear();
+    this->publish_schedule_nodes();
+}
 
-    /*------------------------------------------------------------------------
-     * Clear the record of processed nodes.
-     *-----------------------------------------------------------------------*/
-    this->_node_count_tmp = 0;
-    this->reset_subgraph(this->output);
-    for (auto node : this->scheduled_nodes)
+void AudioGraph::invalidate_schedule()
+{
+    this->schedule_invalid = true;
+}
+
+std::future<void> AudioGraph::post_command(AudioGraphCommand &command)
+{
+    if (is_rendering)
     {
-        this->reset_subgraph(node);
+        this->post_command_without_result(command);
+        return std::future<void>();
     }
+
+    std::shared_ptr<std::promise<void>> promise = std::make_shared<std::promise<void>>();
+    std::future<void> future = promise->get_future();
+    command.promise = promise;
+
+    if (!this->commands.push(command))
+    {
+        promise->set_exception(std::make_exception_ptr(std::runtime_error("AudioGraph: Command queue is full")));
+    }
+
+    return future;
 }
 
-void AudioGraph::reset_subgraph(NodeRef node)
+std::future<void> AudioGraph::apply_command(AudioGraphCommand &command)
 {
-    node->has_rendered = false;
-    for (auto input : node->inputs)
+    if (this->get_is_queueing_commands())
+    {
+        return this->post_command(command);
+    }
+
+    this->apply_command_unchecked(command);
+    std::promise<void> promise;
+    promise.set_value();
+    return promise.get_future();
+}
+
+void AudioGraph::post_command_without_result(AudioGraphCommand &command)
+{
+    this->commands.push(command);
+}
+
+void AudioGraph::apply_command_without_result(AudioGraphCommand &command)
+{
+    if (this->get_is_queueing_commands())
+    {
+        this->post_command_without_result(command);
+    }
+    else
+    {
+        this->apply_command_unchecked(command);
+    }
+}
+
+void AudioGraph::apply_command_unchecked(AudioGraphCommand &command)
+{
+    AudioOut_Abstract *output = (AudioOut_Abstract *) this->output.get();
+
+    switch (command.type)
+    {
+        case SIGNALFLOW_GRAPH_COMMAND_PLAY_NODE:
+            output->add_input(command.node);
+            this->invalidate_schedule();
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_PLAY_PATCH:
+            output->add_input(command.patch->output);
+            if (std::find(this->patches.begin(), this->patches.end(), command.patch) == this->patches.end())
+            {
+                this->patches.push_back(command.patch);
+            }
+            this->invalidate_schedule();
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_STOP_NODE:
+            output->remove_input(command.node);
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_STOP_PATCH:
+            /*------------------------------------------------------------------------
+             * Move the patch's reference into the command, so that it is released
+             * by the reclaimer. Erasing from a vector doesn't free memory.
+             *-----------------------------------------------------------------------*/
+            for (auto patchref = this->patches.begin(); patchref != this->patches.end(); ++patchref)
+            {
+                if (patchref->get() == command.patch_ptr)
+                {
+                    command.patch = std::move(*patchref);
+                    this->patches.erase(patchref);
+                    break;
+                }
+            }
+            output->remove_input(command.node);
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_REPLACE_NODE:
+            output->replace_input(command.node, command.other);
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_ADD_NODE:
+            this->scheduled_nodes.insert(command.node);
+            this->invalidate_schedule();
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_REMOVE_NODE:
+            this->scheduled_nodes.erase(command.node);
+            this->invalidate_schedule();
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_SET_INPUT:
+        {
+            /*------------------------------------------------------------------------
+             * A node with variable inputs creates an input that it doesn't yet
+             * have, so there may be no previous input.
+             *-----------------------------------------------------------------------*/
+            NodeRef previous;
+            auto existing = command.node->inputs.find(command.input_name);
+            if (existing != command.node->inputs.end())
+            {
+                previous = *(existing->second);
+            }
+            if (command.input_change)
+            {
+                command.node->apply_set_input(command.input_name, command.other, *command.input_change);
+            }
+            else
+            {
+                command.node->set_input(command.input_name, command.other);
+            }
+            this->release(std::move(previous));
+            break;
+        }
+
+        case SIGNALFLOW_GRAPH_COMMAND_ADD_INPUT:
+            command.node->add_input(command.other);
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_REMOVE_INPUT:
+            command.node->remove_input(command.other);
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_CLEAR:
+        {
+            for (NodeRef *slot : output->input_slots)
+            {
+                NodeRef input = *slot;
+                if (input)
+                {
+                    output->remove_input(input);
+                    this->release(std::move(input));
+                }
+            }
+            this->invalidate_schedule();
+            this->node_count = 0;
+            break;
+        }
+
+        case SIGNALFLOW_GRAPH_COMMAND_START_RECORDING:
+            this->rendering_recorder = command.recorder.get();
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_STOP_RECORDING:
+            this->rendering_recorder = nullptr;
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_SET_VALUE:
+            ((Constant *) command.other.get())->ramp_to(command.value, 0);
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_RAMP_VALUE:
+            ((Constant *) command.other.get())->ramp_to(command.value, (int) (command.duration * this->sample_rate));
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_TRIGGER:
+            command.node->trigger(command.input_name, command.value);
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_RESET_PATCH:
+            command.patch->reset();
+            break;
+
+        case SIGNALFLOW_GRAPH_COMMAND_NONE:
+            break;
+    }
+}
+
+void AudioGraph::apply_pending_commands()
+{
+    is_applying_commands = true;
+
+    AudioGraphCommand command;
+    while (this->commands.pop(command))
+    {
+        /*------------------------------------------------------------------------
+         * Hold commands scheduled for a future frame until render() reaches
+         * that frame, keeping them ordered by frame (and otherwise in the
+         * order they were posted).
+         *-----------------------------------------------------------------------*/
+        if (command.frame > this->frame_position)
+        {
+            if (this->timed_commands.size() < this->timed_commands.capacity())
+            {
+                auto position = std::upper_bound(this->timed_commands.begin(),
+                                                 this->timed_commands.end(),
+                                                 command.frame,
+                                                 [](long frame, const AudioGraphCommand &other) { return frame < other.frame; });
+                this->timed_commands.insert(position, std::move(command));
+                continue;
+            }
+            command.type = SIGNALFLOW_GRAPH_COMMAND_NONE;
+            if (command.promise)
+            {
+                command.promise->set_exception(std::make_exception_ptr(std::runtime_error("AudioGraph: Event queue is full")));
+                this->release(std::move(command.promise));
+            }
+        }
+
+        this->complete_command(command);
+    }
+
+    is_applying_commands = false;
+}
+
+void AudioGraph::complete_command(AudioGraphCommand &command)
+{
+    try
+    {
+        this->apply_command_unchecked(command);
+        if (command.promise)
+        {
+            command.promise->set_value();
+        }
+    }
+    catch (...)
     {
-        NodeRef input_node = *(input.second);
-        if (input_node && input_node->has_rendered)
+        if (command.promise)
         {
-            this->reset_subgraph(input_node);
+            command.promise->set_exception(std::current_exception());
         }
     }
+
+    this->release(std::move(command.node));
+    this->release(std::move(command.other));
+    this->release(std::move(command.patch));
+    this->release(std::move(command.recorder));
+    this->release(std::move(command.promise));
+    this->release(std::move(command.input_change));
 }
 
-void AudioGraph::render(int num_frames)
+void AudioGraph::release(std::shared_ptr<void> object)
 {
     /*------------------------------------------------------------------------
-     * Timestamp the start of processing to measure CPU usage.
+     * Only defer destruction when on the audio thread. Otherwise, release
+     * the reference immediately, so that destruction happens as usual.
      *-----------------------------------------------------------------------*/
-    double t0 = signalflow_timestamp();
-
+    if (object && is_applying_commands)
+    {
+        this->reclaimer->release(std::move(object));
+    }
+}
+
+void AudioGraph::claim_subgraph(Node *root)
+{
+    std::vector<Node *> claimed;
+    std::vector<Node *> stack;
+    int num_steps = 0;
+    stack.push_back(root);
+    while (!stack.empty())
+    {
+        Node *node = stack.back();
+        stack.pop_back();
+        if (node->graph_owned)
+        {
+            continue;
+        }
+        node->graph_owned = true;
+        claimed.push_back(node);
+        if (this->profiling_enabled)
+        {
+            this->allocate_profile(node);
+        }
+
+        /*------------------------------------------------------------------------
+         * Room for the node's scratch buffer pointers, so that the audio
+         * thread can assign them without allocating.
+         *-----------------------------------------------------------------------*/
+        node->scratch_channels.reserve(node->get_num_output_channels_allocated());
+
+        /*------------------------------------------------------------------------
+         * One step to render the node, and at most one to upmix each input.
+         *-----------------------------------------------------------------------*/
+        num_steps += 1 + (int) node->input_slots.size();
+
+        for (NodeRef *input_node : node->input_slots)
+        {
+            if (input_node && *input_node)
+            {
+                stack.push_back(input_node->get());
+            }
+        }
+    }
+
+    if (!claimed.empty())
+    {
+        int num_buffers;
+        int num_nodes;
+        this->estimate_scratch_buffers(root, claimed, num_buffers, num_nodes);
+        this->reserve_scratch_buffers(num_buffers, num_nodes, num_steps);
+    }
+}
+
+void AudioGraph::rebuild_schedule()
+{
+    this->adopt_scratch_pool();
+    this->schedule.clear();
+    this->schedule_generation++;
+
+    this->schedule_subgraph(this->output.get());
+    for (auto &node : this->scheduled_nodes)
+    {
+        this->schedule_subgraph(node.get());
+    }
+
+    /*------------------------------------------------------------------------
+     * A cyclic connection appears as an input that is scheduled after the
+     * node that reads it.
+     *-----------------------------------------------------------------------*/
+    this->schedule_has_cycle = false;
+    for (int step_index = 0; step_index < (int) this->schedule.size(); step_index++)
+    {
+        auto &step = this->schedule[step_index];
+        if (step.upmix_input)
+        {
+            continue;
+        }
+        for (NodeRef *input_node : step.node->input_slots)
+        {
+            if (input_node && *input_node && (*input_node)->schedule_step >= step_index)
+            {
+                this->schedule_has_cycle = true;
+            }
+        }
+    }
+
+    if (this->worker_pool)
+    {
+        this->partition_schedule();
+    }
+    this->assign_scratch_buffers();
+
+    /*------------------------------------------------------------------------
+     * Any earlier snapshot that hasn't yet been published is out of date.
+     * While the graph isn't running, its nodes are found directly instead.
+     *-----------------------------------------------------------------------*/
+    if (this->is_running)
+    {
+        this->release_unscheduled_nodes(this->schedule_nodes_pending);
+        for (auto &step : this->schedule)
+        {
+            if (!step.upmix_input)
+            {
+                this->schedule_nodes_pending.push_back(step.node->shared_from_this());
+            }
+        }
+        this->schedule_nodes_stale = true;
+        this->publish_schedule_nodes();
+    }
+
+    int node_count = 0;
+    for (auto &step : this->schedule)
+    {
+        if (!step.upmix_input && step.node->type != SIGNALFLOW_NODE_TYPE_CONSTANT)
+        {
+            node_count++;
+        }
+    }
+    this->node_count = node_count;
+    this->schedule_steps_needed = (int) this->schedule.size();
+    this->schedule_generation_built = this->schedule_generation;
+}
+
+void AudioGraph::publish_schedule_nodes()
+{
+    if (this->schedule_nodes_stale && this->schedule_nodes_mutex.try_lock())
+    {
+        this->schedule_nodes.swap(this->schedule_nodes_pending);
+        this->schedule_nodes_mutex.unlock();
+        this->schedule_nodes_stale = false;
+        this->release_unscheduled_nodes(this->schedule_nodes_pending);
+    }
+}
+
+void AudioGraph::release_unscheduled_nodes(std::vector<NodeRef> &nodes)
+{
+    /*------------------------------------------------------------------------
+     * Nodes that are still scheduled are referenced from the graph, so
+     * dropping these references can't destroy them. Any others are passed
+     * to the reclaimer, so that they aren't destroyed on the audio thread.
+     *-----------------------------------------------------------------------*/
+    for (auto &node : nodes)
+    {
+        if (!this->get_is_scheduled(node.get()))
+        {
+            this->reclaimer->release(std::move(node));
+        }
+    }
+    nodes.clear();
+}
+
+bool AudioGraph::get_is_scheduled(Node *node)
+{
+    return node->schedule_generation == this->schedule_generation;
+}
+
+void AudioGraph::schedule_subgraph(Node *root)
+{
+    /*------------------------------------------------------------------------
+     * Iterative depth-first traversal, appending each node to the schedule
+     * after all of its inputs (post-order). Each stack entry records whether
+     * the node's inputs have already been pushed.
+     *
+     * A node is marked as visited as soon as it is first expanded, so shared
+     * inputs are only scheduled once, and any cyclic connection is broken
+     * (the node reads its input's output from the previous block).
+     *-----------------------------------------------------------------------*/
+    std::vector<std::pair<Node *, bool>> &stack = this->schedule_stack;
+    stack.clear();
+    stack.push_back(std::make_pair(root, false));
+
+    while (!stack.empty())
+    {
+        Node *node = stack.back().first;
+        if (!stack.back().second)
+        {
+            if (this->get_is_scheduled(node))
+            {
+                stack.pop_back();
+                continue;
+            }
+            node->schedule_generation = this->schedule_generation;
+            stack.back().second = true;
+
+            for (NodeRef *input_node : node->input_slots)
+            {
+                if (input_node && *input_node && !this->get_is_scheduled(input_node->get()))
+                {
+                    stack.push_back(std::make_pair(input_node->get(), false));
+                }
+            }
+        }
+        else
+        {
+            stack.pop_back();
+
+            if (!node->no_input_upmix)
+            {
+                for (NodeRef *input_node : node->input_slots)
+                {
+                    if (input_node && *input_node)
+                    {
+                        this->schedule.push_back({ node, input_node->get() });
+                    }
+                }
+            }
+            node->schedule_step = (int) this->schedule.size();
+            this->schedule.push_back({ node, nullptr });
+        }
+    }
+}
+
+void AudioGraph::partition_schedule()
+{
+    /*------------------------------------------------------------------------
+     * Each input of the output node, and each scheduled node, is the root
+     * of a subgraph that can be rendered independently of the others.
+     *-----------------------------------------------------------------------*/
+    std::vector<Node *> &roots = this->partition_roots;
+    roots.clear();
+    for (NodeRef *input_node : this->output->input_slots)
+    {
+        if (input_node && *input_node)
+        {
+            roots.push_back(input_node->get());
+        }
+    }
+    for (auto &node : this->scheduled_nodes)
+    {
+        roots.push_back(node.get());
+    }
+
+    /*------------------------------------------------------------------------
+     * Label each node with the index of the root that it belongs to, or
+     * with -1 if it is reachable from more than one root. The set of shared
+     * nodes is closed under inputs: every input of a shared node is itself
+     * reachable from the same roots, so is also shared.
+     *-----------------------------------------------------------------------*/
+    const int owner_shared = -1;
+    const int owner_output = -2;
+    const int owner_none = -3;
+    for (auto &step : this->schedule)
+    {
+        step.node->schedule_owner = owner_none;
+    }
+    this->output->schedule_owner = owner_output;
+
+    std::vector<Node *> &stack = this->partition_stack;
+    for (int root_index = 0; root_index < (int) roots.size(); root_index++)
+    {
+        this->partition_generation++;
+        stack.clear();
+        stack.push_back(roots[root_index]);
+        while (!stack.empty())
+        {
+            Node *node = stack.back();
+            stack.pop_back();
+            if (node->partition_generation == this->partition_generation)
+            {
+                continue;
+            }
+            node->partition_generation = this->partition_generation;
+
+            if (node->schedule_owner == owner_none)
+            {
+                node->schedule_owner = root_index;
+            }
+            else if (node->schedule_owner == owner_output)
+            {
+                continue;
+            }
+            else if (node->schedule_owner != root_index)
+            {
+                node->schedule_owner = owner_shared;
+            }
+
+            for (NodeRef *input_node : node->input_slots)
+            {
+                if (input_node && *input_node)
+                {
+                    stack.push_back(input_node->get());
+                }
+            }
+        }
+    }
+
+    /*------------------------------------------------------------------------
+     * Split the schedule into phases, retaining its topological order
+     * within each. Upmixing a shared input writes to that input's buffer,
+     * so is done in the head phase to avoid concurrent writes. The steps
+     * that belong to each root are counted first.
+     *-----------------------------------------------------------------------*/
+    auto get_step_owner = [&](const signalflow_render_step_t &step) {
+        Node *owner_node = step.upmix_input ? step.upmix_input : step.node;
+        int owner = owner_node->schedule_owner;
+        if (step.upmix_input && owner != owner_shared)
+        {
+            owner = step.node->schedule_owner;
+        }
+        return owner;
+    };
+
+    std::vector<int> &offsets = this->partition_offsets;
+    offsets.assign(roots.size(), 0);
+    this->parallel_head.clear();
+    this->parallel_tail.clear();
+
+    for (auto &step : this->schedule)
+    {
+        int owner = get_step_owner(step);
+        if (owner == owner_shared)
+        {
+            this->parallel_head.push_back(step);
+        }
+        else if (owner == owner_output)
+        {
+            this->parallel_tail.push_back(step);
+        }
+        else
+        {
+            offsets[owner]++;
+        }
+    }
+
+    /*------------------------------------------------------------------------
+     * Order the non-empty tasks by decreasing size, so that the largest
+     * subgraphs are started first, and lay out their steps in that order.
+     *-----------------------------------------------------------------------*/
+    this->parallel_tasks.clear();
+    for (int root_index = 0; root_index < (int) roots.size(); root_index++)
+    {
+        if (offsets[root_index] > 0)
+        {
+            this->parallel_tasks.push_back(std::make_pair(root_index, offsets[root_index]));
+        }
+    }
+    std::sort(this->parallel_tasks.begin(), this->parallel_tasks.end(),
+              [](const std::pair<int, int> &a, const std::pair<int, int> &b) {
+                  return a.second > b.second;
+              });
+
+    int num_steps = 0;
+    for (auto &task : this->parallel_tasks)
+    {
+        int root_index = task.first;
+        int task_size = task.second;
+        offsets[root_index] = num_steps;
+        task.first = num_steps;
+        task.second = num_steps + task_size;
+        num_steps += task_size;
+    }
+
+    this->parallel_steps.resize(num_steps);
+    for (auto &step : this->schedule)
+    {
+        int owner = get_step_owner(step);
+        if (owner >= 0)
+        {
+            this->parallel_steps[offsets[owner]++] = step;
+        }
+    }
+
+    this->parallel_task_count = (int) this->parallel_tasks.size();
+    this->worker_pool->set_task_count(this->parallel_task_count);
+}
+
+void AudioGraph::adopt_scratch_pool()
+{
+    /*------------------------------------------------------------------------
+     * Adopt the most recently reserved pool, moving the previously-assigned
+     * nodes across to it, and taking over the capacity that it reserves for
+     * the schedule. Its capacity is at least that of the last pool.
+     *-----------------------------------------------------------------------*/
+    signalflow_scratch_pool_t *published = this->scratch_pool_published.load(std::memory_order_acquire);
+    if (published != this->scratch_pool)
+    {
+        if (this->scratch_pool)
+        {
+            for (auto &node : this->scratch_pool->nodes)
+            {
+                published->nodes.push_back(std::move(node));
+            }
+            this->scratch_pool->nodes.clear();
+        }
+        adopt_capacity(this->schedule, published->schedule);
+        adopt_capacity(this->schedule_stack, published->schedule_stack);
+        adopt_capacity(this->schedule_nodes_pending, published->schedule_nodes);
+        adopt_capacity(this->parallel_head, published->parallel_head);
+        adopt_capacity(this->parallel_steps, published->parallel_steps);
+        adopt_capacity(this->parallel_tasks, published->parallel_tasks);
+        adopt_capacity(this->parallel_tail, published->parallel_tail);
+        adopt_capacity(this->partition_roots, published->partition_roots);
+        adopt_capacity(this->partition_stack, published->partition_stack);
+        adopt_capacity(this->partition_offsets, published->partition_offsets);
+        this->scratch_pool = published;
+        this->scratch_pool_adopted.store(published, std::memory_order_release);
+    }
+}
+
+void AudioGraph::assign_scratch_buffers()
+{
+    this->adopt_scratch_pool();
+
+    /*------------------------------------------------------------------------
+     * While the graph isn't running, this is the control thread, so if the
+     * pool is too small, enlarge it and assign again.
+     *-----------------------------------------------------------------------*/
+    if (!this->assign_scratch_buffers_from_pool() && !this->is_running)
+    {
+        this->reserve_scratch_buffers(0, 0, 0);
+        if (this->scratch_pool_published.load() != this->scratch_pool)
+        {
+            this->assign_scratch_buffers();
+        }
+    }
+}
+
+bool AudioGraph::assign_scratch_buffers_from_pool()
+{
+    signalflow_scratch_pool_t *pool = this->scratch_pool;
+
+    /*------------------------------------------------------------------------
+     * Revert every node to its own output buffer, and hold on to the
+     * previously-assigned nodes until the end, so that any that are no
+     * longer part of the graph are not destroyed on the audio thread.
+     *-----------------------------------------------------------------------*/
+    pool->nodes_previous.swap(pool->nodes);
+    for (auto &node : pool->nodes_previous)
+    {
+        node->release_scratch_buffer();
+    }
+
+    bool assigned_all = true;
+    if (!this->worker_pool)
+    {
+        /*------------------------------------------------------------------------
+         * Find the last step at which each node's output is read. An input
+         * that is read before it is written is part of a cycle, and its output
+         * must persist between blocks.
+         *-----------------------------------------------------------------------*/
+        for (int step_index = 0; step_index < (int) this->schedule.size(); step_index++)
+        {
+            Node *node = this->schedule[step_index].node;
+            if (!this->schedule[step_index].upmix_input)
+            {
+                node->schedule_last_read = step_index;
+                node->schedule_pinned = false;
+                node->schedule_expiring = nullptr;
+            }
+        }
+        for (int step_index = 0; step_index < (int) this->schedule.size(); step_index++)
+        {
+            Node *node = this->schedule[step_index].node;
+            if (this->schedule[step_index].upmix_input)
+            {
+                continue;
+            }
+            for (NodeRef *input_node : node->input_slots)
+            {
+                if (input_node && *input_node)
+                {
+                    Node *input_ptr = input_node->get();
+                    if (input_ptr->schedule_step >= step_index)
+                    {
+                        input_ptr->schedule_pinned = true;
+                    }
+                    else
+                    {
+                        input_ptr->schedule_last_read = std::max(input_ptr->schedule_last_read, step_index);
+                    }
+                }
+            }
+        }
+        this->output->schedule_pinned = true;
+        for (auto &node : this->scheduled_nodes)
+        {
+            node->schedule_pinned = true;
+        }
+
+        /*------------------------------------------------------------------------
+         * Walk the schedule, giving each node free scratch buffers, and
+         * returning them to the free list after the node's last reader.
+         * A node is assigned its buffers before its inputs' buffers are
+         * freed, so that no node reads and writes the same buffer.
+         *
+         * The nodes whose output expires at each step are chained through
+         * schedule_next_expiring, headed by the schedule_expiring of the node
+         * at that step. Nodes that could use scratch buffers but don't fit in
+         * the pool are chained too, so that the number of buffers that all of
+         * them would need is counted.
+         *-----------------------------------------------------------------------*/
+        std::vector<sample *> &free_buffers = pool->free_buffers;
+        free_buffers.assign(pool->buffers.rbegin(), pool->buffers.rend());
+        int buffers_in_use = 0;
+        int buffers_needed = 0;
+        int nodes_needed = 0;
+        for (int step_index = 0; step_index < (int) this->schedule.size(); step_index++)
+        {
+            Node *node = this->schedule[step_index].node;
+            if (this->schedule[step_index].upmix_input)
+            {
+                continue;
+            }
+
+            if (!node->schedule_pinned && this->get_can_use_scratch_buffer(node))
+            {
+                int num_channels = node->get_num_output_channels_allocated();
+                if ((int) free_buffers.size() >= num_channels
+                    && (int) pool->nodes.size() < pool->node_capacity
+                    && (int) node->scratch_channels.capacity() >= num_channels)
+                {
+                    for (int channel = 0; channel < num_channels; channel++)
+                    {
+                        node->scratch_channels.push_back(free_buffers.back());
+                        free_buffers.pop_back();
+                    }
+                    node->use_scratch_buffer();
+                    pool->nodes.push_back(node->shared_from_this());
+                }
+                else
+                {
+                    assigned_all = false;
+                }
+                buffers_in_use += num_channels;
+                buffers_needed = std::max(buffers_needed, buffers_in_use);
+                nodes_needed++;
+
+                Node *last_reader = this->schedule[node->schedule_last_read].node;
+                node->schedule_next_expiring = last_reader->schedule_expiring;
+                last_reader->schedule_expiring = node;
+            }
+
+            for (Node *expired_node = node->schedule_expiring; expired_node; expired_node = expired_node->schedule_next_expiring)
+            {
+                free_buffers.insert(free_buffers.end(),
+                                    expired_node->scratch_channels.begin(),
+                                    expired_node->scratch_channels.end());
+                buffers_in_use -= expired_node->get_num_output_channels_allocated();
+            }
+        }
+        this->scratch_buffers_needed = buffers_needed;
+        this->scratch_nodes_needed = nodes_needed;
+    }
+
+    this->release_unscheduled_nodes(pool->nodes_previous);
+    return assigned_all;
+}
+
+bool AudioGraph::get_can_use_scratch_buffer(Node *node)
+{
+    return !node->get_output_buffer_pinned()
+           && node->writes_output
+           && node->get_num_output_channels_allocated() > 0
+           && node->get_output_buffer_length() <= SIGNALFLOW_NODE_BUFFER_SIZE;
+}
+
+void AudioGraph::estimate_scratch_buffers(Node *root,
+                                          const std::vector<Node *> &claimed,
+                                          int &num_buffers,
+                                          int &num_nodes)
+{
+    /*------------------------------------------------------------------------
+     * Schedule the newly-claimed nodes in the same order as
+     * schedule_subgraph(), and walk the schedule in the same way as
+     * assign_scratch_buffers(), counting the buffers in use at each step.
+     * The audio thread can't yet reach these nodes, so they can be read
+     * here, but their schedule fields belong to the audio thread, so
+     * lookup tables are used instead. Nodes that are read from outside the
+     * subgraph are assumed to be read at its end.
+     *-----------------------------------------------------------------------*/
+    std::unordered_set<Node *> is_claimed(claimed.begin(), claimed.end());
+    std::unordered_map<Node *, int> steps;
+    std::vector<Node *> order;
+    std::vector<std::pair<Node *, bool>> stack;
+    stack.push_back(std::make_pair(root, false));
+    while (!stack.empty())
+    {
+        Node *node = stack.back().first;
+        if (!stack.back().second)
+        {
+            if (steps.find(node) != steps.end())
+            {
+                stack.pop_back();
+                continue;
+            }
+            steps[node] = -1;
+            stack.back().second = true;
+            for (NodeRef *input_node : node->input_slots)
+            {
+                if (input_node && *input_node && is_claimed.count(input_node->get()) && steps.find(input_node->get()) == steps.end())
+                {
+                    stack.push_back(std::make_pair(input_node->get(), false));
+                }
+            }
+        }
+        else
+        {
+            stack.pop_back();
+            steps[node] = (int) order.size();
+            order.push_back(node);
+        }
+    }
+
+    int num_steps = (int) order.size();
+    std::vector<int> last_read(num_steps);
+    std::vector<bool> pinned(num_steps, false);
+    for (int step = 0; step < num_steps; step++)
+    {
+        Node *node = order[step];
+        last_read[step] = (node == root) ? num_steps : step;
+        for (auto &output : node->outputs)
+        {
+            if (!is_claimed.count(output.first))
+            {
+                last_read[step] = num_steps;
+            }
+        }
+    }
+    for (int step = 0; step < num_steps; step++)
+    {
+        for (NodeRef *input_node : order[step]->input_slots)
+        {
+            if (input_node && *input_node && is_claimed.count(input_node->get()))
+            {
+                int input_step = steps[input_node->get()];
+                if (input_step >= step)
+                {
+                    pinned[input_step] = true;
+                }
+                else
+                {
+                    last_read[input_step] = std::max(last_read[input_step], step);
+                }
+            }
+        }
+    }
+
+    std::vector<int> expiring(num_steps + 1, 0);
+    int buffers_in_use = 0;
+    num_buffers = 0;
+    num_nodes = 0;
+    for (int step = 0; step < num_steps; step++)
+    {
+        Node *node = order[step];
+        if (!pinned[step] && node != this->output.get() && this->get_can_use_scratch_buffer(node))
+        {
+            int num_channels = node->get_num_output_channels_allocated();
+            buffers_in_use += num_channels;
+            num_buffers = std::max(num_buffers, buffers_in_use);
+            expiring[last_read[step]] += num_channels;
+            num_nodes++;
+        }
+        buffers_in_use -= expiring[step];
+    }
+}
+
+void AudioGraph::reserve_scratch_buffers(int num_buffers, int num_nodes, int num_steps)
+{
+    std::lock_guard<std::mutex> lock(this->scratch_pool_mutex);
+
+    /*------------------------------------------------------------------------
+     * Delete the pools that the audio thread has moved on from.
+     *-----------------------------------------------------------------------*/
+    signalflow_scratch_pool_t *adopted = this->scratch_pool_adopted.load(std::memory_order_acquire);
+    for (int index = 0; index < (int) this->scratch_pools.size(); index++)
+    {
+        if (this->scratch_pools[index].get() == adopted)
+        {
+            this->scratch_pools.erase(this->scratch_pools.begin(), this->scratch_pools.begin() + index);
+            break;
+        }
+    }
+
+    /*------------------------------------------------------------------------
+     * The nodes that the audio thread last assigned buffers to, plus those
+     * that are being added.
+     *-----------------------------------------------------------------------*/
+    signalflow_scratch_pool_t *latest = this->scratch_pools.empty() ? nullptr : this->scratch_pools.back().get();
+    int buffer_count = latest ? (int) latest->buffers.size() : 0;
+    int node_capacity = latest ? latest->node_capacity : 0;
+    num_buffers += this->scratch_buffers_needed.load();
+    num_nodes += this->scratch_nodes_needed.load();
+
+    /*------------------------------------------------------------------------
+     * The steps of every node claimed since the schedule was last built,
+     * plus those of the schedule itself.
+     *-----------------------------------------------------------------------*/
+    unsigned long generation_built = this->schedule_generation_built.load();
+    if (generation_built != this->schedule_steps_claimed_generation)
+    {
+        this->schedule_steps_claimed = 0;
+        this->schedule_steps_claimed_generation = generation_built;
+    }
+    this->schedule_steps_claimed += num_steps;
+    num_steps = this->schedule_steps_claimed + this->schedule_steps_needed.load();
+    int step_capacity = latest ? latest->step_capacity : 0;
+
+    if (latest && num_buffers <= buffer_count && num_nodes <= node_capacity && num_steps <= step_capacity)
+    {
+        return;
+    }
+
+    signalflow_scratch_pool_t *pool = new signalflow_scratch_pool_t();
+    if (latest)
+    {
+        pool->buffers = latest->buffers;
+    }
+    while ((int) pool->buffers.size() < num_buffers)
+    {
+        pool->buffers.push_back(new sample[SIGNALFLOW_NODE_BUFFER_SIZE]());
+    }
+    pool->free_buffers.reserve(pool->buffers.size());
+    pool->node_capacity = std::max(num_nodes, node_capacity);
+    pool->nodes.reserve(pool->node_capacity);
+    pool->nodes_previous.reserve(pool->node_capacity);
+    pool->step_capacity = std::max(num_steps, step_capacity);
+    pool->schedule.reserve(pool->step_capacity);
+    pool->schedule_stack.reserve(pool->step_capacity);
+    pool->schedule_nodes.reserve(pool->step_capacity);
+    if (this->config.get_render_thread_count() > 1)
+    {
+        pool->parallel_head.reserve(pool->step_capacity);
+        pool->parallel_steps.reserve(pool->step_capacity);
+        pool->parallel_tasks.reserve(pool->step_capacity);
+        pool->parallel_tail.reserve(pool->step_capacity);
+        pool->partition_roots.reserve(pool->step_capacity);
+        pool->partition_stack.reserve(pool->step_capacity);
+        pool->partition_offsets.reserve(pool->step_capacity);
+    }
+
+    /*------------------------------------------------------------------------
+     * The published snapshot is swapped with schedule_nodes_pending, so
+     * needs the same capacity. The audio thread only try-locks the mutex.
+     *-----------------------------------------------------------------------*/
+    {
+        std::lock_guard<std::mutex> schedule_nodes_lock(this->schedule_nodes_mutex);
+        this->schedule_nodes.reserve(pool->step_capacity);
+    }
+
+    this->scratch_pools.push_back(std::unique_ptr<signalflow_scratch_pool_t>(pool));
+    this->scratch_pool_published.store(pool, std::memory_order_release);
+}
+
+void AudioGraph::render_task(int task_index, int num_frames)
+{
+    ThreadFlagGuard guard(is_rendering);
+    const std::pair<int, int> &task = this->parallel_tasks[task_index];
+    this->render_steps(this->parallel_steps.data() + task.first, task.second - task.first, num_frames);
+}
+
+void AudioGraph::mark_silent_nodes()
+{
+    /*------------------------------------------------------------------------
+     * Walk forwards, so that each node can take account of whether its
+     * inputs are silent.
+     *-----------------------------------------------------------------------*/
+    for (auto &step : this->schedule)
+    {
+        if (!step.upmix_input)
+        {
+            step.node->render_silent = step.node->get_output_will_be_silent();
+            step.node->render_needed = this->schedule_has_cycle || step.node->get_output_buffer_pinned();
+        }
+    }
+
+    /*------------------------------------------------------------------------
+     * Then walk backwards from the output and other scheduled nodes, marking
+     * the inputs of each node that will be processed as needed. Silent
+     * inputs of a silent node are still filled with zeros, which is cheap,
+     * so that they don't later appear to rise from a stale final sample.
+     *-----------------------------------------------------------------------*/
+    this->output->render_needed = true;
+    for (auto &node : this->scheduled_nodes)
+    {
+        node->render_needed = true;
+    }
+    for (auto step = this->schedule.rbegin(); step != this->schedule.rend(); ++step)
+    {
+        Node *node = step->node;
+        if (step->upmix_input || !node->render_needed)
+        {
+            continue;
+        }
+        for (NodeRef *input_node : node->input_slots)
+        {
+            if (input_node && *input_node && (!node->render_silent || (*input_node)->render_silent))
+            {
+                (*input_node)->render_needed = true;
+            }
+        }
+    }
+}
+
+void AudioGraph::render_steps(const signalflow_render_step_t *steps, int num_steps, int num_frames)
+{
+    bool profiling_enabled = this->profiling_enabled.load(std::memory_order_relaxed);
+    for (int step_index = 0; step_index < num_steps; step_index++)
+    {
+        const signalflow_render_step_t &step = steps[step_index];
+        if (!step.node->render_needed)
+        {
+            continue;
+        }
+
+        if (step.upmix_input)
+        {
+            if (!step.node->render_silent)
+            {
+                this->upmix(step.upmix_input, step.node, num_frames);
+            }
+        }
+        else if (step.node->render_silent)
+        {
+            step.node->_process_silence(num_frames);
+        }
+        else if (profiling_enabled && step.node->get_profile())
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            step.node->_process(step.node->out, num_frames);
+            auto t1 = std::chrono::steady_clock::now();
+            step.node->get_profile()->record(std::chrono::duration<double>(t1 - t0).count());
+        }
+        else
+        {
+            step.node->_process(step.node->out, num_frames);
+        }
+    }
+}
+
+void AudioGraph::reset_subgraph(NodeRef node)
+{
+    node->has_rendered = false;
+    for (NodeRef *input_node : node->input_slots)
+    {
+        if (*input_node && (*input_node)->has_rendered)
+        {
+            this->reset_subgraph(*input_node);
+        }
+    }
+}
+
+void AudioGraph::render(int num_frames)
+{
+    if (num_frames > SIGNALFLOW_NODE_BUFFER_SIZE)
+    {
+        throw std::runtime_error("AudioGraph: Cannot render " + std::to_string(num_frames) + " frames in a single block (maximum block size = " + std::to_string(SIGNALFLOW_NODE_BUFFER_SIZE) + "). Render in smaller blocks.");
+    }
+
+    /*------------------------------------------------------------------------
+     * Timestamp the start of processing to measure CPU usage.
+     *-----------------------------------------------------------------------*/
+    double t0 = signalflow_timestamp();
+
     this->reset_graph();
-    this->render_subgraph(this->output, num_frames);
-    for (auto node : this->scheduled_nodes)
+    ThreadFlagGuard guard(is_rendering);
+    ThreadRandomGuard random_guard(&this->random_generators[0]);
+
+    long block_start = this->frame_position;
+    if (this->timed_commands.empty() || this->timed_commands.front().frame >= block_start + num_frames)
+    {
+        this->render_schedule(num_frames);
+    }
+    else
+    {
+        /*------------------------------------------------------------------------
+         * Split the block at each frame at which a command is scheduled,
+         * applying the command between the two halves, and assemble the
+         * output of each sub-block in event_buffer.
+         *-----------------------------------------------------------------------*/
+        int num_channels = std::min(this->output->out.get_num_channels(),
+                                    (int) (this->event_buffer.size() / SIGNALFLOW_NODE_BUFFER_SIZE));
+        int offset = 0;
+        while (offset < num_frames)
+        {
+            is_applying_commands = true;
+            auto command = this->timed_commands.begin();
+            while (command != this->timed_commands.end() && command->frame <= block_start + offset)
+            {
+                this->complete_command(*command);
+                ++command;
+            }
+            this->timed_commands.erase(this->timed_commands.begin(), command);
+            is_applying_commands = false;
+
+            if (this->schedule_invalid.exchange(false))
+            {
+                this->rebuild_schedule();
+            }
+
+            int end = num_frames;
+            if (!this->timed_commands.empty() && this->timed_commands.front().frame < block_start + num_frames)
+            {
+                end = (int) (this->timed_commands.front().frame - block_start);
+            }
+
+            this->render_schedule(end - offset);
+            for (int channel = 0; channel < num_channels; channel++)
+            {
+                memcpy(this->event_buffer.data() + channel * SIGNALFLOW_NODE_BUFFER_SIZE + offset,
+                       this->output->out[channel],
+                       (end - offset) * sizeof(sample));
+            }
+            offset = end;
+        }
+
+        for (int channel = 0; channel < num_channels; channel++)
+        {
+            memcpy(this->output->out[channel],
+                   this->event_buffer.data() + channel * SIGNALFLOW_NODE_BUFFER_SIZE,
+                   num_frames * sizeof(sample));
+        }
+    }
+    signalflow_debug("AudioGraph: pull %d frames, %d nodes", num_frames, this->node_count);
+
+    if (this->rendering_recorder)
+    {
+        /*------------------------------------------------------------------------
+         * If recording, hand the output over to the recorder's writer thread.
+         * This never blocks: if the writer has fallen behind, the block is
+         * dropped and counted.
+         *-----------------------------------------------------------------------*/
+        this->rendering_recorder->write(this->output->out.data, num_frames);
+    }
+
+    /*------------------------------------------------------------------------
+     * Calculate CPU usage (approximately) by measuring the % of time
+     * within the audio I/O callback that was used for processing.
+     *
+     * Overruns are counted by the telemetry thread, rather than reported
+     * here, as writing to the console could itself block the audio thread.
+     *-----------------------------------------------------------------------*/
+    double t1 = signalflow_timestamp();
+    double dt = t1 - t0;
+    double t_max = (double) num_frames / this->sample_rate;
+    this->cpu_usage = dt / t_max;
+
+    signalflow_block_telemetry_t block;
+    block.timestamp = t0;
+    block.render_duration = dt;
+    block.deadline = t_max;
+    block.num_frames = num_frames;
+    block.node_count = this->node_count;
+    block.patch_count = (int) this->patches.size();
+    this->telemetry->record(block);
+
+    this->frame_position = block_start + num_frames;
+    this->frame_position_time = t0 + t_max;
+}
+
+void AudioGraph::render_schedule(int num_frames)
+{
+    this->mark_silent_nodes();
+
+    /*------------------------------------------------------------------------
+     * Walk the schedule linearly. Inputs always precede the nodes that
+     * consume them, so no recursion or rendered flags are needed.
+     *
+     * With a worker pool and more than one independent subgraph, render
+     * shared nodes first, then the subgraphs in parallel, then the output.
+     *-----------------------------------------------------------------------*/
+    if (this->worker_pool && this->parallel_task_count > 1)
+    {
+        this->render_steps(this->parallel_head.data(), (int) this->parallel_head.size(), num_frames);
+        this->worker_pool->run(num_frames);
+        this->render_steps(this->parallel_tail.data(), (int) this->parallel_tail.size(), num_frames);
+    }
+    else
+    {
+        this->render_steps(this->schedule.data(), (int) this->schedule.size(), num_frames);
+    }
+}
+
+int AudioGraph::render_output(int max_frames, sample **output)
+{
+    if (this->block_position >= this->block_size)
+    {
+        this->render(this->block_size);
+        this->block_position = 0;
+    }
+
+    /*------------------------------------------------------------------------
+     * The output node's buffer is pinned, so frames left over at the end
+     * of a callback remain valid until the next block is rendered.
+     *-----------------------------------------------------------------------*/
+    int num_frames = std::min(max_frames, this->block_size - this->block_position);
+    for (int channel = 0; channel < this->output->out.get_num_channels(); channel++)
     {
-        this->render_subgraph(node, num_frames);
+        output[channel] = this->output->out[channel] + this->block_position;
     }
-    this->node_count = this->_node_count_tmp;
-    signalflow_debug("AudioGraph: pull %d frames, %d nodes", num_frames, this->node_count);
+    this->block_position += num_frames;
+
+    return num_frames;
+}
 
-    if (this->recording_fd)
+void AudioGraph::read_output(sample *output, int num_frames)
+{
+    if (this->render_thread && this->is_running)
     {
-        /*------------------------------------------------------------------------
-         * If recording, interleave (for libsndfile format) and write to file.
-         * TODO: This breaks the cardinal rule of doing file I/O in the audio
-         *       thread. Refactor to use threading and ringbuffers.
-         *-----------------------------------------------------------------------*/
-        for (int channel_index = 0; channel_index < this->recording_num_channels; channel_index++)
-        {
-            for (int frame_index = 0; frame_index < num_frames; frame_index++)
-            {
-                this->recording_buffer[frame_index * this->recording_num_channels + channel_index] = this->output->out[channel_index][frame_index];
-            }
-        }
-        sf_writef_float(this->recording_fd, this->recording_buffer, num_frames);
+        this->render_thread->read(output, num_frames);
+        return;
     }
 
-    /*------------------------------------------------------------------------
-     * Calculate CPU usage (approximately) by measuring the % of time
-     * within the audio I/O callback that was used for processing.
-     *-----------------------------------------------------------------------*/
-    double t1 = signalflow_timestamp();
-    double dt = t1 - t0;
-    double t_max = (double) num_frames / this->sample_rate;
-    this->cpu_usage = dt / t_max;
-    if (this->cpu_usage > 1.0)
+    int num_channels = this->output->get_num_input_channels();
+    sample *block[SIGNALFLOW_MAX_CHANNELS];
+    int offset = 0;
+    while (offset < num_frames)
     {
-        std::cerr << "Warning: buffer overrun?" << std::endl;
+        int block_frames = this->render_output(num_frames - offset, block);
+        signalflow_vector_interleave(block, num_channels, output + offset * num_channels, block_frames);
+        offset += block_frames;
     }
+    signalflow_vector_clamp(output, -1.0, 1.0, output, num_frames * num_channels);
 }
 
 void AudioGraph::render_to_buffer(BufferRef buffer, int block_size)
@@ -341,6 +1860,99 @@ void AudioGraph::render_to_buffer(BufferRef buffer, int block_size)
     }
 }
 
+double AudioGraph::render_offline(double duration,
+                                  const signalflow_offline_block_callback_t &callback,
+                                  const signalflow_offline_progress_callback_t &progress,
+                                  double max_duration)
+{
+    if (this->is_running)
+    {
+        throw std::runtime_error("AudioGraph: Cannot render offline while the graph is running");
+    }
+
+    /*------------------------------------------------------------------------
+     * Render for the given duration, or else until nothing is left playing,
+     * stopping at max_duration if set.
+     *-----------------------------------------------------------------------*/
+    AudioOut_Abstract *output = (AudioOut_Abstract *) this->output.get();
+    bool until_finished = duration <= 0;
+    bool limited = !until_finished || max_duration > 0;
+    long frames_total = (long) ((until_finished ? max_duration : duration) * this->sample_rate);
+    long frames_rendered = 0;
+    double t_start = signalflow_timestamp();
+    double t_progress = t_start;
+
+    auto report_progress = [&](double t) {
+        double seconds_rendered = (double) frames_rendered / this->sample_rate;
+        double elapsed = t - t_start;
+        progress(seconds_rendered, elapsed > 0 ? seconds_rendered / elapsed : 0.0);
+    };
+
+    while ((!limited || frames_rendered < frames_total) && (!until_finished || output->has_inputs()))
+    {
+        /*------------------------------------------------------------------------
+         * Always render whole blocks, and only pass on the frames needed to
+         * reach the requested duration.
+         *-----------------------------------------------------------------------*/
+        this->render(this->block_size);
+        int num_frames = this->block_size;
+        if (limited)
+        {
+            num_frames = (int) std::min((long) num_frames, frames_total - frames_rendered);
+        }
+        callback(this->output->out.data, num_frames);
+        frames_rendered += num_frames;
+
+        /*------------------------------------------------------------------------
+         * Patches that auto-free during a block post their removal, which
+         * would otherwise only be applied at the start of the next block.
+         *-----------------------------------------------------------------------*/
+        this->apply_pending_commands();
+
+        if (progress)
+        {
+            double t = signalflow_timestamp();
+            if (t - t_progress >= 1.0)
+            {
+                report_progress(t);
+                t_progress = t;
+            }
+        }
+    }
+
+    if (progress)
+    {
+        report_progress(signalflow_timestamp());
+    }
+
+    return (double) frames_rendered / this->sample_rate;
+}
+
+double AudioGraph::render_to_file(const std::string &filename,
+                                  double duration,
+                                  int num_channels,
+                                  signalflow_recording_format_t format,
+                                  const signalflow_offline_progress_callback_t &progress,
+                                  double max_duration)
+{
+    int output_channels = this->output->get_num_input_channels();
+    if (num_channels == 0)
+    {
+        num_channels = output_channels;
+    }
+    else if (num_channels > output_channels)
+    {
+        throw std::runtime_error("AudioGraph: Cannot render " + std::to_string(num_channels) + " channels, as the output only has " + std::to_string(output_channels));
+    }
+
+    DiskWriter writer(filename, num_channels, this->sample_rate, format);
+    double seconds_rendered = this->render_offline(
+        duration, [&writer](sample **output, int num_frames) { writer.write(output, num_frames, true); }, progress, max_duration);
+    writer.close();
+
+    return seconds_rendered;
+}
+
 NodeRef AudioGraph::get_output()
 {
     return this->output;
@@ -354,19 +1966,27 @@ std::list<NodeRef> AudioGraph::get_outputs()
 
 NodeRef AudioGraph::add_node(NodeRef node)
 {
-    this->scheduled_nodes.insert(node);
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_ADD_NODE;
+    command.node = node;
+    if (this->get_is_queueing_commands())
+    {
+        this->claim_subgraph(node.get());
+    }
+    this->apply_command(command);
     return node;
 }
 
-void AudioGraph::remove_node(NodeRef node)
+std::future<void> AudioGraph::remove_node(NodeRef node)
 {
-    this->scheduled_nodes.erase(node);
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_REMOVE_NODE;
+    command.node = node;
+    return this->apply_command(command);
 }
 
-void AudioGraph::play(PatchRef patch)
+std::future<void> AudioGraph::play(PatchRef patch)
 {
-    AudioOut_Abstract *output = (AudioOut_Abstract *) (this->output.get());
-
     /*----------------------------------------------------------------------------
      * If a Patch has been instantiated from a PatchSpec, its structure has
      * already been parsed, which means it already contains an internal index
@@ -378,63 +1998,336 @@ void AudioGraph::play(PatchRef patch)
      *----------------------------------------------------------------------------*/
     patch->parse();
 
-    output->add_input(patch->output);
-    this->patches.insert(patch);
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_PLAY_PATCH;
+    command.patch = patch;
+    if (this->get_is_queueing_commands())
+    {
+        this->claim_subgraph(patch->output.get());
+    }
+    return this->apply_command(command);
+}
+
+std::future<void> AudioGraph::play(NodeRef node)
+{
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_PLAY_NODE;
+    command.node = node;
+    if (this->get_is_queueing_commands())
+    {
+        this->claim_subgraph(node.get());
+    }
+    return this->apply_command(command);
+}
+
+std::future<void> AudioGraph::stop(PatchRef patch)
+{
+    return this->stop(patch.get());
+}
+
+std::future<void> AudioGraph::stop(Patch *patch)
+{
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_STOP_PATCH;
+    command.patch_ptr = patch;
+    command.node = patch->output;
+    return this->post_command(command);
+}
+
+std::future<void> AudioGraph::stop(NodeRef node)
+{
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_STOP_NODE;
+    command.node = node;
+    return this->post_command(command);
+}
+
+std::future<void> AudioGraph::replace(NodeRef node, NodeRef other)
+{
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_REPLACE_NODE;
+    command.node = node;
+    command.other = other;
+    if (this->get_is_queueing_commands())
+    {
+        this->claim_subgraph(other.get());
+    }
+    return this->post_command(command);
+}
+
+/*------------------------------------------------------------------------
+ * The Constant that holds the value of a node's input, for commands that
+ * set or ramp it.
+ *-----------------------------------------------------------------------*/
+static NodeRef get_constant_input(NodeRef node, std::string name)
+{
+    NodeRef input = node->get_input(name);
+    if (!input || input->type != SIGNALFLOW_NODE_TYPE_CONSTANT)
+    {
+        throw std::runtime_error("AudioGraph: Input " + name + " of node " + node->name + " is not a constant value");
+    }
+    return input;
+}
+
+std::future<void> AudioGraph::set_input_at(NodeRef node, std::string name, float value, long frame)
+{
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_SET_VALUE;
+    command.other = get_constant_input(node, name);
+    command.value = value;
+    command.frame = frame;
+    return this->post_command(command);
+}
+
+std::future<void> AudioGraph::ramp_input_at(NodeRef node, std::string name, float value, double duration, long frame)
+{
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_RAMP_VALUE;
+    command.other = get_constant_input(node, name);
+    command.value = value;
+    command.duration = duration;
+    command.frame = frame;
+    return this->post_command(command);
+}
+
+std::future<void> AudioGraph::trigger_at(NodeRef node, std::string name, float value, long frame)
+{
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_TRIGGER;
+    command.node = node;
+    command.input_name = name;
+    command.value = value;
+    command.frame = frame;
+    return this->post_command(command);
+}
+
+std::future<void> AudioGraph::set_constant_value(NodeRef constant, float value)
+{
+    if (!constant || constant->type != SIGNALFLOW_NODE_TYPE_CONSTANT)
+    {
+        throw std::runtime_error("AudioGraph: Node is not a constant value");
+    }
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_SET_VALUE;
+    command.other = constant;
+    command.value = value;
+    return this->apply_command(command);
+}
+
+std::future<void> AudioGraph::reset_patch(PatchRef patch)
+{
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_RESET_PATCH;
+    command.patch = patch;
+    return this->apply_command(command);
+}
+
+void AudioGraph::post_constant_value(NodeRef constant, float value)
+{
+    if (!constant || constant->type != SIGNALFLOW_NODE_TYPE_CONSTANT)
+    {
+        throw std::runtime_error("AudioGraph: Node is not a constant value");
+    }
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_SET_VALUE;
+    command.other = constant;
+    command.value = value;
+    this->apply_command_without_result(command);
+}
+
+void AudioGraph::post_reset_patch(PatchRef patch)
+{
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_RESET_PATCH;
+    command.patch = patch;
+    this->apply_command_without_result(command);
+}
+
+std::future<void> AudioGraph::play_at(PatchRef patch, long frame)
+{
+    patch->parse();
+
+    /*------------------------------------------------------------------------
+     * Claim the patch's nodes now, even if the graph isn't yet running, as
+     * it may have been started by the time the patch begins playing.
+     *-----------------------------------------------------------------------*/
+    this->claim_subgraph(patch->output.get());
+
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_PLAY_PATCH;
+    command.patch = patch;
+    command.frame = frame;
+    return this->post_command(command);
 }
 
-void AudioGraph::play(NodeRef node)
+std::future<void> AudioGraph::stop_at(PatchRef patch, long frame)
 {
-    AudioOut_Abstract *output = (AudioOut_Abstract *) this->output.get();
-    output->add_input(node);
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_STOP_PATCH;
+    command.patch_ptr = patch.get();
+    command.node = patch->output;
+    command.frame = frame;
+    return this->post_command(command);
+}
+
+long AudioGraph::get_frame_position()
+{
+    return this->frame_position;
+}
+
+long AudioGraph::get_frame_at_time(double timestamp)
+{
+    /*------------------------------------------------------------------------
+     * frame_position_time is the time at which the next block is due to
+     * begin if rendering keeps pace with real time. Before the first block,
+     * assume that it begins now.
+     *-----------------------------------------------------------------------*/
+    double reference_time = this->frame_position_time;
+    if (reference_time == 0.0)
+    {
+        reference_time = signalflow_timestamp();
+    }
+    return this->frame_position + (long) round((timestamp - reference_time) * this->sample_rate);
+}
+
+std::future<void> AudioGraph::set_input(NodeRef node, std::string name, NodeRef input)
+{
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_SET_INPUT;
+    command.node = node;
+    command.input_name = name;
+    command.other = input;
+    if (this->get_is_queueing_commands() && node->graph_owned)
+    {
+        /*------------------------------------------------------------------------
+         * Channel counts are inferred and storage allocated here, so that the
+         * audio thread only has to swap it in. This also means that an input
+         * with an invalid channel count throws here, rather than on the
+         * audio thread.
+         *-----------------------------------------------------------------------*/
+        command.input_change = std::make_shared<NodeInputChange>();
+        node->prepare_set_input(name, input, *command.input_change);
+        if (input)
+        {
+            this->claim_subgraph(input.get());
+        }
+    }
+    return this->apply_command(command);
+}
+
+std::future<void> AudioGraph::add_input(NodeRef node, NodeRef input)
+{
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_ADD_INPUT;
+    command.node = node;
+    command.other = input;
+    if (this->get_is_queueing_commands() && node->graph_owned && input)
+    {
+        this->claim_subgraph(input.get());
+    }
+    return this->apply_command(command);
+}
+
+std::future<void> AudioGraph::remove_input(NodeRef node, NodeRef input)
+{
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_REMOVE_INPUT;
+    command.node = node;
+    command.other = input;
+    return this->apply_command(command);
+}
+
+bool AudioGraph::get_is_running()
+{
+    return this->is_running;
 }
 
-void AudioGraph::stop(PatchRef patch)
+bool AudioGraph::get_is_queueing_commands()
 {
-    this->stop(patch.get());
+    return this->is_running && !is_applying_commands;
 }
 
-void AudioGraph::stop(Patch *patch)
+int AudioGraph::get_command_queue_overflow_count()
 {
-    patches_to_remove.insert(patch);
-    nodes_to_remove.insert(patch->output);
+    return this->commands.get_overflow_count();
 }
 
-void AudioGraph::stop(NodeRef node)
+int AudioGraph::get_reclaim_overflow_count()
 {
-    nodes_to_remove.insert(node);
+    return this->reclaimer->get_overflow_count();
 }
 
-void AudioGraph::replace(NodeRef node, NodeRef other)
+long AudioGraph::get_missing_node_count()
 {
-    nodes_to_replace.insert(std::make_pair(node, other));
+    return ((AudioOut_Abstract *) this->output.get())->get_missing_input_count();
 }
 
-void AudioGraph::start_recording(const std::string &filename, int num_channels)
+AudioGraphTelemetryStats AudioGraph::get_telemetry()
 {
-    SF_INFO info;
-    memset(&info, 0, sizeof(SF_INFO));
-    info.frames = this->get_output_buffer_size();
+    return this->telemetry->get_stats();
+}
+
+void AudioGraph::reset_telemetry()
+{
+    this->telemetry->reset();
+}
 
+void AudioGraph::start_recording(const std::string &filename, int num_channels, signalflow_recording_format_t format)
+{
     if (num_channels == 0)
     {
         num_channels = this->output->get_num_input_channels();
     }
-    info.channels = num_channels;
-    info.samplerate = (int) this->sample_rate;
-    info.format = SF_FORMAT_WAV | SF_FORMAT_PCM_16;
+    if (num_channels > this->output->get_num_input_channels())
+    {
+        throw std::runtime_error("AudioGraph: Cannot record more channels than the output has");
+    }
+
+    this->stop_recording();
+
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_START_RECORDING;
+    command.recorder = std::make_shared<DiskWriter>(filename, num_channels, this->sample_rate, format);
+    this->recorder = command.recorder;
+    this->apply_command(command).get();
+}
+
+void AudioGraph::stop_recording()
+{
+    if (!this->recorder)
+    {
+        return;
+    }
 
-    this->recording_num_channels = num_channels;
-    this->recording_fd = sf_open(filename.c_str(), SFM_WRITE, &info);
+    /*------------------------------------------------------------------------
+     * Wait until the audio thread has stopped writing to the recorder
+     * before closing it.
+     *-----------------------------------------------------------------------*/
+    AudioGraphCommand command;
+    command.type = SIGNALFLOW_GRAPH_COMMAND_STOP_RECORDING;
+    this->apply_command(command).get();
+
+    this->recorder->close();
+    this->recorder = nullptr;
+}
 
-    if (!this->recording_fd)
+int AudioGraph::get_recording_overflow_count()
+{
+    if (!this->recorder)
     {
-        throw std::runtime_error(std::string("Failed to write soundfile (") + std::string(sf_strerror(NULL)) + ")");
+        return 0;
     }
+    return this->recorder->get_overflow_count();
 }
 
-void AudioGraph::stop_recording()
+long AudioGraph::get_render_ahead_underrun_count()
+{
+    return this->render_thread ? this->render_thread->get_underrun_count() : 0;
+}
+
+int AudioGraph::get_render_ahead_buffered_frames()
 {
-    sf_close(this->recording_fd);
+    return this->render_thread ? this->render_thread->get_buffered_frames() : 0;
 }
 
 void AudioGraph::show_structure()
@@ -452,7 +2345,7 @@ void AudioGraph::show_structure(NodeRef &root, int depth)
         std::cout << std::string((depth + 1) * 2 + 1, ' ');
 
         NodeRef param_node = *(pair.second);
-        if (param_node->name == "constant")
+        if (param_node->type == SIGNALFLOW_NODE_TYPE_CONSTANT)
         {
             Constant *constant = (Constant *) (param_node.get());
             std::cout << pair.first << ": " << constant->value << std::endl;
@@ -517,11 +2410,22 @@ int AudioGraph::get_output_buffer_size()
     }
 }
 
+int AudioGraph::get_block_size()
+{
+    return this->block_size;
+}
+
 int AudioGraph::get_node_count()
 {
     return this->node_count;
 }
 
+int AudioGraph::get_scratch_buffer_count()
+{
+    signalflow_scratch_pool_t *pool = this->scratch_pool_adopted.load(std::memory_order_acquire);
+    return pool ? (int) pool->buffers.size() : 0;
+}
+
 int AudioGraph::get_patch_count()
 {
     return (int) this->patches.size();
@@ -532,6 +2436,151 @@ float AudioGraph::get_cpu_usage()
     return this->cpu_usage;
 }
 
+void AudioGraph::set_profiling_enabled(bool enabled)
+{
+    this->profiling_enabled = enabled;
+
+    /*------------------------------------------------------------------------
+     * Nodes that are already being rendered are found from the snapshot of
+     * the schedule. If the graph isn't running, every connected node is
+     * given a profile before the next block is rendered.
+     *-----------------------------------------------------------------------*/
+    if (enabled && this->is_running)
+    {
+        std::vector<NodeRef> nodes;
+        {
+            std::lock_guard<std::mutex> lock(this->schedule_nodes_mutex);
+            nodes = this->schedule_nodes;
+        }
+        for (auto &node : nodes)
+        {
+            this->allocate_profile(node.get());
+        }
+    }
+    this->invalidate_schedule();
+}
+
+bool AudioGraph::get_profiling_enabled()
+{
+    return this->profiling_enabled;
+}
+
+void AudioGraph::allocate_profile(Node *node)
+{
+    if (!node->get_profile())
+    {
+        NodeProfile *profile = new NodeProfile();
+        NodeProfile *expected = nullptr;
+        if (!node->profile.compare_exchange_strong(expected, profile))
+        {
+            delete profile;
+        }
+    }
+}
+
+void AudioGraph::allocate_profiles(Node *node, std::unordered_set<Node *> &visited)
+{
+    if (!node || visited.count(node))
+    {
+        return;
+    }
+    visited.insert(node);
+    this->allocate_profile(node);
+    for (NodeRef *input_node : node->input_slots)
+    {
+        if (input_node && *input_node)
+        {
+            this->allocate_profiles(input_node->get(), visited);
+        }
+    }
+}
+
+std::vector<NodeRef> AudioGraph::get_profiled_nodes()
+{
+    std::vector<NodeRef> nodes;
+    if (this->is_running)
+    {
+        std::lock_guard<std::mutex> lock(this->schedule_nodes_mutex);
+        for (auto &node : this->schedule_nodes)
+        {
+            if (node->get_profile())
+            {
+                nodes.push_back(node);
+            }
+        }
+    }
+    else
+    {
+        /*------------------------------------------------------------------------
+         * Nothing else is rendering the graph, so walk it directly.
+         *-----------------------------------------------------------------------*/
+        std::vector<Node *> stack;
+        std::unordered_set<Node *> visited;
+        stack.push_back(this->output.get());
+        for (auto &node : this->scheduled_nodes)
+        {
+            stack.push_back(node.get());
+        }
+        while (!stack.empty())
+        {
+            Node *node = stack.back();
+            stack.pop_back();
+            if (visited.count(node))
+            {
+                continue;
+            }
+            visited.insert(node);
+            if (node->get_profile())
+            {
+                nodes.push_back(node->shared_from_this());
+            }
+            for (NodeRef *input_node : node->input_slots)
+            {
+                if (input_node && *input_node)
+                {
+                    stack.push_back(input_node->get());
+                }
+            }
+        }
+    }
+    return nodes;
+}
+
+AudioGraphProfile AudioGraph::get_profile()
+{
+    std::vector<NodeRef> nodes = this->get_profiled_nodes();
+
+    AudioGraphProfile profile;
+    std::map<std::string, NodeProfileStats> class_stats;
+    std::map<std::string, std::vector<float>> class_history;
+    for (auto &node : nodes)
+    {
+        profile.nodes.push_back(node->get_profile()->get_stats(node->name));
+        NodeProfileStats &stats = class_stats[node->name];
+        stats.name = node->name;
+        node->get_profile()->accumulate(stats, class_history[node->name]);
+    }
+    for (auto &pair : class_stats)
+    {
+        NodeProfile::finalise(pair.second, class_history[pair.first]);
+        profile.classes.push_back(pair.second);
+    }
+    std::sort(profile.classes.begin(), profile.classes.end(), [](const NodeProfileStats &a, const NodeProfileStats &b) {
+        return a.total > b.total;
+    });
+
+    return profile;
+}
+
+void AudioGraph::reset_profile()
+{
+    std::vector<NodeRef> nodes = this->get_profiled_nodes();
+    for (auto &node : nodes)
+    {
+        node->get_profile()->reset();
+    }
+}
+
 AudioGraphConfig &AudioGraph::get_config()
 {
     return this->config;
@@ -0,0 +1,92 @@
+#include "signalflow/core/profiler.h"
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+namespace signalflow
+{
+
+NodeProfile::NodeProfile()
+{
+    this->reset();
+}
+
+void NodeProfile::record(double duration)
+{
+    long num_blocks = this->num_blocks.load(std::memory_order_relaxed);
+    this->history[num_blocks % SIGNALFLOW_PROFILER_HISTORY_SIZE].store((float) duration, std::memory_order_relaxed);
+    this->total.store(this->total.load(std::memory_order_relaxed) + duration, std::memory_order_relaxed);
+    if (num_blocks == 0 || duration < this->min.load(std::memory_order_relaxed))
+    {
+        this->min.store(duration, std::memory_order_relaxed);
+    }
+    if (duration > this->max.load(std::memory_order_relaxed))
+    {
+        this->max.store(duration, std::memory_order_relaxed);
+    }
+    this->num_blocks.store(num_blocks + 1, std::memory_order_relaxed);
+}
+
+void NodeProfile::reset()
+{
+    for (int i = 0; i < SIGNALFLOW_PROFILER_HISTORY_SIZE; i++)
+    {
+        this->history[i].store(0.0, std::memory_order_relaxed);
+    }
+    this->num_blocks.store(0, std::memory_order_relaxed);
+    this->total.store(0.0, std::memory_order_relaxed);
+    this->min.store(0.0, std::memory_order_relaxed);
+    this->max.store(0.0, std::memory_order_relaxed);
+}
+
+NodeProfileStats NodeProfile::get_stats(const std::string &name)
+{
+    NodeProfileStats stats;
+    std::vector<float> history;
+    stats.name = name;
+    this->accumulate(stats, history);
+    NodeProfile::finalise(stats, history);
+    return stats;
+}
+
+void NodeProfile::accumulate(NodeProfileStats &stats, std::vector<float> &history)
+{
+    long num_blocks = this->num_blocks.load(std::memory_order_relaxed);
+    if (num_blocks == 0)
+    {
+        return;
+    }
+
+    double min = this->min.load(std::memory_order_relaxed);
+    double max = this->max.load(std::memory_order_relaxed);
+    stats.min = stats.num_blocks == 0 ? min : std::min(stats.min, min);
+    stats.max = std::max(stats.max, max);
+    stats.total += this->total.load(std::memory_order_relaxed);
+    stats.num_blocks += num_blocks;
+
+    int history_size = (int) std::min(num_blocks, (long) SIGNALFLOW_PROFILER_HISTORY_SIZE);
+    for (int i = 0; i < history_size; i++)
+    {
+        history.push_back(this->history[i].load(std::memory_order_relaxed));
+    }
+}
+
+void NodeProfile::finalise(NodeProfileStats &stats, std::vector<float> &history)
+{
+    if (stats.num_blocks == 0 || history.empty())
+    {
+        return;
+    }
+    stats.mean = stats.total / stats.num_blocks;
+
+    /*------------------------------------------------------------------------
+     * Nearest-rank percentile. History is stored at single precision, so
+     * clamp to the double-precision extremes.
+     *-----------------------------------------------------------------------*/
+    int index = (int) ceil(0.99 * history.size()) - 1;
+    std::nth_element(history.begin(), history.begin() + index, history.end());
+    stats.p99 = std::min(std::max((double) history[index], stats.min), stats.max);
+}
+
+}
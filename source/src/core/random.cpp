@@ -2,10 +2,13 @@
  * util.cpp: Helper utilities.
  *--------------------------------------------------------------------*/
 
+#include "signalflow/core/graph.h"
 #include "signalflow/core/random.h"
 #include "signalflow/core/util.h"
+#include <functional>
 #include <random>
 #include <sys/time.h>
+#include <thread>
 
 #include <limits.h>
 
@@ -13,28 +16,65 @@ namespace signalflow
 {
 
 /*--------------------------------------------------------------------*
- * Maintain a single global RNG state object.
+ * random_default_seed(): Seed with current time multiplied by
+ * microsecond part, to give a pretty decent non-correlated seed,
+ * mixed with the thread ID so that threads started together differ.
  *--------------------------------------------------------------------*/
-std::mt19937 rng;
+static unsigned long random_default_seed()
+{
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return (tv.tv_sec * tv.tv_usec) ^ std::hash<std::thread::id>()(std::this_thread::get_id());
+}
+
+/*--------------------------------------------------------------------*
+ * Maintain an RNG state object per thread, for random numbers drawn
+ * outside of a graph's render. While a graph is rendering, its
+ * threads instead draw from the graph's own state.
+ *--------------------------------------------------------------------*/
+static thread_local std::mt19937 thread_rng(random_default_seed());
+static thread_local std::mt19937 *thread_generator = nullptr;
+
+static inline std::mt19937 &get_rng()
+{
+    return thread_generator ? *thread_generator : thread_rng;
+}
+
+std::mt19937 *random_set_thread_generator(std::mt19937 *generator)
+{
+    std::mt19937 *previous = thread_generator;
+    thread_generator = generator;
+    return previous;
+}
 
 /*--------------------------------------------------------------------*
- * random_init(): Initialise pseudo-random number generator.
- *
+ * random_init(): Initialise the calling thread's pseudo-random
+ * number generator.
  *--------------------------------------------------------------------*/
 void random_init()
 {
-    /*--------------------------------------------------------------------*
-     * Seed with current time multiplied by microsecond part, to give
-     * a pretty decent non-correlated seed.
-     *--------------------------------------------------------------------*/
-    struct timeval tv;
-    gettimeofday(&tv, 0);
-    random_seed(tv.tv_sec * tv.tv_usec);
+    thread_rng.seed(random_default_seed());
 }
 
+/*--------------------------------------------------------------------*
+ * random_seed(): Seed the calling thread's pseudo-random number
+ * generator, and that of the current graph, which is used by all of
+ * the threads that render it.
+ *--------------------------------------------------------------------*/
 void random_seed(long seed)
 {
-    rng.seed(seed);
+    if (thread_generator)
+    {
+        thread_generator->seed(seed);
+        return;
+    }
+
+    thread_rng.seed(seed);
+    AudioGraph *graph = AudioGraph::get_shared_graph();
+    if (graph)
+    {
+        graph->set_random_seed(seed);
+    }
 }
 
 /*--------------------------------------------------------------------*
@@ -48,7 +88,7 @@ double random_gaussian(double mean, double sd)
 
 double random_gaussian()
 {
-    return std::normal_distribution<double>(0, 1)(rng);
+    return std::normal_distribution<double>(0, 1)(get_rng());
 }
 
 /*--------------------------------------------------------------------*
@@ -56,7 +96,7 @@ double random_gaussian()
  *--------------------------------------------------------------------*/
 double random_uniform()
 {
-    return std::uniform_real_distribution<double>(0, 1)(rng);
+    return std::uniform_real_distribution<double>(0, 1)(get_rng());
 }
 
 double random_uniform(double from, double to)
@@ -74,7 +114,7 @@ bool random_coin(double limit = 0.5)
 
 float random_exponential(float mu)
 {
-    return std::exponential_distribution<double>(mu)(rng);
+    return std::exponential_distribution<double>(mu)(get_rng());
 }
 
 /*--------------------------------------------------------------------*
@@ -1,6 +1,9 @@
 #include "signalflow/core/renderer.h"
 #include "signalflow/node/oscillators/constant.h"
 
+#include <algorithm>
+#include <iomanip>
+
 namespace signalflow
 {
 
@@ -17,7 +20,7 @@ void GraphRenderer::render_node(NodeRef node)
         return;
     this->rendered_nodes.insert(node.get());
 
-    if (node->name == "constant")
+    if (node->type == SIGNALFLOW_NODE_TYPE_CONSTANT)
     {
         /*------------------------------------------------------------------------
          * Render constant numeric values in a ring
@@ -29,35 +32,73 @@ void GraphRenderer::render_node(NodeRef node)
     else
     {
         /*------------------------------------------------------------------------
-         * Render Node names in a box
+         * Render Node names in a box, with their mean processing time if
+         * profiled. Hue runs from green (cheap) to red (the costliest node).
          *-----------------------------------------------------------------------*/
         nodestream << "\"" << (void const *) node.get() << "\" [fontname=\"helvetica-bold\", label = \"";
         nodestream << node->name;
+        auto stats = this->profile_stats.find(node.get());
+        if (stats != this->profile_stats.end() && this->max_mean > 0)
+        {
+            double cost = stats->second.mean / this->max_mean;
+            std::stringstream attributes;
+            attributes << std::fixed << std::setprecision(1) << "\\n" << stats->second.mean * 1e6 << "us\"";
+            attributes << std::setprecision(3) << ", style=filled, fillcolor=\"" << (1.0 - cost) * 0.333 << " 0.6 1.0";
+            nodestream << attributes.str();
+        }
         nodestream << "\"]; ";
     }
 
     /*------------------------------------------------------------------------
      * Collate edges, titled based on their node input
      *-----------------------------------------------------------------------*/
-    for (auto param : node->inputs)
+    for (size_t index = 0; index < node->input_slots.size(); index++)
     {
-        NodeRef value = *(param.second);
+        NodeRef value = *(node->input_slots[index]);
         if (value)
         {
             this->render_node(value);
-            edgestream << "\"" << (void const *) value.get() << "\" -> \"" << (void const *) node.get() << "\" [fontcolor = red, labeldistance = 2, headlabel = \"" << param.first << "\"]; ";
+            edgestream << "\"" << (void const *) value.get() << "\" -> \"" << (void const *) node.get() << "\" [fontcolor = red, labeldistance = 2, headlabel = \"" << node->input_names[index] << "\"]; ";
         }
     }
 }
 
-void GraphRenderer::render(AudioGraphRef graph)
+void GraphRenderer::find_profiles(AudioGraph *graph)
 {
     /*------------------------------------------------------------------------
-     * Recurse and render the complete output
+     * Read the graph's snapshot of its profiled nodes, rather than walking
+     * connections that the audio thread may be changing.
      *-----------------------------------------------------------------------*/
+    for (auto &node : graph->get_profiled_nodes())
+    {
+        NodeProfileStats stats = node->get_profile()->get_stats(node->name);
+        this->profile_stats[node.get()] = stats;
+        this->max_mean = std::max(this->max_mean, stats.mean);
+    }
+}
+
+std::string GraphRenderer::get_dot(AudioGraph *graph)
+{
+    this->nodestream.str("");
+    this->edgestream.str("");
+    this->profile_stats.clear();
+    this->max_mean = 0.0;
+
+    /*------------------------------------------------------------------------
+     * Find the costliest node, then recurse and render the complete output
+     *-----------------------------------------------------------------------*/
+    this->find_profiles(graph);
     this->rendered_nodes.clear();
     this->render_node(graph->get_output());
-    std::cout << "digraph { splines=ortho; graph [pad=1, ranksep=0.5, nodesep=0.5]; node [ fontname = helvetica, fontsize = 11, shape = box  ]; edge [ fontname = helvetica, fontsize = 9 ]; " << nodestream.str() << edgestream.str() << "} " << std::endl;
+
+    std::stringstream dot;
+    dot << "digraph { splines=ortho; graph [pad=1, ranksep=0.5, nodesep=0.5]; node [ fontname = helvetica, fontsize = 11, shape = box  ]; edge [ fontname = helvetica, fontsize = 9 ]; " << nodestream.str() << edgestream.str() << "} ";
+    return dot.str();
+}
+
+void GraphRenderer::render(AudioGraphRef graph)
+{
+    std::cout << this->get_dot(graph.get()) << std::endl;
 }
 
 } /* namespace signalflow */
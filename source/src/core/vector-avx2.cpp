@@ -0,0 +1,51 @@
+#include "vector-kernels.h"
+
+#if defined(SIGNALFLOW_VECTOR_X86)
+
+/*--------------------------------------------------------------------------------
+ * Compiled with -mavx2 (see the top-level CMakeLists.txt). The functions in
+ * this file are only called once runtime detection has confirmed that the CPU
+ * supports AVX2.
+ *-------------------------------------------------------------------------------*/
+#if !defined(__AVX2__)
+#error "vector-avx2.cpp must be compiled with AVX2 enabled"
+#endif
+
+namespace signalflow
+{
+
+namespace
+{
+
+struct AVX2ISA : SSE2Stereo
+{
+    typedef __m256 reg;
+    static const int width = 8;
+    static reg load(const sample *p) { return _mm256_loadu_ps(p); }
+    static void store(sample *p, reg v) { _mm256_storeu_ps(p, v); }
+    static reg set1(sample v) { return _mm256_set1_ps(v); }
+    static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+    static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+    static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+    static reg abs(reg a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static sample reduce(reg a)
+    {
+        __m128 quad = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+        __m128 pairs = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+};
+
+}
+
+const signalflow_vector_kernels_t *signalflow_vector_kernels_avx2()
+{
+    return VectorKernels<AVX2ISA>::table();
+}
+
+}
+
+#endif
@@ -0,0 +1,46 @@
+#include "vector-kernels.h"
+
+#if defined(SIGNALFLOW_VECTOR_X86)
+
+/*--------------------------------------------------------------------------------
+ * Compiled with -mavx512f (see the top-level CMakeLists.txt). The functions in
+ * this file are only called once runtime detection has confirmed that the CPU
+ * supports AVX-512F.
+ *-------------------------------------------------------------------------------*/
+#if !defined(__AVX512F__)
+#error "vector-avx512.cpp must be compiled with AVX-512F enabled"
+#endif
+
+namespace signalflow
+{
+
+namespace
+{
+
+struct AVX512ISA : SSE2Stereo
+{
+    typedef __m512 reg;
+    static const int width = 16;
+    static reg load(const sample *p) { return _mm512_loadu_ps(p); }
+    static void store(sample *p, reg v) { _mm512_storeu_ps(p, v); }
+    static reg set1(sample v) { return _mm512_set1_ps(v); }
+    static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    static reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+    static reg min(reg a, reg b) { return _mm512_min_ps(a, b); }
+    static reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+    static reg abs(reg a) { return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a), _mm512_set1_epi32(0x7fffffff))); }
+    static sample reduce(reg a) { return _mm512_reduce_add_ps(a); }
+};
+
+}
+
+const signalflow_vector_kernels_t *signalflow_vector_kernels_avx512()
+{
+    return VectorKernels<AVX512ISA>::table();
+}
+
+}
+
+#endif
@@ -0,0 +1,298 @@
+/*--------------------------------------------------------------------*
+ * vector-kernels.h: Kernel templates shared by each of the
+ * instruction set implementations of signalflow/core/vector.h.
+ *
+ * Internal: included only by the vector-*.cpp translation units,
+ * each of which is compiled for a different instruction set. The
+ * templates are defined in an unnamed namespace so that code compiled
+ * for one instruction set can never be linked into another.
+ *
+ * Each instruction set is described by a traits class with a register
+ * type, `width` (floats per register), and static load/store/arithmetic
+ * functions. Remaining samples are processed one at a time, with the
+ * same operations as the scalar implementation.
+ *--------------------------------------------------------------------*/
+
+#pragma once
+
+#include "signalflow/core/vector.h"
+
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace signalflow
+{
+
+typedef struct
+{
+    void (*add)(const sample *, const sample *, sample *, int);
+    void (*subtract)(const sample *, const sample *, sample *, int);
+    void (*multiply)(const sample *, const sample *, sample *, int);
+    void (*divide)(const sample *, const sample *, sample *, int);
+    void (*min)(const sample *, const sample *, sample *, int);
+    void (*max)(const sample *, const sample *, sample *, int);
+    void (*mac)(const sample *, sample, sample *, int);
+    void (*scale)(const sample *, sample, sample *, int);
+    void (*clamp)(const sample *, sample, sample, sample *, int);
+    void (*abs)(const sample *, sample *, int);
+    void (*fill)(sample, sample *, int);
+    void (*copy)(const sample *, sample *, int);
+    sample (*sum)(const sample *, int);
+    void (*interleave)(sample *const *, int, sample *, int);
+    void (*deinterleave)(const sample *, int, sample *const *, int);
+} signalflow_vector_kernels_t;
+
+const signalflow_vector_kernels_t *signalflow_vector_kernels_scalar();
+const signalflow_vector_kernels_t *signalflow_vector_kernels_sse2();
+const signalflow_vector_kernels_t *signalflow_vector_kernels_avx2();
+const signalflow_vector_kernels_t *signalflow_vector_kernels_avx512();
+const signalflow_vector_kernels_t *signalflow_vector_kernels_neon();
+
+namespace
+{
+
+/*--------------------------------------------------------------------*
+ * Scalar operations. min and max follow the SSE convention of
+ * returning the second operand if either operand is NaN.
+ *--------------------------------------------------------------------*/
+inline sample scalar_min(sample a, sample b) { return a < b ? a : b; }
+inline sample scalar_max(sample a, sample b) { return a > b ? a : b; }
+inline sample scalar_abs(sample a) { return std::fabs(a); }
+
+#if defined(__SSE2__)
+/*--------------------------------------------------------------------*
+ * Stereo interleaving with 128-bit registers, shared by the x86
+ * implementations.
+ *--------------------------------------------------------------------*/
+struct SSE2Stereo
+{
+    static int interleave_stereo(const sample *left, const sample *right, sample *out, int n)
+    {
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 l = _mm_loadu_ps(left + i);
+            __m128 r = _mm_loadu_ps(right + i);
+            _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(l, r));
+            _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(l, r));
+        }
+        return i;
+    }
+
+    static int deinterleave_stereo(const sample *in, sample *left, sample *right, int n)
+    {
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 a = _mm_loadu_ps(in + 2 * i);
+            __m128 b = _mm_loadu_ps(in + 2 * i + 4);
+            _mm_storeu_ps(left + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(right + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+        return i;
+    }
+};
+#endif
+
+/*--------------------------------------------------------------------*
+ * Traits for the scalar implementation, which processes one sample
+ * per "register".
+ *--------------------------------------------------------------------*/
+struct ScalarISA
+{
+    typedef sample reg;
+    static const int width = 1;
+    static reg load(const sample *p) { return *p; }
+    static void store(sample *p, reg v) { *p = v; }
+    static reg set1(sample v) { return v; }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg sub(reg a, reg b) { return a - b; }
+    static reg mul(reg a, reg b) { return a * b; }
+    static reg div(reg a, reg b) { return a / b; }
+    static reg min(reg a, reg b) { return scalar_min(a, b); }
+    static reg max(reg a, reg b) { return scalar_max(a, b); }
+    static reg abs(reg a) { return scalar_abs(a); }
+    static sample reduce(reg a) { return a; }
+    static int interleave_stereo(const sample *, const sample *, sample *, int) { return 0; }
+    static int deinterleave_stereo(const sample *, sample *, sample *, int) { return 0; }
+};
+
+template <class ISA>
+struct VectorKernels
+{
+    typedef typename ISA::reg reg;
+
+    static void add(const sample *a, const sample *b, sample *out, int n)
+    {
+        int i = 0;
+        for (; i + ISA::width <= n; i += ISA::width)
+            ISA::store(out + i, ISA::add(ISA::load(a + i), ISA::load(b + i)));
+        for (; i < n; i++)
+            out[i] = a[i] + b[i];
+    }
+
+    static void subtract(const sample *a, const sample *b, sample *out, int n)
+    {
+        int i = 0;
+        for (; i + ISA::width <= n; i += ISA::width)
+            ISA::store(out + i, ISA::sub(ISA::load(a + i), ISA::load(b + i)));
+        for (; i < n; i++)
+            out[i] = a[i] - b[i];
+    }
+
+    static void multiply(const sample *a, const sample *b, sample *out, int n)
+    {
+        int i = 0;
+        for (; i + ISA::width <= n; i += ISA::width)
+            ISA::store(out + i, ISA::mul(ISA::load(a + i), ISA::load(b + i)));
+        for (; i < n; i++)
+            out[i] = a[i] * b[i];
+    }
+
+    static void divide(const sample *a, const sample *b, sample *out, int n)
+    {
+        int i = 0;
+        for (; i + ISA::width <= n; i += ISA::width)
+            ISA::store(out + i, ISA::div(ISA::load(a + i), ISA::load(b + i)));
+        for (; i < n; i++)
+            out[i] = a[i] / b[i];
+    }
+
+    static void min(const sample *a, const sample *b, sample *out, int n)
+    {
+        int i = 0;
+        for (; i + ISA::width <= n; i += ISA::width)
+            ISA::store(out + i, ISA::min(ISA::load(a + i), ISA::load(b + i)));
+        for (; i < n; i++)
+            out[i] = scalar_min(a[i], b[i]);
+    }
+
+    static void max(const sample *a, const sample *b, sample *out, int n)
+    {
+        int i = 0;
+        for (; i + ISA::width <= n; i += ISA::width)
+            ISA::store(out + i, ISA::max(ISA::load(a + i), ISA::load(b + i)));
+        for (; i < n; i++)
+            out[i] = scalar_max(a[i], b[i]);
+    }
+
+    static void mac(const sample *in, sample scale, sample *out, int n)
+    {
+        reg s = ISA::set1(scale);
+        int i = 0;
+        for (; i + ISA::width <= n; i += ISA::width)
+            ISA::store(out + i, ISA::add(ISA::load(out + i), ISA::mul(ISA::load(in + i), s)));
+        for (; i < n; i++)
+            out[i] = out[i] + in[i] * scale;
+    }
+
+    static void scale(const sample *in, sample scale, sample *out, int n)
+    {
+        reg s = ISA::set1(scale);
+        int i = 0;
+        for (; i + ISA::width <= n; i += ISA::width)
+            ISA::store(out + i, ISA::mul(ISA::load(in + i), s));
+        for (; i < n; i++)
+            out[i] = in[i] * scale;
+    }
+
+    static void clamp(const sample *in, sample min, sample max, sample *out, int n)
+    {
+        reg lo = ISA::set1(min);
+        reg hi = ISA::set1(max);
+        int i = 0;
+        for (; i + ISA::width <= n; i += ISA::width)
+            ISA::store(out + i, ISA::min(ISA::max(ISA::load(in + i), lo), hi));
+        for (; i < n; i++)
+            out[i] = scalar_min(scalar_max(in[i], min), max);
+    }
+
+    static void abs(const sample *in, sample *out, int n)
+    {
+        int i = 0;
+        for (; i + ISA::width <= n; i += ISA::width)
+            ISA::store(out + i, ISA::abs(ISA::load(in + i)));
+        for (; i < n; i++)
+            out[i] = scalar_abs(in[i]);
+    }
+
+    static void fill(sample value, sample *out, int n)
+    {
+        reg v = ISA::set1(value);
+        int i = 0;
+        for (; i + ISA::width <= n; i += ISA::width)
+            ISA::store(out + i, v);
+        for (; i < n; i++)
+            out[i] = value;
+    }
+
+    static void copy(const sample *in, sample *out, int n)
+    {
+        int i = 0;
+        for (; i + ISA::width <= n; i += ISA::width)
+            ISA::store(out + i, ISA::load(in + i));
+        for (; i < n; i++)
+            out[i] = in[i];
+    }
+
+    static sample sum(const sample *in, int n)
+    {
+        reg total = ISA::set1(0);
+        int i = 0;
+        for (; i + ISA::width <= n; i += ISA::width)
+            total = ISA::add(total, ISA::load(in + i));
+        sample rv = ISA::reduce(total);
+        for (; i < n; i++)
+            rv += in[i];
+        return rv;
+    }
+
+    static void interleave(sample *const *in, int num_channels, sample *out, int num_frames)
+    {
+        int frame = 0;
+        if (num_channels == 2)
+        {
+            frame = ISA::interleave_stereo(in[0], in[1], out, num_frames);
+        }
+        for (; frame < num_frames; frame++)
+        {
+            for (int channel = 0; channel < num_channels; channel++)
+            {
+                out[frame * num_channels + channel] = in[channel][frame];
+            }
+        }
+    }
+
+    static void deinterleave(const sample *in, int num_channels, sample *const *out, int num_frames)
+    {
+        int frame = 0;
+        if (num_channels == 2)
+        {
+            frame = ISA::deinterleave_stereo(in, out[0], out[1], num_frames);
+        }
+        for (; frame < num_frames; frame++)
+        {
+            for (int channel = 0; channel < num_channels; channel++)
+            {
+                out[channel][frame] = in[frame * num_channels + channel];
+            }
+        }
+    }
+
+    static const signalflow_vector_kernels_t *table()
+    {
+        static const signalflow_vector_kernels_t kernels = {
+            add, subtract, multiply, divide, min, max,
+            mac, scale, clamp, abs, fill, copy, sum,
+            interleave, deinterleave
+        };
+        return &kernels;
+    }
+};
+
+}
+
+}
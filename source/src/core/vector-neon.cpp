@@ -0,0 +1,66 @@
+#include "vector-kernels.h"
+
+#if defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+namespace signalflow
+{
+
+namespace
+{
+
+/*--------------------------------------------------------------------------------
+ * vminq_f32/vmaxq_f32 propagate NaNs, so min and max are implemented with a
+ * compare and select to match the scalar implementation.
+ *-------------------------------------------------------------------------------*/
+struct NEONISA
+{
+    typedef float32x4_t reg;
+    static const int width = 4;
+    static reg load(const sample *p) { return vld1q_f32(p); }
+    static void store(sample *p, reg v) { vst1q_f32(p, v); }
+    static reg set1(sample v) { return vdupq_n_f32(v); }
+    static reg add(reg a, reg b) { return vaddq_f32(a, b); }
+    static reg sub(reg a, reg b) { return vsubq_f32(a, b); }
+    static reg mul(reg a, reg b) { return vmulq_f32(a, b); }
+    static reg div(reg a, reg b) { return vdivq_f32(a, b); }
+    static reg min(reg a, reg b) { return vbslq_f32(vcltq_f32(a, b), a, b); }
+    static reg max(reg a, reg b) { return vbslq_f32(vcgtq_f32(a, b), a, b); }
+    static reg abs(reg a) { return vabsq_f32(a); }
+    static sample reduce(reg a) { return vaddvq_f32(a); }
+
+    static int interleave_stereo(const sample *left, const sample *right, sample *out, int n)
+    {
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            float32x4x2_t frames = { { vld1q_f32(left + i), vld1q_f32(right + i) } };
+            vst2q_f32(out + 2 * i, frames);
+        }
+        return i;
+    }
+
+    static int deinterleave_stereo(const sample *in, sample *left, sample *right, int n)
+    {
+        int i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            float32x4x2_t frames = vld2q_f32(in + 2 * i);
+            vst1q_f32(left + i, frames.val[0]);
+            vst1q_f32(right + i, frames.val[1]);
+        }
+        return i;
+    }
+};
+
+}
+
+const signalflow_vector_kernels_t *signalflow_vector_kernels_neon()
+{
+    return VectorKernels<NEONISA>::table();
+}
+
+}
+
+#endif
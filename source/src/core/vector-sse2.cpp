@@ -0,0 +1,41 @@
+#include "vector-kernels.h"
+
+#if defined(SIGNALFLOW_VECTOR_X86)
+
+namespace signalflow
+{
+
+namespace
+{
+
+struct SSE2ISA : SSE2Stereo
+{
+    typedef __m128 reg;
+    static const int width = 4;
+    static reg load(const sample *p) { return _mm_loadu_ps(p); }
+    static void store(sample *p, reg v) { _mm_storeu_ps(p, v); }
+    static reg set1(sample v) { return _mm_set1_ps(v); }
+    static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+    static reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+    static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+    static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+    static reg abs(reg a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    static sample reduce(reg a)
+    {
+        __m128 pairs = _mm_add_ps(a, _mm_movehl_ps(a, a));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+};
+
+}
+
+const signalflow_vector_kernels_t *signalflow_vector_kernels_sse2()
+{
+    return VectorKernels<SSE2ISA>::table();
+}
+
+}
+
+#endif
@@ -0,0 +1,190 @@
+#include "signalflow/core/vector.h"
+#include "vector-kernels.h"
+
+#include <atomic>
+#include <stdexcept>
+
+namespace signalflow
+{
+
+const signalflow_vector_kernels_t *signalflow_vector_kernels_scalar()
+{
+    return VectorKernels<ScalarISA>::table();
+}
+
+/*--------------------------------------------------------------------------------
+ * The x86 implementations are only built when the build system can compile
+ * them with the corresponding instruction set flags (see the top-level
+ * CMakeLists.txt).
+ * NEON is part of the baseline instruction set on 64-bit ARM.
+ *-------------------------------------------------------------------------------*/
+static const signalflow_vector_kernels_t *signalflow_vector_kernels_for_isa(signalflow_vector_isa_t isa)
+{
+    switch (isa)
+    {
+        case SIGNALFLOW_VECTOR_ISA_SCALAR:
+            return signalflow_vector_kernels_scalar();
+#if defined(SIGNALFLOW_VECTOR_X86)
+        case SIGNALFLOW_VECTOR_ISA_SSE2:
+            if (__builtin_cpu_supports("sse2"))
+                return signalflow_vector_kernels_sse2();
+            break;
+        case SIGNALFLOW_VECTOR_ISA_AVX2:
+            if (__builtin_cpu_supports("avx2"))
+                return signalflow_vector_kernels_avx2();
+            break;
+        case SIGNALFLOW_VECTOR_ISA_AVX512:
+            if (__builtin_cpu_supports("avx512f"))
+                return signalflow_vector_kernels_avx512();
+            break;
+#endif
+#if defined(__ARM_NEON)
+        case SIGNALFLOW_VECTOR_ISA_NEON:
+            return signalflow_vector_kernels_neon();
+#endif
+        default:
+            break;
+    }
+    return nullptr;
+}
+
+/*--------------------------------------------------------------------------------
+ * Select the widest supported instruction set at static initialisation.
+ * __builtin_cpu_init() must be called explicitly as this may run before the
+ * compiler's own CPU detection constructor.
+ *-------------------------------------------------------------------------------*/
+static signalflow_vector_isa_t signalflow_vector_select_isa(const signalflow_vector_kernels_t **kernels)
+{
+#if defined(SIGNALFLOW_VECTOR_X86)
+    __builtin_cpu_init();
+#endif
+    const signalflow_vector_isa_t preferred[] = {
+        SIGNALFLOW_VECTOR_ISA_AVX512,
+        SIGNALFLOW_VECTOR_ISA_AVX2,
+        SIGNALFLOW_VECTOR_ISA_NEON,
+        SIGNALFLOW_VECTOR_ISA_SSE2,
+        SIGNALFLOW_VECTOR_ISA_SCALAR
+    };
+    for (auto isa : preferred)
+    {
+        *kernels = signalflow_vector_kernels_for_isa(isa);
+        if (*kernels)
+        {
+            return isa;
+        }
+    }
+    return SIGNALFLOW_VECTOR_ISA_SCALAR;
+}
+
+/*--------------------------------------------------------------------------------
+ * The kernels may be switched while another thread is rendering, so the
+ * table is swapped atomically. The tables themselves are never modified,
+ * so a relaxed load is sufficient, and a render in progress may complete
+ * with either.
+ *-------------------------------------------------------------------------------*/
+static const signalflow_vector_kernels_t *initial_kernels = nullptr;
+static std::atomic<signalflow_vector_isa_t> current_isa(signalflow_vector_select_isa(&initial_kernels));
+static std::atomic<const signalflow_vector_kernels_t *> kernels(initial_kernels);
+
+static inline const signalflow_vector_kernels_t *get_kernels()
+{
+    return kernels.load(std::memory_order_relaxed);
+}
+
+signalflow_vector_isa_t signalflow_vector_get_isa()
+{
+    return current_isa;
+}
+
+void signalflow_vector_set_isa(signalflow_vector_isa_t isa)
+{
+    const signalflow_vector_kernels_t *isa_kernels = signalflow_vector_kernels_for_isa(isa);
+    if (!isa_kernels)
+    {
+        throw std::runtime_error("Vector instruction set is not supported on this CPU");
+    }
+    kernels.store(isa_kernels, std::memory_order_relaxed);
+    current_isa = isa;
+}
+
+bool signalflow_vector_isa_is_supported(signalflow_vector_isa_t isa)
+{
+    return signalflow_vector_kernels_for_isa(isa) != nullptr;
+}
+
+void signalflow_vector_add(const sample *a, const sample *b, sample *out, int num_samples)
+{
+    get_kernels()->add(a, b, out, num_samples);
+}
+
+void signalflow_vector_subtract(const sample *a, const sample *b, sample *out, int num_samples)
+{
+    get_kernels()->subtract(a, b, out, num_samples);
+}
+
+void signalflow_vector_multiply(const sample *a, const sample *b, sample *out, int num_samples)
+{
+    get_kernels()->multiply(a, b, out, num_samples);
+}
+
+void signalflow_vector_divide(const sample *a, const sample *b, sample *out, int num_samples)
+{
+    get_kernels()->divide(a, b, out, num_samples);
+}
+
+void signalflow_vector_min(const sample *a, const sample *b, sample *out, int num_samples)
+{
+    get_kernels()->min(a, b, out, num_samples);
+}
+
+void signalflow_vector_max(const sample *a, const sample *b, sample *out, int num_samples)
+{
+    get_kernels()->max(a, b, out, num_samples);
+}
+
+void signalflow_vector_mac(const sample *in, sample scale, sample *out, int num_samples)
+{
+    get_kernels()->mac(in, scale, out, num_samples);
+}
+
+void signalflow_vector_scale(const sample *in, sample scale, sample *out, int num_samples)
+{
+    get_kernels()->scale(in, scale, out, num_samples);
+}
+
+void signalflow_vector_clamp(const sample *in, sample min, sample max, sample *out, int num_samples)
+{
+    get_kernels()->clamp(in, min, max, out, num_samples);
+}
+
+void signalflow_vector_abs(const sample *in, sample *out, int num_samples)
+{
+    get_kernels()->abs(in, out, num_samples);
+}
+
+void signalflow_vector_fill(sample value, sample *out, int num_samples)
+{
+    get_kernels()->fill(value, out, num_samples);
+}
+
+void signalflow_vector_copy(const sample *in, sample *out, int num_samples)
+{
+    get_kernels()->copy(in, out, num_samples);
+}
+
+sample signalflow_vector_sum(const sample *in, int num_samples)
+{
+    return get_kernels()->sum(in, num_samples);
+}
+
+void signalflow_vector_interleave(sample *const *in, int num_channels, sample *out, int num_frames)
+{
+    get_kernels()->interleave(in, num_channels, out, num_frames);
+}
+
+void signalflow_vector_deinterleave(const sample *in, int num_channels, sample *const *out, int num_frames)
+{
+    get_kernels()->deinterleave(in, num_channels, out, num_frames);
+}
+
+}
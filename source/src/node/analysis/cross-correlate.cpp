@@ -11,6 +11,11 @@ CrossCorrelate::CrossCorrelate(NodeRef input, BufferRef buffer, int hop_size)
 {
     SIGNALFLOW_CHECK_GRAPH();
 
+    if (!buffer)
+    {
+        throw std::runtime_error("CrossCorrelate: No buffer specified");
+    }
+
     this->name = "cross-correlate";
 
     this->create_buffer("buffer", this->buffer);
@@ -18,13 +23,27 @@ CrossCorrelate::CrossCorrelate(NodeRef input, BufferRef buffer, int hop_size)
     this->ring_buffer = new SampleRingBuffer(buffer->get_num_frames());
 }
 
+void CrossCorrelate::copy_to(Node *node)
+{
+    CrossCorrelate *correlate = (CrossCorrelate *) node;
+    correlate->hop_size = this->hop_size;
+    this->Node::copy_to(node);
+}
+
 void CrossCorrelate::process(Buffer &out, int num_frames)
 {
     /*--------------------------------------------------------------------------------
-     * If buffer is null or empty, don't try to process.
+     * If buffer is null or empty, don't try to process. Output silence, as
+     * the output buffer may be shared scratch space.
      *--------------------------------------------------------------------------------*/
     if (!this->buffer || !this->buffer->get_num_frames())
+    {
+        for (int channel = 0; channel < this->num_output_channels; channel++)
+        {
+            memset(out[channel], 0, num_frames * sizeof(sample));
+        }
         return;
+    }
 
     int buffer_num_frames = this->buffer->get_num_frames();
     this->ring_buffer->extend(this->input->out[0], num_frames);
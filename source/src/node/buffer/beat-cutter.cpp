@@ -50,6 +50,7 @@ void BeatCutter::set_buffer(std::string name, BufferRef buffer)
     {
         this->Node::set_buffer(name, buffer);
         this->num_output_channels = buffer->get_num_channels();
+        this->resize_output_buffers(this->num_output_channels);
 
         this->segment_length = (int) ((float) this->buffer->get_num_frames() / this->segment_count);
         for (int i = 0; i < this->segment_count; i++)
@@ -65,8 +66,16 @@ void BeatCutter::set_buffer(std::string name, BufferRef buffer)
 
 void BeatCutter::process(Buffer &out, int num_frames)
 {
+    /*--------------------------------------------------------------------------------
+     * If buffer is null, output silence, as the output buffer may be shared
+     * scratch space.
+     *--------------------------------------------------------------------------------*/
     if (!this->buffer)
     {
+        for (int channel = 0; channel < this->num_output_channels; channel++)
+        {
+            memset(out[channel], 0, num_frames * sizeof(sample));
+        }
         return;
     }
 
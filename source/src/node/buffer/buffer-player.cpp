@@ -52,10 +52,21 @@ void BufferPlayer::set_buffer(std::string name, BufferRef buffer)
     {
         this->Node::set_buffer(name, buffer);
         this->num_output_channels = buffer->get_num_channels();
+        this->resize_output_buffers(this->num_output_channels);
         this->rate_scale_factor = buffer->get_sample_rate() / graph->get_sample_rate();
     }
 }
 
+void BufferPlayer::reset()
+{
+    this->Node::reset();
+    this->phase = std::numeric_limits<int>::max();
+    if (!this->clock)
+    {
+        this->trigger();
+    }
+}
+
 void BufferPlayer::trigger(std::string name, float value)
 {
     if (name == SIGNALFLOW_DEFAULT_TRIGGER)
@@ -64,6 +75,7 @@ void BufferPlayer::trigger(std::string name, float value)
          * Set the offset within the buffer, in samples.
          *----------------------------------------------------------------*/
         this->phase = value;
+        this->set_inactive(false);
     }
     else
     {
@@ -74,10 +86,17 @@ void BufferPlayer::trigger(std::string name, float value)
 void BufferPlayer::process(Buffer &out, int num_frames)
 {
     /*--------------------------------------------------------------------------------
-     * If buffer is null or empty, don't try to process.
+     * If buffer is null or empty, don't try to process. Output silence, as
+     * the output buffer may be shared scratch space.
      *--------------------------------------------------------------------------------*/
     if (!this->buffer || !this->buffer->get_num_frames())
+    {
+        for (int channel = 0; channel < this->num_output_channels; channel++)
+        {
+            memset(out[channel], 0, num_frames * sizeof(sample));
+        }
         return;
+    }
 
     sample s;
 
@@ -109,6 +128,14 @@ void BufferPlayer::process(Buffer &out, int num_frames)
                     {
                         this->set_state(SIGNALFLOW_NODE_STATE_STOPPED);
                     }
+
+                    /*--------------------------------------------------------------------------------
+                     * Past the end of the buffer, playback can only resume if triggered.
+                     *--------------------------------------------------------------------------------*/
+                    if ((int) this->phase >= this->buffer->get_num_frames())
+                    {
+                        this->set_inactive(true);
+                    }
                     s = 0.0;
                 }
             }
@@ -121,4 +148,11 @@ void BufferPlayer::process(Buffer &out, int num_frames)
     }
 }
 
+bool BufferPlayer::get_output_will_be_silent()
+{
+    return this->inactive
+           && (!this->clock || this->clock->get_output_is_silent())
+           && (!this->loop || this->loop->get_output_is_silent());
+}
+
 }
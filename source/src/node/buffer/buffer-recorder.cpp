@@ -18,10 +18,18 @@ BufferRecorder::BufferRecorder(BufferRef buffer, NodeRef input, NodeRef feedback
     this->create_input("feedback", this->feedback);
 
     this->phase = 0.0;
+    this->writes_output = false;
 
     this->set_channels(buffer->get_num_channels(), 0);
 }
 
+void BufferRecorder::copy_to(Node *node)
+{
+    BufferRecorder *recorder = (BufferRecorder *) node;
+    recorder->loop = this->loop;
+    this->Node::copy_to(node);
+}
+
 void BufferRecorder::process(Buffer &out, int num_frames)
 {
     /*--------------------------------------------------------------------------------
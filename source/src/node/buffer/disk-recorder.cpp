@@ -0,0 +1,51 @@
+#include "signalflow/node/buffer/disk-recorder.h"
+#include "signalflow/core/graph.h"
+
+namespace signalflow
+{
+
+DiskRecorder::DiskRecorder(std::string filename, NodeRef input, int num_channels, signalflow_recording_format_t format)
+    : input(input)
+{
+    SIGNALFLOW_CHECK_GRAPH();
+
+    this->name = "disk-recorder";
+
+    this->create_input("input", this->input);
+
+    if (num_channels == 0)
+    {
+        num_channels = input ? input->get_num_output_channels() : 1;
+    }
+
+    /*--------------------------------------------------------------------------------
+     * The node registry creates nodes with default arguments, in which case
+     * there is no file to open.
+     *--------------------------------------------------------------------------------*/
+    if (!filename.empty())
+    {
+        this->writer = std::unique_ptr<DiskWriter>(new DiskWriter(filename, num_channels, this->graph->get_sample_rate(), format));
+    }
+
+    this->set_channels(num_channels, 0);
+}
+
+void DiskRecorder::process(Buffer &out, int num_frames)
+{
+    if (this->writer)
+    {
+        this->writer->write(this->input->out.data, num_frames);
+    }
+}
+
+int DiskRecorder::get_overflow_count()
+{
+    return this->writer ? this->writer->get_overflow_count() : 0;
+}
+
+long DiskRecorder::get_frames_written()
+{
+    return this->writer ? this->writer->get_frames_written() : 0;
+}
+
+}
@@ -33,6 +33,7 @@ void FeedbackBufferReader::set_buffer(std::string name, BufferRef buffer)
     {
         Node::set_buffer(name, buffer);
         this->num_output_channels = buffer->get_num_channels();
+        this->resize_output_buffers(this->num_output_channels);
         this->rate_scale_factor = buffer->get_sample_rate() / graph->get_sample_rate();
     }
 }
@@ -40,10 +41,17 @@ void FeedbackBufferReader::set_buffer(std::string name, BufferRef buffer)
 void FeedbackBufferReader::process(Buffer &out, int num_frames)
 {
     /*--------------------------------------------------------------------------------
-     * If buffer is null or empty, don't try to process.
+     * If buffer is null or empty, don't try to process. Output silence, as
+     * the output buffer may be shared scratch space.
      *--------------------------------------------------------------------------------*/
     if (!this->buffer || !this->buffer->get_num_frames())
+    {
+        for (int channel = 0; channel < this->num_output_channels; channel++)
+        {
+            memset(out[channel], 0, num_frames * sizeof(sample));
+        }
         return;
+    }
 
     int buf_num_frames = this->buffer->get_num_frames();
 
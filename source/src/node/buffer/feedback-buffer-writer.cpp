@@ -19,6 +19,7 @@ FeedbackBufferWriter::FeedbackBufferWriter(BufferRef buffer, NodeRef input, Node
     this->create_input("delay_time", this->delay_time);
 
     this->phase = 0.0;
+    this->writes_output = false;
 
     this->set_channels(buffer->get_num_channels(), 0);
 }
@@ -31,10 +31,17 @@ GrainSegments::GrainSegments(BufferRef buffer, NodeRef clock, NodeRef target, Pr
 void GrainSegments::process(Buffer &out, int num_frames)
 {
     /*--------------------------------------------------------------------------------
-     * If buffer is null or empty, don't try to process .
+     * If buffer is null or empty, don't try to process. Output silence, as
+     * the output buffer may be shared scratch space.
      *--------------------------------------------------------------------------------*/
     if (!this->buffer || !this->buffer->get_num_frames())
+    {
+        for (int channel = 0; channel < this->num_output_channels; channel++)
+        {
+            memset(out[channel], 0, num_frames * sizeof(sample));
+        }
         return;
+    }
 
     // printf("sample_rate now = %f\n", this->graph->get_sample_rate());
     sample frequency = this->target->out[0][0];
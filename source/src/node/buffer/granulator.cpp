@@ -29,10 +29,17 @@ Granulator::Granulator(BufferRef buffer, NodeRef clock, NodeRef pos, NodeRef dur
 void Granulator::process(Buffer &out, int num_frames)
 {
     /*--------------------------------------------------------------------------------
-     * If buffer is null or empty, don't try to process.
+     * If buffer is null or empty, don't try to process. Output silence, as
+     * the output buffer may be shared scratch space.
      *--------------------------------------------------------------------------------*/
     if (!this->buffer || !this->buffer->get_num_frames())
+    {
+        for (int channel = 0; channel < this->num_output_channels; channel++)
+        {
+            memset(out[channel], 0, num_frames * sizeof(sample));
+        }
         return;
+    }
 
     for (int frame = 0; frame < num_frames; frame++)
     {
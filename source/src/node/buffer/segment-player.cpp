@@ -31,7 +31,7 @@ void SegmentPlayer::process(Buffer &out, int num_frames)
         {
             if ((int) this->phase < buffer->get_num_frames())
             {
-                s = this->buffer->data[channel][(int) this->phase];
+                s = this->buffer->get_frame(channel, (int) this->phase);
             }
             else
             {
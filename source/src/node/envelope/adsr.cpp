@@ -18,6 +18,14 @@ EnvelopeADSR::EnvelopeADSR(NodeRef attack, NodeRef decay, NodeRef sustain, NodeR
     this->create_input("gate", this->gate);
 }
 
+void EnvelopeADSR::reset()
+{
+    this->Node::reset();
+    this->phase = 0.0;
+    this->released = false;
+    this->set_inactive(false);
+}
+
 void EnvelopeADSR::process(Buffer &out, int num_frames)
 {
     sample rv;
@@ -30,6 +38,7 @@ void EnvelopeADSR::process(Buffer &out, int num_frames)
             this->phase = 0.0;
             this->state = SIGNALFLOW_NODE_STATE_ACTIVE;
             this->released = false;
+            this->set_inactive(false);
         }
         float attack = this->attack->out[0][frame];
         float decay = this->decay->out[0][frame];
@@ -84,6 +93,7 @@ void EnvelopeADSR::process(Buffer &out, int num_frames)
                     {
                         this->set_state(SIGNALFLOW_NODE_STATE_STOPPED);
                     }
+                    this->set_inactive(true);
                 }
                 this->phase += phase_step;
             }
@@ -112,4 +122,13 @@ void EnvelopeADSR::process(Buffer &out, int num_frames)
     }
 }
 
+bool EnvelopeADSR::get_output_will_be_silent()
+{
+    /*------------------------------------------------------------------------
+     * A finished envelope can only be restarted by a rising edge on the
+     * gate, which a silent gate cannot produce.
+     *-----------------------------------------------------------------------*/
+    return this->inactive && (!this->gate || this->gate->get_output_is_silent());
+}
+
 }
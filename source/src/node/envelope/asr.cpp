@@ -18,7 +18,7 @@ EnvelopeASR::EnvelopeASR(NodeRef attack, NodeRef sustain, NodeRef release, NodeR
     this->create_input("release", this->release);
     this->create_input("curve", this->curve);
     this->create_input("clock", this->clock);
-    this->phase = std::vector<float>(this->num_output_channels, std::numeric_limits<float>::max());
+    this->alloc();
 
     if (!clock)
     {
@@ -26,6 +26,26 @@ EnvelopeASR::EnvelopeASR(NodeRef attack, NodeRef sustain, NodeRef release, NodeR
     }
 }
 
+void EnvelopeASR::alloc()
+{
+    /*------------------------------------------------------------------------
+     * Channels added by upmixing follow the first channel's phase, so that
+     * an envelope that has already been triggered stays in sync.
+     *-----------------------------------------------------------------------*/
+    float initial_phase = this->phase.empty() ? std::numeric_limits<float>::max() : this->phase[0];
+    this->resize_channel_state(this->phase, initial_phase);
+}
+
+void EnvelopeASR::reset()
+{
+    this->Node::reset();
+    std::fill(this->phase.begin(), this->phase.end(), std::numeric_limits<float>::max());
+    if (!this->clock)
+    {
+        this->trigger();
+    }
+}
+
 void EnvelopeASR::trigger(std::string name, float value)
 {
     if (name == SIGNALFLOW_DEFAULT_TRIGGER)
@@ -35,6 +55,7 @@ void EnvelopeASR::trigger(std::string name, float value)
             this->phase[channel] = 0.0;
         }
         this->state = SIGNALFLOW_NODE_STATE_ACTIVE;
+        this->set_inactive(false);
     }
 }
 
@@ -100,6 +121,26 @@ void EnvelopeASR::process(Buffer &out, int num_frames)
             out[channel][frame] = rv;
         }
     }
+
+    /*------------------------------------------------------------------------
+     * Once every channel has finished, the envelope is silent until it is
+     * next triggered.
+     *-----------------------------------------------------------------------*/
+    float duration = this->attack->out[0][num_frames - 1] + this->sustain->out[0][num_frames - 1] + this->release->out[0][num_frames - 1];
+    bool finished = true;
+    for (int channel = 0; channel < this->num_output_channels; channel++)
+    {
+        if (this->phase[channel] < duration)
+        {
+            finished = false;
+        }
+    }
+    this->set_inactive(finished);
+}
+
+bool EnvelopeASR::get_output_will_be_silent()
+{
+    return this->inactive && (!this->clock || this->clock->get_output_is_silent());
 }
 
 }
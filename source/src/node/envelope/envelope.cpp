@@ -70,6 +70,16 @@ void Envelope::trigger(std::string name, float value)
     }
 }
 
+void Envelope::reset()
+{
+    this->Node::reset();
+    this->trigger();
+    if (this->clock)
+    {
+        this->state = SIGNALFLOW_NODE_STATE_STOPPED;
+    }
+}
+
 void Envelope::process(Buffer &out, int num_frames)
 {
     float phase_step = 1.0f / this->graph->get_sample_rate();
@@ -32,6 +32,24 @@ void FFTContinuousPhaseVocoder::trigger(std::string name, float value)
     //   this->prefilled_fft_buffer = false;
 }
 
+void FFTContinuousPhaseVocoder::copy_to(Node *node)
+{
+    /*------------------------------------------------------------------------
+     * The FFT sizes are taken from the input by the constructor, so a copy
+     * can only be made with the default sizes. The input isn't a formal
+     * input, so it isn't connected by clone() and must be copied here.
+     *-----------------------------------------------------------------------*/
+    FFTContinuousPhaseVocoder *vocoder = (FFTContinuousPhaseVocoder *) node;
+    if (vocoder->fft_size != this->fft_size || vocoder->hop_size != this->hop_size
+        || vocoder->window_size != this->window_size)
+    {
+        throw std::runtime_error("FFTContinuousPhaseVocoder: Can't clone a vocoder with non-default sizes");
+    }
+    vocoder->input = this->input;
+    vocoder->rate = this->rate;
+    this->Node::copy_to(node);
+}
+
 void FFTContinuousPhaseVocoder::process(Buffer &out, int num_frames)
 {
     FFTNode *fftin = (FFTNode *) this->input.get();
@@ -1,9 +1,13 @@
-#ifdef __APPLE__
-
 #include "signalflow/core/core.h"
+#include "signalflow/core/graph.h"
+#include "signalflow/core/vector.h"
 #include "signalflow/node/fft/convolve.h"
 #include "signalflow/node/fft/fft.h"
 
+#include <algorithm>
+#include <math.h>
+#include <pthread.h>
+
 namespace signalflow
 {
 
@@ -16,40 +20,242 @@ FFTConvolve::FFTConvolve(NodeRef input, BufferRef buffer)
     {
         throw std::runtime_error("No buffer specified");
     }
-    this->num_partitions = ceil((buffer->get_num_frames() - this->fft_size) / this->hop_size) + 1;
-    if (this->num_partitions < 1)
-        this->num_partitions = 1;
-    this->ir_partitions.resize(this->num_partitions);
-    this->input_history.resize(this->num_partitions);
-    this->output_partition_polar_split = new sample[this->num_bins * 2]();
-    this->output_partition_polar = new sample[this->num_bins * 2]();
-    this->output_partition_cartesian = new sample[this->num_bins * 2]();
-    this->output_sum_cartesian = new sample[this->num_bins * 2]();
-    this->output_sum_polar = new sample[this->num_bins * 2]();
-
-    signalflow_debug("Buffer length %d frames, fft size %d, hop size %d, doing %d partitions\n",
-                     buffer->get_num_frames(), this->fft_size, this->hop_size, this->num_partitions);
 
+    /*------------------------------------------------------------------------
+     * Each partition is an fft_size frame of the impulse response, starting
+     * at a multiple of hop_size. Frames that extend past the end of the
+     * impulse response are zero-padded.
+     *-----------------------------------------------------------------------*/
+    int ir_length = buffer->get_num_frames();
+    this->num_partitions = 1;
+    if (ir_length > this->fft_size)
+    {
+        this->num_partitions += (int) ceil((double) (ir_length - this->fft_size) / this->hop_size);
+    }
+    this->num_head_partitions = std::min(this->num_partitions, SIGNALFLOW_FFT_CONVOLVE_HEAD_PARTITIONS);
+    int num_tail_partitions = this->num_partitions - this->num_head_partitions;
+    this->num_tail_blocks = (num_tail_partitions + SIGNALFLOW_FFT_CONVOLVE_TAIL_BLOCK_PARTITIONS - 1)
+                            / SIGNALFLOW_FFT_CONVOLVE_TAIL_BLOCK_PARTITIONS;
+
+    /*------------------------------------------------------------------------
+     * The input history holds one more frame than there are partitions, so
+     * that the frame received at the next hop doesn't overwrite one that a
+     * tail round in progress still reads.
+     *-----------------------------------------------------------------------*/
+    this->num_history = this->num_partitions + 1;
+
+    /*------------------------------------------------------------------------
+     * Allocate a single block for every spectrum: IR partitions, input
+     * history, the output sum, and two sums for each tail block.
+     *-----------------------------------------------------------------------*/
+    int num_spectra = this->num_partitions + this->num_history + 1 + this->num_tail_blocks * 2;
+    this->spectra.resize(num_spectra * this->num_bins * 2);
+    sample *spectrum = this->spectra.data();
+    auto next_spectrum = [&](std::vector<sample *> &real, std::vector<sample *> &imag) {
+        real.push_back(spectrum);
+        imag.push_back(spectrum + this->num_bins);
+        spectrum += this->num_bins * 2;
+    };
+    for (int i = 0; i < this->num_partitions; i++)
+    {
+        next_spectrum(this->ir_real, this->ir_imag);
+    }
+    for (int i = 0; i < this->num_history; i++)
+    {
+        next_spectrum(this->input_real, this->input_imag);
+    }
+    this->sum_real = spectrum;
+    this->sum_imag = spectrum + this->num_bins;
+    spectrum += this->num_bins * 2;
+    for (int i = 0; i < this->num_tail_blocks * 2; i++)
+    {
+        next_spectrum(this->tail_real, this->tail_imag);
+    }
+
+    signalflow_debug("Buffer length %d frames, fft size %d, hop size %d, doing %d partitions (%d on audio thread)\n",
+                     ir_length, this->fft_size, this->hop_size, this->num_partitions, this->num_head_partitions);
+
+    /*------------------------------------------------------------------------
+     * Take the FFT of each partition, and convert to Cartesian form.
+     *-----------------------------------------------------------------------*/
     FFT *fft = new FFT(nullptr, this->fft_size, this->hop_size, this->window_size, false);
+    std::vector<sample> frame(this->fft_size);
+    std::vector<sample> polar(this->num_bins * 2);
     for (int i = 0; i < this->num_partitions; i++)
     {
-        this->ir_partitions[i] = new sample[this->num_bins * 2]();
-        this->input_history[i] = new sample[this->num_bins * 2]();
-        fft->fft(this->buffer->data[0] + i * this->hop_size,
-                 this->ir_partitions[i],
-                 true,
-                 false);
+        int offset = i * this->hop_size;
+        int length = std::max(0, std::min(this->fft_size, ir_length - offset));
+        std::fill(frame.begin(), frame.end(), 0);
+        std::copy(this->buffer->data[0] + offset, this->buffer->data[0] + offset + length, frame.begin());
+        fft->fft(frame.data(), polar.data(), true, false);
+
+        for (int bin = 0; bin < this->num_bins; bin++)
+        {
+            float magnitude = polar[bin];
+            float phase = polar[this->num_bins + bin];
+            this->ir_real[i][bin] = magnitude * cosf(phase);
+            this->ir_imag[i][bin] = magnitude * sinf(phase);
+        }
     }
     delete fft;
 
+    this->history_position = 0;
+    this->tail_position = 0;
+
+    /*------------------------------------------------------------------------
+     * Hops are numbered from 1. Round 0 stands for no tail work, and is
+     * treated as complete, so the first hop starts its own round.
+     *-----------------------------------------------------------------------*/
+    this->hop_count = 0;
+    this->tail_round = 0;
+    this->tail_block_rounds.reset(new std::atomic<int>[this->num_tail_blocks]);
+    for (int block = 0; block < this->num_tail_blocks; block++)
+    {
+        this->tail_block_rounds[block] = 0;
+    }
+    this->tail_next_block = this->num_tail_blocks;
+    this->tail_blocks_finished = this->num_tail_blocks;
+    this->tail_thread_running = true;
+
+#ifdef __APPLE__
+    this->tail_semaphore = dispatch_semaphore_create(0);
+#else
+    sem_init(&this->tail_semaphore, 0, 0);
+#endif
+
+    if (this->num_tail_blocks > 0)
+    {
+        this->tail_thread = std::thread(&FFTConvolve::run_tail_thread, this);
+    }
+
     this->create_buffer("buffer", this->buffer);
 }
 
 FFTConvolve::~FFTConvolve()
 {
-    for (auto partition : this->ir_partitions)
+    this->tail_thread_running = false;
+    if (this->tail_thread.joinable())
+    {
+#ifdef __APPLE__
+        dispatch_semaphore_signal(this->tail_semaphore);
+#else
+        sem_post(&this->tail_semaphore);
+#endif
+        this->tail_thread.join();
+    }
+
+#ifdef __APPLE__
+    dispatch_release(this->tail_semaphore);
+#else
+    sem_destroy(&this->tail_semaphore);
+#endif
+}
+
+void FFTConvolve::multiply_accumulate(int first_partition,
+                                      int last_partition,
+                                      int position,
+                                      sample *sum_real,
+                                      sample *sum_imag)
+{
+    for (int partition_index = first_partition; partition_index < last_partition; partition_index++)
     {
-        delete partition;
+        /*------------------------------------------------------------------------
+         * Partition n of the impulse response is applied to the input frame
+         * received n hops before the frame at `position`.
+         *-----------------------------------------------------------------------*/
+        int history_index = (position - partition_index + this->num_history) % this->num_history;
+        const sample *input_real = this->input_real[history_index];
+        const sample *input_imag = this->input_imag[history_index];
+        const sample *ir_real = this->ir_real[partition_index];
+        const sample *ir_imag = this->ir_imag[partition_index];
+
+        for (int bin = 0; bin < this->num_bins; bin++)
+        {
+            sum_real[bin] += input_real[bin] * ir_real[bin] - input_imag[bin] * ir_imag[bin];
+            sum_imag[bin] += input_real[bin] * ir_imag[bin] + input_imag[bin] * ir_real[bin];
+        }
+    }
+}
+
+void FFTConvolve::render_tail_blocks()
+{
+    while (true)
+    {
+        int block = this->tail_next_block.fetch_add(1, std::memory_order_acq_rel);
+        if (block >= this->num_tail_blocks)
+        {
+            break;
+        }
+
+        int round = this->tail_round;
+        int first_partition = this->num_head_partitions + block * SIGNALFLOW_FFT_CONVOLVE_TAIL_BLOCK_PARTITIONS;
+        int last_partition = std::min(this->num_partitions, first_partition + SIGNALFLOW_FFT_CONVOLVE_TAIL_BLOCK_PARTITIONS);
+        int index = block * 2 + (round & 1);
+        memset(this->tail_real[index], 0, sizeof(sample) * this->num_bins);
+        memset(this->tail_imag[index], 0, sizeof(sample) * this->num_bins);
+        this->multiply_accumulate(first_partition, last_partition, this->tail_position,
+                                  this->tail_real[index], this->tail_imag[index]);
+
+        this->tail_block_rounds[block].store(round, std::memory_order_release);
+        this->tail_blocks_finished.fetch_add(1, std::memory_order_release);
+    }
+}
+
+bool FFTConvolve::tail_round_finished()
+{
+    return this->tail_blocks_finished.load(std::memory_order_acquire) == this->num_tail_blocks;
+}
+
+void FFTConvolve::start_tail_round(int round, int position)
+{
+    this->tail_round = round;
+    this->tail_position = position;
+    this->tail_blocks_finished.store(0, std::memory_order_relaxed);
+    this->tail_next_block.store(0, std::memory_order_release);
+#ifdef __APPLE__
+    dispatch_semaphore_signal(this->tail_semaphore);
+#else
+    sem_post(&this->tail_semaphore);
+#endif
+}
+
+void FFTConvolve::wait_for_tail_round()
+{
+    while (!this->tail_round_finished())
+    {
+        std::this_thread::yield();
+    }
+}
+
+void FFTConvolve::run_tail_thread()
+{
+    /*------------------------------------------------------------------------
+     * Run just below the priority of the audio thread, so that the tail is
+     * ready by the next hop. This requires privileges that may not be
+     * available, in which case continue at normal priority: the audio
+     * thread omits any tail blocks that this thread hasn't finished in time.
+     *-----------------------------------------------------------------------*/
+    struct sched_param param;
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 2;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+    {
+        signalflow_debug("FFTConvolve: Couldn't set real-time priority for tail thread");
+    }
+
+    while (true)
+    {
+#ifdef __APPLE__
+        dispatch_semaphore_wait(this->tail_semaphore, DISPATCH_TIME_FOREVER);
+#else
+        while (sem_wait(&this->tail_semaphore) != 0)
+        {
+        }
+#endif
+        if (!this->tail_thread_running)
+        {
+            break;
+        }
+        this->render_tail_blocks();
     }
 }
 
@@ -60,64 +266,94 @@ void FFTConvolve::process(Buffer &out, int num_frames)
 
     for (int hop = 0; hop < this->num_hops; hop++)
     {
+        this->hop_count++;
+
         /*------------------------------------------------------------------------
-         * Each hop, roll the partition buffer backwards.
+         * A round computed for hop n reads input frames up to n - 1 hops old,
+         * the oldest of which is overwritten at hop n + 2. If a block of a
+         * round that late is still in progress, the tail thread has stalled
+         * for over a hop, and the audio thread must wait before writing.
          *-----------------------------------------------------------------------*/
-        for (int partition_index = this->num_partitions - 2; partition_index >= 0; partition_index--)
+        if (this->num_tail_blocks > 0 && this->hop_count - this->tail_round >= 2)
         {
-            memcpy(this->input_history[partition_index + 1],
-                   this->input_history[partition_index],
-                   sizeof(sample) * this->num_bins * 2);
+            this->wait_for_tail_round();
         }
-        memcpy(this->input_history[0],
-               this->input->out[hop],
-               sizeof(sample) * this->num_bins * 2);
 
-        memset(output_sum_cartesian, 0, sizeof(sample) * this->num_bins * 2);
+        /*------------------------------------------------------------------------
+         * Add the new input frame to the history, in Cartesian form.
+         *-----------------------------------------------------------------------*/
+        this->history_position = (this->history_position + 1) % this->num_history;
+        sample *magnitudes = this->input->out[hop];
+        sample *phases = this->input->out[hop] + this->num_bins;
+        for (int bin = 0; bin < this->num_bins; bin++)
+        {
+            this->input_real[this->history_position][bin] = magnitudes[bin] * cosf(phases[bin]);
+            this->input_imag[this->history_position][bin] = magnitudes[bin] * sinf(phases[bin]);
+        }
+
+        memset(this->sum_real, 0, sizeof(sample) * this->num_bins);
+        memset(this->sum_imag, 0, sizeof(sample) * this->num_bins);
+        this->multiply_accumulate(0, this->num_head_partitions, this->history_position,
+                                  this->sum_real, this->sum_imag);
+
+        if (this->num_tail_blocks > 0)
+        {
+            /*------------------------------------------------------------------------
+             * If the previous hop couldn't start this hop's round because a
+             * late round was still in progress, start it now.
+             *-----------------------------------------------------------------------*/
+            if (this->tail_round != this->hop_count && this->tail_round_finished())
+            {
+                this->start_tail_round(this->hop_count, this->history_position);
+            }
+
+            /*------------------------------------------------------------------------
+             * Complete any tail blocks that the background thread hasn't yet
+             * started. When rendering manually, wait for those in progress;
+             * otherwise, the deadline has been missed, and those blocks are
+             * omitted from this hop. A block's result is only ever used at
+             * the hop that it was computed for.
+             *-----------------------------------------------------------------------*/
+            if (this->tail_round == this->hop_count)
+            {
+                this->render_tail_blocks();
+                if (!(this->graph && this->graph->get_is_running()))
+                {
+                    this->wait_for_tail_round();
+                }
+            }
+
+            for (int block = 0; block < this->num_tail_blocks; block++)
+            {
+                if (this->tail_block_rounds[block].load(std::memory_order_acquire) == this->hop_count)
+                {
+                    int index = block * 2 + (this->hop_count & 1);
+                    signalflow_vector_add(this->sum_real, this->tail_real[index], this->sum_real, this->num_bins);
+                    signalflow_vector_add(this->sum_imag, this->tail_imag[index], this->sum_imag, this->num_bins);
+                }
+            }
+
+            /*------------------------------------------------------------------------
+             * The tail for the next hop only depends on input frames received
+             * up to now, so start computing it in the background. If the
+             * current round is still in progress, the next hop starts its
+             * own round once this one has finished.
+             *-----------------------------------------------------------------------*/
+            if (this->tail_round_finished())
+            {
+                this->start_tail_round(this->hop_count + 1, (this->history_position + 1) % this->num_history);
+            }
+        }
 
         /*------------------------------------------------------------------------
-         * Iterate over fft_size frames as each block contains a whole
-         * fft of samples.
+         * Convert the sum back to polar form.
          *-----------------------------------------------------------------------*/
-        for (int partition_index = 0; partition_index < this->num_partitions; partition_index++)
+        for (int bin = 0; bin < this->num_bins; bin++)
         {
-            vDSP_vmul(this->input_history[partition_index], 1,
-                      this->ir_partitions[partition_index], 1,
-                      this->output_partition_polar_split, 1,
-                      this->num_bins);
-            vDSP_vadd(this->input_history[partition_index] + this->num_bins, 1,
-                      this->ir_partitions[partition_index] + this->num_bins, 1,
-                      this->output_partition_polar_split + this->num_bins, 1,
-                      this->num_bins);
-
-            const DSPSplitComplex output_partition_polar_split_struct = {
-                this->output_partition_polar_split,
-                this->output_partition_polar_split + num_bins
-            };
-            vDSP_ztoc(&output_partition_polar_split_struct, 1,
-                      (DSPComplex *) this->output_partition_polar, 2,
-                      num_bins);
-
-            vDSP_rect(this->output_partition_polar, 2,
-                      this->output_partition_cartesian, 2,
-                      this->num_bins);
-
-            vDSP_vadd(this->output_partition_cartesian, 1,
-                      this->output_sum_cartesian, 1,
-                      this->output_sum_cartesian, 1,
-                      this->num_bins * 2);
-        } // partitions
-
-        vDSP_polar(this->output_sum_cartesian, 2,
-                   this->output_sum_polar, 2,
-                   this->num_bins);
-        DSPSplitComplex buffer_split = { this->out[hop], this->out[hop] + this->num_bins };
-        vDSP_ctoz((DSPComplex *) this->output_sum_polar, 2,
-                  &buffer_split, 1,
-                  this->num_bins);
+            out[hop][bin] = sqrtf(this->sum_real[bin] * this->sum_real[bin] + this->sum_imag[bin] * this->sum_imag[bin]);
+            out[hop][this->num_bins + bin] = atan2f(this->sum_imag[bin], this->sum_real[bin]);
+        }
     }
 }
 
 }
-
-#endif
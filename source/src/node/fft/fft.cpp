@@ -1,5 +1,7 @@
 #include "signalflow/node/fft/fft.h"
 
+#include "signalflow/core/graph.h"
+
 #include <assert.h>
 
 namespace signalflow
@@ -22,12 +24,23 @@ FFT::FFT(NodeRef input, int fft_size, int hop_size, int window_size, bool do_win
      * Temp buffers for FFT calculations.
      *-----------------------------------------------------------------------*/
     this->buffer2 = new sample[this->num_bins * 2]();
+    this->buffer = new sample[this->num_bins * 2]();
 #elif defined(FFT_FFTW)
-    this->fftw_buffer = (fftwf_complex *) fftwf_malloc(sizeof(fftwf_complex) * (this->num_bins + 1));
+    /*------------------------------------------------------------------------
+     * Plans are shared between nodes, and executed on this node's buffers.
+     * These must be allocated by FFTW so that their alignment matches
+     * that of the plan.
+     *-----------------------------------------------------------------------*/
+    this->fftw_buffer = fftwf_alloc_complex(this->num_bins + 1);
+    this->buffer = fftwf_alloc_real(this->num_bins * 2);
+    signalflow_fft_planner_effort_t effort = SIGNALFLOW_FFT_PLANNER_ESTIMATE;
+    if (this->graph)
+    {
+        effort = this->graph->get_config().get_fft_planner_effort();
+    }
+    this->fftw_plan = signalflow_fftw_plan_r2c(fft_size, effort);
 #endif
 
-    this->buffer = new sample[this->num_bins * 2]();
-
     /*------------------------------------------------------------------------
      * To perform an FFT, we have to enqueue at least `fft_size` samples.
      * input_buffer stores our backlog, so make sure we've allocated enough space.
@@ -65,11 +78,14 @@ FFT::~FFT()
 {
 #if defined(FFT_ACCELERATE)
     vDSP_destroy_fftsetup(this->fft_setup);
-    delete this->buffer2;
+    delete[] this->buffer2;
+    delete[] this->buffer;
+#elif defined(FFT_FFTW)
+    fftwf_free(this->buffer);
+    fftwf_free(this->fftw_buffer);
 #endif
-    delete this->buffer;
-    delete this->input_buffer;
-    delete this->window;
+    delete[] this->input_buffer;
+    delete[] this->window;
 }
 
 void FFT::fft(sample *in, sample *out, bool polar, bool do_window)
@@ -138,10 +154,8 @@ void FFT::fft(sample *in, sample *out, bool polar, bool do_window)
 
     /*------------------------------------------------------------------------
      * Execute FFT
-     * TODO: Plan should be initialised in constructor
      *-----------------------------------------------------------------------*/
-    fftwf_plan fftw_plan = fftwf_plan_dft_r2c_1d(fft_size, this->buffer, this->fftw_buffer, FFTW_ESTIMATE);
-    fftwf_execute(fftw_plan);
+    fftwf_execute_dft_r2c(this->fftw_plan, this->buffer, this->fftw_buffer);
 
     if (polar)
     {
@@ -163,6 +177,21 @@ void FFT::fft(sample *in, sample *out, bool polar, bool do_window)
 #endif
 }
 
+void FFT::copy_to(Node *node)
+{
+    /*------------------------------------------------------------------------
+     * The FFT's buffers, plan and window are allocated by its constructor,
+     * so a copy can only be made with the default sizes.
+     *-----------------------------------------------------------------------*/
+    FFT *fft = (FFT *) node;
+    if (fft->fft_size != this->fft_size || fft->hop_size != this->hop_size
+        || fft->window_size != this->window_size || fft->do_window != this->do_window)
+    {
+        throw std::runtime_error("FFT: Can't clone an FFT with non-default sizes");
+    }
+    this->Node::copy_to(node);
+}
+
 void FFT::process(Buffer &out, int num_frames)
 {
     /*------------------------------------------------------------------------
@@ -19,6 +19,12 @@ FFTNode::FFTNode(int fft_size, int hop_size, int window_size, bool do_window)
     this->output_buffer_length = SIGNALFLOW_MAX_FFT_SIZE + 2;
     this->resize_output_buffers(SIGNALFLOW_MAX_CHANNELS);
 
+    /*------------------------------------------------------------------------
+     * Spectral frames are only written once per hop, and must persist
+     * between blocks, so can't be stored in shared scratch buffers.
+     *-----------------------------------------------------------------------*/
+    this->pin_output_buffer();
+
     this->magnitudes = new float *[SIGNALFLOW_MAX_CHANNELS]();
     for (int i = 0; i < SIGNALFLOW_MAX_CHANNELS; i++)
     {
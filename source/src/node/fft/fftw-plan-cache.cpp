@@ -0,0 +1,111 @@
+#include "signalflow/node/fft/fftw-plan-cache.h"
+
+#if defined(FFT_FFTW)
+
+#include "signalflow/core/core.h"
+
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <tuple>
+
+namespace signalflow
+{
+
+typedef std::tuple<int, bool, signalflow_fft_planner_effort_t> signalflow_fftw_plan_key_t;
+
+static std::mutex fftw_plan_cache_mutex;
+static std::map<signalflow_fftw_plan_key_t, fftwf_plan> fftw_plan_cache;
+static bool fftw_wisdom_loaded = false;
+
+std::string signalflow_fftw_wisdom_path()
+{
+    return SIGNALFLOW_USER_DIR + "/fftw-wisdom";
+}
+
+static unsigned int signalflow_fftw_flags(signalflow_fft_planner_effort_t effort)
+{
+    switch (effort)
+    {
+        case SIGNALFLOW_FFT_PLANNER_MEASURE:
+            return FFTW_MEASURE;
+        case SIGNALFLOW_FFT_PLANNER_PATIENT:
+            return FFTW_PATIENT;
+        default:
+            return FFTW_ESTIMATE;
+    }
+}
+
+/*--------------------------------------------------------------------------------
+ * Saving wisdom is best-effort: failing to write it only means that plans
+ * will be measured again next time.
+ *-------------------------------------------------------------------------------*/
+static void signalflow_fftw_save_wisdom()
+{
+    mkdir((SIGNALFLOW_USER_DIR).c_str(), 0755);
+    if (!fftwf_export_wisdom_to_filename(signalflow_fftw_wisdom_path().c_str()))
+    {
+        signalflow_debug("Couldn't save FFTW wisdom to %s", signalflow_fftw_wisdom_path().c_str());
+    }
+}
+
+static fftwf_plan signalflow_fftw_plan(int fft_size, bool inverse, signalflow_fft_planner_effort_t effort)
+{
+    std::lock_guard<std::mutex> lock(fftw_plan_cache_mutex);
+
+    if (!fftw_wisdom_loaded)
+    {
+        fftwf_import_wisdom_from_filename(signalflow_fftw_wisdom_path().c_str());
+        fftw_wisdom_loaded = true;
+    }
+
+    signalflow_fftw_plan_key_t key(fft_size, inverse, effort);
+    auto it = fftw_plan_cache.find(key);
+    if (it != fftw_plan_cache.end())
+    {
+        return it->second;
+    }
+
+    /*--------------------------------------------------------------------------------
+     * MEASURE and PATIENT overwrite the arrays while planning, so plan with
+     * scratch arrays rather than a node's buffers.
+     *-------------------------------------------------------------------------------*/
+    float *real = fftwf_alloc_real(fft_size);
+    fftwf_complex *complex = fftwf_alloc_complex(fft_size / 2 + 1);
+    unsigned int flags = signalflow_fftw_flags(effort);
+    fftwf_plan plan;
+    if (inverse)
+        plan = fftwf_plan_dft_c2r_1d(fft_size, complex, real, flags);
+    else
+        plan = fftwf_plan_dft_r2c_1d(fft_size, real, complex, flags);
+    fftwf_free(real);
+    fftwf_free(complex);
+
+    if (!plan)
+    {
+        throw std::runtime_error("FFTW: Couldn't create plan for FFT size " + std::to_string(fft_size));
+    }
+    fftw_plan_cache[key] = plan;
+
+    if (effort != SIGNALFLOW_FFT_PLANNER_ESTIMATE)
+    {
+        signalflow_fftw_save_wisdom();
+    }
+
+    return plan;
+}
+
+fftwf_plan signalflow_fftw_plan_r2c(int fft_size, signalflow_fft_planner_effort_t effort)
+{
+    return signalflow_fftw_plan(fft_size, false, effort);
+}
+
+fftwf_plan signalflow_fftw_plan_c2r(int fft_size, signalflow_fft_planner_effort_t effort)
+{
+    return signalflow_fftw_plan(fft_size, true, effort);
+}
+
+}
+
+#endif
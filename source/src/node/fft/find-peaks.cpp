@@ -59,6 +59,7 @@ FFTFindPeaks::FFTFindPeaks(NodeRef input, NodeRef prominence, NodeRef threshold,
 {
     this->name = "fft-find-peaks";
     this->num_output_channels = count * 2;
+    this->resize_output_buffers(this->num_output_channels);
     this->update_channels();
 
     this->create_input("prominence", this->prominence);
@@ -1,4 +1,5 @@
 #include "signalflow/node/fft/ifft.h"
+#include "signalflow/core/graph.h"
 
 namespace signalflow
 {
@@ -15,19 +16,35 @@ IFFT::IFFT(NodeRef input, bool do_window)
      * Buffers used in intermediate FFT calculations.
      *-----------------------------------------------------------------------*/
     this->buffer2 = new sample[this->num_bins * 2]();
+    this->buffer = new sample[this->num_bins * 2]();
 #elif defined(FFT_FFTW)
-    this->fftw_buffer = (fftwf_complex *) fftwf_malloc(sizeof(fftwf_complex) * this->num_bins);
+    /*------------------------------------------------------------------------
+     * Buffers must be allocated by FFTW to match the shared plan's alignment.
+     *-----------------------------------------------------------------------*/
+    this->fftw_buffer = fftwf_alloc_complex(this->num_bins);
+    this->buffer = fftwf_alloc_real(this->num_bins * 2);
+    signalflow_fft_planner_effort_t effort = SIGNALFLOW_FFT_PLANNER_ESTIMATE;
+    if (this->graph)
+    {
+        effort = this->graph->get_config().get_fft_planner_effort();
+    }
+    this->fftw_plan = signalflow_fftw_plan_c2r(this->fft_size, effort);
 #endif
 
-    this->buffer = new sample[this->num_bins * 2]();
-
     /*------------------------------------------------------------------------
-     * Generate a Hann window for overlap-add.
      * Needs to be fft_size, not window_size, because any samples outside
      * of the window_size should be zero'd.
      *-----------------------------------------------------------------------*/
     this->window = new sample[this->fft_size]();
+    this->generate_window();
+}
 
+void IFFT::generate_window()
+{
+    /*------------------------------------------------------------------------
+     * Generate a Hann window for overlap-add, or a rectangular window if
+     * do_window is false.
+     *-----------------------------------------------------------------------*/
     if (this->do_window)
     {
 #if defined(FFT_ACCELERATE)
@@ -48,14 +65,32 @@ IFFT::IFFT(NodeRef input, bool do_window)
     }
 }
 
+void IFFT::copy_to(Node *node)
+{
+    /*------------------------------------------------------------------------
+     * The window is generated by the constructor, so regenerate the copy's
+     * if it was constructed with a different do_window.
+     *-----------------------------------------------------------------------*/
+    IFFT *ifft = (IFFT *) node;
+    if (ifft->do_window != this->do_window)
+    {
+        ifft->do_window = this->do_window;
+        ifft->generate_window();
+    }
+    this->Node::copy_to(node);
+}
+
 IFFT::~IFFT()
 {
 #if defined(FFT_ACCELERATE)
     vDSP_destroy_fftsetup(this->fft_setup);
-    delete this->buffer2;
+    delete[] this->buffer2;
+    delete[] this->buffer;
+#elif defined(FFT_FFTW)
+    fftwf_free(this->buffer);
+    fftwf_free(this->fftw_buffer);
 #endif
-    delete this->buffer;
-    delete this->window;
+    delete[] this->window;
 }
 
 void IFFT::ifft(sample *in, sample *out, bool polar, bool do_window, float scale_factor)
@@ -131,9 +166,7 @@ void IFFT::ifft(sample *in, sample *out, bool polar, bool do_window, float scale
         fftw_buffer_floats[i * 2 + 1] = mags[i] * sinf(phases[i]);
     }
 
-    fftwf_plan pi = fftwf_plan_dft_c2r_1d(fft_size, (fftwf_complex *) fftw_buffer_floats, this->buffer, FFTW_ESTIMATE);
-    fftwf_execute(pi);
-    fftwf_destroy_plan(pi);
+    fftwf_execute_dft_c2r(this->fftw_plan, this->fftw_buffer, this->buffer);
 
     /*------------------------------------------------------------------------
      * Apply window and scale down (fftw IFFT output is scaled up by
@@ -1,18 +1,207 @@
 #include "signalflow/node/io/input/abstract.h"
 
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
 namespace signalflow
 {
-AudioIn_Abstract *shared_in = NULL;
 
 AudioIn_Abstract::AudioIn_Abstract()
 {
-    if (shared_in)
-        throw std::runtime_error("Multiple AudioIn nodes are not yet supported.");
-
-    shared_in = this;
-
     this->name = "audioin";
+    this->type = SIGNALFLOW_NODE_TYPE_AUDIO_IN;
     this->set_channels(0, 1);
+
+    this->target_frames = 0;
+    this->nominal_ratio = 1.0;
+    this->ratio = 1.0;
+    this->fill_average = 0.0;
+    this->overrun_count = 0;
+    this->underrun_count = 0;
+    this->is_streaming = false;
+    this->staged_frames = 0;
+    this->phase = 0.0;
+}
+
+void AudioIn_Abstract::init_ring(int num_channels, int buffer_size, int sample_rate)
+{
+    if (num_channels < 1 || num_channels > SIGNALFLOW_MAX_CHANNELS)
+    {
+        throw std::runtime_error("AudioIn: Invalid channel count (" + std::to_string(num_channels) + ")");
+    }
+    this->set_channels(0, num_channels);
+
+    int block_size = SIGNALFLOW_DEFAULT_BLOCK_SIZE;
+    int graph_sample_rate = sample_rate;
+    if (this->graph)
+    {
+        block_size = this->graph->get_block_size();
+        graph_sample_rate = this->graph->get_sample_rate();
+    }
+    this->nominal_ratio = (double) sample_rate / graph_sample_rate;
+    this->ratio = this->nominal_ratio;
+
+    /*--------------------------------------------------------------------------------
+     * Keep enough input buffered to cover one device callback and one graph
+     * block, so that neither side's burstiness causes an underrun, with
+     * plenty of headroom above that before the ring overruns.
+     *-------------------------------------------------------------------------------*/
+    this->target_frames = buffer_size + (int) ceil(block_size * this->nominal_ratio);
+    this->ring.reset(new SPSCRingBuffer<sample>(this->target_frames * 4 * num_channels));
+
+    int max_staged_frames = (int) ceil(SIGNALFLOW_NODE_BUFFER_SIZE * this->nominal_ratio * (1.0 + SIGNALFLOW_AUDIO_IN_MAX_DRIFT)) + 2;
+    this->staging.resize(max_staged_frames * num_channels);
+    this->staged_frames = 0;
+    this->phase = 0.0;
+    this->is_streaming = false;
+}
+
+void AudioIn_Abstract::write(const sample *frames, int num_frames)
+{
+    if (!this->ring)
+    {
+        return;
+    }
+
+    /*--------------------------------------------------------------------------------
+     * Only write whole frames, so that the ring always holds a whole number
+     * of frames and the reader never sees a partial one.
+     *-------------------------------------------------------------------------------*/
+    int num_channels = this->num_output_channels;
+    int writable_frames = this->ring->get_write_available() / num_channels;
+    if (num_frames > writable_frames)
+    {
+        this->overrun_count.fetch_add(1, std::memory_order_relaxed);
+        num_frames = writable_frames;
+    }
+    this->ring->write(frames, num_frames * num_channels);
+}
+
+void AudioIn_Abstract::process(Buffer &out, int num_frames)
+{
+    int num_channels = this->num_output_channels;
+    if (!this->ring)
+    {
+        for (int channel = 0; channel < num_channels; channel++)
+        {
+            memset(out[channel], 0, num_frames * sizeof(sample));
+        }
+        return;
+    }
+
+    int fill = this->ring->get_read_available() / num_channels + this->staged_frames;
+
+    /*--------------------------------------------------------------------------------
+     * Wait until the ring has filled to its target before consuming, both
+     * on startup and after an underrun.
+     *-------------------------------------------------------------------------------*/
+    if (!this->is_streaming)
+    {
+        if (fill < this->target_frames)
+        {
+            for (int channel = 0; channel < num_channels; channel++)
+            {
+                memset(out[channel], 0, num_frames * sizeof(sample));
+            }
+            return;
+        }
+        this->is_streaming = true;
+        this->fill_average = fill;
+    }
+
+    /*--------------------------------------------------------------------------------
+     * Drift compensation: if the ring is fuller than its target, the input
+     * clock is running fast relative to the output, so consume input frames
+     * slightly faster, and vice versa.
+     *-------------------------------------------------------------------------------*/
+    this->fill_average += SIGNALFLOW_AUDIO_IN_DRIFT_SMOOTHING * (fill - this->fill_average);
+    double error = (this->fill_average - this->target_frames) / this->target_frames;
+    double drift = std::max(-SIGNALFLOW_AUDIO_IN_MAX_DRIFT, std::min(SIGNALFLOW_AUDIO_IN_MAX_DRIFT, error * SIGNALFLOW_AUDIO_IN_DRIFT_GAIN));
+    double ratio = this->nominal_ratio * (1.0 + drift);
+    this->ratio.store(ratio, std::memory_order_relaxed);
+
+    int max_staged_frames = (int) this->staging.size() / num_channels;
+    int needed_frames = std::min(max_staged_frames, (int) (this->phase + (num_frames - 1) * ratio) + 2);
+    if (needed_frames > this->staged_frames)
+    {
+        int num_read = this->ring->read(this->staging.data() + this->staged_frames * num_channels,
+                                        (needed_frames - this->staged_frames) * num_channels);
+        this->staged_frames += num_read / num_channels;
+    }
+
+    /*--------------------------------------------------------------------------------
+     * Resample with linear interpolation.
+     *-------------------------------------------------------------------------------*/
+    int frame;
+    for (frame = 0; frame < num_frames; frame++)
+    {
+        double position = this->phase + frame * ratio;
+        int index = (int) position;
+        if (index + 1 >= this->staged_frames)
+        {
+            break;
+        }
+        sample frac = (sample) (position - index);
+        const sample *current = this->staging.data() + index * num_channels;
+        const sample *next = current + num_channels;
+        for (int channel = 0; channel < num_channels; channel++)
+        {
+            out[channel][frame] = current[channel] + frac * (next[channel] - current[channel]);
+        }
+    }
+
+    if (frame < num_frames)
+    {
+        /*--------------------------------------------------------------------------------
+         * Underrun: pad with silence, and wait for the ring to refill.
+         *-------------------------------------------------------------------------------*/
+        for (int channel = 0; channel < num_channels; channel++)
+        {
+            memset(out[channel] + frame, 0, (num_frames - frame) * sizeof(sample));
+        }
+        this->underrun_count.fetch_add(1, std::memory_order_relaxed);
+        this->is_streaming = false;
+        this->staged_frames = 0;
+        this->phase = 0.0;
+        return;
+    }
+
+    /*--------------------------------------------------------------------------------
+     * Discard the frames that have been fully consumed.
+     *-------------------------------------------------------------------------------*/
+    this->phase += num_frames * ratio;
+    int consumed_frames = std::min((int) this->phase, this->staged_frames);
+    memmove(this->staging.data(),
+            this->staging.data() + consumed_frames * num_channels,
+            (this->staged_frames - consumed_frames) * num_channels * sizeof(sample));
+    this->staged_frames -= consumed_frames;
+    this->phase -= consumed_frames;
+}
+
+int AudioIn_Abstract::get_buffered_frames()
+{
+    return this->ring ? this->ring->get_read_available() / this->num_output_channels : 0;
+}
+
+int AudioIn_Abstract::get_target_frames()
+{
+    return this->target_frames;
+}
+
+long AudioIn_Abstract::get_overrun_count()
+{
+    return this->overrun_count.load();
+}
+
+long AudioIn_Abstract::get_underrun_count()
+{
+    return this->underrun_count.load();
+}
+
+double AudioIn_Abstract::get_resample_ratio()
+{
+    return this->ratio.load();
 }
 
 }
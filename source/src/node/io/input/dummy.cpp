@@ -0,0 +1,18 @@
+#include "signalflow/node/io/input/dummy.h"
+
+namespace signalflow
+{
+
+AudioIn_Dummy::AudioIn_Dummy(int num_channels, int buffer_size, int sample_rate)
+    : AudioIn_Abstract()
+{
+    this->name = "audioin-dummy";
+
+    if (!sample_rate)
+    {
+        sample_rate = this->graph ? this->graph->get_sample_rate() : SIGNALFLOW_DEFAULT_SAMPLE_RATE;
+    }
+    this->init_ring(num_channels, buffer_size, sample_rate);
+}
+
+} // namespace signalflow
@@ -5,27 +5,25 @@
 #include "signalflow/core/graph.h"
 #include "signalflow/node/io/output/soundio.h"
 
+#include <algorithm>
 #include <iostream>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static bool is_processing = false;
-
 namespace signalflow
 {
-extern AudioIn_Abstract *shared_in;
 
 void read_callback(struct SoundIoInStream *instream,
                    int frame_count_min, int frame_count_max)
 {
-    is_processing = true;
-
-    AudioIn_SoundIO *input = (AudioIn_SoundIO *) shared_in;
-    if (!shared_in)
+    AudioIn_SoundIO *input = (AudioIn_SoundIO *) instream->userdata;
+    if (!input)
         return;
 
+    input->is_processing = true;
+
     const struct SoundIoChannelLayout *layout = &instream->layout;
     struct SoundIoChannelArea *areas;
     int frame_count = frame_count_max;
@@ -42,18 +40,51 @@ void read_callback(struct SoundIoInStream *instream,
         if ((err = soundio_instream_begin_read(instream, &areas, &frame_count)))
             throw std::runtime_error("libsoundio error on begin read: " + std::string(soundio_strerror(err)));
 
-        if (!input)
-            continue;
-        // throw std::runtime_error("libsoundio error: No global input created");
+        if (frame_count == 0)
+            break;
 
-        for (int frame = 0; frame < frame_count; frame++)
+        int channel_count = layout->channel_count;
+        if (!areas)
+        {
+            /*-----------------------------------------------------------------------*
+             * The driver has dropped frames: keep the input in time by writing
+             * silence in their place.
+             *-----------------------------------------------------------------------*/
+            sample silence[SIGNALFLOW_NODE_BUFFER_SIZE] = { 0 };
+            int chunk_frames = SIGNALFLOW_NODE_BUFFER_SIZE / channel_count;
+            for (int offset = 0; offset < frame_count; offset += chunk_frames)
+            {
+                input->write(silence, std::min(chunk_frames, frame_count - offset));
+            }
+        }
+        else if (signalflow_soundio_areas_are_interleaved(areas, channel_count))
+        {
+            /*-----------------------------------------------------------------------*
+             * Common case: a single interleaved float buffer, which is
+             * appended to the ring as-is.
+             *-----------------------------------------------------------------------*/
+            input->write((const float *) areas[0].ptr, frame_count);
+        }
+        else
         {
-            for (int channel = 0; channel < layout->channel_count; channel += 1)
+            /*-----------------------------------------------------------------------*
+             * Otherwise, interleave into a scratch buffer in chunks.
+             *-----------------------------------------------------------------------*/
+            sample scratch[SIGNALFLOW_NODE_BUFFER_SIZE];
+            int chunk_frames = SIGNALFLOW_NODE_BUFFER_SIZE / channel_count;
+            for (int offset = 0; offset < frame_count; offset += chunk_frames)
             {
-                float *ptr = (float *) (areas[channel].ptr + areas[channel].step * frame);
-                input->buffer->data[channel][input->write_pos] = *ptr;
+                int num_frames = std::min(chunk_frames, frame_count - offset);
+                for (int frame = 0; frame < num_frames; frame++)
+                {
+                    for (int channel = 0; channel < channel_count; channel++)
+                    {
+                        float *ptr = (float *) (areas[channel].ptr + areas[channel].step * (offset + frame));
+                        scratch[frame * channel_count + channel] = *ptr;
+                    }
+                }
+                input->write(scratch, num_frames);
             }
-            input->write_pos = (input->write_pos + 1) % input->buffer->get_num_frames();
         }
 
         if ((err = soundio_instream_end_read(instream)))
@@ -62,20 +93,37 @@ void read_callback(struct SoundIoInStream *instream,
         frames_left -= frame_count;
     }
 
-    is_processing = false;
+    input->is_processing = false;
 }
 
-AudioIn_SoundIO::AudioIn_SoundIO()
+int soundio_get_input_device_by_name(struct SoundIo *soundio, const char *name)
+{
+    int input_count = soundio_input_device_count(soundio);
+    for (int i = 0; i < input_count; i++)
+    {
+        struct SoundIoDevice *device = soundio_get_input_device(soundio, i);
+        bool matches = strcmp(device->name, name) == 0;
+        soundio_device_unref(device);
+        if (matches)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+AudioIn_SoundIO::AudioIn_SoundIO(const std::string &device_name, int num_channels, int buffer_size)
     : AudioIn_Abstract()
 {
-    // Allocate enough buffer for twice our block size, else
-    // we risk overwriting our input buffer from the audio in
-    // while it is still being read from.
-    // TODO: Bad hardcoded block size
-    this->buffer = new Buffer(2, 2048 * 2);
-    this->read_pos = 0;
-    this->write_pos = 2048;
-    this->name = "audioin_soundio";
+    this->device_name = device_name;
+    this->requested_num_channels = num_channels;
+    this->requested_buffer_size = buffer_size;
+    this->soundio = nullptr;
+    this->device = nullptr;
+    this->instream = nullptr;
+    this->is_processing = false;
+    this->name = "audioin-soundio";
     this->init();
 }
 
@@ -88,37 +136,79 @@ int AudioIn_SoundIO::init()
 {
     int err;
 
+    if (!this->graph)
+        throw std::runtime_error("AudioIn: No AudioGraph has been created");
+
     this->soundio = ((AudioOut_SoundIO *) this->graph->get_output().get())->soundio;
 
     if (!this->soundio)
         throw std::runtime_error("libsoundio init error: No output node found in graph (initialising input before output?)");
 
-    int default_in_device_index = soundio_default_input_device_index(this->soundio);
-    if (default_in_device_index < 0)
-        throw std::runtime_error("libsoundio init error: no input devices found.");
+    std::string device_name = this->device_name;
+    if (device_name.empty())
+    {
+        device_name = this->graph->get_config().get_input_device_name();
+    }
 
-    this->device = soundio_get_input_device(this->soundio, default_in_device_index);
+    int device_index;
+    if (!device_name.empty())
+    {
+        device_index = soundio_get_input_device_by_name(this->soundio, device_name.c_str());
+        if (device_index < 0)
+            throw std::runtime_error("libsoundio init error: Could not find input device: " + device_name);
+    }
+    else
+    {
+        device_index = soundio_default_input_device_index(this->soundio);
+        if (device_index < 0)
+            throw std::runtime_error("libsoundio init error: no input devices found.");
+    }
+
+    this->device = soundio_get_input_device(this->soundio, device_index);
     if (!device)
         throw std::runtime_error("libsoundio init error: out of memory.");
 
     this->instream = soundio_instream_create(device);
     this->instream->format = SoundIoFormatFloat32NE;
     this->instream->read_callback = read_callback;
-    this->instream->sample_rate = device->sample_rate_current;
-    this->instream->software_latency = 256.0 / this->instream->sample_rate;
+    this->instream->userdata = (void *) this;
+
+    if (this->requested_num_channels > 0)
+    {
+        const struct SoundIoChannelLayout *layout = soundio_channel_layout_get_default(this->requested_num_channels);
+        if (!layout || !soundio_device_supports_layout(this->device, layout))
+        {
+            throw std::runtime_error("libsoundio init error: Input device does not support " + std::to_string(this->requested_num_channels) + " channels");
+        }
+        this->instream->layout = *layout;
+    }
+
+    /*-----------------------------------------------------------------------*
+     * Prefer to record at the graph's sample rate. If the device doesn't
+     * support it, record at the nearest supported rate and resample.
+     *-----------------------------------------------------------------------*/
+    this->instream->sample_rate = soundio_device_nearest_sample_rate(this->device, this->graph->get_sample_rate());
+
+    int buffer_size = this->requested_buffer_size;
+    if (!buffer_size)
+        buffer_size = this->graph->get_config().get_input_buffer_size();
+    if (!buffer_size)
+        buffer_size = this->graph->get_block_size();
+    this->instream->software_latency = (double) buffer_size / this->instream->sample_rate;
 
     if ((err = soundio_instream_open(this->instream)))
     {
         throw std::runtime_error("libsoundio init error: unable to open device: " + std::string(soundio_strerror(err)));
     }
 
+    buffer_size = (int) round(this->instream->software_latency * this->instream->sample_rate);
+    this->init_ring(this->instream->layout.channel_count, buffer_size, this->instream->sample_rate);
+
     if ((err = soundio_instream_start(instream)))
     {
         throw std::runtime_error("libsoundio init error: unable to start device: " + std::string(soundio_strerror(err)));
     }
 
-    this->num_output_channels = this->instream->layout.channel_count;
-    int buffer_size = this->instream->software_latency * this->instream->sample_rate;
     std::string s = num_output_channels == 1 ? "" : "s";
 
     std::cerr << "Input device: " << device->name << " (" << this->instream->sample_rate << "Hz, "
@@ -139,29 +229,23 @@ int AudioIn_SoundIO::stop()
 
 int AudioIn_SoundIO::destroy()
 {
-    while (is_processing)
+    if (!this->instream)
+    {
+        return 0;
+    }
+
+    while (this->is_processing)
     {
     }
 
-    shared_in = NULL;
     soundio_instream_destroy(this->instream);
     soundio_device_unref(this->device);
+    this->instream = nullptr;
+    this->device = nullptr;
 
     return 0;
 }
 
-void AudioIn_SoundIO::process(Buffer &out, int num_frames)
-{
-    for (int frame = 0; frame < num_frames; frame++)
-    {
-        for (int channel = 0; channel < num_output_channels; channel++)
-        {
-            out[channel][frame] = this->buffer->data[channel][read_pos];
-        }
-        read_pos = (read_pos + 1) % this->buffer->get_num_frames();
-    }
-}
-
 }
 
 #endif
@@ -1,47 +1,66 @@
 #include "signalflow/node/io/output/abstract.h"
+#include "signalflow/core/vector.h"
 
 namespace signalflow
 {
 
 AudioOut_Abstract::AudioOut_Abstract()
+    : Node(nullptr)
 {
     this->name = "audioout";
-    // do we need to set num_output channels to allocate the right number of output buffers?
+    this->type = SIGNALFLOW_NODE_TYPE_AUDIO_OUT;
     this->set_channels(2, 0);
     this->no_input_upmix = true;
     this->has_variable_inputs = true;
     this->input_index = 0;
+    this->missing_input_count = 0;
+}
+
+void AudioOut_Abstract::set_channels(int num_input_channels, int num_output_channels)
+{
+    /*--------------------------------------------------------------------------------
+     * AudioOut has no outputs, but mixes its inputs into its own output buffer,
+     * so must allocate one buffer per input channel.
+     *-------------------------------------------------------------------------------*/
+    this->Node::set_channels(num_input_channels, num_output_channels);
+    this->resize_output_buffers(num_input_channels);
 }
 
 void AudioOut_Abstract::process(Buffer &out, int num_frames)
 {
     for (int channel = 0; channel < this->num_input_channels; channel++)
     {
-        memset(out[channel], 0, num_frames * sizeof(sample));
+        signalflow_vector_fill(0, out[channel], num_frames);
     }
 
-    for (NodeRef input : this->audio_inputs)
+    for (NodeRef &input : this->audio_inputs)
     {
+        if (!input)
+        {
+            continue;
+        }
         for (int channel = 0; channel < input->get_num_output_channels(); channel++)
         {
-#ifdef __APPLE__
-
-            vDSP_vadd(input->out[channel], 1, out[channel], 1, out[channel], 1, num_frames);
-
-#else
-
-            for (int frame = 0; frame < num_frames; frame++)
-            {
-                out[channel][frame] += input->out[channel][frame];
-            }
-
-#endif
+            signalflow_vector_add(out[channel], input->out[channel], out[channel], num_frames);
         }
     }
 }
 
 void AudioOut_Abstract::add_input(NodeRef node)
 {
+    /*--------------------------------------------------------------------------------
+     * Reuse the slot of an input that has been removed, if there is one.
+     *-------------------------------------------------------------------------------*/
+    for (int index = 0; index < (int) this->input_slots.size(); index++)
+    {
+        if (!*this->input_slots[index])
+        {
+            *this->input_slots[index] = node;
+            this->Node::create_input(this->input_names[index], *this->input_slots[index]);
+            return;
+        }
+    }
+
     audio_inputs.push_back(node);
     std::string input_name = "input" + std::to_string(input_index);
     this->input_index++;
@@ -50,50 +69,68 @@ void AudioOut_Abstract::add_input(NodeRef node)
 
 void AudioOut_Abstract::remove_input(NodeRef node)
 {
-    bool removed = false;
-    for (auto param : this->inputs)
+    /*--------------------------------------------------------------------------------
+     * Clear the input's slot rather than destroying it, so that stopping a
+     * node or patch on the audio thread doesn't free memory. The slot is
+     * reused by the next input added.
+     *-------------------------------------------------------------------------------*/
+    for (int index = 0; index < (int) this->input_slots.size(); index++)
     {
-        if (*(param.second) == node)
+        if (*this->input_slots[index] == node)
         {
-            this->destroy_input(param.first);
-            audio_inputs.remove(node);
-            removed = true;
-            node->remove_output(this, param.first);
-            break;
+            this->input_slots[index]->reset();
+            node->remove_output(this, this->input_names[index]);
+            this->invalidate_graph_schedule();
+            return;
         }
     }
-    if (!removed)
-    {
-        std::cerr << "Couldn't find node to remove" << std::endl;
-    }
+    this->missing_input_count.fetch_add(1, std::memory_order_relaxed);
 }
 
 void AudioOut_Abstract::replace_input(NodeRef node, NodeRef other)
 {
-    bool replaced = false;
-    for (auto param : this->inputs)
+    for (int index = 0; index < (int) this->input_slots.size(); index++)
     {
-        if (*(param.second) == node)
+        if (*this->input_slots[index] == node)
         {
             // Need to call create_input to also update the channel I/O on `other`
-            audio_inputs.remove(node);
-            audio_inputs.push_back(other);
-            this->create_input(param.first, audio_inputs.back());
-            replaced = true;
-            break;
+            *this->input_slots[index] = other;
+            node->remove_output(this, this->input_names[index]);
+            this->create_input(this->input_names[index], *this->input_slots[index]);
+            return;
         }
     }
+    this->missing_input_count.fetch_add(1, std::memory_order_relaxed);
+}
 
-    if (!replaced)
+std::list<NodeRef> AudioOut_Abstract::get_inputs()
+{
+    std::list<NodeRef> inputs;
+    for (NodeRef &input : this->audio_inputs)
     {
-        std::cerr << "Couldn't find node to replace" << std::endl;
-        // throw std::runtime_error("Couldn't find node to replace");
+        if (input)
+        {
+            inputs.push_back(input);
+        }
     }
+    return inputs;
 }
 
-std::list<NodeRef> AudioOut_Abstract::get_inputs()
+bool AudioOut_Abstract::has_inputs()
+{
+    for (NodeRef &input : this->audio_inputs)
+    {
+        if (input)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+long AudioOut_Abstract::get_missing_input_count()
 {
-    return this->audio_inputs;
+    return this->missing_input_count.load();
 }
 
 unsigned int AudioOut_Abstract::get_sample_rate()
@@ -3,12 +3,12 @@
 namespace signalflow
 {
 
-AudioOut_Dummy::AudioOut_Dummy(int num_channels)
+AudioOut_Dummy::AudioOut_Dummy(int num_channels, int sample_rate)
     : AudioOut_Abstract()
 {
     this->name = "audioout-dummy";
     this->set_channels(num_channels, 0);
-    this->sample_rate = 44100;
+    this->sample_rate = sample_rate;
 }
 
 } // namespace signalflow
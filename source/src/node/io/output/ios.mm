@@ -18,10 +18,9 @@
 namespace libsignal
 {
     
-extern AudioGraph *shared_graph;
-    
 void audio_callback(float **data, int num_channels, int num_frames)
 {
+    AudioGraph *shared_graph = AudioGraph::get_shared_graph();
     shared_graph->pull_input(num_frames);
     
     for (int frame = 0; frame < num_frames; frame++)
@@ -4,41 +4,51 @@
 
 #include "signalflow/core/graph.h"
 
+#include <algorithm>
 #include <iostream>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-static bool is_processing = false;
-
 namespace signalflow
 {
 
-extern AudioGraph *shared_graph;
+bool signalflow_soundio_areas_are_interleaved(const struct SoundIoChannelArea *areas, int channel_count)
+{
+    for (int channel = 0; channel < channel_count; channel++)
+    {
+        if (areas[channel].step != (int) (channel_count * sizeof(float)) || areas[channel].ptr != areas[0].ptr + channel * sizeof(float))
+        {
+            return false;
+        }
+    }
+    return true;
+}
 
 void write_callback(struct SoundIoOutStream *outstream,
                     int frame_count_min,
                     int frame_count_max)
 {
-    is_processing = true;
-
     const struct SoundIoChannelLayout *layout = &outstream->layout;
     struct SoundIoChannelArea *areas;
     int frame_count = frame_count_max;
     int frames_left = frame_count_max;
 
+    AudioOut_SoundIO *out_node = (AudioOut_SoundIO *) outstream->userdata;
+    AudioGraph *graph = out_node->graph;
+
     /*-----------------------------------------------------------------------*
-     * Return if the shared_graph hasn't been initialized yet.
+     * Return if the output's graph hasn't been initialized yet.
      * (The libsoundio Pulse Audio driver calls the write_callback once
      * on initialization, so this may happen legitimately.)
      *-----------------------------------------------------------------------*/
-    if (!shared_graph || !shared_graph->get_output())
+    if (!graph || !graph->get_output())
     {
         return;
     }
 
-    AudioOut_SoundIO *out_node = (AudioOut_SoundIO *) outstream->userdata;
+    out_node->is_processing = true;
 
     /*-----------------------------------------------------------------------*
      * On some drivers (eg Linux), we cannot write all samples at once.
@@ -54,32 +64,52 @@ void write_callback(struct SoundIoOutStream *outstream,
         }
         if (out_node->get_state() == SIGNALFLOW_NODE_STATE_ACTIVE)
         {
+            /*-----------------------------------------------------------------------*
+             * The graph renders in fixed-size blocks, which generally don't
+             * line up with the frames requested by the driver. read_output()
+             * serves any number of frames, interleaved and hard-limited, either
+             * from blocks rendered ahead on the render thread or by rendering
+             * blocks as needed.
+             *-----------------------------------------------------------------------*/
+            int channel_count = layout->channel_count;
+            bool interleaved = signalflow_soundio_areas_are_interleaved(areas, channel_count);
             try
             {
-                shared_graph->render(frame_count);
+                if (interleaved)
+                {
+                    /*-----------------------------------------------------------------------*
+                     * Common case: a single interleaved float buffer.
+                     *-----------------------------------------------------------------------*/
+                    graph->read_output((float *) areas[0].ptr, frame_count);
+                }
+                else
+                {
+                    /*-----------------------------------------------------------------------*
+                     * Otherwise, read into a scratch buffer in chunks, and copy each
+                     * sample to the driver's channel areas.
+                     *-----------------------------------------------------------------------*/
+                    sample scratch[SIGNALFLOW_NODE_BUFFER_SIZE];
+                    int chunk_frames = SIGNALFLOW_NODE_BUFFER_SIZE / channel_count;
+                    for (int offset = 0; offset < frame_count; offset += chunk_frames)
+                    {
+                        int num_frames = std::min(chunk_frames, frame_count - offset);
+                        graph->read_output(scratch, num_frames);
+                        for (int frame = 0; frame < num_frames; frame++)
+                        {
+                            for (int channel = 0; channel < channel_count; channel++)
+                            {
+                                float *ptr = (float *) (areas[channel].ptr + areas[channel].step * (offset + frame));
+                                *ptr = scratch[frame * channel_count + channel];
+                            }
+                        }
+                    }
+                }
             }
             catch (const std::exception &e)
             {
                 std::cerr << "Exception in AudioGraph: " << e.what() << std::endl;
                 exit(1);
             }
-
-            for (int frame = 0; frame < frame_count; frame++)
-            {
-                for (int channel = 0; channel < layout->channel_count; channel += 1)
-                {
-                    float *ptr = (float *) (areas[channel].ptr + areas[channel].step * frame);
-                    *ptr = shared_graph->get_output()->out[channel][frame];
-
-                    /*-----------------------------------------------------------------------*
-                     * Hard limiter.
-                     *-----------------------------------------------------------------------*/
-                    if (*ptr > 1.0)
-                        *ptr = 1.0;
-                    if (*ptr < -1.0)
-                        *ptr = -1.0;
-                }
-            }
         }
         else
         {
@@ -101,7 +131,7 @@ void write_callback(struct SoundIoOutStream *outstream,
         frames_left -= frame_count;
     }
 
-    is_processing = false;
+    out_node->is_processing = false;
 }
 
 int soundio_get_device_by_name(struct SoundIo *soundio, const char *name)
@@ -129,6 +159,7 @@ AudioOut_SoundIO::AudioOut_SoundIO(const std::string &device_name,
     this->sample_rate = sample_rate;
     this->buffer_size = buffer_size;
     this->name = "audioout-soundio";
+    this->is_processing = false;
 
     this->init();
 }
@@ -209,7 +240,6 @@ int AudioOut_SoundIO::init()
     std::cerr << "Output device: " << device->name << " (" << sample_rate << "Hz, "
               << "buffer size " << buffer_size << " samples, " << num_output_channels << " channel" << s << ")" << std::endl;
 
-    // do we need to set num_output channels to allocate the right number of output buffers?
     this->set_channels(num_output_channels, 0);
 
     return 0;
@@ -233,7 +263,7 @@ int AudioOut_SoundIO::stop()
 
 int AudioOut_SoundIO::destroy()
 {
-    while (is_processing)
+    while (this->is_processing)
     {
     }
 
@@ -13,17 +13,25 @@
 #include "signalflow/core/core.h"
 #include "signalflow/core/exceptions.h"
 #include "signalflow/core/graph.h"
+#include "signalflow/core/vector.h"
 #include "signalflow/node/node-monitor.h"
+#include "signalflow/patch/patch.h"
+
+#include <algorithm>
 
 namespace signalflow
 {
 
-extern AudioGraph *shared_graph;
-
 Node::Node()
+    : Node(AudioGraph::get_shared_graph())
+{
+}
+
+Node::Node(AudioGraph *graph)
 {
     this->name = "(unknown node)";
-    this->graph = shared_graph;
+    this->type = SIGNALFLOW_NODE_TYPE_GENERIC;
+    this->graph = graph;
     this->state = SIGNALFLOW_NODE_STATE_ACTIVE;
 
     this->matches_input_channels = true;
@@ -36,24 +44,27 @@ Node::Node()
     this->patch = NULL;
 
     this->has_rendered = false;
+    this->output_is_constant = false;
+    this->inactive = false;
     this->num_output_channels_allocated = 0;
 
     /*------------------------------------------------------------------------
-     * In most cases, shared_graph->get_output_buffer_size() should always
-     * be non-zero. However, there are edge cases when it is zero
-     * (e.g. when creating an AudioOut before the graph has been instantiated).
+     * Allocate just enough output buffer for the node's current channel
+     * count, and for the graph's block size. If more channels or frames
+     * are later needed, the buffer is grown by update_channels() and
+     * _process() respectively.
      *
+     * The graph's block size may be zero (e.g. when creating an AudioOut
+     * before the graph has been instantiated), in which case use the
+     * default block size.
      *-----------------------------------------------------------------------*/
-    if (shared_graph && shared_graph->get_config().get_output_buffer_size() && false)
+    this->output_buffer_length = SIGNALFLOW_DEFAULT_BLOCK_SIZE;
+    if (this->graph && this->graph->get_block_size() > 0)
     {
-        this->output_buffer_length = shared_graph->get_config().get_output_buffer_size();
-    }
-    else
-    {
-        this->output_buffer_length = SIGNALFLOW_NODE_BUFFER_SIZE;
+        this->output_buffer_length = this->graph->get_block_size();
     }
 
-    this->resize_output_buffers(SIGNALFLOW_NODE_INITIAL_OUTPUT_BUFFERS);
+    this->resize_output_buffers(this->num_output_channels);
 
     /*------------------------------------------------------------------------
      * last_num_frames caches the number of frames generated in the last
@@ -67,6 +78,8 @@ Node::Node()
 
 Node::~Node()
 {
+    this->release_scratch_buffer();
+    delete this->profile.load();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -81,26 +94,53 @@ Node::~Node()
  *-----------------------------------------------------------------------*/
 void Node::_process(Buffer &out, int num_frames)
 {
-    if (&out == &this->out && num_frames > this->output_buffer_length)
+    if (&out == &this->out)
     {
-        throw std::runtime_error("Node " + this->name + " cannot render because output buffer size is insufficient (" + std::to_string(num_frames) + " samples requested, buffer size = " + std::to_string(this->output_buffer_length) + "). Increase the buffer size.");
+        this->resize_output_buffer_length(num_frames);
     }
 
     /*--------------------------------------------------------------------------------
+     * The final samples of the previous block are captured once it has been
+     * rendered, as by now its buffer may have been reused as scratch space by
+     * another node.
+     *
      * Must use `num_output_channels_allocated`, rather than `num_output_channels`,
      * as the additional allocated channels may be used for upmixing, and otherwise
-     * the last-sample-magic fails for upmixed channels.
+     * the last-sample-magic fails for upmixed channels. AudioGraph::upmix()
+     * captures the final samples of upmixed channels.
      *-------------------------------------------------------------------------------*/
     for (int i = 0; i < this->num_output_channels_allocated; i++)
     {
-        this->last_sample[i] = out[i][last_num_frames - 1];
+        this->last_sample[i] = this->final_sample[i];
     }
+    this->output_is_constant = false;
     this->process(out, num_frames);
     this->last_num_frames = num_frames;
+    for (int i = 0; i < this->num_output_channels_allocated; i++)
+    {
+        this->final_sample[i] = out[i][num_frames - 1];
+    }
+}
+
+void Node::_process_silence(int num_frames)
+{
+    this->resize_output_buffer_length(num_frames);
+    for (int i = 0; i < this->num_output_channels_allocated; i++)
+    {
+        this->last_sample[i] = this->final_sample[i];
+        this->final_sample[i] = 0.0;
+    }
+    for (int channel = 0; channel < this->num_output_channels; channel++)
+    {
+        signalflow_vector_fill(0.0, this->out[channel], num_frames);
+    }
+    this->last_num_frames = num_frames;
+    this->output_is_constant = true;
 }
 
 void Node::process(int num_frames)
 {
+    this->output_is_constant = false;
     this->process(this->out, num_frames);
 }
 
@@ -123,6 +163,19 @@ void Node::set_channels(int num_input_channels, int num_output_channels)
     this->num_input_channels = num_input_channels;
     this->num_output_channels = num_output_channels;
     this->matches_input_channels = false;
+    this->resize_output_buffers(num_output_channels);
+
+    /*------------------------------------------------------------------------
+     * Inputs that are already connected may now need to be upmixed to
+     * more channels than they have allocated.
+     *-----------------------------------------------------------------------*/
+    for (NodeRef *ptr : this->input_slots)
+    {
+        if (!this->no_input_upmix && *ptr && (*ptr)->get_num_output_channels_allocated() < num_input_channels)
+        {
+            (*ptr)->resize_output_buffers(num_input_channels);
+        }
+    }
 }
 
 void Node::update_channels()
@@ -130,15 +183,13 @@ void Node::update_channels()
     if (this->matches_input_channels)
     {
         int max_channels = 1;
-        for (auto input : this->inputs)
+        for (NodeRef *ptr : this->input_slots)
         {
-            NodeRef *ptr = input.second;
             // A param may be registered but not yet set
-            if (!ptr || !*ptr)
+            if (!*ptr)
                 continue;
-            std::string param_name = input.first;
 
-            NodeRef input_node = *ptr;
+            const NodeRef &input_node = *ptr;
             if (input_node->get_num_output_channels() > max_channels)
                 max_channels = input_node->get_num_output_channels();
         }
@@ -147,9 +198,9 @@ void Node::update_channels()
         this->num_input_channels = max_channels;
         this->num_output_channels = max_channels;
 
-        for (auto input : this->inputs)
+        for (NodeRef *ptr : this->input_slots)
         {
-            NodeRef node = *input.second;
+            const NodeRef &node = *ptr;
             if (node && node->get_num_output_channels_allocated() < this->num_output_channels)
             {
                 node->resize_output_buffers(this->num_output_channels);
@@ -158,7 +209,7 @@ void Node::update_channels()
 
         if (previous_num_output_channels != this->num_output_channels)
         {
-            for (auto output : this->outputs)
+            for (auto &output : this->outputs)
             {
                 Node *node = output.first;
                 node->update_channels();
@@ -171,20 +222,55 @@ void Node::update_channels()
     }
     else
     {
-        for (auto input : this->inputs)
+        for (NodeRef *ptr : this->input_slots)
         {
-            NodeRef *ptr = input.second;
             // A param may be registered but not yet set
-            if (!ptr || !*ptr)
+            if (!*ptr)
                 continue;
-            std::string param_name = input.first;
 
-            NodeRef input_node = *ptr;
+            const NodeRef &input_node = *ptr;
             if (input_node->get_num_output_channels() > this->num_input_channels)
             {
                 throw invalid_channel_count_exception("Node " + input_node->name + " has more output channels than " + this->name + " supports. Either downmix with ChannelMixer, or select the intended channels with ChannelSelect.");
             }
+
+            /*------------------------------------------------------------------------
+             * Ensure that the input has enough buffers allocated to be upmixed.
+             *-----------------------------------------------------------------------*/
+            if (!this->no_input_upmix && input_node->get_num_output_channels_allocated() < this->num_input_channels)
+            {
+                input_node->resize_output_buffers(this->num_input_channels);
+            }
+        }
+    }
+}
+
+void Node::infer_channels(const std::vector<int> &input_channels,
+                          int &num_input_channels,
+                          int &num_output_channels)
+{
+    if (this->matches_input_channels)
+    {
+        int max_channels = 1;
+        for (int channels : input_channels)
+        {
+            max_channels = std::max(max_channels, channels);
+        }
+        num_input_channels = max_channels;
+        num_output_channels = max_channels;
+    }
+    else
+    {
+        for (int index = 0; index < (int) input_channels.size(); index++)
+        {
+            if (input_channels[index] > this->num_input_channels)
+            {
+                std::string input_name = index < (int) this->input_names.size() ? this->input_names[index] : "input";
+                throw invalid_channel_count_exception("Input " + input_name + " has more output channels than " + this->name + " supports. Either downmix with ChannelMixer, or select the intended channels with ChannelSelect.");
+            }
         }
+        num_input_channels = this->num_input_channels;
+        num_output_channels = this->num_output_channels;
     }
 }
 
@@ -230,19 +316,135 @@ void Node::resize_output_buffers(int output_buffer_count)
          * If not enough channels/frames  are allocated, dealloc the current
          * allocations and resize
          *-----------------------------------------------------------------------*/
+        this->release_scratch_buffer();
+        this->invalidate_graph_schedule();
+
         this->free();
         this->out.resize(output_buffer_count, this->output_buffer_length);
         this->last_sample.resize(output_buffer_count);
+        this->final_sample.resize(output_buffer_count);
+        this->scratch_channels.reserve(output_buffer_count);
         this->num_output_channels_allocated = output_buffer_count;
         this->alloc();
     }
 }
 
+void Node::swap_output_buffers(NodeOutputBuffers &buffers)
+{
+    int num_channels = buffers.out.get_num_channels();
+    if (num_channels <= this->out.get_num_channels() || buffers.out.get_num_frames() < this->output_buffer_length)
+    {
+        return;
+    }
+
+    this->release_scratch_buffer();
+    this->invalidate_graph_schedule();
+
+    /*------------------------------------------------------------------------
+     * As in resize_output_buffers(), except that the new storage has already
+     * been allocated. The final samples of the existing channels are kept,
+     * so that out[-1] is still valid for them.
+     *-----------------------------------------------------------------------*/
+    this->free();
+    std::copy(this->last_sample.begin(), this->last_sample.end(), buffers.last_sample.begin());
+    std::copy(this->final_sample.begin(), this->final_sample.end(), buffers.final_sample.begin());
+    this->out.swap_storage(buffers.out);
+    this->last_sample.swap(buffers.last_sample);
+    this->final_sample.swap(buffers.final_sample);
+    this->scratch_channels.swap(buffers.scratch_channels);
+    this->num_output_channels_allocated = num_channels;
+    this->alloc();
+}
+
+void Node::resize_output_buffer_length(int num_frames)
+{
+    if (num_frames <= this->output_buffer_length)
+    {
+        return;
+    }
+
+    /*------------------------------------------------------------------------
+     * Typically only happens once, the first time that the audio device
+     * requests a block larger than its nominal buffer size.
+     *-----------------------------------------------------------------------*/
+    this->output_buffer_length = num_frames;
+    this->resize_output_buffers(std::max(this->num_output_channels_allocated, 1));
+}
+
 int Node::get_output_buffer_length()
 {
     return this->output_buffer_length;
 }
 
+void Node::pin_output_buffer()
+{
+    if (!this->output_buffer_pinned)
+    {
+        this->output_buffer_pinned = true;
+        this->invalidate_graph_schedule();
+    }
+}
+
+bool Node::get_output_buffer_pinned()
+{
+    return this->output_buffer_pinned;
+}
+
+bool Node::get_output_is_constant()
+{
+    return this->output_is_constant;
+}
+
+NodeProfile *Node::get_profile()
+{
+    return this->profile.load();
+}
+
+bool Node::get_output_will_be_silent()
+{
+    return this->inactive;
+}
+
+bool Node::get_output_is_silent()
+{
+    return this->render_silent;
+}
+
+bool Node::get_is_inactive()
+{
+    return this->inactive;
+}
+
+void Node::set_inactive(bool inactive)
+{
+    this->inactive = inactive;
+}
+
+sample *Node::get_output_buffer_data()
+{
+    sample **data = this->owned_output_data ? this->owned_output_data : this->out.data;
+    return data ? data[0] : nullptr;
+}
+
+void Node::use_scratch_buffer()
+{
+    if (!this->owned_output_data)
+    {
+        this->owned_output_data = this->out.data;
+    }
+    this->out.data = this->scratch_channels.data();
+}
+
+void Node::release_scratch_buffer()
+{
+    if (this->owned_output_data)
+    {
+        this->out.data = this->owned_output_data;
+        this->owned_output_data = nullptr;
+    }
+    this->scratch_channels.clear();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // States
 ////////////////////////////////////////////////////////////////////////////////
@@ -270,7 +472,19 @@ void Node::set_state(signalflow_node_state_t state)
 
 void Node::create_input(std::string name, NodeRef &input)
 {
+    auto existing = this->inputs.find(name);
+    if (existing != this->inputs.end())
+    {
+        auto slot = std::find(this->input_slots.begin(), this->input_slots.end(), existing->second);
+        *slot = &input;
+    }
+    else
+    {
+        this->input_slots.push_back(&input);
+        this->input_names.push_back(name);
+    }
     this->inputs[name] = &input;
+    this->invalidate_patch_clone_plan();
 
     /*------------------------------------------------------------------------
      * Create a new named input.
@@ -285,6 +499,8 @@ void Node::create_input(std::string name, NodeRef &input)
          *-----------------------------------------------------------------------*/
         this->update_channels();
     }
+
+    this->invalidate_graph_schedule();
 }
 
 void Node::destroy_input(std::string name)
@@ -292,8 +508,17 @@ void Node::destroy_input(std::string name)
     /*------------------------------------------------------------------------
      * Only done by special classes (ChannelArray, AudioOut)
      *-----------------------------------------------------------------------*/
-    this->inputs.erase(name);
+    auto existing = this->inputs.find(name);
+    if (existing != this->inputs.end())
+    {
+        auto slot = std::find(this->input_slots.begin(), this->input_slots.end(), existing->second);
+        this->input_names.erase(this->input_names.begin() + (slot - this->input_slots.begin()));
+        this->input_slots.erase(slot);
+        this->inputs.erase(existing);
+    }
+    this->invalidate_patch_clone_plan();
     this->update_channels();
+    this->invalidate_graph_schedule();
 }
 
 NodeRef Node::get_input(std::string name)
@@ -308,11 +533,20 @@ NodeRef Node::get_input(std::string name)
 
 void Node::set_input(std::string name, const NodeRef &node)
 {
+    /*------------------------------------------------------------------------
+     * Validate the name before posting, so that an unknown input throws
+     * here rather than on the audio thread.
+     *-----------------------------------------------------------------------*/
     if (this->inputs.find(name) == this->inputs.end())
     {
         throw std::runtime_error("Node " + this->name + " has no such input: " + name);
     }
 
+    if (this->post_set_input(name, node))
+    {
+        return;
+    }
+
     NodeRef current_input = *(this->inputs[name]);
 
     if (current_input)
@@ -321,9 +555,11 @@ void Node::set_input(std::string name, const NodeRef &node)
     }
 
     *(this->inputs[name]) = node;
+    this->invalidate_patch_clone_plan();
     this->update_channels();
 
     node->add_output(this, name);
+    this->invalidate_graph_schedule();
 }
 
 void Node::set_input(std::string name, float value)
@@ -335,10 +571,21 @@ void Node::set_input(std::string name, float value)
 
     NodeRef current_input = *(this->inputs[name]);
 
-    if (current_input && current_input->name == "constant")
+    if (current_input && current_input->type == SIGNALFLOW_NODE_TYPE_CONSTANT)
     {
-        Constant *constant = (Constant *) current_input.get();
-        constant->value = value;
+        /*------------------------------------------------------------------------
+         * The audio thread reads the constant's value while rendering, so
+         * if it is running, have the value set there.
+         *-----------------------------------------------------------------------*/
+        if (this->graph_owned && this->graph && this->graph->get_is_queueing_commands())
+        {
+            this->graph->set_input_at(this->shared_from_this(), name, value, 0);
+        }
+        else
+        {
+            Constant *constant = (Constant *) current_input.get();
+            constant->value = value;
+        }
     }
     else
     {
@@ -346,6 +593,243 @@ void Node::set_input(std::string name, float value)
     }
 }
 
+void Node::invalidate_patch_clone_plan()
+{
+    /*------------------------------------------------------------------------
+     * A Patch caches the connections between its nodes for clone(), so
+     * must be told whenever they change.
+     *-----------------------------------------------------------------------*/
+    if (this->patch)
+    {
+        this->patch->invalidate_clone_plan();
+    }
+}
+
+void Node::invalidate_graph_schedule()
+{
+    /*------------------------------------------------------------------------
+     * The graph caches its render order, so must be told whenever
+     * connections between nodes change.
+     *-----------------------------------------------------------------------*/
+    if (this->graph)
+    {
+        this->graph->invalidate_schedule();
+    }
+}
+
+bool Node::post_set_input(std::string name, const NodeRef &input)
+{
+    if (this->graph_owned && this->graph && this->graph->get_is_queueing_commands())
+    {
+        this->graph->set_input(this->shared_from_this(), name, input);
+        return true;
+    }
+    return false;
+}
+
+void Node::prepare_set_input(const std::string &name, const NodeRef &input, NodeInputChange &change)
+{
+    /*------------------------------------------------------------------------
+     * The slot being set is either one of the node's own, or a new one
+     * prepared by prepare_input_slot().
+     *-----------------------------------------------------------------------*/
+    NodeRef *slot = nullptr;
+    const std::vector<NodeRef *> &slots = change.slot.empty() ? this->input_slots : change.input_slots;
+    if (!change.slot.empty())
+    {
+        slot = &change.slot.back();
+    }
+    else
+    {
+        auto existing = this->inputs.find(name);
+        if (existing == this->inputs.end())
+        {
+            throw std::runtime_error("Node " + this->name + " has no such input: " + name);
+        }
+        slot = existing->second;
+    }
+
+    if (input)
+    {
+        change.output = std::make_pair(this, name);
+        change.outputs.reserve(2 * input->outputs.size() + 1);
+    }
+
+    /*------------------------------------------------------------------------
+     * Infer channel counts as update_channels() will once the input is set,
+     * starting at this node and following each change in a node's output
+     * channels to the nodes that it is connected to. Each node needs as many
+     * channels allocated as it outputs, and its inputs as many as it reads
+     * (so that they can be upmixed).
+     *-----------------------------------------------------------------------*/
+    std::unordered_map<Node *, int> inferred_output_channels;
+    std::unordered_map<Node *, int> allocations;
+    auto get_output_channels = [&](Node *node) {
+        auto inferred = inferred_output_channels.find(node);
+        return inferred == inferred_output_channels.end() ? node->get_num_output_channels() : inferred->second;
+    };
+
+    std::vector<Node *> stack = { this };
+    while (!stack.empty())
+    {
+        Node *node = stack.back();
+        stack.pop_back();
+
+        std::vector<Node *> node_inputs;
+        std::vector<int> input_channels;
+        for (NodeRef *node_slot : (node == this ? slots : node->input_slots))
+        {
+            Node *node_input = (node_slot == slot) ? input.get() : node_slot->get();
+            node_inputs.push_back(node_input);
+            input_channels.push_back(node_input ? get_output_channels(node_input) : 0);
+        }
+
+        int num_input_channels;
+        int num_output_channels;
+        node->infer_channels(input_channels, num_input_channels, num_output_channels);
+
+        allocations[node] = std::max(allocations[node], num_output_channels);
+        if (!node->no_input_upmix)
+        {
+            for (Node *node_input : node_inputs)
+            {
+                if (node_input)
+                {
+                    allocations[node_input] = std::max(allocations[node_input], num_input_channels);
+                }
+            }
+        }
+
+        if (num_output_channels != get_output_channels(node))
+        {
+            inferred_output_channels[node] = num_output_channels;
+            for (auto &output : node->outputs)
+            {
+                stack.push_back(output.first);
+            }
+        }
+    }
+
+    for (auto &allocation : allocations)
+    {
+        Node *node = allocation.first;
+        int num_channels = allocation.second;
+        if (num_channels > node->get_num_output_channels_allocated())
+        {
+            change.buffers.emplace_back();
+            NodeOutputBuffers &buffers = change.buffers.back();
+            buffers.node = node->shared_from_this();
+            buffers.out.resize(num_channels, node->output_buffer_length);
+            buffers.last_sample.resize(num_channels);
+            buffers.final_sample.resize(num_channels);
+            buffers.scratch_channels.reserve(num_channels);
+        }
+    }
+}
+
+void Node::apply_set_input(const std::string &name, const NodeRef &input, NodeInputChange &change)
+{
+    for (auto &buffers : change.buffers)
+    {
+        buffers.node->swap_output_buffers(buffers);
+    }
+
+    auto existing = this->inputs.find(name);
+    if (existing == this->inputs.end())
+    {
+        throw std::runtime_error("Node " + this->name + " has no such input: " + name);
+    }
+    NodeRef *slot = existing->second;
+    if (*slot)
+    {
+        (*slot)->remove_output(this, name);
+    }
+    *slot = input;
+    this->invalidate_patch_clone_plan();
+
+    /*------------------------------------------------------------------------
+     * The storage for every node that grows has now been swapped in, so
+     * update_channels() just applies the counts that were inferred.
+     *-----------------------------------------------------------------------*/
+    this->update_channels();
+
+    if (input)
+    {
+        auto &outputs = input->outputs;
+        if (std::find(outputs.begin(), outputs.end(), change.output) == outputs.end())
+        {
+            if (outputs.size() == outputs.capacity() && change.outputs.capacity() > outputs.size())
+            {
+                change.outputs.insert(change.outputs.end(),
+                                      std::make_move_iterator(outputs.begin()),
+                                      std::make_move_iterator(outputs.end()));
+                outputs.swap(change.outputs);
+            }
+            outputs.push_back(std::move(change.output));
+        }
+    }
+    this->invalidate_graph_schedule();
+}
+
+void Node::prepare_input_slot(const std::string &name, NodeInputChange &change)
+{
+    if (this->inputs.find(name) == this->inputs.end())
+    {
+        change.slot.push_back(nullptr);
+        change.input_slots = this->input_slots;
+        change.input_slots.push_back(&change.slot.back());
+        change.input_names = this->input_names;
+        change.input_names.push_back(name);
+        change.inputs = this->inputs;
+        change.inputs[name] = &change.slot.back();
+    }
+}
+
+void Node::apply_input_slot(const std::string &name, std::list<NodeRef> &input_list, NodeInputChange &change)
+{
+    if (change.slot.empty() || this->inputs.find(name) != this->inputs.end())
+    {
+        return;
+    }
+
+    if (change.input_slots.size() == this->input_slots.size() + 1)
+    {
+        input_list.splice(input_list.end(), change.slot);
+        this->input_slots.swap(change.input_slots);
+        this->input_names.swap(change.input_names);
+        this->inputs.swap(change.inputs);
+    }
+    else
+    {
+        /*------------------------------------------------------------------------
+         * Another change has added a slot since this one was prepared, so the
+         * prepared tables are out of date. Rare, so just create the slot.
+         *-----------------------------------------------------------------------*/
+        input_list.push_back(nullptr);
+        this->Node::create_input(name, input_list.back());
+    }
+}
+
+bool Node::post_add_input(const NodeRef &input)
+{
+    if (this->graph_owned && this->graph && this->graph->get_is_queueing_commands())
+    {
+        this->graph->add_input(this->shared_from_this(), input);
+        return true;
+    }
+    return false;
+}
+
+bool Node::post_remove_input(const NodeRef &input)
+{
+    if (this->graph_owned && this->graph && this->graph->get_is_queueing_commands())
+    {
+        this->graph->remove_input(this->shared_from_this(), input);
+        return true;
+    }
+    return false;
+}
+
 void Node::add_input(NodeRef input)
 {
     throw std::runtime_error("This Node class does not support unnamed inputs");
@@ -358,12 +842,25 @@ void Node::remove_input(NodeRef input)
 
 void Node::add_output(Node *target, std::string name)
 {
-    this->outputs.insert(std::make_pair(target, name));
+    auto output = std::make_pair(target, name);
+    if (std::find(this->outputs.begin(), this->outputs.end(), output) == this->outputs.end())
+    {
+        this->outputs.push_back(output);
+    }
 }
 
 void Node::remove_output(Node *target, std::string name)
 {
-    this->outputs.erase(std::make_pair(target, name));
+    /*------------------------------------------------------------------------
+     * outputs is a vector rather than a set, so that removing an output
+     * (which happens on the audio thread when a node is stopped) doesn't
+     * free memory.
+     *-----------------------------------------------------------------------*/
+    auto output = std::find(this->outputs.begin(), this->outputs.end(), std::make_pair(target, name));
+    if (output != this->outputs.end())
+    {
+        this->outputs.erase(output);
+    }
 }
 
 void Node::disconnect_inputs()
@@ -378,14 +875,15 @@ void Node::disconnect_outputs()
 {
     // TODO: Can this method be removed?
     /*------------------------------------------------------------------------
-     * Don't iterate over outputs as the output set will change during
-     * iteration (as calling set_input on each output of the node will 
-     * change our own `outputs` array). Instead, keep trying until all
-     * outputs are removed.
+     * Iterate over a copy of the outputs, as the output set will change
+     * during iteration (as calling set_input on each output of the node will
+     * change our own `outputs` array). If the graph is running, changes to
+     * its nodes are applied at the start of the next block, so `outputs`
+     * may not yet be empty on return.
      *-----------------------------------------------------------------------*/
-    while (this->outputs.size() > 0)
+    auto outputs = this->outputs;
+    for (auto output : outputs)
     {
-        auto output = *(this->outputs.begin());
         Node *target = output.first;
         std::string name = output.second;
         //        target->set_input(name, new Constant(0.0));
@@ -481,8 +979,84 @@ void Node::trigger(std::string name, float value)
     throw std::runtime_error("Trigger " + name + " is not implemented in node class " + this->name);
 }
 
+void Node::reset()
+{
+    this->state = SIGNALFLOW_NODE_STATE_ACTIVE;
+}
+
+NodeRef Node::clone()
+{
+    if (!this->clone_factory)
+    {
+        this->clone_factory = NodeRegistry::global()->get_factory(this->name);
+    }
+    Node *node = this->clone_factory();
+    this->copy_to(node);
+    NodeRef clone = NodeRef(node);
+
+    for (int index = 0; index < (int) this->input_slots.size(); index++)
+    {
+        NodeRef input = *(this->input_slots[index]);
+        if (input)
+        {
+            if (input->type == SIGNALFLOW_NODE_TYPE_CONSTANT)
+            {
+                input = input->clone();
+            }
+            clone->set_cloned_input(this->input_names[index], input);
+        }
+    }
+
+    return clone;
+}
+
+void Node::copy_to(Node *node)
+{
+    for (auto property : this->properties)
+    {
+        node->set_property(property.first, *(property.second));
+    }
+    for (auto buffer : this->buffers)
+    {
+        if (*(buffer.second))
+        {
+            node->set_buffer(buffer.first, *(buffer.second));
+        }
+    }
+
+    /*------------------------------------------------------------------------
+     * The copy's inputs are connected with set_cloned_input, which doesn't
+     * infer channel counts, so they are copied as they stand. Output buffers
+     * are allocated up front at the size that the prototype has grown to,
+     * which is enough for any upmixing that its outputs do.
+     *-----------------------------------------------------------------------*/
+    node->num_input_channels = this->num_input_channels;
+    node->num_output_channels = this->num_output_channels;
+    node->matches_input_channels = this->matches_input_channels;
+    if (node->get_num_output_channels_allocated() < this->num_output_channels_allocated)
+    {
+        node->resize_output_buffers(this->num_output_channels_allocated);
+    }
+}
+
+void Node::set_cloned_input(const std::string &name, const NodeRef &input)
+{
+    auto slot = this->inputs.find(name);
+    if (slot == this->inputs.end())
+    {
+        throw std::runtime_error("Node " + this->name + " has no such input: " + name);
+    }
+    if (*(slot->second))
+    {
+        (*(slot->second))->remove_output(this, name);
+    }
+    *(slot->second) = input;
+    input->add_output(this, name);
+}
+
 void Node::poll(float frequency, std::string label)
 {
+    this->pin_output_buffer();
     this->monitor = new NodeMonitor(this, label, frequency);
     this->monitor->start();
 }
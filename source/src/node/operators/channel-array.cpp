@@ -1,6 +1,7 @@
 #include "signalflow/core/core.h"
 #include "signalflow/node/operators/channel-array.h"
 #include "signalflow/node/oscillators/constant.h"
+#include "signalflow/core/vector.h"
 
 namespace signalflow
 {
@@ -51,11 +52,16 @@ ChannelArray::ChannelArray(std::vector<int> inputs)
 void ChannelArray::process(Buffer &out, int num_frames)
 {
     int global_channel = 0;
-    for (NodeRef input : this->input_list)
+    for (NodeRef *slot : this->input_slots)
     {
+        const NodeRef &input = *slot;
+        if (!input)
+        {
+            continue;
+        }
         for (int this_channel = 0; this_channel < input->get_num_output_channels(); this_channel++)
         {
-            memcpy(out[global_channel + this_channel], input->out[this_channel], num_frames * sizeof(sample));
+            signalflow_vector_copy(input->out[this_channel], out[global_channel + this_channel], num_frames);
         }
         global_channel += input->get_num_output_channels();
     }
@@ -64,9 +70,13 @@ void ChannelArray::process(Buffer &out, int num_frames)
 void ChannelArray::update_channels()
 {
     this->num_input_channels = 0;
-    for (NodeRef input : this->input_list)
+    for (NodeRef *slot : this->input_slots)
     {
-        this->num_input_channels += input->get_num_output_channels();
+        const NodeRef &input = *slot;
+        if (input)
+        {
+            this->num_input_channels += input->get_num_output_channels();
+        }
     }
 
     this->set_channels(this->num_input_channels, this->num_input_channels);
@@ -76,8 +86,25 @@ void ChannelArray::update_channels()
     this->resize_output_buffers(this->num_input_channels);
 }
 
+void ChannelArray::infer_channels(const std::vector<int> &input_channels,
+                                  int &num_input_channels,
+                                  int &num_output_channels)
+{
+    num_input_channels = 0;
+    for (int channels : input_channels)
+    {
+        num_input_channels += channels;
+    }
+    num_output_channels = num_input_channels;
+}
+
 void ChannelArray::add_input(NodeRef input)
 {
+    if (this->post_add_input(input))
+    {
+        return;
+    }
+
     this->input_list.push_back(input);
     std::string input_name = "input" + std::to_string(this->inputs.size());
     this->Node::create_input(input_name, input_list.back());
@@ -85,6 +112,11 @@ void ChannelArray::add_input(NodeRef input)
 
 void ChannelArray::set_input(std::string name, const NodeRef &node)
 {
+    if (this->post_set_input(name, node))
+    {
+        return;
+    }
+
     if (this->inputs.find(name) == this->inputs.end())
     {
         this->input_list.push_back(node);
@@ -94,4 +126,30 @@ void ChannelArray::set_input(std::string name, const NodeRef &node)
     this->Node::set_input(name, node);
 }
 
+void ChannelArray::prepare_set_input(const std::string &name, const NodeRef &input, NodeInputChange &change)
+{
+    this->prepare_input_slot(name, change);
+    this->Node::prepare_set_input(name, input, change);
+}
+
+void ChannelArray::apply_set_input(const std::string &name, const NodeRef &input, NodeInputChange &change)
+{
+    this->apply_input_slot(name, this->input_list, change);
+    this->Node::apply_set_input(name, input, change);
+}
+
+void ChannelArray::copy_to(Node *node)
+{
+    /*------------------------------------------------------------------------
+     * Create the copy's input slots, unconnected, with the same names.
+     *-----------------------------------------------------------------------*/
+    ChannelArray *array = (ChannelArray *) node;
+    for (auto &input_name : this->input_names)
+    {
+        array->input_list.push_back(nullptr);
+        array->Node::create_input(input_name, array->input_list.back());
+    }
+    this->Node::copy_to(node);
+}
+
 }
@@ -1,5 +1,8 @@
 #include "signalflow/core/core.h"
 #include "signalflow/node/operators/channel-mixer.h"
+#include "signalflow/core/vector.h"
+
+#include <algorithm>
 
 namespace signalflow
 {
@@ -19,7 +22,7 @@ void ChannelMixer::process(Buffer &out, int num_frames)
 
     for (int channel = 0; channel < this->num_output_channels; channel++)
     {
-        memset(out[channel], 0, num_frames * sizeof(sample));
+        signalflow_vector_fill(0, out[channel], num_frames);
     }
 
     for (int out_channel = 0; out_channel < this->channels; out_channel++)
@@ -52,10 +55,7 @@ void ChannelMixer::process(Buffer &out, int num_frames)
             }
             channel_amp = channel_amp * this->amplitude_compensation_level;
 
-            for (int frame = 0; frame < num_frames; frame++)
-            {
-                out[out_channel][frame] += channel_amp * this->input->out[in_channel][frame];
-            }
+            signalflow_vector_mac(this->input->out[in_channel], channel_amp, out[out_channel], num_frames);
         }
     }
 }
@@ -77,4 +77,22 @@ void ChannelMixer::update_channels()
                      this->num_output_channels, this->num_input_channels);
 }
 
+void ChannelMixer::infer_channels(const std::vector<int> &input_channels,
+                                  int &num_input_channels,
+                                  int &num_output_channels)
+{
+    auto input_name = std::find(this->input_names.begin(), this->input_names.end(), "input");
+    num_input_channels = input_channels[input_name - this->input_names.begin()];
+    num_output_channels = this->channels;
+}
+
+void ChannelMixer::copy_to(Node *node)
+{
+    ChannelMixer *mixer = (ChannelMixer *) node;
+    mixer->channels = this->channels;
+    mixer->amplitude_compensation = this->amplitude_compensation;
+    mixer->amplitude_compensation_level = this->amplitude_compensation_level;
+    this->Node::copy_to(node);
+}
+
 }
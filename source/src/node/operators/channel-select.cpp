@@ -1,4 +1,5 @@
 #include "signalflow/node/operators/channel-select.h"
+#include "signalflow/core/vector.h"
 
 namespace signalflow
 {
@@ -21,7 +22,7 @@ void ChannelSelect::process(Buffer &out, int num_frames)
     int output_channel = 0;
     for (int channel = this->offset; channel < this->maximum; channel += this->step)
     {
-        memcpy(out[output_channel], input->out[channel], num_frames * sizeof(sample));
+        signalflow_vector_copy(input->out[channel], out[output_channel], num_frames);
         output_channel++;
     }
 }
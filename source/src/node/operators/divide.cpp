@@ -1,4 +1,5 @@
 #include "signalflow/node/operators/divide.h"
+#include "signalflow/core/vector.h"
 
 namespace signalflow
 {
@@ -11,11 +12,16 @@ Divide::Divide(NodeRef a, NodeRef b)
 
 void Divide::process(Buffer &out, int num_frames)
 {
-    for (int frame = 0; frame < num_frames; frame++)
+    this->output_is_constant = input0->get_output_is_constant() && input1->get_output_is_constant();
+    for (int channel = 0; channel < this->num_output_channels; channel++)
     {
-        for (int channel = 0; channel < this->num_output_channels; channel++)
+        if (this->output_is_constant)
         {
-            out[channel][frame] = input0->out[channel][frame] / input1->out[channel][frame];
+            signalflow_vector_fill(input0->out[channel][0] / input1->out[channel][0], out[channel], num_frames);
+        }
+        else
+        {
+            signalflow_vector_divide(input0->out[channel], input1->out[channel], out[channel], num_frames);
         }
     }
 }
@@ -1,4 +1,5 @@
 #include "signalflow/node/operators/multiply.h"
+#include "signalflow/core/vector.h"
 
 namespace signalflow
 {
@@ -11,15 +12,37 @@ Multiply::Multiply(NodeRef a, NodeRef b)
 
 void Multiply::process(Buffer &out, int num_frames)
 {
+    /*--------------------------------------------------------------------------------
+     * Multiplying by a constant (for example, a fixed gain) only needs to
+     * read one buffer.
+     *-------------------------------------------------------------------------------*/
+    bool input0_is_constant = input0->get_output_is_constant();
+    bool input1_is_constant = input1->get_output_is_constant();
+    this->output_is_constant = input0_is_constant && input1_is_constant;
     for (int channel = 0; channel < this->num_output_channels; channel++)
     {
-#ifdef __APPLE__
-        vDSP_vmul(input0->out[channel], 1, input1->out[channel], 1, out[channel], 1, num_frames);
-#else
-        for (int frame = 0; frame < num_frames; frame++)
-            out[channel][frame] = input0->out[channel][frame] * input1->out[channel][frame];
-#endif
+        if (this->output_is_constant)
+        {
+            signalflow_vector_fill(input0->out[channel][0] * input1->out[channel][0], out[channel], num_frames);
+        }
+        else if (input1_is_constant)
+        {
+            signalflow_vector_scale(input0->out[channel], input1->out[channel][0], out[channel], num_frames);
+        }
+        else if (input0_is_constant)
+        {
+            signalflow_vector_scale(input1->out[channel], input0->out[channel][0], out[channel], num_frames);
+        }
+        else
+        {
+            signalflow_vector_multiply(input0->out[channel], input1->out[channel], out[channel], num_frames);
+        }
     }
 }
 
+bool Multiply::get_output_will_be_silent()
+{
+    return input0->get_output_is_silent() || input1->get_output_is_silent();
+}
+
 }
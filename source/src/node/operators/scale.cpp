@@ -1,4 +1,5 @@
 #include "signalflow/node/operators/scale.h"
+#include "signalflow/core/vector.h"
 
 namespace signalflow
 {
@@ -16,6 +17,34 @@ ScaleLinExp::ScaleLinExp(NodeRef input, NodeRef a, NodeRef b, NodeRef c, NodeRef
 
 void ScaleLinExp::process(Buffer &out, int num_frames)
 {
+    /*--------------------------------------------------------------------------------
+     * The ranges are almost always fixed, in which case read them once per
+     * block. If the input is also fixed, so is the output.
+     *-------------------------------------------------------------------------------*/
+    if (a->get_output_is_constant() && b->get_output_is_constant() && c->get_output_is_constant() && d->get_output_is_constant())
+    {
+        this->output_is_constant = input->get_output_is_constant();
+        for (int channel = 0; channel < this->num_output_channels; channel++)
+        {
+            float a = this->a->out[channel][0];
+            float range = this->b->out[channel][0] - a;
+            float c = this->c->out[channel][0];
+            float ratio = this->d->out[channel][0] / c;
+            if (this->output_is_constant)
+            {
+                float norm = (input->out[channel][0] - a) / range;
+                signalflow_vector_fill(powf(ratio, norm) * c, out[channel], num_frames);
+                continue;
+            }
+            for (int frame = 0; frame < num_frames; frame++)
+            {
+                float norm = (input->out[channel][frame] - a) / range;
+                out[channel][frame] = powf(ratio, norm) * c;
+            }
+        }
+        return;
+    }
+
     for (int frame = 0; frame < num_frames; frame++)
     {
         for (int channel = 0; channel < this->num_output_channels; channel++)
@@ -39,6 +68,30 @@ ScaleLinLin::ScaleLinLin(NodeRef input, NodeRef a, NodeRef b, NodeRef c, NodeRef
 
 void ScaleLinLin::process(Buffer &out, int num_frames)
 {
+    if (a->get_output_is_constant() && b->get_output_is_constant() && c->get_output_is_constant() && d->get_output_is_constant())
+    {
+        this->output_is_constant = input->get_output_is_constant();
+        for (int channel = 0; channel < this->num_output_channels; channel++)
+        {
+            float a = this->a->out[channel][0];
+            float range = this->b->out[channel][0] - a;
+            float c = this->c->out[channel][0];
+            float span = this->d->out[channel][0] - c;
+            if (this->output_is_constant)
+            {
+                float norm = (input->out[channel][0] - a) / range;
+                signalflow_vector_fill(c + span * norm, out[channel], num_frames);
+                continue;
+            }
+            for (int frame = 0; frame < num_frames; frame++)
+            {
+                float norm = (input->out[channel][frame] - a) / range;
+                out[channel][frame] = c + span * norm;
+            }
+        }
+        return;
+    }
+
     for (int frame = 0; frame < num_frames; frame++)
     {
         for (int channel = 0; channel < this->num_output_channels; channel++)
@@ -1,4 +1,5 @@
 #include "signalflow/node/operators/subtract.h"
+#include "signalflow/core/vector.h"
 
 namespace signalflow
 {
@@ -11,17 +12,23 @@ Subtract::Subtract(NodeRef a, NodeRef b)
 
 void Subtract::process(Buffer &out, int num_frames)
 {
+    this->output_is_constant = input0->get_output_is_constant() && input1->get_output_is_constant();
     for (int channel = 0; channel < this->num_output_channels; channel++)
     {
-#ifdef __APPLE__
-        vDSP_vsub(input1->out[channel], 1, input0->out[channel], 1, out[channel], 1, num_frames);
-#else
-        for (int frame = 0; frame < num_frames; frame++)
+        if (this->output_is_constant)
         {
-            out[channel][frame] = input0->out[channel][frame] - input1->out[channel][frame];
+            signalflow_vector_fill(input0->out[channel][0] - input1->out[channel][0], out[channel], num_frames);
+        }
+        else
+        {
+            signalflow_vector_subtract(input0->out[channel], input1->out[channel], out[channel], num_frames);
         }
-#endif
     }
 }
 
+bool Subtract::get_output_will_be_silent()
+{
+    return input0->get_output_is_silent() && input1->get_output_is_silent();
+}
+
 }
@@ -1,6 +1,7 @@
 #include "signalflow/core/core.h"
 #include "signalflow/node/operators/sum.h"
 #include "signalflow/node/oscillators/constant.h"
+#include "signalflow/core/vector.h"
 
 namespace signalflow
 {
@@ -51,12 +52,13 @@ void Sum::process(Buffer &out, int num_frames)
 {
     for (int channel = 0; channel < this->num_output_channels; channel++)
     {
-        memset(this->out[channel], 0, sizeof(sample) * num_frames);
-        for (NodeRef input : this->input_list)
+        signalflow_vector_fill(0, this->out[channel], num_frames);
+        for (NodeRef *slot : this->input_slots)
         {
-            for (int frame = 0; frame < num_frames; frame++)
+            const NodeRef &input = *slot;
+            if (input)
             {
-                this->out[channel][frame] += input->out[channel][frame];
+                signalflow_vector_add(this->out[channel], input->out[channel], this->out[channel], num_frames);
             }
         }
     }
@@ -64,6 +66,24 @@ void Sum::process(Buffer &out, int num_frames)
 
 void Sum::add_input(NodeRef input)
 {
+    if (this->post_add_input(input))
+    {
+        return;
+    }
+
+    /*------------------------------------------------------------------------
+     * Reuse the slot of an input that has been removed, if there is one.
+     *-----------------------------------------------------------------------*/
+    for (int index = 0; index < (int) this->input_slots.size(); index++)
+    {
+        if (!*this->input_slots[index])
+        {
+            *this->input_slots[index] = input;
+            this->Node::create_input(this->input_names[index], *this->input_slots[index]);
+            return;
+        }
+    }
+
     this->input_list.push_back(input);
     std::string input_name = "input" + std::to_string(this->input_index++);
     this->Node::create_input(input_name, input_list.back());
@@ -71,11 +91,34 @@ void Sum::add_input(NodeRef input)
 
 void Sum::remove_input(NodeRef input)
 {
-    this->input_list.remove(input);
+    if (this->post_remove_input(input))
+    {
+        return;
+    }
+
+    /*------------------------------------------------------------------------
+     * Clear the input's slot rather than destroying it, so that removing an
+     * input on the audio thread doesn't free memory.
+     *-----------------------------------------------------------------------*/
+    for (int index = 0; index < (int) this->input_slots.size(); index++)
+    {
+        if (*this->input_slots[index] == input)
+        {
+            this->input_slots[index]->reset();
+            input->remove_output(this, this->input_names[index]);
+            this->invalidate_graph_schedule();
+            return;
+        }
+    }
 }
 
 void Sum::set_input(std::string name, const NodeRef &node)
 {
+    if (this->post_set_input(name, node))
+    {
+        return;
+    }
+
     if (this->inputs.find(name) == this->inputs.end())
     {
         this->input_list.push_back(node);
@@ -85,4 +128,31 @@ void Sum::set_input(std::string name, const NodeRef &node)
     this->Node::set_input(name, node);
 }
 
+void Sum::prepare_set_input(const std::string &name, const NodeRef &input, NodeInputChange &change)
+{
+    this->prepare_input_slot(name, change);
+    this->Node::prepare_set_input(name, input, change);
+}
+
+void Sum::apply_set_input(const std::string &name, const NodeRef &input, NodeInputChange &change)
+{
+    this->apply_input_slot(name, this->input_list, change);
+    this->Node::apply_set_input(name, input, change);
+}
+
+void Sum::copy_to(Node *node)
+{
+    /*------------------------------------------------------------------------
+     * Create the copy's input slots, unconnected, with the same names.
+     *-----------------------------------------------------------------------*/
+    Sum *sum = (Sum *) node;
+    for (auto &input_name : this->input_names)
+    {
+        sum->input_list.push_back(nullptr);
+        sum->Node::create_input(input_name, sum->input_list.back());
+    }
+    sum->input_index = this->input_index;
+    this->Node::copy_to(node);
+}
+
 }
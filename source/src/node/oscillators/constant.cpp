@@ -1,4 +1,5 @@
 #include "signalflow/node/oscillators/constant.h"
+#include "signalflow/core/vector.h"
 
 namespace signalflow
 {
@@ -7,7 +8,13 @@ Constant::Constant(sample value)
     : Node()
 {
     this->value = value;
+    this->filled_value = value;
+    this->filled_num_frames = 0;
+    this->ramp_target = value;
+    this->ramp_step = 0.0;
+    this->ramp_frames_remaining = 0;
     this->name = "constant";
+    this->type = SIGNALFLOW_NODE_TYPE_CONSTANT;
     this->set_channels(0, 1);
 
     /*--------------------------------------------------------------------------------
@@ -18,20 +25,93 @@ Constant::Constant(sample value)
      *
      * node.probability = 0.5    # creates a Constant(0.5)
      * node.trigger("generate")  # examines the Constant's ->out property
+     *
+     * For the same reason, its output buffer is never shared with other nodes.
      *--------------------------------------------------------------------------------*/
     this->process(this->out, this->output_buffer_length);
+    this->pin_output_buffer();
+}
+
+void Constant::alloc()
+{
+    /*--------------------------------------------------------------------------------
+     * Reallocating the output buffer clears it, so re-render the value so that
+     * it can still be queried immediately.
+     *--------------------------------------------------------------------------------*/
+    this->filled_num_frames = 0;
+    if (this->out.get_num_channels() > 0)
+    {
+        this->process(this->out, this->output_buffer_length);
+    }
 }
 
 void Constant::process(Buffer &out, int num_frames)
 {
-#if __APPLE__
-    vDSP_vfill(&(this->value), out[0], 1, num_frames);
-#else
-    for (int frame = 0; frame < num_frames; frame++)
+    if (this->ramp_frames_remaining > 0)
+    {
+        for (int frame = 0; frame < num_frames; frame++)
+        {
+            out[0][frame] = this->value;
+            if (this->ramp_frames_remaining > 0)
+            {
+                this->ramp_frames_remaining--;
+                this->value = this->ramp_frames_remaining ? this->value + this->ramp_step : this->ramp_target;
+            }
+        }
+        if (&out == &this->out)
+        {
+            this->filled_num_frames = 0;
+        }
+        return;
+    }
+
+    /*--------------------------------------------------------------------------------
+     * Consumers with a constant-input fast path read only the first sample,
+     * but others still read the whole buffer, so it must remain populated.
+     * Upmixed channels are rewritten by the AudioGraph each block.
+     *--------------------------------------------------------------------------------*/
+    if (&out != &this->out || this->value != this->filled_value || num_frames > this->filled_num_frames)
+    {
+        signalflow_vector_fill(this->value, out[0], num_frames);
+        if (&out == &this->out)
+        {
+            this->filled_value = this->value;
+            this->filled_num_frames = num_frames;
+        }
+    }
+    this->output_is_constant = true;
+}
+
+void Constant::copy_to(Node *node)
+{
+    Constant *constant = (Constant *) node;
+    constant->value = this->value;
+    this->Node::copy_to(node);
+    constant->alloc();
+}
+
+bool Constant::get_output_will_be_silent()
+{
+    /*--------------------------------------------------------------------------------
+     * Only once zero has been rendered, so that filled_value stays in sync with
+     * the contents of the buffer.
+     *--------------------------------------------------------------------------------*/
+    return this->value == 0 && this->filled_value == 0 && this->ramp_frames_remaining == 0;
+}
+
+void Constant::ramp_to(float target, int num_frames)
+{
+    if (num_frames > 0)
+    {
+        this->ramp_target = target;
+        this->ramp_step = (target - this->value) / num_frames;
+        this->ramp_frames_remaining = num_frames;
+    }
+    else
     {
-        out[0][frame] = this->value;
+        this->value = target;
+        this->ramp_frames_remaining = 0;
     }
-#endif
 }
 
 }
@@ -18,7 +18,7 @@ Impulse::Impulse(NodeRef frequency)
 
 void Impulse::alloc()
 {
-    this->steps_remaining.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->steps_remaining);
 }
 
 void Impulse::process(Buffer &out, int num_frames)
@@ -16,7 +16,7 @@ LFO::LFO(NodeRef frequency, NodeRef min, NodeRef max)
 
 void LFO::alloc()
 {
-    this->phase.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->phase);
 }
 
 }
@@ -19,10 +19,10 @@ Line::Line(NodeRef from, NodeRef to, NodeRef time, NodeRef loop)
 
 void Line::alloc()
 {
-    this->value.resize(this->num_output_channels_allocated);
-    this->value_change_per_step.resize(this->num_output_channels_allocated);
-    this->step.resize(this->num_output_channels_allocated);
-    this->duration_samples.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->value);
+    this->resize_channel_state(this->value_change_per_step);
+    this->resize_channel_state(this->step);
+    this->resize_channel_state(this->duration_samples);
 }
 
 void Line::trigger(std::string name, float value)
@@ -16,7 +16,13 @@ SawOscillator::SawOscillator(NodeRef frequency)
 
 void SawOscillator::alloc()
 {
-    this->phase.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->phase);
+}
+
+void SawOscillator::reset()
+{
+    this->Node::reset();
+    std::fill(this->phase.begin(), this->phase.end(), 0.0);
 }
 
 void SawOscillator::process(Buffer &out, int num_frames)
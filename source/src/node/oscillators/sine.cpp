@@ -30,13 +30,36 @@ SineOscillator::SineOscillator(NodeRef frequency)
 
 void SineOscillator::alloc()
 {
-    this->phase.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->phase);
+}
+
+void SineOscillator::reset()
+{
+    this->Node::reset();
+    std::fill(this->phase.begin(), this->phase.end(), 0.0);
 }
 
 void SineOscillator::process(Buffer &out, int num_frames)
 {
     for (int channel = 0; channel < this->num_output_channels; channel++)
     {
+        if (this->frequency->get_output_is_constant())
+        {
+            /*--------------------------------------------------------------------------------
+             * Fixed frequency: compute the phase increment once per block.
+             *-------------------------------------------------------------------------------*/
+            float increment = this->frequency->out[channel][0] / this->graph->get_sample_rate();
+            for (int frame = 0; frame < num_frames; frame++)
+            {
+                out[channel][frame] = sin(this->phase[channel] * M_PI * 2.0);
+                this->phase[channel] += increment;
+
+                while (this->phase[channel] > 1.0)
+                    this->phase[channel] -= 1.0;
+            }
+            continue;
+        }
+
         for (int frame = 0; frame < num_frames; frame++)
         {
             float freq = this->frequency->out[channel][frame];
@@ -19,7 +19,13 @@ SquareOscillator::SquareOscillator(NodeRef frequency, NodeRef width)
 
 void SquareOscillator::alloc()
 {
-    this->phase.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->phase);
+}
+
+void SquareOscillator::reset()
+{
+    this->Node::reset();
+    std::fill(this->phase.begin(), this->phase.end(), 0.0);
 }
 
 void SquareOscillator::process(Buffer &out, int num_frames)
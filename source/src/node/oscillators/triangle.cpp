@@ -16,7 +16,13 @@ TriangleOscillator::TriangleOscillator(NodeRef frequency)
 
 void TriangleOscillator::alloc()
 {
-    this->phase.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->phase);
+}
+
+void TriangleOscillator::reset()
+{
+    this->Node::reset();
+    std::fill(this->phase.begin(), this->phase.end(), 0.0);
 }
 
 void TriangleOscillator::process(Buffer &out, int num_frames)
@@ -22,16 +22,23 @@ Wavetable::Wavetable(BufferRef buffer, NodeRef frequency, NodeRef phase, NodeRef
 
 void Wavetable::alloc()
 {
-    this->current_phase.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->current_phase);
 }
 
 void Wavetable::process(Buffer &out, int num_frames)
 {
     /*--------------------------------------------------------------------------------
-     * If buffer is null or empty, don't try to process.
+     * If buffer is null or empty, don't try to process. Output silence, as
+     * the output buffer may be shared scratch space.
      *--------------------------------------------------------------------------------*/
     if (!this->buffer || !this->buffer->get_num_frames())
+    {
+        for (int channel = 0; channel < this->num_output_channels; channel++)
+        {
+            memset(out[channel], 0, num_frames * sizeof(sample));
+        }
         return;
+    }
 
     for (int channel = 0; channel < this->num_output_channels; channel++)
     {
@@ -84,7 +91,7 @@ Wavetable2D::Wavetable2D(BufferRef2D buffer, NodeRef frequency, NodeRef crossfad
 
 void Wavetable2D::alloc()
 {
-    this->current_phase.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->current_phase);
 }
 
 void Wavetable2D::process(Buffer &out, int num_frames)
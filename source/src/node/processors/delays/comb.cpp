@@ -7,7 +7,7 @@ namespace signalflow
 {
 
 CombDelay::CombDelay(NodeRef input, NodeRef delaytime, NodeRef feedback, float maxdelaytime)
-    : UnaryOpNode(input), delaytime(delaytime), feedback(feedback)
+    : UnaryOpNode(input), delaytime(delaytime), feedback(feedback), maxdelaytime(maxdelaytime)
 {
     this->name = "comb-delay";
     this->create_input("delay_time", this->delaytime);
@@ -16,7 +16,7 @@ CombDelay::CombDelay(NodeRef input, NodeRef delaytime, NodeRef feedback, float m
     SIGNALFLOW_CHECK_GRAPH();
     for (int i = 0; i < SIGNALFLOW_MAX_CHANNELS; i++)
     {
-        buffers.push_back(new SampleRingBuffer(maxdelaytime * this->graph->get_sample_rate()));
+        buffers.push_back(new SampleRingBuffer(this->maxdelaytime * this->graph->get_sample_rate()));
     }
 }
 
@@ -28,6 +28,29 @@ CombDelay::~CombDelay()
     }
 }
 
+void CombDelay::copy_to(Node *node)
+{
+    /*------------------------------------------------------------------------
+     * The delay lines are allocated by the constructor at the default
+     * maxdelaytime, so the copy's are reallocated to match this one.
+     *-----------------------------------------------------------------------*/
+    CombDelay *delay = (CombDelay *) node;
+    if (delay->maxdelaytime != this->maxdelaytime)
+    {
+        for (auto buffer : delay->buffers)
+        {
+            delete buffer;
+        }
+        delay->buffers.clear();
+        delay->maxdelaytime = this->maxdelaytime;
+        for (int i = 0; i < SIGNALFLOW_MAX_CHANNELS; i++)
+        {
+            delay->buffers.push_back(new SampleRingBuffer(delay->maxdelaytime * delay->graph->get_sample_rate()));
+        }
+    }
+    this->Node::copy_to(node);
+}
+
 void CombDelay::process(Buffer &out, int num_frames)
 {
     SIGNALFLOW_CHECK_GRAPH();
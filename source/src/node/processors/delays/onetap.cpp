@@ -6,7 +6,7 @@ namespace signalflow
 {
 
 OneTapDelay::OneTapDelay(NodeRef input, NodeRef delaytime, float maxdelaytime)
-    : UnaryOpNode(input), delaytime(delaytime)
+    : UnaryOpNode(input), delaytime(delaytime), maxdelaytime(maxdelaytime)
 {
     this->name = "one-tap-delay";
     this->create_input("delay_time", this->delaytime);
@@ -14,7 +14,7 @@ OneTapDelay::OneTapDelay(NodeRef input, NodeRef delaytime, float maxdelaytime)
     SIGNALFLOW_CHECK_GRAPH();
     for (int i = 0; i < SIGNALFLOW_MAX_CHANNELS; i++)
     {
-        buffers.push_back(new SampleRingBuffer(maxdelaytime * this->graph->get_sample_rate()));
+        buffers.push_back(new SampleRingBuffer(this->maxdelaytime * this->graph->get_sample_rate()));
     }
 }
 
@@ -26,6 +26,29 @@ OneTapDelay::~OneTapDelay()
     }
 }
 
+void OneTapDelay::copy_to(Node *node)
+{
+    /*------------------------------------------------------------------------
+     * The delay lines are allocated by the constructor at the default
+     * maxdelaytime, so the copy's are reallocated to match this one.
+     *-----------------------------------------------------------------------*/
+    OneTapDelay *delay = (OneTapDelay *) node;
+    if (delay->maxdelaytime != this->maxdelaytime)
+    {
+        for (auto buffer : delay->buffers)
+        {
+            delete buffer;
+        }
+        delay->buffers.clear();
+        delay->maxdelaytime = this->maxdelaytime;
+        for (int i = 0; i < SIGNALFLOW_MAX_CHANNELS; i++)
+        {
+            delay->buffers.push_back(new SampleRingBuffer(delay->maxdelaytime * delay->graph->get_sample_rate()));
+        }
+    }
+    this->Node::copy_to(node);
+}
+
 void OneTapDelay::process(Buffer &out, int num_frames)
 {
     SIGNALFLOW_CHECK_GRAPH();
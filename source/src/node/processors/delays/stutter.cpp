@@ -14,21 +14,20 @@ Stutter::Stutter(NodeRef input, NodeRef stutter_time, NodeRef stutter_count, Nod
     this->create_input("stutter_time", this->stutter_time);
     this->create_input("stutter_count", this->stutter_count);
     this->create_input("clock", this->clock);
+
+    for (int i = 0; i < SIGNALFLOW_MAX_CHANNELS; i++)
+    {
+        buffers.push_back(new SampleRingBuffer(this->max_stutter_time * this->graph->get_sample_rate()));
+    }
     this->alloc();
 }
 
 void Stutter::alloc()
 {
-    this->stutter_index.resize(this->num_output_channels_allocated);
-    this->stutter_sample_buffer_offset.resize(this->num_output_channels_allocated);
-    this->stutters_to_do.resize(this->num_output_channels_allocated);
-    this->stutter_samples_remaining.resize(this->num_output_channels_allocated);
-
-    int buffers_to_allocate = this->num_output_channels_allocated - buffers.size();
-    for (int i = 0; i < buffers_to_allocate; i++)
-    {
-        buffers.push_back(new SampleRingBuffer(this->max_stutter_time * this->graph->get_sample_rate()));
-    }
+    this->resize_channel_state(this->stutter_index);
+    this->resize_channel_state(this->stutter_sample_buffer_offset);
+    this->resize_channel_state(this->stutters_to_do);
+    this->resize_channel_state(this->stutter_samples_remaining);
 }
 
 Stutter::~Stutter()
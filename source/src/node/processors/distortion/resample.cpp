@@ -22,7 +22,7 @@ Resample::Resample(NodeRef input, NodeRef sample_rate, NodeRef bit_rate)
 
 void Resample::alloc()
 {
-    this->sample_last.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->sample_last);
 }
 
 void Resample::process(Buffer &out, int num_frames)
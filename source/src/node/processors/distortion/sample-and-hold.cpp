@@ -13,7 +13,7 @@ SampleAndHold::SampleAndHold(NodeRef input, NodeRef clock)
 
 void SampleAndHold::alloc()
 {
-    this->values.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->values);
 }
 
 void SampleAndHold::process(Buffer &out, int num_frames)
@@ -29,13 +29,16 @@ BiquadFilter::BiquadFilter(NodeRef input,
 
 void BiquadFilter::alloc()
 {
-    this->a0.resize(this->num_output_channels_allocated, 1.0);
-    this->a1.resize(this->num_output_channels_allocated, 0.0);
-    this->a2.resize(this->num_output_channels_allocated, 0.0);
-    this->b1.resize(this->num_output_channels_allocated, 0.0);
-    this->b2.resize(this->num_output_channels_allocated, 0.0);
-    this->z1.resize(this->num_output_channels_allocated, 0.0);
-    this->z2.resize(this->num_output_channels_allocated, 0.0);
+    this->resize_channel_state(this->a0, 1.0);
+    this->resize_channel_state(this->a1, 0.0);
+    this->resize_channel_state(this->a2, 0.0);
+    this->resize_channel_state(this->b1, 0.0);
+    this->resize_channel_state(this->b2, 0.0);
+    this->resize_channel_state(this->z1, 0.0);
+    this->resize_channel_state(this->z2, 0.0);
+    this->resize_channel_state(this->last_cutoff, NAN);
+    this->resize_channel_state(this->last_resonance, NAN);
+    this->resize_channel_state(this->last_peak_gain, NAN);
 }
 
 void BiquadFilter::process(Buffer &out, int num_frames)
@@ -54,15 +57,35 @@ void BiquadFilter::process(Buffer &out, int num_frames)
     }
 }
 
+void BiquadFilter::copy_to(Node *node)
+{
+    BiquadFilter *filter = (BiquadFilter *) node;
+    filter->filter_type = this->filter_type;
+    this->Node::copy_to(node);
+}
+
 void BiquadFilter::_recalculate()
 {
     for (int channel = 0; channel < num_output_channels; channel++)
     {
-        float norm;
-        float V = powf(10.0, fabs(this->peak_gain->out[channel][0]) / 20.0);
-        float K = tan(M_PI * this->cutoff->out[channel][0] / this->graph->get_sample_rate());
+        /*--------------------------------------------------------------------------------
+         * Parameters are typically constant, in which case the coefficients
+         * only need calculating once.
+         *--------------------------------------------------------------------------------*/
+        float cutoff = this->cutoff->out[channel][0];
         float Q = this->resonance->out[channel][0];
         float peak_gain = this->peak_gain->out[channel][0];
+        if (cutoff == last_cutoff[channel] && Q == last_resonance[channel] && peak_gain == last_peak_gain[channel])
+        {
+            continue;
+        }
+        last_cutoff[channel] = cutoff;
+        last_resonance[channel] = Q;
+        last_peak_gain[channel] = peak_gain;
+
+        float norm;
+        float V = powf(10.0, fabs(peak_gain) / 20.0);
+        float K = tan(M_PI * cutoff / this->graph->get_sample_rate());
 
         switch (this->filter_type)
         {
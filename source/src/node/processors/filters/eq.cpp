@@ -23,17 +23,17 @@ EQ::EQ(NodeRef input, NodeRef low_gain, NodeRef mid_gain, NodeRef high_gain,
 
 void EQ::alloc()
 {
-    this->f1p0.resize(this->num_output_channels_allocated);
-    this->f1p1.resize(this->num_output_channels_allocated);
-    this->f1p2.resize(this->num_output_channels_allocated);
-    this->f1p3.resize(this->num_output_channels_allocated);
-    this->f2p0.resize(this->num_output_channels_allocated);
-    this->f2p1.resize(this->num_output_channels_allocated);
-    this->f2p2.resize(this->num_output_channels_allocated);
-    this->f2p3.resize(this->num_output_channels_allocated);
-    this->sdm1.resize(this->num_output_channels_allocated);
-    this->sdm2.resize(this->num_output_channels_allocated);
-    this->sdm3.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->f1p0);
+    this->resize_channel_state(this->f1p1);
+    this->resize_channel_state(this->f1p2);
+    this->resize_channel_state(this->f1p3);
+    this->resize_channel_state(this->f2p0);
+    this->resize_channel_state(this->f2p1);
+    this->resize_channel_state(this->f2p2);
+    this->resize_channel_state(this->f2p3);
+    this->resize_channel_state(this->sdm1);
+    this->resize_channel_state(this->sdm2);
+    this->resize_channel_state(this->sdm3);
 }
 
 void EQ::process(Buffer &out, int num_frames)
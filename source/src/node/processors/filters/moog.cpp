@@ -18,14 +18,14 @@ MoogVCF::MoogVCF(NodeRef input, NodeRef cutoff, NodeRef resonance)
 
 void MoogVCF::alloc()
 {
-    this->out1.resize(this->num_output_channels_allocated);
-    this->out2.resize(this->num_output_channels_allocated);
-    this->out3.resize(this->num_output_channels_allocated);
-    this->out4.resize(this->num_output_channels_allocated);
-    this->in1.resize(this->num_output_channels_allocated);
-    this->in2.resize(this->num_output_channels_allocated);
-    this->in3.resize(this->num_output_channels_allocated);
-    this->in4.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->out1);
+    this->resize_channel_state(this->out2);
+    this->resize_channel_state(this->out3);
+    this->resize_channel_state(this->out4);
+    this->resize_channel_state(this->in1);
+    this->resize_channel_state(this->in2);
+    this->resize_channel_state(this->in3);
+    this->resize_channel_state(this->in4);
 }
 
 void MoogVCF::process(Buffer &out, int num_frames)
@@ -70,13 +70,13 @@ SVFFilter::SVFFilter(NodeRef input,
 
 void SVFFilter::alloc()
 {
-    this->ic1eq.resize(this->num_output_channels_allocated, 0.0);
-    this->ic2eq.resize(this->num_output_channels_allocated, 0.0);
-    this->g.resize(this->num_output_channels_allocated, 0.0);
-    this->k.resize(this->num_output_channels_allocated, 0.0);
-    this->a1.resize(this->num_output_channels_allocated, 0.0);
-    this->a2.resize(this->num_output_channels_allocated, 0.0);
-    this->a3.resize(this->num_output_channels_allocated, 0.0);
+    this->resize_channel_state(this->ic1eq, 0.0);
+    this->resize_channel_state(this->ic2eq, 0.0);
+    this->resize_channel_state(this->g, 0.0);
+    this->resize_channel_state(this->k, 0.0);
+    this->resize_channel_state(this->a1, 0.0);
+    this->resize_channel_state(this->a2, 0.0);
+    this->resize_channel_state(this->a3, 0.0);
 }
 
 void SVFFilter::process(Buffer &out, int num_frames)
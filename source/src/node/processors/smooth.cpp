@@ -13,13 +13,24 @@ Smooth::Smooth(NodeRef input, NodeRef smooth)
 
 void Smooth::alloc()
 {
-    this->values.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->values);
 }
 
 void Smooth::process(Buffer &out, int num_frames)
 {
     for (int channel = 0; channel < this->num_output_channels; channel++)
     {
+        if (smooth->get_output_is_constant())
+        {
+            float coefficient = smooth->out[channel][0];
+            for (int frame = 0; frame < num_frames; frame++)
+            {
+                values[channel] = (coefficient * values[channel]) + ((1.0 - coefficient) * input->out[channel][frame]);
+                out[channel][frame] = values[channel];
+            }
+            continue;
+        }
+
         for (int frame = 0; frame < num_frames; frame++)
         {
             values[channel] = (smooth->out[channel][frame] * values[channel]) + ((1.0 - smooth->out[channel][frame]) * input->out[channel][frame]);
@@ -2,6 +2,7 @@
 #include "signalflow/patch/patch-spec.h"
 #include "signalflow/patch/patch.h"
 
+#include <algorithm>
 #include <stdlib.h>
 
 namespace signalflow
@@ -38,4 +39,28 @@ Node *NodeRegistry::create(std::string name)
     return node;
 }
 
+std::function<Node *()> NodeRegistry::get_factory(std::string name)
+{
+    auto factory = registry->classes.find(name);
+    if (factory == registry->classes.end() || !factory->second)
+    {
+        throw std::runtime_error("Could not instantiate Node (unknown type: " + name + ")");
+    }
+    return factory->second;
+}
+
+std::vector<std::string> NodeRegistry::get_node_names()
+{
+    std::vector<std::string> names;
+    for (auto pair : registry->classes)
+    {
+        if (pair.second)
+        {
+            names.push_back(pair.first);
+        }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
 }
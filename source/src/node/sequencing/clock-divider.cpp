@@ -16,7 +16,7 @@ ClockDivider::ClockDivider(NodeRef clock, NodeRef factor)
 
 void ClockDivider::alloc()
 {
-    this->counter.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->counter);
 }
 
 void ClockDivider::trigger(std::string name, float value)
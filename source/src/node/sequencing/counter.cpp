@@ -17,7 +17,7 @@ Counter::Counter(NodeRef clock, NodeRef min, NodeRef max)
 
 void Counter::alloc()
 {
-    this->counter.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->counter);
 }
 
 void Counter::trigger(std::string name, float value)
@@ -15,7 +15,7 @@ FlipFlop::FlipFlop(NodeRef clock)
 
 void FlipFlop::alloc()
 {
-    this->value.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->value);
 }
 
 void FlipFlop::trigger(std::string name, float value)
@@ -18,7 +18,7 @@ ImpulseSequence::ImpulseSequence(std::string sequence, NodeRef clock)
 
 void ImpulseSequence::alloc()
 {
-    this->position.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->position);
 }
 
 void ImpulseSequence::trigger(std::string name, float value)
@@ -29,6 +29,13 @@ void ImpulseSequence::trigger(std::string name, float value)
     }
 }
 
+void ImpulseSequence::copy_to(Node *node)
+{
+    ImpulseSequence *sequence = (ImpulseSequence *) node;
+    sequence->sequence = this->sequence;
+    this->Node::copy_to(node);
+}
+
 void ImpulseSequence::process(Buffer &out, int num_frames)
 {
     for (int channel = 0; channel < this->num_output_channels; channel++)
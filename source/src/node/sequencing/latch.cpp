@@ -16,7 +16,7 @@ Latch::Latch(NodeRef set, NodeRef reset)
 
 void Latch::alloc()
 {
-    this->value.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->value);
 }
 
 void Latch::trigger(std::string name, float value)
@@ -15,8 +15,8 @@ Logistic::Logistic(NodeRef chaos, NodeRef frequency)
 
 void Logistic::alloc()
 {
-    this->value.resize(this->num_output_channels_allocated, 0.5);
-    this->steps_remaining.resize(this->num_output_channels_allocated, 0);
+    this->resize_channel_state(this->value, 0.5);
+    this->resize_channel_state(this->steps_remaining, 0);
 }
 
 void Logistic::process(Buffer &out, int num_frames)
@@ -3,6 +3,7 @@
 #include "signalflow/core/graph.h"
 #include "signalflow/core/random.h"
 
+#include <algorithm>
 #include <math.h>
 
 namespace signalflow
@@ -31,8 +32,13 @@ PinkNoise::PinkNoise(float low_cutoff, float high_cutoff, NodeRef reset)
 
 void PinkNoise::alloc()
 {
-    this->value.resize(this->num_output_channels_allocated, std::vector<float>(this->num_octaves, std::numeric_limits<float>::max()));
-    this->steps_remaining.resize(this->num_output_channels_allocated, std::vector<int>(this->num_octaves));
+    /*--------------------------------------------------------------------------------
+     * Each channel's state is itself a vector, so can't be added on the audio
+     * thread without allocating. Allocate state for every channel up front.
+     *--------------------------------------------------------------------------------*/
+    int num_channels = std::max(this->num_output_channels_allocated, SIGNALFLOW_MAX_CHANNELS);
+    this->value.resize(num_channels, std::vector<float>(this->num_octaves, std::numeric_limits<float>::max()));
+    this->steps_remaining.resize(num_channels, std::vector<int>(this->num_octaves));
 }
 
 void PinkNoise::process(Buffer &out, int num_frames)
@@ -16,7 +16,7 @@ RandomBrownian::RandomBrownian(NodeRef min, NodeRef max, NodeRef delta, NodeRef
 
 void RandomBrownian::alloc()
 {
-    this->value.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->value);
 }
 
 void RandomBrownian::trigger(std::string name, float value)
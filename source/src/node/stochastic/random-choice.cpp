@@ -15,7 +15,7 @@ RandomChoice::RandomChoice(std::vector<float> values, NodeRef clock, NodeRef res
 
 void RandomChoice::alloc()
 {
-    this->value.resize(this->num_output_channels_allocated, std::numeric_limits<float>::max());
+    this->resize_channel_state(this->value, std::numeric_limits<float>::max());
 }
 
 void RandomChoice::trigger(std::string name, float value)
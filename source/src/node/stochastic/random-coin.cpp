@@ -16,7 +16,7 @@ RandomCoin::RandomCoin(NodeRef probability, NodeRef clock, NodeRef reset)
 
 void RandomCoin::alloc()
 {
-    this->value.resize(this->num_output_channels_allocated, std::numeric_limits<float>::max());
+    this->resize_channel_state(this->value, std::numeric_limits<float>::max());
 }
 
 void RandomCoin::trigger(std::string name, float value)
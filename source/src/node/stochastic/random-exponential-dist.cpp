@@ -15,7 +15,7 @@ RandomExponentialDist::RandomExponentialDist(NodeRef scale, NodeRef clock, NodeR
 
 void RandomExponentialDist::alloc()
 {
-    this->value.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->value);
 }
 
 void RandomExponentialDist::trigger(std::string name, float value)
@@ -17,7 +17,7 @@ RandomExponential::RandomExponential(NodeRef min, NodeRef max, NodeRef clock, No
 
 void RandomExponential::alloc()
 {
-    this->value.resize(this->num_output_channels_allocated, std::numeric_limits<float>::max());
+    this->resize_channel_state(this->value, std::numeric_limits<float>::max());
 }
 
 void RandomExponential::trigger(std::string name, float value)
@@ -15,7 +15,7 @@ RandomGaussian::RandomGaussian(NodeRef mean, NodeRef sigma, NodeRef clock, NodeR
 
 void RandomGaussian::alloc()
 {
-    this->value.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->value);
 }
 
 void RandomGaussian::trigger(std::string name, float value)
@@ -25,7 +25,7 @@ RandomImpulseSequence::RandomImpulseSequence(NodeRef probability, NodeRef length
 
 void RandomImpulseSequence::alloc()
 {
-    this->position.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->position);
 }
 
 void RandomImpulseSequence::trigger(std::string name, float value)
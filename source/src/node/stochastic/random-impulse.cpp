@@ -22,7 +22,7 @@ RandomImpulse::RandomImpulse(NodeRef frequency, signalflow_event_distribution_t
 
 void RandomImpulse::alloc()
 {
-    this->steps_remaining.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->steps_remaining);
 }
 
 void RandomImpulse::process(Buffer &out, int num_frames)
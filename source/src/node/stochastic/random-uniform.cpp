@@ -17,7 +17,7 @@ RandomUniform::RandomUniform(NodeRef min, NodeRef max, NodeRef clock, NodeRef re
 
 void RandomUniform::alloc()
 {
-    this->value.resize(this->num_output_channels_allocated, std::numeric_limits<float>::max());
+    this->resize_channel_state(this->value, std::numeric_limits<float>::max());
 }
 
 void RandomUniform::trigger(std::string name, float value)
@@ -24,9 +24,9 @@ WhiteNoise::WhiteNoise(NodeRef frequency,
 
 void WhiteNoise::alloc()
 {
-    this->value.resize(this->num_output_channels_allocated, std::numeric_limits<float>::max());
-    this->steps_remaining.resize(this->num_output_channels_allocated);
-    this->step_change.resize(this->num_output_channels_allocated);
+    this->resize_channel_state(this->value, std::numeric_limits<float>::max());
+    this->resize_channel_state(this->steps_remaining);
+    this->resize_channel_state(this->step_change);
 }
 
 void WhiteNoise::process(Buffer &out, int num_frames)
@@ -4,6 +4,7 @@
 #include "signalflow/core/graph.h"
 #include "signalflow/node/oscillators/constant.h"
 #include "signalflow/patch/patch-registry.h"
+#include "signalflow/patch/voice-pool.h"
 
 #include "signalflow/node/operators/add.h"
 #include "signalflow/node/operators/divide.h"
@@ -16,12 +17,11 @@
 namespace signalflow
 {
 
-extern AudioGraph *shared_graph;
-
 Patch::Patch()
 {
-    this->graph = shared_graph;
+    this->graph = AudioGraph::get_shared_graph();
     this->auto_free = false;
+    this->state = SIGNALFLOW_PATCH_STATE_ACTIVE;
 }
 
 Patch::Patch(PatchSpecRef patchspec)
@@ -135,17 +135,28 @@ NodeRef Patch::instantiate(PatchNodeSpec *nodespec)
     return noderef;
 }
 
-void Patch::set_input(std::string name, float value)
+void Patch::set_input(const std::string &name, float value)
 {
-    if (this->inputs[name] == nullptr)
+    auto input = this->inputs.find(name);
+    if (input == this->inputs.end() || input->second == nullptr)
     {
         throw std::runtime_error("Patch has no such parameter: " + name);
     }
-    NodeRef current = this->inputs[name];
-    if (current->name == "constant")
+    NodeRef current = input->second;
+    if (current->type == SIGNALFLOW_NODE_TYPE_CONSTANT)
     {
-        Constant *current_constant = (Constant *) current.get();
-        current_constant->value = value;
+        /*------------------------------------------------------------------------
+         * If the constant is being rendered, set it on the audio thread.
+         *-----------------------------------------------------------------------*/
+        if (current->graph_owned && this->graph && this->graph->get_is_queueing_commands())
+        {
+            this->graph->post_constant_value(current, value);
+        }
+        else
+        {
+            Constant *current_constant = (Constant *) current.get();
+            current_constant->value = value;
+        }
     }
     else
     {
@@ -153,7 +164,7 @@ void Patch::set_input(std::string name, float value)
     }
 }
 
-void Patch::set_input(std::string name, NodeRef value)
+void Patch::set_input(const std::string &name, NodeRef value)
 {
     /*------------------------------------------------------------------------
      * Replace a named input with another node.
@@ -183,9 +194,10 @@ void Patch::set_input(std::string name, NodeRef value)
         throw std::runtime_error("Couldn't find input: " + name);
     }
     this->inputs[name] = value;
+    this->invalidate_clone_plan();
 }
 
-void Patch::set_input(std::string name, BufferRef value)
+void Patch::set_input(const std::string &name, BufferRef value)
 {
     if (this->buffer_inputs[name] == nullptr)
     {
@@ -221,13 +233,175 @@ void Patch::set_auto_free(bool value)
 
 void Patch::node_state_changed(Node *node)
 {
-    if (node->get_state() == SIGNALFLOW_NODE_STATE_STOPPED && this->auto_free)
+    if (node->get_state() == SIGNALFLOW_NODE_STATE_STOPPED)
+    {
+        if (this->voice_pool)
+        {
+            if (this->state != SIGNALFLOW_PATCH_STATE_STOPPED)
+            {
+                this->set_state(SIGNALFLOW_PATCH_STATE_STOPPED);
+                this->voice_pool->voice_stopped(this);
+            }
+        }
+        else if (this->auto_free)
+        {
+            this->set_state(SIGNALFLOW_PATCH_STATE_STOPPED);
+            this->disconnect();
+        }
+    }
+}
+
+void Patch::reset()
+{
+    for (auto &node : this->nodes)
+    {
+        node->reset();
+    }
+    if (this->voice_pool)
+    {
+        this->voice_generation++;
+    }
+    this->set_state(SIGNALFLOW_PATCH_STATE_ACTIVE);
+}
+
+PatchRef Patch::clone()
+{
+    if (this->output == nullptr)
+    {
+        throw std::runtime_error("Patch does not have an output set");
+    }
+
+    /*------------------------------------------------------------------------
+     * The generation is read before building, so that if the plan is
+     * invalidated while it is being built, it is rebuilt by the next call.
+     *-----------------------------------------------------------------------*/
+    std::lock_guard<std::mutex> lock(this->clone_plan_mutex);
+    unsigned long generation = this->clone_plan_generation.load();
+    if (this->clone_plan_built_generation != generation)
+    {
+        this->build_clone_plan();
+        this->clone_plan_built_generation = generation;
+    }
+
+    PatchRef patch = new Patch();
+    std::vector<NodeRef> clones(this->clone_plan.size());
+    for (size_t index = 0; index < this->clone_plan.size(); index++)
+    {
+        signalflow_clone_step_t &step = this->clone_plan[index];
+        if (step.external)
+        {
+            clones[index] = step.external;
+            continue;
+        }
+
+        NodeRef node = NodeRef(step.factory());
+        step.prototype->copy_to(node.get());
+        node->set_patch(patch.get());
+        patch->nodes.insert(node);
+        clones[index] = node;
+    }
+
+    for (size_t index = 0; index < this->clone_plan.size(); index++)
+    {
+        for (auto &input : this->clone_plan[index].inputs)
+        {
+            clones[index]->set_cloned_input(input.first, clones[input.second]);
+        }
+    }
+
+    patch->output = clones.front();
+    for (auto &input : this->clone_plan_inputs)
+    {
+        patch->inputs[input.first] = clones[input.second];
+    }
+    patch->buffer_inputs = this->buffer_inputs;
+    patch->auto_free = this->auto_free;
+    patch->name = this->name;
+    patch->parsed = true;
+
+    return patch;
+}
+
+void Patch::invalidate_clone_plan()
+{
+    this->clone_plan_generation++;
+}
+
+void Patch::build_clone_plan()
+{
+    this->clone_plan.clear();
+    std::unordered_map<Node *, int> indices;
+    this->_add_clone_step(this->output, indices);
+
+    /*------------------------------------------------------------------------
+     * Inputs that don't feed the output are copied too, so that they can
+     * still be set on the copy.
+     *-----------------------------------------------------------------------*/
+    this->clone_plan_inputs.clear();
+    for (auto input : this->inputs)
     {
-        this->set_state(SIGNALFLOW_PATCH_STATE_STOPPED);
-        this->disconnect();
+        if (input.second)
+        {
+            int index = this->_add_clone_step(input.second, indices);
+            this->clone_plan_inputs.push_back({ input.first, index });
+        }
     }
 }
 
+int Patch::_add_clone_step(const NodeRef &node, std::unordered_map<Node *, int> &indices)
+{
+    auto existing = indices.find(node.get());
+    if (existing != indices.end())
+    {
+        return existing->second;
+    }
+
+    signalflow_clone_step_t step;
+    step.prototype = node.get();
+
+    /*------------------------------------------------------------------------
+     * A node that has been connected to one of the Patch's inputs from
+     * outside the Patch is shared with the copy.
+     *-----------------------------------------------------------------------*/
+    bool is_external = false;
+    for (auto input : this->inputs)
+    {
+        if (input.second.get() == node.get() && this->nodes.find(node) == this->nodes.end())
+        {
+            is_external = true;
+        }
+    }
+
+    /*------------------------------------------------------------------------
+     * The node's index is reserved before visiting its inputs, so that a
+     * feedback cycle back to it finds it rather than recursing forever.
+     *-----------------------------------------------------------------------*/
+    int index = (int) this->clone_plan.size();
+    indices[node.get()] = index;
+
+    if (is_external)
+    {
+        step.external = node;
+        this->clone_plan.push_back(step);
+    }
+    else
+    {
+        step.factory = NodeRegistry::global()->get_factory(node->name);
+        this->clone_plan.push_back(step);
+        for (auto input_name : node->input_names)
+        {
+            NodeRef input = *(node->inputs[input_name]);
+            if (input)
+            {
+                int input_index = this->_add_clone_step(input, indices);
+                this->clone_plan[index].inputs.push_back({ input_name, input_index });
+            }
+        }
+    }
+
+    return index;
+}
+
 /*------------------------------------------------------------------------
  * TEMPLATING
  *-----------------------------------------------------------------------*/
@@ -236,6 +410,7 @@ NodeRef Patch::add_input(std::string name, sample default_value)
 {
     NodeRef placeholder(default_value);
     this->inputs[name] = placeholder;
+    this->invalidate_clone_plan();
     nodes.insert(placeholder);
     return placeholder;
 }
@@ -277,6 +452,7 @@ NodeRef Patch::add_node(NodeRef node)
 {
     nodes.insert(node);
     node->patch = this;
+    this->invalidate_clone_plan();
     return node;
 }
 void Patch::set_output(NodeRef out)
@@ -338,15 +514,14 @@ PatchSpecRef Patch::create_spec()
 
 void Patch::_iterate_from_node(const NodeRef &node)
 {
-    for (auto input : node->inputs)
+    for (NodeRef *input : node->input_slots)
     {
-        NodeRef input_node = *(input.second);
+        const NodeRef &input_node = *input;
         if (input_node)
         {
             if (nodes.find(input_node) == nodes.end())
             {
-                // Lazy - use a better way of checking for constant
-                if (input_node->name != "constant")
+                if (input_node->type != SIGNALFLOW_NODE_TYPE_CONSTANT)
                 {
                     this->add_node(input_node);
                     this->_iterate_from_node(input_node);
@@ -361,7 +536,7 @@ PatchNodeSpec *Patch::_create_spec_from_node(const NodeRef &node)
     PatchNodeSpec *nodespec = new PatchNodeSpec(node->name);
     nodespec->set_id(this->last_id++);
 
-    if (node->name == "constant")
+    if (node->type == SIGNALFLOW_NODE_TYPE_CONSTANT)
     {
         Constant *constant = (Constant *) node.get();
         nodespec->set_constant_value(constant->value);
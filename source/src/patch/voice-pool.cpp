@@ -0,0 +1,221 @@
+#include "signalflow/patch/voice-pool.h"
+
+#include "signalflow/core/graph.h"
+#include "signalflow/node/operators/multiply.h"
+#include "signalflow/node/operators/sum.h"
+#include "signalflow/node/oscillators/constant.h"
+
+namespace signalflow
+{
+
+VoicePool::VoicePool(PatchSpecRef spec, int num_voices, signalflow_voice_steal_policy_t steal_policy)
+    : voice_active(num_voices, false),
+      voice_order(num_voices, 0),
+      voice_generation(num_voices, 0),
+      steal_policy(steal_policy),
+      stopped_voices(std::max(num_voices, 1))
+{
+    if (num_voices < 1)
+    {
+        throw std::runtime_error("VoicePool: Number of voices must be positive");
+    }
+
+    Sum *sum = new Sum();
+    this->output = sum;
+    for (int index = 0; index < num_voices; index++)
+    {
+        PatchRef voice = new Patch(spec);
+        voice->voice_pool = this;
+        voice->voice_index = index;
+        this->voices.push_back(voice);
+
+        /*------------------------------------------------------------------------
+         * While a voice's gate is zero, the Multiply is silent, so the voice's
+         * nodes are not rendered.
+         *-----------------------------------------------------------------------*/
+        NodeRef gate = new Constant(0.0);
+        this->gates.push_back(gate);
+        sum->add_input(voice->output * gate);
+    }
+
+    /*------------------------------------------------------------------------
+     * Voices are taken from the back of the stack, so push in reverse to
+     * allocate the first voice first.
+     *-----------------------------------------------------------------------*/
+    this->idle_voices.reserve(num_voices);
+    for (int index = num_voices - 1; index >= 0; index--)
+    {
+        this->idle_voices.push_back(index);
+    }
+}
+
+VoicePool::~VoicePool()
+{
+    for (auto &voice : this->voices)
+    {
+        voice->voice_pool = nullptr;
+    }
+}
+
+PatchRef VoicePool::allocate()
+{
+    this->collect_stopped_voices();
+
+    int index = -1;
+    if (!this->idle_voices.empty())
+    {
+        index = this->idle_voices.back();
+        this->idle_voices.pop_back();
+    }
+    else if (this->steal_policy != SIGNALFLOW_VOICE_STEAL_NONE)
+    {
+        for (int candidate = 0; candidate < (int) this->voices.size(); candidate++)
+        {
+            if (index == -1
+                || (this->steal_policy == SIGNALFLOW_VOICE_STEAL_OLDEST && this->voice_order[candidate] < this->voice_order[index])
+                || (this->steal_policy == SIGNALFLOW_VOICE_STEAL_NEWEST && this->voice_order[candidate] > this->voice_order[index]))
+            {
+                index = candidate;
+            }
+        }
+        this->set_gate(index, 0.0);
+        this->num_active_voices--;
+        this->steal_count++;
+    }
+
+    if (index == -1)
+    {
+        return nullptr;
+    }
+
+    /*------------------------------------------------------------------------
+     * The voice's nodes may be rendering, so reset them on the audio thread.
+     * This is ordered after the gate is closed, and before any inputs that
+     * are subsequently set.
+     *-----------------------------------------------------------------------*/
+    PatchRef voice = this->voices[index];
+    if (voice->get_graph())
+    {
+        voice->get_graph()->post_reset_patch(voice);
+    }
+    else
+    {
+        voice->reset();
+    }
+    this->voice_generation[index]++;
+    this->voice_active[index] = true;
+    this->voice_order[index] = this->next_order++;
+    this->num_active_voices++;
+
+    return voice;
+}
+
+void VoicePool::start(PatchRef voice)
+{
+    if (voice->voice_pool != this)
+    {
+        throw std::runtime_error("VoicePool: Patch is not a voice of this pool");
+    }
+    this->set_gate(voice->voice_index, 1.0);
+}
+
+PatchRef VoicePool::note_on(const std::unordered_map<std::string, float> &inputs)
+{
+    PatchRef voice = this->allocate();
+    if (voice)
+    {
+        for (auto &input : inputs)
+        {
+            voice->set_input(input.first, input.second);
+        }
+        this->start(voice);
+    }
+    return voice;
+}
+
+void VoicePool::stop(PatchRef voice)
+{
+    if (voice->voice_pool != this)
+    {
+        throw std::runtime_error("VoicePool: Patch is not a voice of this pool");
+    }
+    this->release_voice(voice->voice_index);
+}
+
+void VoicePool::voice_stopped(Patch *voice)
+{
+    int index = voice->voice_index;
+    this->set_gate(index, 0.0);
+
+    signalflow_stopped_voice_t stopped = { index, voice->voice_generation };
+    this->stopped_voices.write(&stopped, 1);
+}
+
+void VoicePool::collect_stopped_voices()
+{
+    signalflow_stopped_voice_t stopped;
+    while (this->stopped_voices.read(&stopped, 1))
+    {
+        if (stopped.generation == this->voice_generation[stopped.index])
+        {
+            this->release_voice(stopped.index);
+        }
+    }
+}
+
+void VoicePool::release_voice(int index)
+{
+    if (this->voice_active[index])
+    {
+        this->set_gate(index, 0.0);
+        this->voice_active[index] = false;
+        this->idle_voices.push_back(index);
+        this->num_active_voices--;
+    }
+}
+
+void VoicePool::set_gate(int index, float value)
+{
+    NodeRef gate = this->gates[index];
+    if (gate->graph)
+    {
+        gate->graph->post_constant_value(gate, value);
+    }
+    else
+    {
+        ((Constant *) gate.get())->value = value;
+    }
+}
+
+NodeRef VoicePool::get_output()
+{
+    return this->output;
+}
+
+int VoicePool::get_num_voices()
+{
+    return (int) this->voices.size();
+}
+
+int VoicePool::get_num_active_voices()
+{
+    this->collect_stopped_voices();
+    return this->num_active_voices;
+}
+
+int VoicePool::get_steal_count()
+{
+    return this->steal_count;
+}
+
+signalflow_voice_steal_policy_t VoicePool::get_steal_policy()
+{
+    return this->steal_policy;
+}
+
+void VoicePool::set_steal_policy(signalflow_voice_steal_policy_t policy)
+{
+    this->steal_policy = policy;
+}
+
+}
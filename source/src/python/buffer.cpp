@@ -72,4 +72,13 @@ void init_python_buffer(py::module &m)
         .def(py::init<int>())
         .def(py::init<std::string>())
         .def(py::init<std::string, int>());
+
+    py::class_<StreamingBuffer, Buffer, BufferRefTemplate<StreamingBuffer>>(m, "StreamingBuffer", "A buffer of audio samples that is paged in from disk as it is played")
+        .def(py::init<std::string, float, std::string>(), "filename"_a, "preload_duration"_a = SIGNALFLOW_STREAMING_BUFFER_DEFAULT_PRELOAD_DURATION, "cache_dir"_a = "")
+        .def_property_readonly("cache_path", &StreamingBuffer::get_cache_path)
+        .def_property_readonly("page_size", &StreamingBuffer::get_page_size)
+        .def_property_readonly("num_pages", &StreamingBuffer::get_num_pages)
+        .def_property_readonly("num_resident_pages", &StreamingBuffer::get_num_resident_pages)
+        .def_property_readonly("page_miss_count", &StreamingBuffer::get_page_miss_count)
+        .def("get_frame_is_resident", &StreamingBuffer::get_frame_is_resident);
 }
@@ -10,6 +10,10 @@ void init_python_config(py::module &m)
         .def_property("sample_rate", &AudioGraphConfig::get_sample_rate, &AudioGraphConfig::set_sample_rate)
         .def_property("input_buffer_size", &AudioGraphConfig::get_input_buffer_size, &AudioGraphConfig::set_input_buffer_size)
         .def_property("output_buffer_size", &AudioGraphConfig::get_output_buffer_size, &AudioGraphConfig::set_output_buffer_size)
+        .def_property("block_size", &AudioGraphConfig::get_block_size, &AudioGraphConfig::set_block_size)
         .def_property("input_device_name", &AudioGraphConfig::get_input_device_name, &AudioGraphConfig::set_input_device_name)
-        .def_property("output_device_name", &AudioGraphConfig::get_output_device_name, &AudioGraphConfig::set_output_device_name);
+        .def_property("output_device_name", &AudioGraphConfig::get_output_device_name, &AudioGraphConfig::set_output_device_name)
+        .def_property("render_thread_count", &AudioGraphConfig::get_render_thread_count, &AudioGraphConfig::set_render_thread_count)
+        .def_property("render_ahead_blocks", &AudioGraphConfig::get_render_ahead_blocks, &AudioGraphConfig::set_render_ahead_blocks)
+        .def_property("fft_planner_effort", &AudioGraphConfig::get_fft_planner_effort, &AudioGraphConfig::set_fft_planner_effort);
 }
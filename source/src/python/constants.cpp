@@ -16,11 +16,38 @@ void init_python_constants(py::module &m)
         .value("SIGNALFLOW_EVENT_DISTRIBUTION_POISSON", SIGNALFLOW_EVENT_DISTRIBUTION_POISSON, "Poisson distribution")
         .export_values();
 
+    py::enum_<signalflow_recording_format_t>(m, "signalflow_recording_format_t", py::arithmetic(), "signalflow_recording_format_t")
+        .value("SIGNALFLOW_RECORDING_FORMAT_FLOAT32", SIGNALFLOW_RECORDING_FORMAT_FLOAT32, "32-bit floating-point WAV")
+        .value("SIGNALFLOW_RECORDING_FORMAT_PCM16", SIGNALFLOW_RECORDING_FORMAT_PCM16, "16-bit integer WAV")
+        .value("SIGNALFLOW_RECORDING_FORMAT_PCM24", SIGNALFLOW_RECORDING_FORMAT_PCM24, "24-bit integer WAV")
+        .value("SIGNALFLOW_RECORDING_FORMAT_FLAC", SIGNALFLOW_RECORDING_FORMAT_FLAC, "24-bit FLAC")
+        .export_values();
+
+    py::enum_<signalflow_voice_steal_policy_t>(m, "signalflow_voice_steal_policy_t", py::arithmetic(), "signalflow_voice_steal_policy_t")
+        .value("SIGNALFLOW_VOICE_STEAL_NONE", SIGNALFLOW_VOICE_STEAL_NONE, "Don't steal voices")
+        .value("SIGNALFLOW_VOICE_STEAL_OLDEST", SIGNALFLOW_VOICE_STEAL_OLDEST, "Steal the voice started least recently")
+        .value("SIGNALFLOW_VOICE_STEAL_NEWEST", SIGNALFLOW_VOICE_STEAL_NEWEST, "Steal the voice started most recently")
+        .export_values();
+
     py::enum_<signalflow_node_state_t>(m, "signalflow_node_state_t", py::arithmetic(), "signalflow_node_state_t")
         .value("SIGNALFLOW_NODE_STATE_ACTIVE", SIGNALFLOW_NODE_STATE_ACTIVE, "Active")
         .value("SIGNALFLOW_NODE_STATE_STOPPED", SIGNALFLOW_NODE_STATE_STOPPED, "Stopped")
         .export_values();
 
+    py::enum_<signalflow_fft_planner_effort_t>(m, "signalflow_fft_planner_effort_t", py::arithmetic(), "signalflow_fft_planner_effort_t")
+        .value("SIGNALFLOW_FFT_PLANNER_ESTIMATE", SIGNALFLOW_FFT_PLANNER_ESTIMATE, "Estimate plans without measurement")
+        .value("SIGNALFLOW_FFT_PLANNER_MEASURE", SIGNALFLOW_FFT_PLANNER_MEASURE, "Measure candidate plans")
+        .value("SIGNALFLOW_FFT_PLANNER_PATIENT", SIGNALFLOW_FFT_PLANNER_PATIENT, "Measure a wider range of candidate plans")
+        .export_values();
+
+    py::enum_<signalflow_vector_isa_t>(m, "signalflow_vector_isa_t", py::arithmetic(), "signalflow_vector_isa_t")
+        .value("SIGNALFLOW_VECTOR_ISA_SCALAR", SIGNALFLOW_VECTOR_ISA_SCALAR, "Scalar")
+        .value("SIGNALFLOW_VECTOR_ISA_SSE2", SIGNALFLOW_VECTOR_ISA_SSE2, "SSE2")
+        .value("SIGNALFLOW_VECTOR_ISA_AVX2", SIGNALFLOW_VECTOR_ISA_AVX2, "AVX2")
+        .value("SIGNALFLOW_VECTOR_ISA_AVX512", SIGNALFLOW_VECTOR_ISA_AVX512, "AVX-512")
+        .value("SIGNALFLOW_VECTOR_ISA_NEON", SIGNALFLOW_VECTOR_ISA_NEON, "NEON")
+        .export_values();
+
     m.attr("SIGNALFLOW_MAX_CHANNELS") = SIGNALFLOW_MAX_CHANNELS;
     m.attr("SIGNALFLOW_DEFAULT_FFT_SIZE") = SIGNALFLOW_DEFAULT_FFT_SIZE;
     m.attr("SIGNALFLOW_MAX_FFT_SIZE") = SIGNALFLOW_MAX_FFT_SIZE;
@@ -2,6 +2,41 @@
 
 void init_python_graph(py::module &m)
 {
+    /*--------------------------------------------------------------------------------
+     * Profiling
+     *-------------------------------------------------------------------------------*/
+    py::class_<NodeProfileStats>(m, "NodeProfileStats")
+        .def_readonly("name", &NodeProfileStats::name)
+        .def_readonly("num_blocks", &NodeProfileStats::num_blocks)
+        .def_readonly("min", &NodeProfileStats::min)
+        .def_readonly("mean", &NodeProfileStats::mean)
+        .def_readonly("p99", &NodeProfileStats::p99)
+        .def_readonly("max", &NodeProfileStats::max)
+        .def_readonly("total", &NodeProfileStats::total)
+        .def("__repr__", [](NodeProfileStats &stats) {
+            return "NodeProfileStats(" + stats.name + ", num_blocks=" + std::to_string(stats.num_blocks) + ", mean=" + std::to_string(stats.mean * 1e6) + "us, p99=" + std::to_string(stats.p99 * 1e6) + "us)";
+        });
+
+    py::class_<AudioGraphProfile>(m, "AudioGraphProfile")
+        .def_readonly("nodes", &AudioGraphProfile::nodes)
+        .def_readonly("classes", &AudioGraphProfile::classes);
+
+    /*--------------------------------------------------------------------------------
+     * Telemetry
+     *-------------------------------------------------------------------------------*/
+    py::class_<AudioGraphTelemetryStats>(m, "AudioGraphTelemetryStats")
+        .def_readonly("block_count", &AudioGraphTelemetryStats::block_count)
+        .def_readonly("xrun_count", &AudioGraphTelemetryStats::xrun_count)
+        .def_readonly("late_count", &AudioGraphTelemetryStats::late_count)
+        .def_readonly("max_render_duration", &AudioGraphTelemetryStats::max_render_duration)
+        .def_readonly("max_load", &AudioGraphTelemetryStats::max_load)
+        .def_readonly("last_timestamp", &AudioGraphTelemetryStats::last_timestamp)
+        .def_readonly("histogram", &AudioGraphTelemetryStats::histogram)
+        .def_readonly("dropped_count", &AudioGraphTelemetryStats::dropped_count)
+        .def("__repr__", [](AudioGraphTelemetryStats &stats) {
+            return "AudioGraphTelemetryStats(block_count=" + std::to_string(stats.block_count) + ", xrun_count=" + std::to_string(stats.xrun_count) + ", late_count=" + std::to_string(stats.late_count) + ", max_load=" + std::to_string(stats.max_load) + ")";
+        });
+
     /*--------------------------------------------------------------------------------
      * Graph
      *-------------------------------------------------------------------------------*/
@@ -16,23 +51,99 @@ void init_python_graph(py::module &m)
          *-------------------------------------------------------------------------------*/
         .def_property_readonly("config", &AudioGraph::get_config)
         .def_property("sample_rate", &AudioGraph::get_sample_rate, &AudioGraph::set_sample_rate)
+        .def_property_readonly("block_size", &AudioGraph::get_block_size)
         .def_property_readonly("node_count", &AudioGraph::get_node_count)
+        .def_property_readonly("scratch_buffer_count", &AudioGraph::get_scratch_buffer_count)
         .def_property_readonly("cpu_usage", &AudioGraph::get_cpu_usage)
         .def_property_readonly("output", &AudioGraph::get_output)
         .def_property_readonly("outputs", &AudioGraph::get_outputs)
         .def_property_readonly("status", &AudioGraph::get_status)
+        .def_property_readonly("command_queue_overflow_count", &AudioGraph::get_command_queue_overflow_count)
+        .def_property_readonly("reclaim_overflow_count", &AudioGraph::get_reclaim_overflow_count)
+        .def_property_readonly("missing_node_count", &AudioGraph::get_missing_node_count)
+        .def_property_readonly("recording_overflow_count", &AudioGraph::get_recording_overflow_count)
+        .def_property("profiling_enabled", &AudioGraph::get_profiling_enabled, &AudioGraph::set_profiling_enabled)
+        .def_property_readonly("frame_position", &AudioGraph::get_frame_position)
+        .def_property_readonly("render_ahead_underrun_count", &AudioGraph::get_render_ahead_underrun_count)
+        .def_property_readonly("render_ahead_buffered_frames", &AudioGraph::get_render_ahead_buffered_frames)
 
         /*--------------------------------------------------------------------------------
          * Methods
          *-------------------------------------------------------------------------------*/
         .def("start", &AudioGraph::start)
         .def("stop", [](AudioGraph &graph) { graph.stop(); })
-        .def("clear", &AudioGraph::clear)
+        .def("clear", [](AudioGraph &graph) { graph.clear(); })
+        .def("make_current", &AudioGraph::make_current)
+        .def_static("get_graph_count", &AudioGraph::get_graph_count)
 
         .def("show_structure", [](AudioGraph &graph) { graph.show_structure(); })
         .def("show_status", &AudioGraph::show_status)
-        .def("render", [](AudioGraph &graph, int num_frames) { graph.render(num_frames); })
-        .def("render_to_buffer", [](AudioGraph &graph, BufferRef buffer) { graph.render_to_buffer(buffer); })
+        .def("get_profile", &AudioGraph::get_profile)
+        .def("reset_profile", &AudioGraph::reset_profile)
+        .def("get_telemetry", &AudioGraph::get_telemetry)
+        .def("reset_telemetry", &AudioGraph::reset_telemetry)
+        .def("get_dot", [](AudioGraph &graph) {
+            GraphRenderer renderer;
+            return renderer.get_dot(&graph);
+        })
+
+        /*--------------------------------------------------------------------------------
+         * Offline rendering releases the GIL, so that graphs on separate Python
+         * threads can render in parallel.
+         *-------------------------------------------------------------------------------*/
+        .def(
+            "render", [](AudioGraph &graph, int num_frames) { graph.render(num_frames); },
+            py::call_guard<py::gil_scoped_release>())
+        .def(
+            "render_to_buffer", [](AudioGraph &graph, BufferRef buffer) { graph.render_to_buffer(buffer); },
+            py::call_guard<py::gil_scoped_release>())
+        .def("render_to_file", &AudioGraph::render_to_file, "filename"_a, "duration"_a = 0, "num_channels"_a = 0,
+             "format"_a = SIGNALFLOW_RECORDING_FORMAT_FLOAT32, "progress"_a = nullptr, "max_duration"_a = 0,
+             py::call_guard<py::gil_scoped_release>())
+        .def(
+            "render_offline", [](AudioGraph &graph, double duration, std::function<void(py::array_t<float>)> callback, signalflow_offline_progress_callback_t progress, double max_duration) {
+                /*--------------------------------------------------------------------------------
+                 * Pass each block to Python as a copy, as the output buffer is
+                 * overwritten by the next block.
+                 *-------------------------------------------------------------------------------*/
+                int num_channels = graph.get_output()->get_num_input_channels();
+                return graph.render_offline(
+                    duration, [&](sample **output, int num_frames) {
+                        py::array_t<float> block({ num_channels, num_frames });
+                        for (int channel = 0; channel < num_channels; channel++)
+                        {
+                            std::copy(output[channel], output[channel] + num_frames, block.mutable_data(channel));
+                        }
+                        callback(block);
+                    },
+                    progress, max_duration);
+            },
+            "duration"_a, "callback"_a, "progress"_a = nullptr, "max_duration"_a = 0)
+        .def(
+            "read_output", [](AudioGraph &graph, int num_frames) {
+                /*--------------------------------------------------------------------------------
+                 * Read output as an audio device callback would, returning a
+                 * (num_channels, num_frames) array, so that device timing can be
+                 * simulated with a dummy output.
+                 *-------------------------------------------------------------------------------*/
+                int num_channels = graph.get_output()->get_num_input_channels();
+                std::vector<sample> interleaved(num_frames * num_channels);
+                {
+                    py::gil_scoped_release release;
+                    graph.read_output(interleaved.data(), num_frames);
+                }
+                py::array_t<float> output({ num_channels, num_frames });
+                for (int channel = 0; channel < num_channels; channel++)
+                {
+                    float *data = output.mutable_data(channel);
+                    for (int frame = 0; frame < num_frames; frame++)
+                    {
+                        data[frame] = interleaved[frame * num_channels + channel];
+                    }
+                }
+                return output;
+            },
+            "num_frames"_a)
         .def(
             "render_subgraph", [](AudioGraph &graph, NodeRef node, int num_frames, bool reset) {
                 if (reset)
@@ -48,10 +159,22 @@ void init_python_graph(py::module &m)
         .def("stop", [](AudioGraph &graph, NodeRef node) { graph.stop(node); })
         .def("stop", [](AudioGraph &graph, PatchRef patch) { graph.stop(patch); })
         .def("replace", [](AudioGraph &graph, NodeRef node, NodeRef other) { graph.replace(node, other); })
+        .def(
+            "set_input_at", [](AudioGraph &graph, NodeRef node, std::string name, float value, long frame) { graph.set_input_at(node, name, value, frame); },
+            "node"_a, "name"_a, "value"_a, "frame"_a)
+        .def(
+            "ramp_input_at", [](AudioGraph &graph, NodeRef node, std::string name, float value, double duration, long frame) { graph.ramp_input_at(node, name, value, duration, frame); },
+            "node"_a, "name"_a, "value"_a, "duration"_a, "frame"_a)
+        .def(
+            "trigger_at", [](AudioGraph &graph, NodeRef node, long frame, std::string name, float value) { graph.trigger_at(node, name, value, frame); },
+            "node"_a, "frame"_a, "name"_a = SIGNALFLOW_DEFAULT_TRIGGER, "value"_a = 1.0)
+        .def("play_at", [](AudioGraph &graph, PatchRef patch, long frame) { graph.play_at(patch, frame); }, "patch"_a, "frame"_a)
+        .def("stop_at", [](AudioGraph &graph, PatchRef patch, long frame) { graph.stop_at(patch, frame); }, "patch"_a, "frame"_a)
+        .def("get_frame_at_time", &AudioGraph::get_frame_at_time, "timestamp"_a)
         .def("add_node", &AudioGraph::add_node)
-        .def("remove_node", &AudioGraph::remove_node)
+        .def("remove_node", [](AudioGraph &graph, NodeRef node) { graph.remove_node(node); })
 
-        .def("start_recording", &AudioGraph::start_recording, "filename"_a = "", "num_channels"_a = 0)
+        .def("start_recording", &AudioGraph::start_recording, "filename"_a = "", "num_channels"_a = 0, "format"_a = SIGNALFLOW_RECORDING_FORMAT_FLOAT32)
         .def("stop_recording", &AudioGraph::stop_recording)
 
         .def("wait", [](AudioGraph &graph) {
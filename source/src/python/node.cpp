@@ -87,6 +87,17 @@ void init_python_node(py::module &m)
         .def_property_readonly("num_input_channels", &Node::get_num_input_channels)
         .def_property_readonly("num_output_channels_allocated", &Node::get_num_output_channels_allocated)
         .def_property_readonly("patch", &Node::get_patch)
+        .def_property_readonly("output_buffer_pinned", &Node::get_output_buffer_pinned)
+        .def_property_readonly("output_is_constant", &Node::get_output_is_constant)
+        .def_property_readonly("output_is_silent", &Node::get_output_is_silent)
+        .def_property_readonly("inactive", &Node::get_is_inactive)
+        .def_property_readonly("profile", [](Node &node) -> py::object {
+            if (!node.get_profile())
+            {
+                return py::none();
+            }
+            return py::cast(node.get_profile()->get_stats(node.name));
+        })
         .def_property_readonly("state", &Node::get_state)
         .def_property_readonly("inputs", [](Node &node) {
             std::unordered_map<std::string, NodeRef> inputs(node.inputs.size());
@@ -102,12 +113,16 @@ void init_python_node(py::module &m)
              * pointer to the original data, rather than a copy. This means that we can
              * modify the contents of the output buffer in-place from Python if we want to.
              * https://github.com/pybind/pybind11/issues/323
+             *
+             * The output is now observed from outside of the graph, so pin it to the
+             * node's own buffer rather than a shared scratch buffer.
              *-------------------------------------------------------------------------------*/
+            node.pin_output_buffer();
             py::str dummy_data_owner;
             return py::array_t<float>(
                 { node.get_num_output_channels_allocated(), node.last_num_frames },
                 { sizeof(float) * node.get_output_buffer_length(), sizeof(float) },
-                node.out[0],
+                node.get_output_buffer_data(),
                 dummy_data_owner);
         })
 
@@ -115,6 +130,7 @@ void init_python_node(py::module &m)
          * Methods
          *-------------------------------------------------------------------------------*/
         .def("set_buffer", &Node::set_buffer)
+        .def("pin_output_buffer", &Node::pin_output_buffer)
         .def("poll", [](Node &node) { node.poll(); })
         .def("poll", [](Node &node, float frequency) { node.poll(frequency); })
         .def("poll", [](Node &node, float frequency, std::string label) { node.poll(frequency, label); })
@@ -122,10 +138,24 @@ void init_python_node(py::module &m)
         .def("set_input", [](Node &node, std::string name, NodeRef noderef) { node.set_input(name, noderef); })
         .def("get_input", &Node::get_input)
         .def("add_input", &Node::add_input)
+        .def("remove_input", &Node::remove_input)
+        .def("clone", &Node::clone)
         .def("trigger", [](Node &node) { node.trigger(); })
         .def("trigger", [](Node &node, std::string name) { node.trigger(name); })
         .def("trigger", [](Node &node, std::string name, float value) { node.trigger(name, value); })
         .def("process", [](Node &node, int num_frames) {
+            /*--------------------------------------------------------------------------------
+             * When processing a single node outside of the graph, its inputs are not
+             * rendered first, so make sure they have enough frames allocated to be read.
+             *-------------------------------------------------------------------------------*/
+            for (auto input : node.inputs)
+            {
+                if (*(input.second))
+                {
+                    (*(input.second))->resize_output_buffer_length(num_frames);
+                }
+            }
+            node.resize_output_buffer_length(num_frames);
             node.process(num_frames);
             node.last_num_frames = num_frames;
         })
@@ -153,6 +183,52 @@ void init_python_node(py::module &m)
     py::class_<StochasticNode, Node, NodeRefTemplate<StochasticNode>>(m, "StochasticNode")
         .def("set_seed", &StochasticNode::set_seed);
 
+    /*--------------------------------------------------------------------------------
+     * DiskRecorder is bound here rather than in the generated bindings, as it
+     * exposes its recording statistics.
+     *-------------------------------------------------------------------------------*/
+    py::class_<DiskRecorder, Node, NodeRefTemplate<DiskRecorder>>(m, "DiskRecorder")
+        .def(py::init<std::string, NodeRef, int, signalflow_recording_format_t>(), "filename"_a = "", "input"_a = 0.0, "num_channels"_a = 0, "format"_a = SIGNALFLOW_RECORDING_FORMAT_FLOAT32)
+        .def_property_readonly("overflow_count", &DiskRecorder::get_overflow_count)
+        .def_property_readonly("frames_written", &DiskRecorder::get_frames_written);
+
+    /*--------------------------------------------------------------------------------
+     * Audio inputs are bound here rather than in the generated bindings, as they
+     * expose their ring buffer statistics. AudioIn_Dummy.write() takes an array
+     * of shape (num_channels, num_frames), as if received from a device.
+     *-------------------------------------------------------------------------------*/
+    py::class_<AudioIn_Abstract, Node, NodeRefTemplate<AudioIn_Abstract>>(m, "AudioIn_Abstract")
+        .def_property_readonly("buffered_frames", &AudioIn_Abstract::get_buffered_frames)
+        .def_property_readonly("target_frames", &AudioIn_Abstract::get_target_frames)
+        .def_property_readonly("overrun_count", &AudioIn_Abstract::get_overrun_count)
+        .def_property_readonly("underrun_count", &AudioIn_Abstract::get_underrun_count)
+        .def_property_readonly("resample_ratio", &AudioIn_Abstract::get_resample_ratio);
+
+    py::class_<AudioIn_Dummy, AudioIn_Abstract, NodeRefTemplate<AudioIn_Dummy>>(m, "AudioIn_Dummy")
+        .def(py::init<int, int, int>(), "num_channels"_a = 1, "buffer_size"_a = SIGNALFLOW_DEFAULT_BLOCK_SIZE, "sample_rate"_a = 0)
+        .def("write", [](AudioIn_Dummy &input, py::array_t<float, py::array::c_style | py::array::forcecast> frames) {
+            if (frames.ndim() != 2 || frames.shape(0) != input.get_num_output_channels())
+            {
+                throw std::runtime_error("AudioIn_Dummy: Frames must have shape (num_channels, num_frames)");
+            }
+            int num_channels = (int) frames.shape(0);
+            int num_frames = (int) frames.shape(1);
+            std::vector<sample> interleaved(num_channels * num_frames);
+            for (int channel = 0; channel < num_channels; channel++)
+            {
+                for (int frame = 0; frame < num_frames; frame++)
+                {
+                    interleaved[frame * num_channels + channel] = frames.at(channel, frame);
+                }
+            }
+            input.write(interleaved.data(), num_frames);
+        });
+
+#ifdef HAVE_SOUNDIO
+    py::class_<AudioIn, AudioIn_Abstract, NodeRefTemplate<AudioIn>>(m, "AudioIn")
+        .def(py::init<std::string, int, int>(), "device_name"_a = "", "num_channels"_a = 0, "buffer_size"_a = 0);
+#endif
+
     py::enum_<signalflow_filter_type_t>(m, "signalflow_filter_type_t", py::arithmetic(), "Filter type")
         .value("SIGNALFLOW_FILTER_TYPE_LOW_PASS", SIGNALFLOW_FILTER_TYPE_LOW_PASS, "Low-pass filter")
         .value("SIGNALFLOW_FILTER_TYPE_HIGH_PASS", SIGNALFLOW_FILTER_TYPE_HIGH_PASS, "High-pass filter")
@@ -179,5 +255,6 @@ void init_python_node(py::module &m)
 
     py::class_<NodeRegistry>(m, "NodeRegistry")
         .def(py::init<>())
-        .def("create", &NodeRegistry::create);
+        .def("create", &NodeRegistry::create)
+        .def("get_node_names", &NodeRegistry::get_node_names);
 }
@@ -28,6 +28,8 @@ void init_python_patch(py::module &m)
         .def("set_input", [](Patch &patch, std::string name, float value) { patch.set_input(name, value); })
         .def("set_input", [](Patch &patch, std::string name, NodeRef node) { patch.set_input(name, node); })
         .def("set_input", [](Patch &patch, std::string name, BufferRef buffer) { patch.set_input(name, buffer); })
+        .def("reset", &Patch::reset)
+        .def("clone", &Patch::clone)
         .def("set_auto_free", &Patch::set_auto_free)
         .def("get_auto_free", &Patch::get_auto_free)
         .def_property("auto_free", &Patch::get_auto_free, &Patch::set_auto_free)
@@ -56,6 +58,22 @@ void init_python_patch(py::module &m)
         .def("to_json", &PatchSpec::to_json)
         .def("from_json", &PatchSpec::from_json);
 
+    /*--------------------------------------------------------------------------------
+     * VoicePool
+     *-------------------------------------------------------------------------------*/
+    py::class_<VoicePool>(m, "VoicePool")
+        .def(py::init<PatchSpecRef, int, signalflow_voice_steal_policy_t>(),
+             "spec"_a, "num_voices"_a, "steal_policy"_a = SIGNALFLOW_VOICE_STEAL_OLDEST)
+        .def("allocate", &VoicePool::allocate)
+        .def("start", &VoicePool::start)
+        .def("note_on", &VoicePool::note_on, "inputs"_a = std::unordered_map<std::string, float>())
+        .def("stop", &VoicePool::stop)
+        .def_property_readonly("output", &VoicePool::get_output)
+        .def_property_readonly("num_voices", &VoicePool::get_num_voices)
+        .def_property_readonly("num_active_voices", &VoicePool::get_num_active_voices)
+        .def_property_readonly("steal_count", &VoicePool::get_steal_count)
+        .def_property("steal_policy", &VoicePool::get_steal_policy, &VoicePool::set_steal_policy);
+
     py::class_<PatchRegistry>(m, "PatchRegistry")
         .def(py::init(&PatchRegistry::global))
         .def("create", &PatchRegistry::create);
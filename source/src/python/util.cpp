@@ -21,5 +21,9 @@ void init_python_util(py::module &m)
     m.def("save_block_to_text_file", signalflow_save_block_to_text_file, R"pbdoc(Write a block of PCM float samples to a .csv-style text file)pbdoc");
     m.def("save_block_to_wav_file", signalflow_save_block_to_wav_file, R"pbdoc(Write a block of PCM float samples to a .wav file)pbdoc");
 
-    m.def("random_seed", random_seed, R"pbdoc(Set the global random seed)pbdoc");
+    m.def("vector_get_isa", signalflow_vector_get_isa, R"pbdoc(Get the instruction set used by vectorised kernels)pbdoc");
+    m.def("vector_set_isa", signalflow_vector_set_isa, R"pbdoc(Set the instruction set used by vectorised kernels)pbdoc");
+    m.def("vector_isa_is_supported", signalflow_vector_isa_is_supported, R"pbdoc(Query whether an instruction set is supported by this CPU)pbdoc");
+
+    m.def("random_seed", random_seed, R"pbdoc(Set the random seed of the calling thread, and of the current graph)pbdoc");
 }
@@ -1,9 +1,10 @@
-from signalflow import Buffer, Buffer2D
+from signalflow import Buffer, Buffer2D, StreamingBuffer
 from signalflow import SIGNALFLOW_INTERPOLATION_NONE, SIGNALFLOW_INTERPOLATION_LINEAR
 from signalflow import GraphNotCreatedException
 import numpy as np
 import pytest
 import os
+import time
 from . import graph
 
 def test_buffer_no_graph():
@@ -132,6 +133,50 @@ def test_buffer_save(graph):
     assert np.all(b2.data[0] - rand_buf < 0.0001)
     os.unlink(BUFFER_FILENAME)
 
+def wait_until_resident(buffer, frame, timeout=5.0):
+    start = time.time()
+    while not buffer.get_frame_is_resident(frame) and time.time() - start < timeout:
+        time.sleep(0.01)
+    return buffer.get_frame_is_resident(frame)
+
+def test_streaming_buffer(graph, tmp_path):
+    num_frames = 65536 * 5 + 1000
+    data = np.array([ np.random.uniform(-1, 1, num_frames), np.random.uniform(-1, 1, num_frames) ])
+    path = str(tmp_path / "stream.wav")
+    Buffer(2, num_frames, data).save(path)
+    reference = Buffer(path)
+
+    b = StreamingBuffer(path, preload_duration=0.1, cache_dir=str(tmp_path))
+    assert b.num_channels == 2
+    assert b.num_frames == num_frames
+    assert b.sample_rate == reference.sample_rate
+    assert os.path.exists(b.cache_path)
+
+    #--------------------------------------------------------------------------------
+    # Only the preloaded start of the file is resident initially.
+    #--------------------------------------------------------------------------------
+    assert b.page_size == 65536
+    assert b.num_pages == 6
+    assert b.num_resident_pages == 1
+    assert b.get_frame_is_resident(0)
+    assert np.array_equal(b.data[:, :b.page_size], reference.data[:, :b.page_size])
+
+    #--------------------------------------------------------------------------------
+    # Reading an absent frame returns silence and pages it in in the background.
+    #--------------------------------------------------------------------------------
+    frame = num_frames - 10
+    assert b.get_frame(1, frame) == 0.0
+    assert b.page_miss_count == 1
+    assert wait_until_resident(b, frame)
+    assert b.get_frame(1, frame) == reference.get_frame(1, frame)
+
+    #--------------------------------------------------------------------------------
+    # The cache is reused by later buffers of the same file.
+    #--------------------------------------------------------------------------------
+    b2 = StreamingBuffer(path, preload_duration=0.1, cache_dir=str(tmp_path))
+    assert b2.cache_path == b.cache_path
+    assert np.array_equal(b2.data, reference.data)
+
 def test_buffer_2d(graph):
     b1 = Buffer([ 1, 5, 9 ])
     b2 = Buffer([ 2, 4, 5 ])
@@ -1,4 +1,6 @@
-from signalflow import AudioGraph, AudioOut_Dummy, Buffer, SineOscillator, Line, Constant, Add
+from signalflow import AudioGraph, AudioGraphConfig, AudioOut_Dummy, Buffer, SineOscillator, Line, Constant, Add
+from signalflow import Patch, EnvelopeASR, SawOscillator, ChannelArray, StereoBalance, InvalidChannelCountException
+from signalflow import SIGNALFLOW_RECORDING_FORMAT_FLOAT32, SIGNALFLOW_RECORDING_FORMAT_PCM24, SIGNALFLOW_RECORDING_FORMAT_FLAC
 from . import process_tree, count_zero_crossings
 import pytest
 import numpy as np
@@ -94,3 +96,510 @@ def test_graph_clear():
     graph.clear()
     graph.render_to_buffer(buffer)
     assert np.all(buffer.data[0] == 0)
+
+def test_graph_topology_change():
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    c1 = Constant(1)
+    c2 = Constant(2)
+    add = Add(c1, 0)
+    graph.play(add)
+    buffer = Buffer(1, 1024)
+    graph.render_to_buffer(buffer)
+    assert np.all(buffer.data[0] == 1)
+    assert graph.node_count == 2
+
+    add.set_input("input1", c2 + 1)
+    graph.render_to_buffer(buffer)
+    assert np.all(buffer.data[0] == 4)
+    assert graph.node_count == 3
+
+    graph.stop(add)
+    graph.render_to_buffer(buffer)
+    assert np.all(buffer.data[0] == 0)
+    assert graph.node_count == 1
+    del graph
+
+def test_graph_stop_reuses_output_slots():
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    a = Constant(1) + 0
+    b = Constant(2) + 0
+    graph.play(a)
+    graph.play(b)
+    buffer = Buffer(1, 1024)
+    graph.render_to_buffer(buffer)
+    assert np.all(buffer.data[0] == 3)
+
+    for n in range(4):
+        graph.stop(a)
+        graph.render_to_buffer(buffer)
+        assert np.all(buffer.data[0] == 2)
+        graph.play(a)
+        graph.render_to_buffer(buffer)
+        assert np.all(buffer.data[0] == 3)
+    assert len(graph.output.inputs) == 2
+
+    # Stopping a node that isn't playing is counted, not reported
+    assert graph.missing_node_count == 0
+    graph.stop(a)
+    graph.stop(a)
+    graph.render_to_buffer(buffer)
+    assert np.all(buffer.data[0] == 2)
+    assert graph.missing_node_count == 1
+    del graph
+
+def test_graph_parallel_render():
+    config = AudioGraphConfig()
+    config.render_thread_count = 4
+    graph = AudioGraph(config=config, output_device=AudioOut_Dummy(1))
+    shared = Constant(0.5) * 2
+    for n in range(16):
+        graph.play(Constant(n) * 0.5 + shared)
+    graph.add_node(Constant(1) + shared)
+    buffer = Buffer(1, 1024)
+    graph.render_to_buffer(buffer)
+    assert np.all(buffer.data[0] == sum(range(16)) * 0.5 + 16)
+    assert graph.node_count == 35
+
+    with pytest.raises(RuntimeError):
+        graph.render(441000)
+    del graph
+
+def test_graph_command_queue():
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    graph.start()
+    add = Add(Constant(1), 0)
+    graph.play(add)
+    assert len(graph.outputs) == 0
+
+    buffer = Buffer(1, 1024)
+    graph.render_to_buffer(buffer)
+    assert len(graph.outputs) == 1
+    assert np.all(buffer.data[0] == 1)
+
+    add.set_input("input1", Constant(2))
+    graph.render_to_buffer(buffer)
+    assert np.all(buffer.data[0] == 3)
+
+    # Constant values are also set on the audio thread, and unknown inputs
+    # throw at the call site
+    add.set_input("input1", 5)
+    graph.render_to_buffer(buffer)
+    assert np.all(buffer.data[0] == 6)
+    with pytest.raises(RuntimeError):
+        add.set_input("no_such_input", Constant(2))
+
+    # Changes that the audio thread hasn't yet applied are applied on stop
+    add.set_input("input1", Constant(3))
+    graph.stop()
+    graph.render_to_buffer(buffer)
+    assert np.all(buffer.data[0] == 4)
+    assert graph.command_queue_overflow_count == 0
+    del graph
+
+def test_graph_command_queue_channels():
+    graph = AudioGraph(output_device=AudioOut_Dummy(2))
+    graph.start()
+    add = Add(Constant(1), 0)
+    graph.play(add)
+    buffer = Buffer(2, 1024)
+    graph.render_to_buffer(buffer)
+    assert add.num_output_channels == 1
+
+    # Connecting an input with more channels grows the node (and upmixes its
+    # other inputs) from storage that is allocated at the call site
+    add.set_input("input1", ChannelArray([2, 3]))
+    graph.render_to_buffer(buffer)
+    assert add.num_output_channels == 2
+    assert np.all(buffer.data[0] == 3)
+    assert np.all(buffer.data[1] == 4)
+
+    # An input with too many channels throws at the call site
+    balance = StereoBalance(ChannelArray([1, 1]), 0)
+    graph.play(balance)
+    graph.render_to_buffer(buffer)
+    with pytest.raises(InvalidChannelCountException):
+        balance.set_input("input", ChannelArray([1, 1, 1]))
+    graph.stop()
+    del graph
+
+def test_graph_deferred_destruction():
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    graph.start()
+    buffer = Buffer(1, 256)
+    for n in range(64):
+        graph.play(Constant(1) * n)
+    graph.render_to_buffer(buffer)
+    assert np.all(buffer.data[0] == sum(range(64)))
+
+    graph.clear()
+    graph.render_to_buffer(buffer)
+    assert np.all(buffer.data[0] == 0)
+    assert graph.reclaim_overflow_count == 0
+    graph.stop()
+    del graph
+
+def test_graph_scratch_buffers():
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    sine = SineOscillator(440)
+    chain = sine
+    for n in range(32):
+        chain = chain * 1
+    graph.play(chain)
+    graph.render(1024)
+    expected = np.sin(np.arange(1024) * 2 * np.pi * 440 / graph.sample_rate)
+    assert np.allclose(graph.output.output_buffer[0], expected, atol=1e-4)
+
+    # Each intermediate output is only needed until its consumer has run
+    assert 0 < graph.scratch_buffer_count <= 2
+    assert not chain.output_buffer_pinned
+
+    # Rendering a subgraph outside of the schedule doesn't pin its nodes
+    graph.render_subgraph(chain, 1024, reset=True)
+    assert not chain.output_buffer_pinned
+    assert not sine.output_buffer_pinned
+
+    # Accessing a node's output buffer pins it from the next block onwards
+    chain.output_buffer
+    assert chain.output_buffer_pinned
+    graph.render(1024)
+    assert np.all(chain.output_buffer[0] == graph.output.output_buffer[0])
+    del graph
+
+@pytest.mark.parametrize("format, extension", [
+    (SIGNALFLOW_RECORDING_FORMAT_FLOAT32, "wav"),
+    (SIGNALFLOW_RECORDING_FORMAT_PCM24, "wav"),
+    (SIGNALFLOW_RECORDING_FORMAT_FLAC, "flac"),
+])
+def test_graph_recording(tmp_path, format, extension):
+    graph = AudioGraph(output_device=AudioOut_Dummy(2))
+    sine = SineOscillator([ 220, 440 ]) * 0.5
+    graph.play(sine)
+
+    path = str(tmp_path / ("recording." + extension))
+    graph.start_recording(path, format=format)
+    for n in range(16):
+        graph.render(512)
+    assert graph.recording_overflow_count == 0
+    graph.stop_recording()
+    graph.render(512)
+
+    recording = Buffer(path)
+    assert recording.num_channels == 2
+    assert recording.num_frames == 16 * 512
+    expected = 0.5 * np.sin(np.arange(16 * 512) * 2 * np.pi * 220 / graph.sample_rate)
+    assert np.allclose(recording.data[0], expected, atol=1e-3)
+    del graph
+
+def test_graph_block_size():
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    assert graph.block_size == 256
+    del graph
+
+    config = AudioGraphConfig()
+    config.block_size = 64
+    graph = AudioGraph(config=config, output_device=AudioOut_Dummy(1))
+    assert graph.block_size == 64
+    assert SineOscillator(440).output_buffer.shape[1] == 64
+    del graph
+
+    config.block_size = 100
+    with pytest.raises(RuntimeError):
+        AudioGraph(config=config, output_device=AudioOut_Dummy(1))
+
+def test_graph_failed_construction():
+    # A graph whose constructor throws is not left registered, so another
+    # can be created on the same thread
+    with pytest.raises(RuntimeError):
+        AudioGraph(output_device=AudioOut_Dummy(1, sample_rate=0))
+    assert AudioGraph.get_graph_count() == 0
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    assert AudioGraph.get_graph_count() == 1
+    del graph
+
+def test_graph_render_offline(tmp_path):
+    graph = AudioGraph(output_device=AudioOut_Dummy(2))
+    graph.play(Constant(0.25))
+    blocks = []
+    seconds = graph.render_offline(0.5, lambda block: blocks.append(block))
+    assert seconds == pytest.approx(0.5, abs=1.0 / graph.sample_rate)
+    assert sum(block.shape[1] for block in blocks) == int(0.5 * graph.sample_rate)
+    assert all(block.shape[0] == 2 for block in blocks)
+    assert np.all(np.concatenate(blocks, axis=1)[0] == 0.25)
+
+    progress = []
+    path = str(tmp_path / "render.wav")
+    graph.render_to_file(path, 1.0, 1, progress=lambda seconds, factor: progress.append((seconds, factor)))
+    assert progress[-1][0] == pytest.approx(1.0, abs=1.0 / graph.sample_rate)
+    assert progress[-1][1] > 0
+    buffer = Buffer(path)
+    assert buffer.num_channels == 1
+    assert buffer.num_frames == graph.sample_rate
+    assert np.all(buffer.data[0] == 0.25)
+    del graph
+
+def test_graph_render_offline_until_freed():
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    patch = Patch()
+    envelope = patch.add_node(EnvelopeASR(0.0, 0.05, 0.05))
+    patch.set_output(patch.add_node(SineOscillator(440) * envelope))
+    patch.auto_free = True
+    graph.play(patch)
+    seconds = graph.render_offline(0, lambda block: None)
+    assert 0.1 <= seconds < 0.2
+    assert len(graph.outputs) == 0
+    del graph
+
+def test_graph_render_offline_max_duration():
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    graph.play(SineOscillator(440))
+    seconds = graph.render_offline(0, lambda block: None, max_duration=0.25)
+    assert seconds == pytest.approx(0.25, abs=1.0 / graph.sample_rate)
+    assert len(graph.outputs) == 1
+    del graph
+
+def test_graph_profiling():
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    sine = SineOscillator(440)
+    graph.play(sine * 0.5)
+    graph.render(256)
+    assert not graph.profiling_enabled
+    assert sine.profile is None
+
+    graph.profiling_enabled = True
+    for n in range(10):
+        graph.render(256)
+    stats = sine.profile
+    assert stats.name == "sine"
+    assert stats.num_blocks == 10
+    assert 0 < stats.min <= stats.mean <= stats.max
+    assert stats.min <= stats.p99 <= stats.max
+
+    profile = graph.get_profile()
+    assert "sine" in [node.name for node in profile.nodes]
+    assert sorted(stats.name for stats in profile.classes) == ["audioout-dummy", "constant", "multiply", "sine"]
+    assert "fillcolor" in graph.get_dot()
+
+    graph.reset_profile()
+    assert sine.profile.num_blocks == 0
+    graph.profiling_enabled = False
+    graph.render(256)
+    assert sine.profile.num_blocks == 0
+    del graph
+
+def test_graph_profiling_running():
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    sine = SineOscillator(440)
+    graph.play(sine * 0.5)
+    graph.start()
+    buffer = Buffer(1, 256)
+    graph.render_to_buffer(buffer)
+
+    # Nodes that are already playing are found from the audio thread's
+    # snapshot of the schedule, and nodes played later are profiled when
+    # they are connected
+    graph.profiling_enabled = True
+    saw = SawOscillator(220)
+    graph.play(saw * 0.5)
+    for n in range(4):
+        graph.render_to_buffer(buffer)
+    assert sine.profile.num_blocks > 0
+    assert saw.profile.num_blocks > 0
+    names = [node.name for node in graph.get_profile().nodes]
+    assert "sine" in names and "saw" in names
+
+    graph.stop()
+    del graph
+
+def test_graph_telemetry():
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    graph.play(SineOscillator(440) * 0.5)
+    telemetry = graph.get_telemetry()
+    assert telemetry.block_count == 0
+
+    for n in range(10):
+        graph.render(256)
+    telemetry = graph.get_telemetry()
+    assert telemetry.block_count == 10
+    assert telemetry.xrun_count <= telemetry.late_count <= 10
+    assert telemetry.max_render_duration > 0
+    assert telemetry.max_load > 0
+    assert sum(telemetry.histogram) == 10
+    assert telemetry.dropped_count == 0
+
+    graph.reset_telemetry()
+    assert graph.get_telemetry().block_count == 0
+    del graph
+
+def test_graph_scheduled_events():
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    add = Add(0, 0)
+    graph.play(add)
+    graph.set_input_at(add, "input0", 1, 100)
+    graph.ramp_input_at(add, "input1", 1, 100 / graph.sample_rate, 300)
+    with pytest.raises(Exception):
+        graph.set_input_at(Add(SineOscillator(440), 0), "input0", 1, 0)
+
+    buf = Buffer(1, 512)
+    graph.render_to_buffer(buf)
+    assert graph.frame_position == 512
+    assert np.all(buf.data[0][:100] == 0)
+    assert np.all(buf.data[0][100:301] == 1)
+    assert buf.data[0][350] == pytest.approx(1.5, abs=0.01)
+    assert np.all(buf.data[0][400:] == 2)
+    graph.stop(add)
+
+    patch = Patch()
+    patch.set_output(patch.add_node(Add(patch.add_input("value", 1), 0)))
+    graph.play_at(patch, 600)
+    graph.stop_at(patch, 700)
+    graph.render_to_buffer(buf)
+    assert np.all(buf.data[0][:88] == 0)
+    assert np.all(buf.data[0][88:188] == 1)
+    assert np.all(buf.data[0][188:] == 0)
+    del graph
+
+def test_graph_multiple_threads():
+    import threading
+
+    # Asserts in a thread only print a warning, so each thread records what
+    # it saw, and the results are checked once it has joined
+    def render(frequency, results, graph_counts, index):
+        graph = AudioGraph(output_device=AudioOut_Dummy(1))
+        graph_counts[index] = AudioGraph.get_graph_count()
+        graph.play(SineOscillator(frequency))
+        buf = Buffer(1, 44100)
+        graph.render_to_buffer(buf)
+        results[index] = count_zero_crossings(buf.data[0])
+        del graph
+
+    frequencies = [100, 200, 300, 400]
+    results = [None] * len(frequencies)
+    graph_counts = [0] * len(frequencies)
+    threads = [threading.Thread(target=render, args=(frequency, results, graph_counts, index))
+               for index, frequency in enumerate(frequencies)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    assert results == frequencies
+    assert all(count >= 1 for count in graph_counts)
+    assert AudioGraph.get_graph_count() == 0
+
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    with pytest.raises(Exception):
+        AudioGraph(output_device=AudioOut_Dummy(1))
+    del graph
+
+def test_graph_shared_graph_ambiguous():
+    import threading
+
+    # While several graphs exist, a thread with no current graph must pick one
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    errors = []
+    sample_rates = []
+    other_created = threading.Event()
+    other_done = threading.Event()
+
+    def create_other():
+        other = AudioGraph(output_device=AudioOut_Dummy(1))
+        other_created.set()
+        other_done.wait()
+        del other
+
+    def use_shared():
+        try:
+            Buffer(1, 16)
+        except RuntimeError as e:
+            errors.append(e)
+        graph.make_current()
+        sample_rates.append(Buffer(1, 16).sample_rate)
+
+    creator = threading.Thread(target=create_other)
+    creator.start()
+    other_created.wait()
+    user = threading.Thread(target=use_shared)
+    user.start()
+    user.join()
+    other_done.set()
+    creator.join()
+    assert len(errors) == 1
+    assert sample_rates == [graph.sample_rate]
+    del graph
+
+def test_graph_random_seed():
+    import threading
+    from signalflow import BeatCutter, random_seed
+    graph = AudioGraph(output_device=AudioOut_Dummy(1))
+    source = Buffer(1, 4096)
+    source.data[0][:] = np.arange(4096) / 4096
+
+    # The seed applies to the graph, whichever thread renders it
+    def render_cutter():
+        cutter = BeatCutter(source, 16, jump_probability=0.5)
+        graph.play(cutter)
+        output = Buffer(1, 4096)
+        thread = threading.Thread(target=graph.render_to_buffer, args=(output,))
+        thread.start()
+        thread.join()
+        graph.stop(cutter)
+        return output.data[0].copy()
+
+    random_seed(123)
+    first = render_cutter()
+    random_seed(123)
+    second = render_cutter()
+    random_seed(456)
+    third = render_cutter()
+    assert np.array_equal(first, second)
+    assert not np.array_equal(first, third)
+    del graph
+
+def test_graph_render_ahead():
+    import time
+
+    config = AudioGraphConfig()
+    config.block_size = 256
+    graph = AudioGraph(config=config, output_device=AudioOut_Dummy(1))
+    graph.play(SineOscillator(100) * 2)
+
+    #--------------------------------------------------------------------------------
+    # Without render-ahead, read_output() renders blocks as needed.
+    #--------------------------------------------------------------------------------
+    output = graph.read_output(100)
+    assert output.shape == (1, 100)
+    assert graph.render_ahead_buffered_frames == 0
+    graph.stop()
+    del graph
+
+    config.render_ahead_blocks = 4
+    graph = AudioGraph(config=config, output_device=AudioOut_Dummy(1))
+    graph.play(SineOscillator(100) * 2)
+    graph.start()
+    assert graph.render_ahead_buffered_frames == 1024
+
+    #--------------------------------------------------------------------------------
+    # Simulate a device requesting 300 frames per callback. Each callback
+    # waits for the render thread to refill the ring, so that the test
+    # doesn't depend on timing. The output is clamped to [-1, 1], and is
+    # continuous across callbacks.
+    #--------------------------------------------------------------------------------
+    blocks = []
+    for n in range(147):
+        deadline = time.time() + 10
+        while graph.render_ahead_buffered_frames < 300 and time.time() < deadline:
+            time.sleep(0.001)
+        blocks.append(graph.read_output(300))
+    samples = np.concatenate(blocks, axis=1)[0]
+    assert np.max(samples) == 1.0
+    assert np.min(samples) == -1.0
+    assert count_zero_crossings(samples) == 100
+    assert graph.render_ahead_underrun_count == 0
+
+    #--------------------------------------------------------------------------------
+    # A callback larger than the ring underruns, and is padded with silence.
+    #--------------------------------------------------------------------------------
+    output = graph.read_output(4096)
+    assert graph.render_ahead_underrun_count == 1
+    assert np.all(output[0][-3072:] == 0)
+    graph.stop()
+    del graph
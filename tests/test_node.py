@@ -11,7 +11,7 @@ def test_node_no_graph():
 def test_node_process(graph):
     a = SineOscillator(440)
     a.process(1024)
-    assert a.output_buffer.shape == (32, 1024)
+    assert a.output_buffer.shape == (1, 1024)
 
 def test_node_add_input(graph):
     a = SineOscillator(440)
@@ -71,21 +71,21 @@ def test_node_write_to_output_buffer(graph):
     assert a.output_buffer[0][3] == 1.0
 
     #--------------------------------------------------------------------------------
-    # Why is the output buffer of length 256 (SIGNALFLOW_DEFAULT_BLOCK_SIZE)
-    # rather than 2048 (SIGNALFLOW_NODE_BUFFER_SIZE)? Because the output buffer's
-    # length is reported by the Python bindings as `last_num_frames`.
-    # Whether this is a good idea is open to debate.
-    #
-    # Better would be to have a precise and rigorous block size throughout, which
-    # would mean adding a block buffer between the audio I/O and the Graph.
+    # The output buffer is allocated with one channel per output channel, and
+    # its length is reported by the Python bindings as `last_num_frames`, which
+    # here is 256: the graph's block_size, which defaults to
+    # SIGNALFLOW_DEFAULT_BLOCK_SIZE. Nodes are rendered in blocks of
+    # block_size frames, whatever the size of the audio I/O's callbacks,
+    # except for blocks that are split into shorter sub-blocks by an event
+    # scheduled at a frame within them (see AudioGraph.set_input_at).
     #--------------------------------------------------------------------------------
-    assert a.output_buffer.shape == (32, 256)
-    a.output_buffer[31][255] = 1.0
-    assert a.output_buffer[31][255] == 1.0
+    assert a.output_buffer.shape == (1, 256)
+    a.output_buffer[0][255] = 1.0
+    assert a.output_buffer[0][255] == 1.0
     with pytest.raises(IndexError):
-        a.output_buffer[32][255] == 1.0
+        a.output_buffer[1][255] == 1.0
     with pytest.raises(IndexError):
-        a.output_buffer[31][256] == 1.0
+        a.output_buffer[0][256] == 1.0
 
 
 def test_node_trigger(graph):
@@ -139,4 +139,61 @@ def test_node_trigger(graph):
     node.output_buffer[0][1] = 0
     node.output_buffer[0][1023] = 0
     graph.render(1024)
-    assert np.all(env.output_buffer[0] < 1.0)
\ No newline at end of file
+    assert np.all(env.output_buffer[0] < 1.0)
+
+def test_node_output_is_constant(graph):
+    constant = sf.Constant(2)
+    assert constant.output_is_constant
+
+    product = constant * 3
+    process_tree(product)
+    assert product.output_is_constant
+    assert np.all(product.output_buffer[0] == 6)
+
+    sine = SineOscillator(440)
+    scaled = sine * 0.5
+    process_tree(scaled)
+    assert not scaled.output_is_constant
+    expected = 0.5 * np.sin(np.arange(1024) * 2 * np.pi * 440 / graph.sample_rate)
+    assert np.allclose(scaled.output_buffer[0][:1024], expected, atol=1e-4)
+
+    #--------------------------------------------------------------------------------
+    # A Constant only rewrites its buffer when its value changes.
+    #--------------------------------------------------------------------------------
+    scaled.set_input("input0", 4)
+    graph.play(scaled)
+    graph.render(1024)
+    assert np.all(graph.output.output_buffer[0][:1024] == 2)
+    scaled.set_input("input0", 8)
+    graph.render(1024)
+    assert np.all(graph.output.output_buffer[0][:1024] == 4)
+
+def test_node_silence_propagation(graph):
+    envelope = sf.EnvelopeASR(0.0, 0.001, 0.001)
+    product = SineOscillator(440) * envelope
+    graph.play(product)
+    graph.render(1024)
+    assert np.any(graph.output.output_buffer[0][:1024] != 0)
+    assert envelope.inactive
+
+    #--------------------------------------------------------------------------------
+    # Once the envelope has finished, the product is silent and not processed.
+    #--------------------------------------------------------------------------------
+    graph.render(1024)
+    assert envelope.output_is_silent
+    assert product.output_is_silent
+    assert np.all(graph.output.output_buffer[0][:1024] == 0)
+
+    envelope.trigger()
+    assert not envelope.inactive
+    graph.render(1024)
+    assert not product.output_is_silent
+    assert np.any(graph.output.output_buffer[0][:1024] != 0)
+    graph.stop(product)
+
+    muted = SineOscillator(440) * 0
+    graph.play(muted)
+    graph.render(1024)
+    graph.render(1024)
+    assert muted.output_is_silent
+    assert np.all(graph.output.output_buffer[0][:1024] == 0)
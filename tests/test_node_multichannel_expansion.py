@@ -176,7 +176,7 @@ def test_expansion_recursive_processing():
 def test_expansion_buffer_reallocation(graph):
     a = SineOscillator([440] * 4)
     assert a.num_output_channels == 4
-    assert a.num_output_channels_allocated == 32
+    assert a.num_output_channels_allocated == 4
     a.set_input("frequency", [440] * 100)
     assert a.num_output_channels == 100
     assert a.num_output_channels_allocated == 100
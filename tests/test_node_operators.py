@@ -1,6 +1,7 @@
-from signalflow import Constant, ChannelArray, Sum
+from signalflow import Buffer, Constant, ChannelArray, Sum
 import numpy as np
 
+from . import graph
 from . import process_tree
 
 def test_add():
@@ -188,3 +189,30 @@ def test_sum():
     assert a.num_output_channels == 1
     process_tree(a)
     assert np.all(a.output_buffer[0] == 10)
+
+def test_sum_running(graph):
+    #--------------------------------------------------------------------------------
+    # While the graph is running, inputs are added, created and removed by the
+    # audio thread.
+    #--------------------------------------------------------------------------------
+    a = Sum([ 1, 2 ])
+    graph.start()
+    graph.play(a)
+    buf = Buffer(1, 256)
+    graph.render_to_buffer(buf)
+    assert np.all(buf.data[0] == 3)
+
+    four = Constant(4)
+    a.add_input(four)
+    a.set_input("eight", Constant(8))
+    graph.render_to_buffer(buf)
+    assert np.all(buf.data[0] == 15)
+
+    a.remove_input(four)
+    graph.render_to_buffer(buf)
+    assert np.all(buf.data[0] == 11)
+
+    a.add_input(Constant(16))
+    graph.render_to_buffer(buf)
+    assert np.all(buf.data[0] == 27)
+    graph.stop()
@@ -1,10 +1,11 @@
-from signalflow import Buffer, BufferPlayer, BufferRecorder, SineOscillator
+from signalflow import Buffer, StreamingBuffer, BufferPlayer, BufferRecorder, DiskRecorder, SineOscillator
 from signalflow import SIGNALFLOW_NODE_STATE_ACTIVE, SIGNALFLOW_NODE_STATE_STOPPED
 from . import graph
 from . import process_tree
 
 import numpy as np
 import pytest
+import time
 
 def test_buffer_player(graph):
     data = np.random.uniform(-1, 1, 1024)
@@ -18,6 +19,35 @@ def test_buffer_player(graph):
     assert player.state == SIGNALFLOW_NODE_STATE_STOPPED
     assert np.array_equal(output.data[0][:len(buf)], buf.data[0])
 
+def test_buffer_player_streaming(graph, tmp_path):
+    num_frames = 65536 * 3
+    data = np.random.uniform(-1, 1, num_frames)
+    path = str(tmp_path / "stream.wav")
+    Buffer(data).save(path)
+    reference = Buffer(path)
+
+    buf = StreamingBuffer(path, preload_duration=0.1, cache_dir=str(tmp_path))
+    player = BufferPlayer(buf, loop=False)
+
+    #--------------------------------------------------------------------------------
+    # Playback starts instantly from the preloaded page, and reading it
+    # requests the pages that follow, so that playback continues without
+    # any page misses.
+    #--------------------------------------------------------------------------------
+    output = Buffer(1, 1024)
+    process_tree(player, buffer=output)
+    assert np.array_equal(output.data[0], reference.data[0][:1024])
+
+    start = time.time()
+    while buf.num_resident_pages < buf.num_pages and time.time() - start < 5.0:
+        time.sleep(0.01)
+    assert buf.num_resident_pages == buf.num_pages
+
+    for block in range(1, num_frames // 1024):
+        process_tree(player, buffer=output)
+    assert np.array_equal(output.data[0], reference.data[0][-1024:])
+    assert buf.page_miss_count == 0
+
 def test_buffer_recorder(graph):
     record_buf = Buffer(2, 1024)
 
@@ -49,4 +79,34 @@ def test_buffer_recorder(graph):
     process_tree(recorder2, num_frames=len(record_buf))
     assert recorder2.state == SIGNALFLOW_NODE_STATE_ACTIVE
     sine_rendered2 = 0.5 * sine_rendered2 + np.sin(np.arange(len(record_buf)) * np.pi * 2 * 2000 / graph.sample_rate)
-    assert list(record_buf.data[0]) == pytest.approx(sine_rendered2, abs=0.001)
\ No newline at end of file
+    assert list(record_buf.data[0]) == pytest.approx(sine_rendered2, abs=0.001)
+
+def test_buffer_recorder_output_is_silent(graph):
+    # The recorder never writes its output, so must not be given a scratch
+    # buffer left over from the oscillator that it is played alongside
+    record_buf = Buffer(2, 4096)
+    graph.play(BufferRecorder(record_buf, SineOscillator(880) * 1, loop=True) * 1)
+    graph.play(SineOscillator(440) * 1)
+    graph.render(1024)
+    graph.render(1024)
+    expected = np.sin(np.arange(1024, 2048) * np.pi * 2 * 440 / graph.sample_rate)
+    assert list(graph.output.output_buffer[0]) == pytest.approx(expected, abs=0.0001)
+
+def test_disk_recorder(graph, tmp_path):
+    path = str(tmp_path / "recording.wav")
+    sine = SineOscillator(440)
+    recorder = DiskRecorder(path, sine * 0.5)
+    assert recorder.num_input_channels == 1
+    assert recorder.num_output_channels == 0
+    graph.add_node(recorder)
+    graph.render(1024)
+    graph.render(1024)
+    assert recorder.overflow_count == 0
+    graph.remove_node(recorder)
+    del recorder
+
+    recording = Buffer(path)
+    assert recording.num_channels == 1
+    assert recording.num_frames == 2048
+    sine_rendered = 0.5 * np.sin(np.arange(2048) * np.pi * 2 * 440 / graph.sample_rate)
+    assert list(recording.data[0]) == pytest.approx(sine_rendered, abs=0.0001)
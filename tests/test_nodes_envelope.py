@@ -1,4 +1,4 @@
-from signalflow import Buffer, EnvelopeADSR
+from signalflow import Buffer, ChannelArray, EnvelopeADSR, EnvelopeASR
 from signalflow import db_to_amplitude
 from . import graph
 from . import process_tree
@@ -24,3 +24,19 @@ def test_envelope_adsr(graph):
     assert b.data[0][10] == pytest.approx(1.0)
     assert b.data[0][110] == pytest.approx(db_to_amplitude(SIGNALFLOW_EXPONENTIAL_ENVELOPE_MIN_DB * 0.5))
     assert b.data[0][1111] == 0.0
+
+def test_envelope_asr_upmix(graph):
+    #--------------------------------------------------------------------------------
+    # An envelope upmixed by a multichannel input follows the same phase
+    # on every channel.
+    #--------------------------------------------------------------------------------
+    num_channels = 16
+    env = EnvelopeASR(0.0, 0.0, 0.01)
+    env.set_input("release", ChannelArray([0.01] * num_channels))
+    assert env.num_output_channels == num_channels
+    graph.render_subgraph(env)
+    env.trigger()
+    graph.render_subgraph(env)
+    assert env.output_buffer[0][0] == 1.0
+    for channel in range(1, num_channels):
+        assert np.array_equal(env.output_buffer[channel], env.output_buffer[0])
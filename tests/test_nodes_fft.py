@@ -1,5 +1,6 @@
 from signalflow import Buffer, EnvelopeASR
 from signalflow import SineOscillator, Impulse, FFT, IFFT
+from signalflow import AudioGraph, AudioGraphConfig, AudioOut_Dummy, SIGNALFLOW_FFT_PLANNER_MEASURE
 
 try:
     from signalflow import FFTConvolve
@@ -14,6 +15,9 @@ from . import graph
 from . import process_tree
 
 import numpy as np
+import pytest
+import sys
+import os
 
 fft_size = 2048
 num_bins = fft_size // 2 + 1
@@ -87,6 +91,27 @@ def test_fft_ifft(graph):
 
         assert np.all(np.abs(buffer_a.data[0] - buffer_b.data[0]) < 0.000001)
 
+@pytest.mark.skipif(sys.platform == "darwin", reason="FFTW is not used on macOS")
+def test_fft_ifft_planner_effort(tmp_path, monkeypatch):
+    #--------------------------------------------------------------------------------
+    # Measured plans should give the same results as estimated plans, and
+    # should be saved to FFTW wisdom under ~/.signalflow.
+    #--------------------------------------------------------------------------------
+    monkeypatch.setenv("HOME", str(tmp_path))
+    config = AudioGraphConfig()
+    config.fft_planner_effort = SIGNALFLOW_FFT_PLANNER_MEASURE
+    graph = AudioGraph(config=config, output_device=AudioOut_Dummy(2))
+    assert graph.config.fft_planner_effort == SIGNALFLOW_FFT_PLANNER_MEASURE
+
+    buffer_a = Buffer(1, fft_size)
+    buffer_b = Buffer(1, fft_size)
+    process_tree(SineOscillator(440), buffer_a)
+    fft = FFT(SineOscillator(440), fft_size=fft_size, hop_size=fft_size, do_window=False)
+    ifft = IFFT(fft)
+    process_tree(ifft, buffer_b)
+    assert np.all(np.abs(buffer_a.data[0] - buffer_b.data[0]) < 0.000001)
+    assert os.path.exists(os.path.join(tmp_path, ".signalflow", "fftw-wisdom"))
+
 def test_fft_ifft_split(graph):
     #--------------------------------------------------------------------------------
     # Verify that fft -> ifft returns the same output, with output
@@ -150,3 +175,25 @@ def test_fft_convolve_split(graph):
         process_tree(ifft, buffer_out)
         output_samples = np.concatenate((output_samples, buffer_out.data[0]))
     assert np.all(np.abs(output_samples - buffer_ir.data[0]) < 0.000001)
+
+def test_fft_convolve_tail(graph):
+    #--------------------------------------------------------------------------------
+    # An impulse response long enough that most partitions are convolved on
+    # the background thread.
+    #--------------------------------------------------------------------------------
+    num_blocks = 24
+    buffer_ir = Buffer(1, fft_size * num_blocks)
+    envelope_duration_seconds = buffer_ir.num_frames / graph.sample_rate
+    envelope = EnvelopeASR(0, 0, envelope_duration_seconds) * SineOscillator(440)
+    process_tree(envelope, buffer_ir)
+
+    fft = FFT(Impulse(0), fft_size=fft_size, hop_size=fft_size, do_window=False)
+    convolve = FFTConvolve(fft, buffer_ir)
+    ifft = IFFT(convolve) * 0.5
+
+    buffer_out = Buffer(1, fft_size)
+    output_samples = np.zeros(0)
+    for n in range(num_blocks):
+        process_tree(ifft, buffer_out)
+        output_samples = np.concatenate((output_samples, buffer_out.data[0]))
+    assert np.all(np.abs(output_samples - buffer_ir.data[0]) < 0.000001)
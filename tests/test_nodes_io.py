@@ -0,0 +1,58 @@
+from signalflow import AudioIn_Dummy
+from . import graph
+import numpy as np
+
+def render_input(graph, audio_in, num_frames):
+    graph.render_subgraph(audio_in, num_frames, reset=True)
+    return np.copy(audio_in.output_buffer[:, :num_frames])
+
+def test_audio_in_dummy(graph):
+    audio_in = AudioIn_Dummy(2, 256)
+    assert audio_in.num_output_channels == 2
+    assert audio_in.target_frames == 512
+
+    #--------------------------------------------------------------------------------
+    # Output is silent until the ring has filled to its target.
+    #--------------------------------------------------------------------------------
+    frames = np.array([np.arange(256), -np.arange(256)], dtype=np.float32) / 256
+    audio_in.write(frames)
+    assert audio_in.buffered_frames == 256
+    assert np.all(render_input(graph, audio_in, 256) == 0)
+
+    audio_in.write(frames)
+    output = render_input(graph, audio_in, 256)
+    assert np.allclose(output, frames, atol=1e-3)
+    assert audio_in.underrun_count == 0
+
+    #--------------------------------------------------------------------------------
+    # Writes that don't fit in the ring are truncated and counted.
+    #--------------------------------------------------------------------------------
+    for n in range(10):
+        audio_in.write(frames)
+    assert audio_in.overrun_count > 0
+    assert audio_in.buffered_frames <= audio_in.target_frames * 4
+
+def test_audio_in_drift_compensation(graph):
+    block_size = 256
+    for drift in [0.002, -0.002]:
+        audio_in = AudioIn_Dummy(1, block_size)
+
+        #--------------------------------------------------------------------------------
+        # Simulate an input device whose clock runs slightly faster or slower
+        # than the output's, by writing blocks of varying size.
+        #--------------------------------------------------------------------------------
+        phase = 0
+        frames_owed = 0.0
+        for block in range(4000):
+            frames_owed += block_size * (1 + drift)
+            num_frames = int(frames_owed)
+            frames_owed -= num_frames
+            frames = np.sin(2 * np.pi * 100 * (phase + np.arange(num_frames)) / 44100).astype(np.float32)
+            phase += num_frames
+            audio_in.write(frames.reshape(1, -1))
+            render_input(graph, audio_in, block_size)
+
+        assert audio_in.overrun_count == 0
+        assert audio_in.underrun_count == 0
+        assert abs(audio_in.resample_ratio - (1 + drift)) < 0.0005
+        assert abs(audio_in.buffered_frames - audio_in.target_frames) < audio_in.target_frames
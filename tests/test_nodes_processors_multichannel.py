@@ -15,4 +15,15 @@ def test_nodes_multichannel_pan(graph):
     graph.reset_subgraph(b)
     graph.render_subgraph(b)
     assert all(b.output_buffer[0] == 0.5 * math.sqrt(0.5))
-    assert all(b.output_buffer[1] == 0.5 * math.sqrt(0.5))
\ No newline at end of file
+    assert all(b.output_buffer[1] == 0.5 * math.sqrt(0.5))
+
+def test_nodes_multichannel_squiz(graph):
+    #--------------------------------------------------------------------------------
+    # Each channel has its own mono lookahead buffer.
+    #--------------------------------------------------------------------------------
+    squiz = sf.Squiz(sf.SineOscillator([440, 440]), 2.0, 4)
+    graph.play(squiz)
+    buffer = sf.Buffer(2, 8192)
+    graph.render_to_buffer(buffer)
+    assert all(buffer.data[1] == buffer.data[0])
+    assert max(abs(buffer.data[0][4096:])) > 0.5
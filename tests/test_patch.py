@@ -1,7 +1,12 @@
-from signalflow import PatchSpec, Patch, Buffer, BufferPlayer
-from signalflow import Multiply, SineOscillator, EnvelopeASR, SquareOscillator, Sum, Add
+from signalflow import PatchSpec, Patch, Buffer, BufferPlayer, VoicePool
+from signalflow import SIGNALFLOW_VOICE_STEAL_NONE, SIGNALFLOW_VOICE_STEAL_OLDEST
+from signalflow import Multiply, SineOscillator, EnvelopeASR, SquareOscillator, Sum, Add, ChannelArray
+from signalflow import BiquadFilter, LinearPanner, ImpulseSequence, Impulse, FFT, ChannelSelect
+from signalflow import IFFT, FFTContinuousPhaseVocoder, CombDelay, AllpassDelay, OneTapDelay, BufferRecorder, CrossCorrelate
+from signalflow import SIGNALFLOW_FILTER_TYPE_HIGH_PASS
 from . import graph
 import numpy as np
+import pytest
 
 def test_patch(graph):
     prototype = Patch()
@@ -49,6 +54,154 @@ def test_patch_duplicate(graph):
     graph.render_to_buffer(buf)
     assert np.all(buf.data[0] == 6)
 
+def test_patch_clone(graph):
+    prototype = Patch()
+    a = prototype.add_input("a", 1)
+    b = prototype.add_input("b", 2)
+    shared = prototype.add_node(a * b)
+    output = prototype.add_node(ChannelArray([shared, shared + b]))
+    prototype.set_output(output)
+
+    clone = prototype.clone()
+    assert clone.output.num_output_channels == 2
+    assert clone.output is not prototype.output
+    clone.set_input("a", 4)
+
+    buf = Buffer(2, 100)
+    graph.play(prototype)
+    graph.render_to_buffer(buf)
+    assert np.all(buf.data[0] == 2)
+    assert np.all(buf.data[1] == 4)
+    graph.stop(prototype)
+
+    graph.play(clone)
+    graph.render_to_buffer(buf)
+    assert np.all(buf.data[0] == 8)
+    assert np.all(buf.data[1] == 10)
+    graph.stop(clone)
+
+    second_clone = clone.clone()
+    graph.play(second_clone)
+    graph.render_to_buffer(buf)
+    assert np.all(buf.data[0] == 8)
+
+def test_patch_clone_rewired(graph):
+    prototype = Patch()
+    a = prototype.add_input("a", 1)
+    b = prototype.add_input("b", 2)
+    product = prototype.add_node(a * b)
+    prototype.set_output(product)
+    prototype.clone()
+
+    #--------------------------------------------------------------------------------
+    # Rewiring a node within the patch must be reflected in later clones.
+    #--------------------------------------------------------------------------------
+    product.set_input("input0", b)
+    clone = prototype.clone()
+
+    buf = Buffer(1, 100)
+    graph.play(clone)
+    graph.render_to_buffer(buf)
+    assert np.all(buf.data[0] == 4)
+    graph.stop(clone)
+
+def test_patch_clone_feedback(graph):
+    prototype = Patch()
+    add = prototype.add_node(Add(1, 0))
+    multiply = prototype.add_node(add * 0.5)
+    add.set_input("input1", multiply)
+    prototype.set_output(add)
+
+    #--------------------------------------------------------------------------------
+    # A feedback cycle is copied as a cycle between the copies.
+    #--------------------------------------------------------------------------------
+    clone = prototype.clone()
+    assert clone.output is not add
+    assert clone.output.inputs["input1"] is not multiply
+    assert clone.output.inputs["input1"].inputs["input0"] is clone.output
+    assert len(clone.nodes) == 4
+
+def test_patch_clone_unused_input(graph):
+    prototype = Patch()
+    a = prototype.add_input("a", 1)
+    prototype.add_input("unused", 2)
+    prototype.set_output(prototype.add_node(a * 2))
+
+    #--------------------------------------------------------------------------------
+    # An input that doesn't feed the output can still be set on the copy.
+    #--------------------------------------------------------------------------------
+    clone = prototype.clone()
+    clone.set_input("unused", 3)
+    assert clone.inputs["unused"] is not prototype.inputs["unused"]
+
+def test_node_clone(graph):
+    sine = SineOscillator(440)
+    clone = sine.clone()
+    assert clone is not sine
+    clone.frequency = 220
+    assert sine.frequency.output_buffer[0][0] == 440
+
+def test_node_clone_settings(graph):
+    #--------------------------------------------------------------------------------
+    # Settings that are passed to the constructor but aren't inputs must be
+    # copied too.
+    #--------------------------------------------------------------------------------
+    prototypes = [
+        BiquadFilter(SquareOscillator(100), SIGNALFLOW_FILTER_TYPE_HIGH_PASS, 2000),
+        LinearPanner(2, SineOscillator(440), 0.5),
+        ImpulseSequence([1, 0, 0, 1], Impulse(4410)),
+        IFFT(FFT(SineOscillator(440)), do_window=True)
+    ]
+    for prototype in prototypes:
+        clone = prototype.clone()
+        assert clone.num_output_channels == prototype.num_output_channels
+        graph.play(prototype)
+        graph.play(clone)
+        buf = Buffer(2, 1024)
+        graph.render_to_buffer(buf)
+        assert np.allclose(clone.output_buffer[:, :1024], prototype.output_buffer[:, :1024])
+        graph.stop(prototype)
+        graph.stop(clone)
+
+    #--------------------------------------------------------------------------------
+    # Delay lines are reallocated at the prototype's maximum delay time, so
+    # delays longer than the default are read back once they have filled.
+    #--------------------------------------------------------------------------------
+    prototypes = [
+        CombDelay(SineOscillator(440), 0.8, 0.5, maxdelaytime=1.0),
+        AllpassDelay(SineOscillator(440), 0.8, 0.5, maxdelaytime=1.0),
+        OneTapDelay(SineOscillator(440), 0.8, maxdelaytime=1.0)
+    ]
+    for prototype in prototypes:
+        clone = prototype.clone()
+        graph.play(prototype)
+        graph.play(clone)
+        buf = Buffer(2, 44100)
+        graph.render_to_buffer(buf)
+        assert np.any(prototype.output_buffer[:, :1024])
+        assert np.allclose(clone.output_buffer[:, :1024], prototype.output_buffer[:, :1024])
+        graph.stop(prototype)
+        graph.stop(clone)
+
+    #--------------------------------------------------------------------------------
+    # Nodes whose settings can't be copied throw rather than cloning with
+    # different ones.
+    #--------------------------------------------------------------------------------
+    with pytest.raises(Exception):
+        FFT(SineOscillator(440), 256, 64).clone()
+    with pytest.raises(Exception):
+        ChannelSelect(SineOscillator(440), 0).clone()
+    with pytest.raises(Exception):
+        FFTContinuousPhaseVocoder(FFT(SineOscillator(440), 256, 64), 0.5).clone()
+
+    #--------------------------------------------------------------------------------
+    # Nodes that can't be constructed without a buffer can't be cloned.
+    #--------------------------------------------------------------------------------
+    with pytest.raises(Exception):
+        BufferRecorder(Buffer(1, 1024), SineOscillator(440), loop=True).clone()
+    with pytest.raises(Exception):
+        CrossCorrelate(SineOscillator(440), Buffer(1, 1024), 256).clone()
+
 def test_patch_free(graph):
     prototype = Patch()
     sine = prototype.add_node(SineOscillator(440))
@@ -60,3 +213,79 @@ def test_patch_free(graph):
     patch = Patch(spec)
     patch.auto_free = True
 
+def test_voice_pool(graph):
+    prototype = Patch()
+    level = prototype.add_input("level", 1.0)
+    envelope = prototype.add_node(EnvelopeASR(0.0, 0.0, 0.01))
+    prototype.set_output(envelope * level)
+    spec = prototype.create_spec()
+
+    pool = VoicePool(spec, 2, SIGNALFLOW_VOICE_STEAL_NONE)
+    assert pool.num_voices == 2
+    graph.play(pool.output)
+
+    buf = Buffer(1, 1024)
+    graph.render_to_buffer(buf)
+    assert np.all(buf.data[0] == 0)
+
+    a = pool.note_on({ "level": 0.5 })
+    b = pool.note_on({ "level": 0.25 })
+    assert a is not None and b is not None
+    assert pool.note_on() is None
+    assert pool.num_active_voices == 2
+    graph.render_to_buffer(buf)
+    assert buf.data[0][0] == 0.75
+    assert buf.data[0][-1] == 0
+
+    #--------------------------------------------------------------------------------
+    # Once their envelopes finish, voices return to the pool, and are reset
+    # when next allocated.
+    #--------------------------------------------------------------------------------
+    assert pool.num_active_voices == 0
+    c = pool.note_on({ "level": 0.5 })
+    graph.render_to_buffer(buf)
+    assert buf.data[0][0] == 0.5
+
+    pool.stop(c)
+    assert pool.num_active_voices == 0
+    graph.render_to_buffer(buf)
+    assert np.all(buf.data[0] == 0)
+
+    pool.steal_policy = SIGNALFLOW_VOICE_STEAL_OLDEST
+    first = pool.note_on()
+    second = pool.note_on()
+    third = pool.note_on()
+    assert third is first
+    assert pool.steal_count == 1
+    graph.stop(pool.output)
+
+def test_voice_pool_running(graph):
+    prototype = Patch()
+    level = prototype.add_input("level", 1.0)
+    envelope = prototype.add_node(EnvelopeASR(0.0, 0.0, 0.01))
+    prototype.set_output(envelope * level)
+    spec = prototype.create_spec()
+
+    #--------------------------------------------------------------------------------
+    # While the graph is running, gates, resets and input values are applied
+    # by the audio thread, in the order that they were requested.
+    #--------------------------------------------------------------------------------
+    pool = VoicePool(spec, 1, SIGNALFLOW_VOICE_STEAL_OLDEST)
+    graph.start()
+    graph.play(pool.output)
+    buf = Buffer(1, 1024)
+
+    a = pool.note_on({ "level": 0.5 })
+    graph.render_to_buffer(buf)
+    assert buf.data[0][0] == 0.5
+    assert buf.data[0][-1] == 0
+
+    b = pool.note_on({ "level": 0.25 })
+    assert b is a
+    graph.render_to_buffer(buf)
+    assert buf.data[0][0] == 0.25
+
+    pool.stop(b)
+    graph.render_to_buffer(buf)
+    assert np.all(buf.data[0] == 0)
+    graph.stop()
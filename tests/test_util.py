@@ -2,7 +2,7 @@ import signalflow
 import pytest
 import math
 import numpy as np
-from . import DEFAULT_BUFFER_LENGTH
+from . import DEFAULT_BUFFER_LENGTH, process_tree, graph
 
 def test_clip():
     assert signalflow.clip(-0.5, 0, 1) == 0.0
@@ -47,4 +47,54 @@ def test_save_block_to_text_file():
 
 @pytest.mark.skip
 def test_save_block_to_wav_file():
-    pass
\ No newline at end of file
+    pass
+
+def test_vector_isa(graph):
+    isas = [signalflow.SIGNALFLOW_VECTOR_ISA_SCALAR,
+            signalflow.SIGNALFLOW_VECTOR_ISA_SSE2,
+            signalflow.SIGNALFLOW_VECTOR_ISA_AVX2,
+            signalflow.SIGNALFLOW_VECTOR_ISA_AVX512,
+            signalflow.SIGNALFLOW_VECTOR_ISA_NEON]
+    supported = [isa for isa in isas if signalflow.vector_isa_is_supported(isa)]
+    assert signalflow.SIGNALFLOW_VECTOR_ISA_SCALAR in supported
+    assert signalflow.vector_get_isa() in supported
+
+    def render_operators():
+        def inputs():
+            return signalflow.SineOscillator(440), signalflow.SawOscillator(110) + 1.5
+
+        #--------------------------------------------------------------------------------
+        # Use a block length that isn't a multiple of any vector width, so that
+        # the scalar remainder is also exercised.
+        #--------------------------------------------------------------------------------
+        outputs = []
+        nodes = [
+            inputs()[0] + inputs()[1],
+            inputs()[0] - inputs()[1],
+            inputs()[0] * inputs()[1],
+            inputs()[0] / inputs()[1],
+            signalflow.Sum([*inputs(), *inputs()]),
+            signalflow.ChannelMixer(1, signalflow.ChannelArray([*inputs(), *inputs()])),
+            signalflow.ChannelMixer(5, signalflow.ChannelArray([*inputs()])),
+        ]
+        for node in nodes:
+            process_tree(node, num_frames=1021)
+            outputs.append(np.copy(node.output_buffer[:, :1021]))
+        return outputs
+
+    default_isa = signalflow.vector_get_isa()
+    try:
+        signalflow.vector_set_isa(signalflow.SIGNALFLOW_VECTOR_ISA_SCALAR)
+        expected = render_operators()
+        for isa in supported:
+            signalflow.vector_set_isa(isa)
+            assert signalflow.vector_get_isa() == isa
+            for output, expected_output in zip(render_operators(), expected):
+                assert np.array_equal(output, expected_output)
+    finally:
+        signalflow.vector_set_isa(default_isa)
+
+    for isa in isas:
+        if isa not in supported:
+            with pytest.raises(Exception):
+                signalflow.vector_set_isa(isa)